@@ -0,0 +1,34 @@
+/*
+ * Clustered lighting math shared by the light culling shaders and the forward pass. LightClustering.cpp has the CPU
+ * implementation of the same functions, the two must be kept in sync
+ */
+
+/*
+ * Converts a value from the reverse-Z depth buffer into the distance from the camera along its view direction
+ */
+float LinearizeDepth(float DeviceDepth, vec2 CameraZBounds)
+{
+    float NearZ = CameraZBounds.x;
+    float FarZ  = CameraZBounds.y;
+
+    return NearZ * FarZ / (DeviceDepth * (FarZ - NearZ) + NearZ);
+}
+
+uint ComputeLightClusterZSlice(float ViewDepth, vec2 ClusterZScaleAndBias, uint NumberOfZClusters)
+{
+    float Slice = floor(log(ViewDepth) * ClusterZScaleAndBias.x + ClusterZScaleAndBias.y);
+    return uint(clamp(Slice, 0.0, float(NumberOfZClusters - 1)));
+}
+
+uint ComputeLinearLightClusterIndex(uvec3 Cluster, uvec2 NumberOfXYClusters)
+{
+    return Cluster.x + Cluster.y * NumberOfXYClusters.x + Cluster.z * NumberOfXYClusters.x * NumberOfXYClusters.y;
+}
+
+uvec3 DecomposeLinearLightClusterIndex(uint ClusterIndex, uvec2 NumberOfXYClusters)
+{
+    uint XYClusterCount = NumberOfXYClusters.x * NumberOfXYClusters.y;
+    uint IndexInSlice = ClusterIndex % XYClusterCount;
+
+    return uvec3(IndexInSlice % NumberOfXYClusters.x, IndexInSlice / NumberOfXYClusters.x, ClusterIndex / XYClusterCount);
+}
@@ -0,0 +1,18 @@
+/*
+ * Material properties are the members of a struct that the material's fragment shader stores in the material data buffer
+ * (one element per material instance, indexed by GlobalDrawcallData::MaterialIndex). Members of type TextureHandle are
+ * texture properties, the engine fills them with indices into the bindless texture array
+ *
+ * NOTE: shaders that include this file must include SharedData.h before it and enable GL_EXT_nonuniform_qualifier
+ */
+struct TextureHandle
+{
+    uint Index;
+};
+
+layout(set = MATERIAL_DATA_DESCRIPTOR_SET, binding = BINDLESS_TEXTURES_BINDING) uniform sampler2D u_BindlessTextures[];
+
+vec4 SampleMaterialTexture(TextureHandle Texture, vec2 TextureCoordinates)
+{
+    return texture(u_BindlessTextures[nonuniformEXT(Texture.Index)], TextureCoordinates);
+}
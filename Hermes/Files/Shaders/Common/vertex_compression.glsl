@@ -0,0 +1,11 @@
+/*
+ * Decodes a unit vector that was octahedral-encoded by MeshToAsset, see CompressedVertex in AssetHeaders.h
+ */
+vec3 DecodeOctahedral(vec2 Encoded)
+{
+    vec3 Result = vec3(Encoded, 1.0 - abs(Encoded.x) - abs(Encoded.y));
+    float Fold = max(-Result.z, 0.0);
+    Result.x += Result.x >= 0.0 ? -Fold : Fold;
+    Result.y += Result.y >= 0.0 ? -Fold : Fold;
+    return normalize(Result);
+}
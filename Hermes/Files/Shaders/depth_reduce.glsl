@@ -0,0 +1,42 @@
+#version 450
+#pragma shader_stage(compute)
+
+#include "SharedData.h"
+
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+layout(set = 0, binding = 0) uniform sampler2D u_Source;
+layout(set = 0, binding = 1, r32f) uniform writeonly image2D u_Destination;
+
+layout(push_constant) uniform DepthPyramidReductionDataWrapper
+{
+    DepthPyramidReductionData Data;
+} u_ReductionData;
+
+/*
+ * Computes one texel of the next level of the min-depth pyramid (reverse depth, so min is the furthest value)
+ *
+ * NOTE: a 3x3 footprint is used instead of 2x2 so that the last row and column of source levels with odd dimensions
+ *       are not lost; the overlap only makes the pyramid more conservative
+ */
+void main()
+{
+    uvec2 Texel = gl_GlobalInvocationID.xy;
+    if (any(greaterThanEqual(Texel, u_ReductionData.Data.DestinationDimensions)))
+        return;
+
+    ivec2 BaseSourceTexel = ivec2(Texel * 2);
+    ivec2 MaxSourceTexel = ivec2(u_ReductionData.Data.SourceDimensions) - 1;
+
+    float Result = 1.0;
+    for (int Y = 0; Y < 3; Y++)
+    {
+        for (int X = 0; X < 3; X++)
+        {
+            ivec2 SourceTexel = min(BaseSourceTexel + ivec2(X, Y), MaxSourceTexel);
+            Result = min(Result, texelFetch(u_Source, SourceTexel, 0).r);
+        }
+    }
+
+    imageStore(u_Destination, ivec2(Texel), vec4(Result));
+}
@@ -1,8 +1,16 @@
 #version 450
 #pragma shader_stage(fragment)
+#extension GL_EXT_nonuniform_qualifier : require
 
 #include "brdf_math.glsl"
 #include "SharedData.h"
+#include "light_clusters.glsl"
+#include "material_data.glsl"
+
+layout(push_constant, row_major) uniform GlobalDrawcallDataWrapper
+{
+    GlobalDrawcallData Data;
+} u_DrawcallData;
 
 // NOTE : set 0 - global scene data, updated once for every frame
 
@@ -13,23 +21,30 @@ layout(set = 0, binding = 0, row_major) uniform GlobalSceneDataWrapper
 layout(set = 0, binding = 1) uniform samplerCube u_IrradianceMap;
 layout(set = 0, binding = 2) uniform samplerCube u_SpecularMap;
 layout(set = 0, binding = 3) uniform sampler2D u_PrecomputedBRDFMap;
-layout(set = 0, binding = 4) buffer ClusterList
+layout(set = 0, binding = 4) readonly buffer LightClusterMasks
 {
-    uvec2 Clusters[]; // NOTE: x - index of first light, y - number of lights
-} u_ClusterList;
-layout(set = 0, binding = 5) buffer LightIndexList
+    uint Masks[]; // NOTE: see SceneData for the layout
+} u_LightClusterMasks;
+layout(set = 0, binding = 5) readonly buffer PointLightList
 {
-    uint IndexOfNextElement;
-    uint Indices[];
-} u_LightIndexList;
+    PointLight Lights[]; // NOTE: only the first u_SceneData.Data.PointLightCount elements are valid
+} u_PointLights;
 
 
-// NOTE : set 1 - material data, updated for every material type; we can't use binding #0 because it can only be used for uniform buffer containing numeric properties
+// NOTE : set 1 - material data shared by all materials, see material_data.glsl
 
-layout(set = 1, binding = 1) uniform sampler2D u_AlbedoTexture;
-layout(set = 1, binding = 2) uniform sampler2D u_RoughnessTexture;
-layout(set = 1, binding = 3) uniform sampler2D u_MetallicTexture;
-layout(set = 1, binding = 4) uniform sampler2D u_NormalTexture;
+struct MaterialData
+{
+    TextureHandle u_AlbedoTexture;
+    TextureHandle u_RoughnessTexture;
+    TextureHandle u_MetallicTexture;
+    TextureHandle u_NormalTexture;
+};
+
+layout(set = MATERIAL_DATA_DESCRIPTOR_SET, binding = MATERIAL_DATA_BUFFER_BINDING, std430) readonly buffer MaterialDataBuffer
+{
+    MaterialData Instances[];
+} u_MaterialData;
 
 layout(location = 0) in vec2 i_TextureCoordinates;
 layout(location = 1) in vec3 i_FragmentPosition;
@@ -38,17 +53,6 @@ layout(location = 3) in mat3 i_TBNMatrix;
 
 layout(location = 0) out vec4 o_Color;
 
-float LinearDepth(float SampledDepth)
-{
-    float NearZ = u_SceneData.Data.CameraZBounds.x;
-    float FarZ  = u_SceneData.Data.CameraZBounds.y;
-
-    float Numerator = -NearZ * FarZ;
-    float Denominator = SampledDepth * (FarZ - NearZ) + NearZ;
-
-    return Numerator / Denominator;
-}
-
 vec3 AccumulatedColorFromLightSource(vec3 Normal, vec3 ViewVector, vec3 MedianVector, vec3 LightDirection, vec3 LightColor, float LightDistance, float LightPower, vec3 AlbedoColor, float Roughness, float Metallic)
 {
     float Attenuation = 1.0 / (LightDistance * LightDistance);
@@ -71,48 +75,47 @@ vec3 AccumulatedColorFromLightSource(vec3 Normal, vec3 ViewVector, vec3 MedianVe
     return Result;
 }
 
-vec4 CalculateLighting(vec3 Position, vec3 Normal, vec3 ViewVector)
+vec4 CalculateLighting(vec3 Position, vec3 Normal, vec3 ViewVector, MaterialData Material)
 {
     vec3 Result = vec3(0.0);
 
-    vec3 AlbedoColor = texture(u_AlbedoTexture, i_TextureCoordinates).rgb;
-    float Roughness = texture(u_RoughnessTexture, i_TextureCoordinates).r;
-    float Metallic = texture(u_MetallicTexture, i_TextureCoordinates).r;
+    vec3 AlbedoColor = SampleMaterialTexture(Material.u_AlbedoTexture, i_TextureCoordinates).rgb;
+    float Roughness = SampleMaterialTexture(Material.u_RoughnessTexture, i_TextureCoordinates).r;
+    float Metallic = SampleMaterialTexture(Material.u_MetallicTexture, i_TextureCoordinates).r;
 
-    float NearZ = u_SceneData.Data.CameraZBounds.x;
-    float FarZ  = u_SceneData.Data.CameraZBounds.y;
+    // NOTE: must find the same cluster as light_cluster_marking.glsl does for this pixel, otherwise the cluster might be skipped by light culling
+    float Depth = LinearizeDepth(gl_FragCoord.z, u_SceneData.Data.CameraZBounds);
+    uint ClusterZIndex = ComputeLightClusterZSlice(Depth, u_SceneData.Data.ClusterZScaleAndBias, u_SceneData.Data.NumberOfZClusters);
 
-    // NOTE: we use negative here because even though depth in view space has negative values we need to use the positive value for indexing the cluster
-    float Depth = -LinearDepth(gl_FragCoord.z);
+    uvec2 NumberOfXYClusters = u_SceneData.Data.NumberOfXYClusters;
+    uvec2 ClusterXYIndex = min(uvec2(gl_FragCoord.xy) / uvec2(u_SceneData.Data.MaxPixelsPerLightCluster), NumberOfXYClusters - 1);
 
-    // FIXME: optimize this - coefficients can be calculated once on the CPU side
-    uint ClusterZIndex = clamp(uint(floor(u_SceneData.Data.NumberOfZClusters.x * log(Depth) / log(FarZ / NearZ) - u_SceneData.Data.NumberOfZClusters.x * log(NearZ) / log(FarZ / NearZ))), 0, u_SceneData.Data.NumberOfZClusters.x - 1);
-    uvec2 ClusterXYIndex = uvec2((gl_FragCoord.xy - 0.5) / u_SceneData.Data.MaxPixelsPerLightCluster);
-
-    uvec2 NumberOfXYClusters = uvec2(ceil(u_SceneData.Data.ScreenDimensions / u_SceneData.Data.MaxPixelsPerLightCluster));
-
-    uint LightClusterIndex = ClusterXYIndex.x + ClusterXYIndex.y * NumberOfXYClusters.x + ClusterZIndex * NumberOfXYClusters.x * NumberOfXYClusters.y;
-    if (LightClusterIndex >= u_ClusterList.Clusters.length())
-        discard;
+    uint LightClusterIndex = ComputeLinearLightClusterIndex(uvec3(ClusterXYIndex, ClusterZIndex), NumberOfXYClusters);
 
 #define USE_CLUSTERED_LIGHTING 1
 #if defined(USE_CLUSTERED_LIGHTING) && USE_CLUSTERED_LIGHTING
-    uint FirstLight = u_ClusterList.Clusters[LightClusterIndex].x;
-    uint OnePastLastLight  = FirstLight + u_ClusterList.Clusters[LightClusterIndex].y;
-    for (uint Index = FirstLight; Index < OnePastLastLight; Index++)
+    uint WordsPerCluster = u_SceneData.Data.LightMaskWordsPerCluster;
+    uint FirstWordOfCluster = LightClusterIndex * WordsPerCluster;
+    for (uint WordIndex = 0; WordIndex < WordsPerCluster; WordIndex++)
     {
-        uint LightIndex = u_LightIndexList.Indices[Index];
+        uint Mask = u_LightClusterMasks.Masks[FirstWordOfCluster + WordIndex];
+        while (Mask != 0)
+        {
+            uint LightIndex = WordIndex * 32 + uint(findLSB(Mask));
+            Mask &= Mask - 1;
 #else
     for (uint LightIndex = 0; LightIndex < u_SceneData.Data.PointLightCount; LightIndex++)
     {
+        {
 #endif
-        PointLight Light = u_SceneData.Data.PointLights[LightIndex];
+            PointLight Light = u_PointLights.Lights[LightIndex];
 
-        vec3 LightDirection = normalize(Light.Position.xyz - Position);
-        float LightDistance = length(Light.Position.xyz - Position);
-        vec3 MedianVector = normalize(LightDirection + ViewVector);
+            vec3 LightDirection = normalize(Light.Position.xyz - Position);
+            float LightDistance = length(Light.Position.xyz - Position);
+            vec3 MedianVector = normalize(LightDirection + ViewVector);
 
-        Result += AccumulatedColorFromLightSource(Normal, ViewVector, MedianVector, LightDirection, Light.Color.rgb, LightDistance, Light.Color.w, AlbedoColor, Roughness, Metallic);
+            Result += AccumulatedColorFromLightSource(Normal, ViewVector, MedianVector, LightDirection, Light.Color.rgb, LightDistance, Light.Color.w, AlbedoColor, Roughness, Metallic);
+        }
     }
 
     for (uint LightIndex = 0; LightIndex < u_SceneData.Data.DirectionalLightCount; LightIndex++)
@@ -147,12 +150,14 @@ vec4 CalculateLighting(vec3 Position, vec3 Normal, vec3 ViewVector)
 
 void main()
 {
-    vec3 Normal = texture(u_NormalTexture, i_TextureCoordinates).rgb;
+    MaterialData Material = u_MaterialData.Instances[u_DrawcallData.Data.MaterialIndex];
+
+    vec3 Normal = SampleMaterialTexture(Material.u_NormalTexture, i_TextureCoordinates).rgb;
     Normal = Normal * 2.0 - 1.0; // Remapping into [-1;+1]
     Normal = normalize(i_TBNMatrix * Normal);
 
     vec3 Position = i_FragmentPosition;
     vec3 ViewVector = normalize(u_SceneData.Data.CameraLocation.xyz - Position);
 
-    o_Color = CalculateLighting(Position, Normal, ViewVector);
+    o_Color = CalculateLighting(Position, Normal, ViewVector, Material);
 }
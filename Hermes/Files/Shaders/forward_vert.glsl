@@ -2,6 +2,7 @@
 #pragma shader_stage(vertex)
 
 #include "SharedData.h"
+#include "vertex_compression.glsl"
 
 layout(location = 0) in vec3 i_Position;
 layout(location = 1) in vec2 i_TextureCoordinates;
@@ -25,17 +26,26 @@ layout(location = 3) out mat3 o_TBNMatrix;
 
 void main()
 {
-    vec4 Result = u_SceneData.Data.ViewProjection * u_DrawcallData.Data.ModelMatrix * vec4(i_Position, 1.0);
+    vec3 Position = u_DrawcallData.Data.PositionOffset.xyz + u_DrawcallData.Data.PositionScale.xyz * i_Position;
+    vec3 InputNormal = i_Normal;
+    vec3 InputTangent = i_Tangent;
+    if (u_DrawcallData.Data.AreVerticesCompressed != 0)
+    {
+        InputNormal = DecodeOctahedral(i_Normal.xy);
+        InputTangent = DecodeOctahedral(i_Tangent.xy);
+    }
+
+    vec4 Result = u_SceneData.Data.ViewProjection * u_DrawcallData.Data.ModelMatrix * vec4(Position, 1.0);
     gl_Position = Result;
 
     mat3 NormalMatrix = mat3(transpose(inverse(u_DrawcallData.Data.ModelMatrix)));
-    vec3 Normal = normalize(NormalMatrix * i_Normal);
+    vec3 Normal = normalize(NormalMatrix * InputNormal);
 
     o_TextureCoordinates = i_TextureCoordinates;
-    o_FragmentPosition = (u_DrawcallData.Data.ModelMatrix * vec4(i_Position, 1.0)).xyz;
+    o_FragmentPosition = (u_DrawcallData.Data.ModelMatrix * vec4(Position, 1.0)).xyz;
     o_FragmentNormal = Normal;
 
-    vec3 Tangent = normalize(NormalMatrix * i_Tangent);
+    vec3 Tangent = normalize(NormalMatrix * InputTangent);
     // Reorthogonalize tangent
     Tangent = normalize(Tangent - dot(Tangent, Normal) * Normal);
     vec3 Bitangent = normalize(cross(Normal, Tangent));
@@ -0,0 +1,75 @@
+#version 450
+#pragma shader_stage(compute)
+
+#include "SharedData.h"
+#include "light_clusters.glsl"
+
+// NOTE: one workgroup covers the pixels of one column of light clusters, each thread processes every 16th pixel in both directions
+layout(local_size_x = 16, local_size_y = 16, local_size_z = 1) in;
+
+layout(set = 0, binding = 0, row_major) uniform GlobalSceneDataWrapper
+{
+    SceneData Data;
+} u_SceneData;
+
+layout(set = 0, binding = 1) buffer ActiveLightClusterList
+{
+    uint DispatchSize[ACTIVE_LIGHT_CLUSTER_LIST_HEADER_SIZE / 4]; // NOTE: only the first three elements are meaningful
+    uint ClusterIndices[];
+} u_ActiveClusters;
+
+layout(set = 0, binding = 2) uniform sampler2D u_Depth;
+
+// Bit N is set if any pixel of the column belongs to Z slice N, LightCullingPass::NumberOfZSlices is at most 32
+shared uint s_UsedZSlices;
+
+/*
+ * Finds the light clusters that contain at least one pixel of the depth buffer and appends them to the active cluster
+ * list, which is then used as the indirect dispatch of the light culling shader
+ */
+void main()
+{
+    if (gl_LocalInvocationIndex == 0)
+        s_UsedZSlices = 0;
+    barrier();
+
+    uvec2 ClusterSize = uvec2(u_SceneData.Data.MaxPixelsPerLightCluster);
+    uvec2 ScreenDimensions = uvec2(u_SceneData.Data.ScreenDimensions);
+    uvec2 FirstPixel = gl_WorkGroupID.xy * ClusterSize;
+    uvec2 OnePastLastPixel = min(FirstPixel + ClusterSize, ScreenDimensions);
+
+    // Slices are accumulated per thread first, so that the shared variable is only touched once by every thread
+    uint UsedZSlices = 0;
+    for (uint Y = FirstPixel.y + gl_LocalInvocationID.y; Y < OnePastLastPixel.y; Y += gl_WorkGroupSize.y)
+    {
+        for (uint X = FirstPixel.x + gl_LocalInvocationID.x; X < OnePastLastPixel.x; X += gl_WorkGroupSize.x)
+        {
+            float Depth = texelFetch(u_Depth, ivec2(X, Y), 0).r;
+
+            // Reverse-Z depth buffer is cleared to 0, so these pixels are not covered by any geometry
+            if (Depth == 0.0)
+                continue;
+
+            float ViewDepth = LinearizeDepth(Depth, u_SceneData.Data.CameraZBounds);
+            uint Slice = ComputeLightClusterZSlice(ViewDepth, u_SceneData.Data.ClusterZScaleAndBias, u_SceneData.Data.NumberOfZClusters);
+            UsedZSlices |= 1u << Slice;
+        }
+    }
+    if (UsedZSlices != 0)
+        atomicOr(s_UsedZSlices, UsedZSlices);
+    barrier();
+
+    // A single global atomic per column
+    if (gl_LocalInvocationIndex == 0 && s_UsedZSlices != 0)
+    {
+        uint RemainingSlices = s_UsedZSlices;
+        uint NextElement = atomicAdd(u_ActiveClusters.DispatchSize[0], uint(bitCount(RemainingSlices)));
+        while (RemainingSlices != 0)
+        {
+            uint Slice = uint(findLSB(RemainingSlices));
+            RemainingSlices &= RemainingSlices - 1;
+
+            u_ActiveClusters.ClusterIndices[NextElement++] = ComputeLinearLightClusterIndex(uvec3(gl_WorkGroupID.xy, Slice), u_SceneData.Data.NumberOfXYClusters);
+        }
+    }
+}
@@ -2,143 +2,123 @@
 #pragma shader_stage(compute)
 
 #include "SharedData.h"
+#include "light_clusters.glsl"
 
-layout(local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+#define THREAD_COUNT 64
+
+layout(local_size_x = THREAD_COUNT, local_size_y = 1, local_size_z = 1) in;
 
 layout(set = 0, binding = 0, row_major) uniform GlobalSceneDataWrapper
 {
     SceneData Data;
 } u_SceneData;
 
-layout(set = 0, binding = 1) buffer ClusterList
+layout(set = 0, binding = 1) writeonly buffer LightClusterMasks
+{
+    uint Masks[]; // NOTE: see SceneData for the layout
+} u_LightClusterMasks;
+
+layout(set = 0, binding = 2) readonly buffer ViewSpacePointLightList
 {
-    uvec2 Clusters[]; // NOTE: x - index of first light, y - number of lights
-} u_ClusterList;
+    vec4 Lights[]; // NOTE: XYZ = position in view space, W = radius, see light_preparation.glsl
+} u_ViewSpacePointLights;
 
-layout(set = 0, binding = 2) coherent buffer LightIndexList
+layout(set = 0, binding = 3) readonly buffer ActiveLightClusterList
 {
-    uint IndexOfNextElement;
-    uint Indices[];
-} u_LightIndexList;
+    uint DispatchSize[ACTIVE_LIGHT_CLUSTER_LIST_HEADER_SIZE / 4];
+    uint ClusterIndices[];
+} u_ActiveClusters;
 
+// Converts a point on the near plane given in framebuffer coordinates into view space
 vec3 ScreenSpaceToViewSpace(vec2 FramebufferCoordinates)
 {
-    vec2 ScreenCoordinates = FramebufferCoordinates / u_SceneData.Data.ScreenDimensions;
-    ScreenCoordinates.y = 1.0 - ScreenCoordinates.y;
-    ScreenCoordinates = ScreenCoordinates * 2.0 - 1.0;
-    vec4 ClipSpaceCoordinates = vec4(ScreenCoordinates, 1.0, 1.0); // Using reverse depth (near plane maps to 1)
+    vec2 NormalizedCoordinates = FramebufferCoordinates / u_SceneData.Data.ScreenDimensions * 2.0 - 1.0;
+    vec4 ClipSpaceCoordinates = vec4(NormalizedCoordinates, 1.0, 1.0); // Using reverse depth (near plane maps to 1)
 
     vec4 ViewSpaceCoordinates = u_SceneData.Data.InverseProjection * ClipSpaceCoordinates;
-    ViewSpaceCoordinates /= ViewSpaceCoordinates.w;
-
-    return ViewSpaceCoordinates.xyz;
+    return ViewSpaceCoordinates.xyz / ViewSpaceCoordinates.w;
 }
 
-vec3 IntersectCameraRayWithZPlane(vec3 RayDirection, float PlaneDistance)
+// Moves a point along the ray from the camera until it is at the given distance from the camera along the view direction
+vec3 ScaleToViewDepth(vec3 PointOnRay, float ViewDepth)
 {
-    const vec3 Normal = vec3(0.0, 0.0, -1.0);
-
-    vec3 Direction = normalize(RayDirection);
-    
-    float t = (PlaneDistance - dot(Normal, Direction)) / dot(Normal, Direction);
-
-    vec3 Result = t * Direction;
-    return Result;
+    return PointOnRay * (ViewDepth / -PointOnRay.z);
 }
 
 bool TestSphereToAABB(vec3 MinCorner, vec3 MaxCorner, vec3 SpherePosition, float SphereRadius)
 {
-    if (SpherePosition.x + SphereRadius >= MinCorner.x && SpherePosition.x - SphereRadius <= MaxCorner.x &&
-        SpherePosition.y + SphereRadius >= MinCorner.y && SpherePosition.y - SphereRadius <= MaxCorner.y &&
-        SpherePosition.z + SphereRadius >= MinCorner.z && SpherePosition.z - SphereRadius <= MaxCorner.z)
-    {
-        return true;
-    }
+    vec3 ClosestPoint = clamp(SpherePosition, MinCorner, MaxCorner);
+    vec3 Offset = SpherePosition - ClosestPoint;
 
-    return false;
+    return dot(Offset, Offset) <= SphereRadius * SphereRadius;
 }
 
-shared uint s_LocalLightIndices[MAX_POINT_LIGHTS_IN_CLUSTER];
-shared uint s_NextIndexInLocalLightIndexArray;
+shared vec3 s_MinCorner;
+shared vec3 s_MaxCorner;
+shared uint s_Masks[THREAD_COUNT];
 
 /*
- * TODO: this whole thing still needs quite a bit of work to be called a proper light culling shader
- * In particular:
- *   1. Check if we really need all the barriers that are present here
- *   2. We could probably use a better culling algorithm
- *   3. Using a better data structure for the culled light list would also be nice (at the moment there is a lot of duplicates and it requires 30+ MB for ~1000 lights)
- *   4. Many other things that can come up later
- * This shader also needs A TONN of optimization.
+ * One workgroup processes one of the clusters found by light_cluster_marking.glsl. The lights are split into batches of
+ * 32 * THREAD_COUNT, the threads test disjoint lights of a batch and gather the results in shared memory, then every
+ * thread writes one word of the cluster's mask
  */
 void main()
 {
-    if (gl_WorkGroupID.x + gl_WorkGroupID.y + gl_WorkGroupID.z + gl_LocalInvocationID.x == 0)
-        u_LightIndexList.IndexOfNextElement = 0;
-    if (gl_LocalInvocationID.x == 0)
-        s_NextIndexInLocalLightIndexArray = 0;
-    memoryBarrier();
-
-    // One workgroup per cluster, each thread withing a workgroup does the same calculations for now
-    uint LinearTileIndex = gl_WorkGroupID.x + gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.z * gl_NumWorkGroups.x * gl_NumWorkGroups.y;
-    if (LinearTileIndex >= u_ClusterList.Clusters.length())
-        return;
-
-    float NearZ = u_SceneData.Data.CameraZBounds.x * pow(u_SceneData.Data.CameraZBounds.y / u_SceneData.Data.CameraZBounds.x, float(gl_WorkGroupID.z) / float(gl_NumWorkGroups.z));
-    float FarZ  = u_SceneData.Data.CameraZBounds.x * pow(u_SceneData.Data.CameraZBounds.y / u_SceneData.Data.CameraZBounds.x, float(gl_WorkGroupID.z + 1) / float(gl_NumWorkGroups.z));
-
-    vec3 MinCornerOnNearCameraPlane = ScreenSpaceToViewSpace(vec2(min(u_SceneData.Data.MaxPixelsPerLightCluster * gl_WorkGroupID.xy, u_SceneData.Data.ScreenDimensions)));
-    vec3 MaxCornerOnNearCameraPlane = ScreenSpaceToViewSpace(vec2(min(u_SceneData.Data.MaxPixelsPerLightCluster * (gl_WorkGroupID.xy + 1), u_SceneData.Data.ScreenDimensions)));
-
-    vec3 MinPointNear = IntersectCameraRayWithZPlane(MinCornerOnNearCameraPlane, NearZ);
-    vec3 MaxPointNear = IntersectCameraRayWithZPlane(MaxCornerOnNearCameraPlane, NearZ);
-    vec3 MinPointFar = IntersectCameraRayWithZPlane(MinCornerOnNearCameraPlane, FarZ);
-    vec3 MaxPointFar = IntersectCameraRayWithZPlane(MaxCornerOnNearCameraPlane, FarZ);
-
-    vec3 MinCorner = min(min(MinPointNear, MinPointFar), min(MaxPointNear, MaxPointFar));
-    vec3 MaxCorner = max(max(MinPointNear, MinPointFar), max(MaxPointNear, MaxPointFar));
+    uint ClusterIndex = u_ActiveClusters.ClusterIndices[gl_WorkGroupID.x];
 
-    // This is where the workgroup splits - each individual thread processes a single light
-    barrier();
-    for (uint IndexOfFirstLightInBatch = 0; IndexOfFirstLightInBatch < u_SceneData.Data.PointLightCount; IndexOfFirstLightInBatch += gl_WorkGroupSize.x)
+    if (gl_LocalInvocationIndex == 0)
     {
-        uint Index = IndexOfFirstLightInBatch + gl_LocalInvocationID.x;
-        if (Index >= u_SceneData.Data.PointLightCount)
-            continue;
-
-        PointLight Light = u_SceneData.Data.PointLights[Index];
-
-        const float LightIntensityTolerance = 0.01;
+        uvec3 Cluster = DecomposeLinearLightClusterIndex(ClusterIndex, u_SceneData.Data.NumberOfXYClusters);
+
+        float NearZ = u_SceneData.Data.CameraZBounds.x;
+        float FarZ  = u_SceneData.Data.CameraZBounds.y;
+        float ClusterNearZ = NearZ * pow(FarZ / NearZ, float(Cluster.z) / float(u_SceneData.Data.NumberOfZClusters));
+        float ClusterFarZ  = NearZ * pow(FarZ / NearZ, float(Cluster.z + 1) / float(u_SceneData.Data.NumberOfZClusters));
+
+        vec2 ClusterSize = u_SceneData.Data.MaxPixelsPerLightCluster;
+        vec3 MinCornerOnNearPlane = ScreenSpaceToViewSpace(min(ClusterSize * vec2(Cluster.xy), u_SceneData.Data.ScreenDimensions));
+        vec3 MaxCornerOnNearPlane = ScreenSpaceToViewSpace(min(ClusterSize * vec2(Cluster.xy + 1), u_SceneData.Data.ScreenDimensions));
+
+        // NOTE: X and Y in view space only depend on the respective screen coordinate and the depth, so the two
+        //       diagonal corners at both depths are enough to bound the whole cluster
+        vec3 MinPointNear = ScaleToViewDepth(MinCornerOnNearPlane, ClusterNearZ);
+        vec3 MaxPointNear = ScaleToViewDepth(MaxCornerOnNearPlane, ClusterNearZ);
+        vec3 MinPointFar  = ScaleToViewDepth(MinCornerOnNearPlane, ClusterFarZ);
+        vec3 MaxPointFar  = ScaleToViewDepth(MaxCornerOnNearPlane, ClusterFarZ);
+
+        s_MinCorner = min(min(MinPointNear, MinPointFar), min(MaxPointNear, MaxPointFar));
+        s_MaxCorner = max(max(MinPointNear, MinPointFar), max(MaxPointNear, MaxPointFar));
+    }
+    barrier();
 
-        // FIXME: optimize this (get rid of 2 square roots)
-        vec3 Radiance = Light.Color.rgb * Light.Color.w;
-        float Radius = sqrt(length(Radiance) / LightIntensityTolerance);
+    vec3 MinCorner = s_MinCorner;
+    vec3 MaxCorner = s_MaxCorner;
 
-        vec3 LightPositionInViewSpace = (u_SceneData.Data.View * vec4(Light.Position.xyz, 1.0)).xyz;
+    uint LightCount = u_SceneData.Data.PointLightCount;
+    uint WordsPerCluster = u_SceneData.Data.LightMaskWordsPerCluster;
+    uint FirstWordOfCluster = ClusterIndex * WordsPerCluster;
+    for (uint FirstWordOfBatch = 0; FirstWordOfBatch < WordsPerCluster; FirstWordOfBatch += THREAD_COUNT)
+    {
+        s_Masks[gl_LocalInvocationIndex] = 0;
+        barrier();
 
-        if (TestSphereToAABB(MinCorner, MaxCorner, LightPositionInViewSpace, Radius))
+        // Consecutive threads test consecutive lights, so the loads of a warp are coalesced
+        for (uint Step = 0; Step < 32; Step++)
         {
-            uint LocalIndex = atomicAdd(s_NextIndexInLocalLightIndexArray, 1);
-            s_LocalLightIndices[LocalIndex] = Index;
-            memoryBarrierShared();
+            uint IndexInBatch = Step * THREAD_COUNT + gl_LocalInvocationIndex;
+            uint LightIndex = FirstWordOfBatch * 32 + IndexInBatch;
+            if (LightIndex >= LightCount)
+                break;
+
+            vec4 Light = u_ViewSpacePointLights.Lights[LightIndex];
+            if (TestSphereToAABB(MinCorner, MaxCorner, Light.xyz, Light.w))
+                atomicOr(s_Masks[IndexInBatch / 32], 1u << (IndexInBatch % 32));
         }
-    }
+        barrier();
 
-    // Workgroup joins again and only thread #0 is copying the data to the global array
-    // FIXME: can this be optimized?
-    barrier();
-    memoryBarrierShared(); // FIXME: I'm not too sure if we need memory barrier after execution barrier here
-    if (gl_LocalInvocationID.x == 0)
-    {
-        uint NumberOfVisibleLights = s_NextIndexInLocalLightIndexArray;
-
-        uint OffsetInGlobalList = atomicAdd(u_LightIndexList.IndexOfNextElement, NumberOfVisibleLights);
-
-        for (uint Index = 0; Index < NumberOfVisibleLights; Index++)
-            u_LightIndexList.Indices[OffsetInGlobalList + Index] = s_LocalLightIndices[Index];
-
-        u_ClusterList.Clusters[LinearTileIndex].x = OffsetInGlobalList;
-        u_ClusterList.Clusters[LinearTileIndex].y = NumberOfVisibleLights;
+        uint WordIndex = FirstWordOfBatch + gl_LocalInvocationIndex;
+        if (WordIndex < WordsPerCluster)
+            u_LightClusterMasks.Masks[FirstWordOfCluster + WordIndex] = s_Masks[gl_LocalInvocationIndex];
+        barrier();
     }
-
-    memoryBarrier(); // FIXME: again not too sure if a barrier is needed right at the end of the shader
 }
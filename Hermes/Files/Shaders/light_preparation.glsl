@@ -0,0 +1,38 @@
+#version 450
+#pragma shader_stage(compute)
+
+#include "SharedData.h"
+
+#define THREAD_COUNT 64
+
+layout(local_size_x = THREAD_COUNT, local_size_y = 1, local_size_z = 1) in;
+
+layout(set = 0, binding = 0, row_major) uniform GlobalSceneDataWrapper
+{
+    SceneData Data;
+} u_SceneData;
+
+layout(set = 0, binding = 1) readonly buffer PointLightList
+{
+    PointLight Lights[];
+} u_PointLights;
+
+layout(set = 0, binding = 2) writeonly buffer ViewSpacePointLightList
+{
+    vec4 Lights[]; // NOTE: XYZ = position in view space, W = radius
+} u_ViewSpacePointLights;
+
+/*
+ * Every thread transforms one point light into view space, the light culling shader then tests the transformed lights
+ * against all active clusters without multiplying by the view matrix again
+ */
+void main()
+{
+    uint LightIndex = gl_GlobalInvocationID.x;
+    if (LightIndex >= u_SceneData.Data.PointLightCount)
+        return;
+
+    vec4 Light = u_PointLights.Lights[LightIndex].Position;
+    vec3 LightPositionInViewSpace = (u_SceneData.Data.View * vec4(Light.xyz, 1.0)).xyz;
+    u_ViewSpacePointLights.Lights[LightIndex] = vec4(LightPositionInViewSpace, Light.w);
+}
@@ -0,0 +1,155 @@
+#version 450
+#pragma shader_stage(compute)
+
+#include "SharedData.h"
+
+layout(local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+
+struct DrawIndexedIndirectCommand
+{
+    uint IndexCount;
+    uint InstanceCount;
+    uint FirstIndex;
+    int VertexOffset;
+    uint FirstInstance;
+};
+
+layout(set = 0, binding = 0, row_major) uniform GlobalSceneDataWrapper
+{
+    SceneData Data;
+} u_SceneData;
+
+layout(set = 0, binding = 1) writeonly buffer DrawCommandList
+{
+    DrawIndexedIndirectCommand Commands[];
+} u_DrawCommandList;
+
+layout(set = 0, binding = 2) buffer DrawCountList
+{
+    uint Counts[];
+} u_DrawCountList;
+
+layout(set = 0, binding = 3) uniform sampler2D u_DepthPyramid;
+
+layout(set = 1, binding = 0) readonly buffer MeshletList
+{
+    Meshlet Meshlets[];
+} u_MeshletList;
+
+layout(push_constant, row_major) uniform MeshletCullingDrawcallDataWrapper
+{
+    MeshletCullingDrawcallData Data;
+} u_DrawcallData;
+
+bool IsOutsideOfFrustum(vec3 Center, float Radius)
+{
+    // NOTE: frustum planes are extracted from the view projection matrix (Gribb-Hartmann method); the far plane is skipped
+    //       because with reverse depth it is usually very far away or at infinity
+    mat4 Matrix = transpose(u_SceneData.Data.ViewProjection);
+    vec4 Planes[5] = vec4[5](
+        Matrix[3] + Matrix[0],
+        Matrix[3] - Matrix[0],
+        Matrix[3] + Matrix[1],
+        Matrix[3] - Matrix[1],
+        Matrix[3] - Matrix[2] // Near plane maps to 1 with reverse depth
+    );
+
+    for (int PlaneIndex = 0; PlaneIndex < 5; PlaneIndex++)
+    {
+        vec4 Plane = Planes[PlaneIndex];
+        if (dot(Plane.xyz, Center) + Plane.w < -Radius * length(Plane.xyz))
+            return true;
+    }
+    return false;
+}
+
+bool IsBackFacing(vec3 Center, float Radius, vec3 ConeAxis, float ConeCutoff)
+{
+    vec3 CameraToCenter = Center - u_SceneData.Data.CameraLocation.xyz;
+    return dot(CameraToCenter, ConeAxis) >= ConeCutoff * length(CameraToCenter) + Radius;
+}
+
+bool IsOccluded(vec3 Center, float Radius)
+{
+    vec2 MinUV = vec2(1.0);
+    vec2 MaxUV = vec2(0.0);
+    float MaxDepth = 0.0;
+
+    // NOTE: projecting the corners of the box around the sphere gives a conservative screen space rectangle
+    for (int Corner = 0; Corner < 8; Corner++)
+    {
+        vec3 Offset = vec3((Corner & 1) != 0 ? Radius : -Radius, (Corner & 2) != 0 ? Radius : -Radius, (Corner & 4) != 0 ? Radius : -Radius);
+        vec4 ClipSpacePosition = u_SceneData.Data.ViewProjection * vec4(Center + Offset, 1.0);
+
+        // The box intersects the near plane, so it can't be tested reliably
+        if (ClipSpacePosition.w <= 0.0)
+            return false;
+
+        vec3 NDCPosition = ClipSpacePosition.xyz / ClipSpacePosition.w;
+        vec2 UV = NDCPosition.xy * 0.5 + 0.5;
+        MinUV = min(MinUV, UV);
+        MaxUV = max(MaxUV, UV);
+        MaxDepth = max(MaxDepth, NDCPosition.z);
+    }
+
+    MinUV = clamp(MinUV, vec2(0.0), vec2(1.0));
+    MaxUV = clamp(MaxUV, vec2(0.0), vec2(1.0));
+
+    // Pick the level at which the rectangle covers at most 2x2 texels; every texel of the pyramid level L covers 2^(L+1) pixels
+    // of the depth buffer and additionally overlaps its neighbours, so the four texels below cover the whole rectangle
+    vec2 PyramidDimensions = vec2(u_DrawcallData.Data.DepthPyramidDimensions);
+    vec2 SizeInPixels = (MaxUV - MinUV) * PyramidDimensions * 2.0;
+    float Level = max(ceil(log2(max(max(SizeInPixels.x, SizeInPixels.y), 1.0))) - 1.0, 0.0);
+    int MipLevel = min(int(Level), int(u_DrawcallData.Data.DepthPyramidMipLevelCount) - 1);
+
+    ivec2 MipDimensions = textureSize(u_DepthPyramid, MipLevel);
+    ivec2 MinTexel = clamp(ivec2(MinUV * vec2(MipDimensions)), ivec2(0), MipDimensions - 1);
+    ivec2 MaxTexel = clamp(ivec2(MaxUV * vec2(MipDimensions)), ivec2(0), MipDimensions - 1);
+
+    float MinOccluderDepth = 1.0;
+    for (int Y = MinTexel.y; Y <= MaxTexel.y; Y++)
+    {
+        for (int X = MinTexel.x; X <= MaxTexel.x; X++)
+            MinOccluderDepth = min(MinOccluderDepth, texelFetch(u_DepthPyramid, ivec2(X, Y), MipLevel).r);
+    }
+
+    // Reverse depth: the meshlet is hidden if even its closest point is further away than the furthest occluder
+    return MaxDepth < MinOccluderDepth;
+}
+
+void main()
+{
+    uint MeshletIndex = gl_GlobalInvocationID.x;
+    if (MeshletIndex >= u_DrawcallData.Data.MeshletCount)
+        return;
+
+    Meshlet CurrentMeshlet = u_MeshletList.Meshlets[MeshletIndex];
+
+    vec3 Center = (u_DrawcallData.Data.ModelMatrix * vec4(CurrentMeshlet.BoundingSphere.xyz, 1.0)).xyz;
+    float Radius = CurrentMeshlet.BoundingSphere.w * u_DrawcallData.Data.MaxModelScale;
+
+    // NOTE: transforming the cone axis with the model matrix is only correct for uniform scaling, so the cone test
+    //       is skipped for non-uniformly scaled meshes
+    mat3 ModelMatrix3 = mat3(u_DrawcallData.Data.ModelMatrix);
+    vec3 AxisScales = vec3(length(ModelMatrix3[0]), length(ModelMatrix3[1]), length(ModelMatrix3[2]));
+    bool IsUniformlyScaled = max(max(AxisScales.x, AxisScales.y), AxisScales.z) - min(min(AxisScales.x, AxisScales.y), AxisScales.z) <= 0.001 * AxisScales.x;
+    vec3 ConeAxis = normalize(ModelMatrix3 * CurrentMeshlet.Cone.xyz);
+    float ConeCutoff = CurrentMeshlet.Cone.w;
+
+    if (IsOutsideOfFrustum(Center, Radius))
+        return;
+    if (IsUniformlyScaled && IsBackFacing(Center, Radius, ConeAxis, ConeCutoff))
+        return;
+    if (u_DrawcallData.Data.IsOcclusionCullingEnabled != 0 && IsOccluded(Center, Radius))
+        return;
+
+    uint DrawCountIndex = u_DrawcallData.Data.FirstDrawCount + CurrentMeshlet.PrimitiveIndex;
+    uint CommandIndexInPrimitive = atomicAdd(u_DrawCountList.Counts[DrawCountIndex], 1);
+    uint CommandIndex = u_DrawcallData.Data.FirstDrawCommand + CurrentMeshlet.FirstMeshletOfPrimitive + CommandIndexInPrimitive;
+
+    u_DrawCommandList.Commands[CommandIndex].IndexCount = CurrentMeshlet.IndexCount;
+    u_DrawCommandList.Commands[CommandIndex].InstanceCount = 1;
+    u_DrawCommandList.Commands[CommandIndex].FirstIndex = u_DrawcallData.Data.FirstIndex + CurrentMeshlet.IndexOffset;
+    u_DrawCommandList.Commands[CommandIndex].VertexOffset = u_DrawcallData.Data.VertexOffset;
+    u_DrawCommandList.Commands[CommandIndex].FirstInstance = 0;
+}
@@ -1,16 +1,28 @@
 #version 450
 #pragma shader_stage(fragment)
+#extension GL_EXT_nonuniform_qualifier : require
 
 #include "SharedData.h"
+#include "material_data.glsl"
+
+layout(push_constant, row_major) uniform GlobalDrawcallDataWrapper
+{
+    GlobalDrawcallData Data;
+} u_DrawcallData;
 
 layout(set = 0, binding = 0) uniform GlobalSceneDataWrapper
 {
     SceneData Data;
 } u_GlobalSceneDataWrapper;
 
-layout(set = 1, binding = 0) uniform MaterialData
+struct MaterialData
 {
     vec3 Color;
+};
+
+layout(set = MATERIAL_DATA_DESCRIPTOR_SET, binding = MATERIAL_DATA_BUFFER_BINDING, std430) readonly buffer MaterialDataBuffer
+{
+    MaterialData Instances[];
 } u_MaterialData;
 
 layout(location = 0) in vec2 i_TextureCoordinates;
@@ -22,5 +34,5 @@ layout(location = 0) out vec4 o_Color;
 
 void main()
 {
-    o_Color = vec4(u_MaterialData.Color, 1.0);
+    o_Color = vec4(u_MaterialData.Instances[u_DrawcallData.Data.MaterialIndex].Color, 1.0);
 }
@@ -18,6 +18,18 @@ namespace Hermes
 		HDR = 0x10
 	};
 
+	enum class MeshVertexFormat : uint8
+	{
+		Full = 0x00, // Vertex
+		Compressed = 0x01 // CompressedVertex
+	};
+
+	enum class MeshIndexType : uint8
+	{
+		UInt32 = 0x00,
+		UInt16 = 0x01
+	};
+
 	PACKED_STRUCT_BEGIN
 	struct AssetHeader
 	{
@@ -30,9 +42,18 @@ namespace Hermes
 
 	struct MeshAssetHeader
 	{
+		// NOTE: must be incremented whenever the layout of the header or of the data that follows it changes
+		static constexpr uint32 CurrentVersion = 1;
+
+		uint32 Version;
 		uint32 VertexBufferSize; // Number of elements in the vertex buffer
 		uint32 IndexBufferSize; // Number of elements in the index buffer
 		uint32 PrimitiveCount;
+		uint32 MeshletCount;
+		MeshVertexFormat VertexFormat;
+		MeshIndexType IndexType;
+		Vec3 BoundingBoxMin;
+		Vec3 BoundingBoxMax;
 	};
 
 	struct Vertex
@@ -43,12 +64,43 @@ namespace Hermes
 		Vec3 Tangent;
 	};
 
+	/*
+	 * Packed 20-byte alternative to Vertex:
+	 *  - position is quantized to 16-bit unsigned normalized integers relative to the bounding box of the mesh
+	 *    (4th component is padding because 3-component 16-bit vertex formats are not widely supported)
+	 *  - texture coordinates are half floats
+	 *  - normal and tangent are octahedral-encoded into two 16-bit signed normalized integers
+	 */
+	struct CompressedVertex
+	{
+		uint16 Position[4];
+		uint16 TextureCoordinates[2];
+		int16 Normal[2];
+		int16 Tangent[2];
+	};
+
 	struct MeshPrimitiveHeader
 	{
 		uint32 IndexBufferOffset;
 		uint32 IndexCount;
 	};
 
+	/*
+	 * A cluster of at most 64 unique vertices and 124 triangles that occupies a contiguous range of the index buffer
+	 * within a single primitive. The normal cone describes the orientation of its triangles: the whole meshlet is back-facing
+	 * for every camera position that satisfies dot(Center - CameraPosition, ConeAxis) >= ConeCutoff * length(Center - CameraPosition) + Radius
+	 */
+	struct MeshletHeader
+	{
+		Vec3 Center;
+		float Radius;
+		Vec3 ConeAxis;
+		float ConeCutoff;
+		uint32 IndexOffset;
+		uint32 IndexCount;
+		uint32 PrimitiveIndex;
+	};
+
 	struct ImageAssetHeader
 	{
 		uint16 Width;
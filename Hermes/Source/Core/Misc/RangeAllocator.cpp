@@ -0,0 +1,143 @@
+#include "RangeAllocator.h"
+
+#include <algorithm>
+
+namespace Hermes
+{
+	RangeAllocator::RangeAllocator(size_t InCapacity)
+		: Capacity(InCapacity)
+	{
+		if (Capacity > 0)
+			FreeRanges[0] = Capacity;
+	}
+
+	std::optional<size_t> RangeAllocator::Allocate(size_t Size, size_t Alignment)
+	{
+		HERMES_ASSERT(Size > 0);
+		HERMES_ASSERT(Alignment > 0);
+
+		// NOTE: first fit, which keeps the allocations packed at the beginning of the address space and is good enough
+		//       for mesh data that is allocated and freed in large chunks
+		for (auto It = FreeRanges.begin(); It != FreeRanges.end(); ++It)
+		{
+			auto [RangeOffset, RangeSize] = *It;
+			auto AlignedOffset = AlignUp(RangeOffset, Alignment);
+			if (AlignedOffset + Size > RangeOffset + RangeSize)
+				continue;
+
+			FreeRanges.erase(It);
+			if (AlignedOffset > RangeOffset)
+				FreeRanges[RangeOffset] = AlignedOffset - RangeOffset;
+			if (AlignedOffset + Size < RangeOffset + RangeSize)
+				FreeRanges[AlignedOffset + Size] = RangeOffset + RangeSize - AlignedOffset - Size;
+
+			Allocations[AlignedOffset] = { Size, Alignment };
+			AllocatedSize += Size;
+			return AlignedOffset;
+		}
+
+		return {};
+	}
+
+	void RangeAllocator::Free(size_t Offset)
+	{
+		auto It = Allocations.find(Offset);
+		HERMES_ASSERT(It != Allocations.end());
+
+		auto Size = It->second.Size;
+		Allocations.erase(It);
+		AllocatedSize -= Size;
+
+		AddFreeRange(Offset, Size);
+	}
+
+	std::vector<RangeAllocator::Relocation> RangeAllocator::Defragment()
+	{
+		std::vector<Relocation> Result;
+		std::map<size_t, AllocationInfo> NewAllocations;
+		FreeRanges.clear();
+
+		// NOTE: every allocation ends up at the same or at a lower offset because all allocations before it were packed
+		//       as well, so the moves can be performed in order without overwriting data that was not moved yet
+		size_t CurrentOffset = 0;
+		for (const auto& [Offset, Info] : Allocations)
+		{
+			auto NewOffset = AlignUp(CurrentOffset, Info.Alignment);
+			if (NewOffset > CurrentOffset)
+				FreeRanges[CurrentOffset] = NewOffset - CurrentOffset;
+			if (NewOffset != Offset)
+				Result.push_back({ Offset, NewOffset, Info.Size });
+
+			NewAllocations[NewOffset] = Info;
+			CurrentOffset = NewOffset + Info.Size;
+		}
+		if (CurrentOffset < Capacity)
+			FreeRanges[CurrentOffset] = Capacity - CurrentOffset;
+
+		Allocations = std::move(NewAllocations);
+		return Result;
+	}
+
+	void RangeAllocator::Grow(size_t NewCapacity)
+	{
+		HERMES_ASSERT(NewCapacity >= Capacity);
+		if (NewCapacity == Capacity)
+			return;
+
+		auto OldCapacity = Capacity;
+		Capacity = NewCapacity;
+		AddFreeRange(OldCapacity, NewCapacity - OldCapacity);
+	}
+
+	size_t RangeAllocator::GetCapacity() const
+	{
+		return Capacity;
+	}
+
+	size_t RangeAllocator::GetAllocatedSize() const
+	{
+		return AllocatedSize;
+	}
+
+	size_t RangeAllocator::GetLargestFreeRangeSize() const
+	{
+		size_t Result = 0;
+		for (const auto& [Offset, Size] : FreeRanges)
+			Result = std::max(Result, Size);
+		return Result;
+	}
+
+	size_t RangeAllocator::GetAllocationSize(size_t Offset) const
+	{
+		auto It = Allocations.find(Offset);
+		HERMES_ASSERT(It != Allocations.end());
+		return It->second.Size;
+	}
+
+	void RangeAllocator::AddFreeRange(size_t Offset, size_t Size)
+	{
+		auto Next = FreeRanges.lower_bound(Offset);
+		if (Next != FreeRanges.end() && Next->first == Offset + Size)
+		{
+			Size += Next->second;
+			Next = FreeRanges.erase(Next);
+		}
+
+		if (Next != FreeRanges.begin())
+		{
+			auto Previous = std::prev(Next);
+			if (Previous->first + Previous->second == Offset)
+			{
+				Previous->second += Size;
+				return;
+			}
+		}
+
+		FreeRanges[Offset] = Size;
+	}
+
+	size_t RangeAllocator::AlignUp(size_t Value, size_t Alignment)
+	{
+		return (Value + Alignment - 1) / Alignment * Alignment;
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "Core/Core.h"
+
+namespace Hermes
+{
+	/*
+	 * Sub-allocates ranges of a linear address space (e.g. a large GPU buffer) without touching any memory itself
+	 *
+	 * Allocations are identified by their offset. Free ranges are merged with their neighbours when an allocation is
+	 * freed; fragmentation that remains can be removed with Defragment(), which returns the moves that the owner of
+	 * the memory has to perform.
+	 */
+	class HERMES_API RangeAllocator
+	{
+	public:
+		explicit RangeAllocator(size_t InCapacity);
+
+		/*
+		 * Returns the offset of the allocated range or nothing if there is no free range that is large enough.
+		 * Alignment does not have to be a power of two (vertex data is aligned to the vertex stride)
+		 */
+		std::optional<size_t> Allocate(size_t Size, size_t Alignment = 1);
+
+		void Free(size_t Offset);
+
+		struct Relocation
+		{
+			size_t OldOffset;
+			size_t NewOffset;
+			size_t Size;
+		};
+
+		/*
+		 * Moves all allocations towards the beginning of the address space while preserving their order and alignment.
+		 * Returns the list of moved allocations sorted by their offset
+		 */
+		std::vector<Relocation> Defragment();
+
+		/*
+		 * Extends the address space; the new part becomes a free range
+		 */
+		void Grow(size_t NewCapacity);
+
+		size_t GetCapacity() const;
+		size_t GetAllocatedSize() const;
+		size_t GetLargestFreeRangeSize() const;
+		size_t GetAllocationSize(size_t Offset) const;
+
+	private:
+		struct AllocationInfo
+		{
+			size_t Size;
+			size_t Alignment;
+		};
+
+		size_t Capacity;
+		size_t AllocatedSize = 0;
+
+		// Both maps are keyed by the offset of the range
+		std::map<size_t, size_t> FreeRanges;
+		std::map<size_t, AllocationInfo> Allocations;
+
+		void AddFreeRange(size_t Offset, size_t Size);
+
+		static size_t AlignUp(size_t Value, size_t Alignment);
+	};
+}
@@ -0,0 +1,86 @@
+#include "ThreadPool.h"
+
+#include "Core/Profiling.h"
+
+namespace Hermes
+{
+	ThreadPool::ThreadPool(uint32 InWorkerCount)
+	{
+		Workers.reserve(InWorkerCount);
+		for (uint32 WorkerIndex = 0; WorkerIndex < InWorkerCount; WorkerIndex++)
+			Workers.emplace_back(&ThreadPool::WorkerLoop, this, WorkerIndex + 1);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard Lock(Mutex);
+			IsShuttingDown = true;
+		}
+		WorkAvailable.notify_all();
+
+		for (auto& Worker : Workers)
+			Worker.join();
+	}
+
+	void ThreadPool::ParallelFor(size_t Count, const ParallelForFunction& Function)
+	{
+		if (Count == 0)
+			return;
+
+		{
+			std::lock_guard Lock(Mutex);
+			HERMES_ASSERT(CurrentFunction == nullptr);
+
+			CurrentFunction = &Function;
+			CurrentCount = Count;
+			NextIndex = 0;
+			BusyWorkerCount = Workers.size();
+			CurrentGeneration++;
+		}
+		WorkAvailable.notify_all();
+
+		RunIterations(0);
+
+		// NOTE: every worker has to report back even if it found no work left, otherwise it could still be reading
+		//       CurrentFunction of this loop when the next one starts
+		std::unique_lock Lock(Mutex);
+		WorkFinished.wait(Lock, [this]() { return BusyWorkerCount == 0; });
+		CurrentFunction = nullptr;
+	}
+
+	uint32 ThreadPool::GetThreadCount() const
+	{
+		return static_cast<uint32>(Workers.size()) + 1;
+	}
+
+	void ThreadPool::WorkerLoop(uint32 ThreadIndex)
+	{
+		HERMES_PROFILE_THREAD("Hermes worker");
+
+		uint64 LastGeneration = 0;
+		while (true)
+		{
+			{
+				std::unique_lock Lock(Mutex);
+				WorkAvailable.wait(Lock, [&]() { return IsShuttingDown || CurrentGeneration != LastGeneration; });
+				if (IsShuttingDown)
+					return;
+				LastGeneration = CurrentGeneration;
+			}
+
+			RunIterations(ThreadIndex);
+
+			std::lock_guard Lock(Mutex);
+			if (--BusyWorkerCount == 0)
+				WorkFinished.notify_one();
+		}
+	}
+
+	void ThreadPool::RunIterations(uint32 ThreadIndex)
+	{
+		// Iterations are handed out one at a time, which balances the load when they take very different amounts of time
+		for (auto Index = NextIndex.fetch_add(1); Index < CurrentCount; Index = NextIndex.fetch_add(1))
+			(*CurrentFunction)(Index, ThreadIndex);
+	}
+}
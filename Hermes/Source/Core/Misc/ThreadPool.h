@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Core/Core.h"
+#include "Core/Misc/NonCopyableMovable.h"
+
+namespace Hermes
+{
+	/*
+	 * A fixed set of worker threads that execute the iterations of ParallelFor()
+	 *
+	 * The calling thread takes part in the work as well, so a pool without any workers simply runs the loop serially.
+	 * Only one loop can run at a time and it has to be started from the thread that owns the pool.
+	 */
+	class HERMES_API ThreadPool
+	{
+		MAKE_NON_COPYABLE(ThreadPool)
+		MAKE_NON_MOVABLE(ThreadPool)
+
+	public:
+		using ParallelForFunction = std::function<void(size_t Index, uint32 ThreadIndex)>;
+
+		explicit ThreadPool(uint32 InWorkerCount);
+
+		~ThreadPool();
+
+		/*
+		 * Calls Function for every index in range [0, Count) and returns once all calls have finished. ThreadIndex is in
+		 * range [0, GetThreadCount()) and identifies the thread that executes the call (0 is the calling thread), so it
+		 * can be used to access per-thread data without locking
+		 */
+		void ParallelFor(size_t Count, const ParallelForFunction& Function);
+
+		/*
+		 * Number of workers plus the calling thread
+		 */
+		uint32 GetThreadCount() const;
+
+	private:
+		std::vector<std::thread> Workers;
+
+		std::mutex Mutex;
+		std::condition_variable WorkAvailable;
+		std::condition_variable WorkFinished;
+
+		// All of these are protected by the mutex except for NextIndex
+		const ParallelForFunction* CurrentFunction = nullptr;
+		size_t CurrentCount = 0;
+		uint64 CurrentGeneration = 0;
+		size_t BusyWorkerCount = 0;
+		bool IsShuttingDown = false;
+
+		std::atomic<size_t> NextIndex = 0;
+
+		void WorkerLoop(uint32 ThreadIndex);
+
+		void RunIterations(uint32 ThreadIndex);
+	};
+}
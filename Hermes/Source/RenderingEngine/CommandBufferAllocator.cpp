@@ -0,0 +1,65 @@
+#include "CommandBufferAllocator.h"
+
+#include <algorithm>
+
+#include "Core/Profiling.h"
+#include "Vulkan/CommandBuffer.h"
+#include "Vulkan/CommandPool.h"
+#include "Vulkan/Queue.h"
+
+namespace Hermes
+{
+	CommandBufferAllocator::CommandBufferAllocator(uint32 InFramesInFlightCount, uint32 InThreadCount)
+		: Pools(InFramesInFlightCount, std::vector<std::vector<PoolContainer>>(InThreadCount))
+	{
+	}
+
+	CommandBufferAllocator::~CommandBufferAllocator() = default;
+
+	void CommandBufferAllocator::BeginFrame(uint32 FrameIndex)
+	{
+		HERMES_PROFILE_FUNC();
+		HERMES_ASSERT(FrameIndex < Pools.size());
+
+		CurrentFrameIndex = FrameIndex;
+		for (auto& ThreadPools : Pools[FrameIndex])
+		{
+			for (auto& Container : ThreadPools)
+			{
+				if (Container.UsedPrimaryCount == 0 && Container.UsedSecondaryCount == 0)
+					continue;
+
+				Container.Pool->Reset();
+				Container.UsedPrimaryCount = 0;
+				Container.UsedSecondaryCount = 0;
+			}
+		}
+	}
+
+	Vulkan::CommandBuffer& CommandBufferAllocator::Allocate(const Vulkan::Queue& Queue, uint32 ThreadIndex, bool IsPrimaryBuffer)
+	{
+		auto& ThreadPools = Pools[CurrentFrameIndex];
+		HERMES_ASSERT(ThreadIndex < ThreadPools.size());
+
+		auto& Containers = ThreadPools[ThreadIndex];
+		auto QueueFamilyIndex = Queue.GetQueueFamilyIndex();
+		auto ContainerIterator = std::find_if(Containers.begin(), Containers.end(), [&](const PoolContainer& Container)
+		{
+			return Container.QueueFamilyIndex == QueueFamilyIndex;
+		});
+		if (ContainerIterator == Containers.end())
+		{
+			// The pool is only ever reset as a whole and its buffers are rerecorded every frame
+			Containers.push_back({ QueueFamilyIndex, Queue.CreateCommandPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT) });
+			ContainerIterator = Containers.end() - 1;
+		}
+
+		auto& Container = *ContainerIterator;
+		auto& Buffers = IsPrimaryBuffer ? Container.PrimaryBuffers : Container.SecondaryBuffers;
+		auto& UsedCount = IsPrimaryBuffer ? Container.UsedPrimaryCount : Container.UsedSecondaryCount;
+		if (UsedCount == Buffers.size())
+			Buffers.push_back(Container.Pool->CreateCommandBuffer(IsPrimaryBuffer));
+
+		return *Buffers[UsedCount++];
+	}
+}
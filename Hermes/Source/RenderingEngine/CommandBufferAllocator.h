@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Core/Core.h"
+#include "Core/Misc/NonCopyableMovable.h"
+#include "Vulkan/Forward.h"
+#include "Vulkan/VulkanCore.h"
+
+namespace Hermes
+{
+	/*
+	 * Hands out command buffers that are only valid until the GPU has finished the frame they were allocated in
+	 *
+	 * Every frame in flight has its own set of command pools per thread and per queue family. Instead of freeing the
+	 * individual command buffers, all pools of a frame are reset at once in BeginFrame() and their command buffers
+	 * are handed out again, so no command buffers are allocated in the steady state.
+	 *
+	 * Allocate() may be called concurrently as long as every thread passes its own thread index.
+	 */
+	class HERMES_API CommandBufferAllocator
+	{
+		MAKE_NON_COPYABLE(CommandBufferAllocator)
+		MAKE_NON_MOVABLE(CommandBufferAllocator)
+
+	public:
+		CommandBufferAllocator(uint32 InFramesInFlightCount, uint32 InThreadCount);
+
+		~CommandBufferAllocator();
+
+		/*
+		 * Must be called when the GPU has finished the frame that previously used the given frame index. Resets all
+		 * command buffers that were allocated while that frame was recorded, later allocations belong to this frame
+		 */
+		void BeginFrame(uint32 FrameIndex);
+
+		/*
+		 * Returns a command buffer in the initial state for the given queue, ThreadIndex must be in range [0, thread count)
+		 */
+		Vulkan::CommandBuffer& Allocate(const Vulkan::Queue& Queue, uint32 ThreadIndex = 0, bool IsPrimaryBuffer = true);
+
+	private:
+		struct PoolContainer
+		{
+			uint32 QueueFamilyIndex;
+			std::unique_ptr<Vulkan::CommandPool> Pool;
+
+			// Buffers allocated from the pool so far, the first Used*Count of them are in use by the current frame
+			std::vector<std::unique_ptr<Vulkan::CommandBuffer>> PrimaryBuffers;
+			std::vector<std::unique_ptr<Vulkan::CommandBuffer>> SecondaryBuffers;
+			size_t UsedPrimaryCount = 0;
+			size_t UsedSecondaryCount = 0;
+		};
+
+		// Indexed by frame index, then by thread index, with one pool for every queue family that was used
+		std::vector<std::vector<std::vector<PoolContainer>>> Pools;
+
+		uint32 CurrentFrameIndex = 0;
+	};
+}
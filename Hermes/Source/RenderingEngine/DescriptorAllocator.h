@@ -25,9 +25,13 @@ namespace Hermes
 		std::vector<std::unique_ptr<Vulkan::DescriptorSetPool>> PoolList;
 
 		static constexpr uint32 DescriptorSetsPerPool = 1024;
-		static constexpr std::array<VkDescriptorPoolSize, 5> Subpools =
+		static constexpr std::array<VkDescriptorPoolSize, 9> Subpools =
 		{
 			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 * DescriptorSetsPerPool },
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * DescriptorSetsPerPool },
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 * DescriptorSetsPerPool },
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1 * DescriptorSetsPerPool },
+			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 * DescriptorSetsPerPool },
 			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1 * DescriptorSetsPerPool },
 			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 * DescriptorSetsPerPool },
 			VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_SAMPLER, 1 * DescriptorSetsPerPool },
@@ -3,6 +3,7 @@
 #include "Core/Profiling.h"
 #include "RenderingEngine/GPUInteractionUtilities.h"
 #include "RenderingEngine/Renderer.h"
+#include "Vulkan/Device.h"
 
 namespace Hermes
 {
@@ -41,6 +42,10 @@ namespace Hermes
 		Vec2ui FullGlyphSlotSize = MaxGlyphDimensions + HalfGlyphPadding * 2;
 		Vec2ui ImageDimensions = FullGlyphSlotSize * Vec2ui(GlyphCountInRow, RowCount);
 
+		// NOTE: the old image might still be sampled by the frames in flight; repacking only happens when new glyphs are
+		//       requested, so it is cheaper to wait here than to keep a copy of the pack per frame
+		Renderer::GetDevice().WaitForIdle();
+
 		FontPackImage = Renderer::GetDevice().CreateImage(ImageDimensions, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, FontPackImageFormat, 1);
 		FontPackImageView = FontPackImage->CreateDefaultImageView();
 
@@ -0,0 +1,90 @@
+#include "FrameAllocator.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "Logging/Logger.h"
+#include "RenderingEngine/Renderer.h"
+#include "Vulkan/Buffer.h"
+#include "Vulkan/Device.h"
+
+namespace Hermes
+{
+	static constexpr VkBufferUsageFlags GFrameBufferUsage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+	                                                        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+	static size_t AlignUp(size_t Value, size_t Alignment)
+	{
+		return (Value + Alignment - 1) / Alignment * Alignment;
+	}
+
+	void FrameAllocation::Flush() const
+	{
+		HERMES_ASSERT(Buffer);
+		Buffer->Flush(Offset, Size);
+	}
+
+	FrameAllocator::FrameAllocator(uint32 InFramesInFlightCount, size_t InitialCapacity)
+		: Frames(InFramesInFlightCount)
+		, MinAlignment(std::max<size_t>(Renderer::GetDevice().GetMinBufferOffsetAlignment(), 16))
+	{
+		for (auto& Frame : Frames)
+			AddBuffer(Frame, InitialCapacity);
+	}
+
+	FrameAllocator::~FrameAllocator() = default;
+
+	void FrameAllocator::BeginFrame(uint32 FrameIndex)
+	{
+		HERMES_ASSERT(FrameIndex < Frames.size());
+
+		auto& Frame = Frames[FrameIndex];
+		if (Frame.Buffers.size() > 1)
+		{
+			// NOTE: the last buffer is the largest one and it is still mapped
+			auto LargestBuffer = std::move(Frame.Buffers.back());
+			Frame.Buffers.clear();
+			Frame.Buffers.push_back(std::move(LargestBuffer));
+		}
+		Frame.UsedSize = 0;
+
+		CurrentFrameIndex = FrameIndex;
+	}
+
+	FrameAllocation FrameAllocator::Allocate(size_t Size, size_t Alignment)
+	{
+		HERMES_ASSERT(Size > 0);
+		HERMES_ASSERT(Alignment > 0);
+		// NOTE: the alignment does not have to be a power of two, e.g. for arrays of 12 byte vertices
+		Alignment = std::lcm(Alignment, MinAlignment);
+
+		auto& Frame = Frames[CurrentFrameIndex];
+		auto Offset = AlignUp(Frame.UsedSize, Alignment);
+		if (Offset + Size > Frame.Buffers.back()->GetSize())
+		{
+			auto NewCapacity = std::max(Frame.Buffers.back()->GetSize() * 2, AlignUp(Size, MinAlignment));
+			HERMES_LOG_WARNING("Frame allocator ran out of space, growing the buffer of frame %u to %zu bytes", CurrentFrameIndex, NewCapacity);
+			AddBuffer(Frame, NewCapacity);
+			Offset = 0;
+		}
+		Frame.UsedSize = Offset + Size;
+
+		FrameAllocation Result;
+		Result.Buffer = Frame.Buffers.back().get();
+		Result.Offset = static_cast<uint32>(Offset);
+		Result.Size = Size;
+		Result.Data = Frame.MappedData + Offset;
+		return Result;
+	}
+
+	const Vulkan::Buffer& FrameAllocator::GetBuffer() const
+	{
+		return *Frames[CurrentFrameIndex].Buffers.back();
+	}
+
+	void FrameAllocator::AddBuffer(FrameData& Frame, size_t Capacity) const
+	{
+		Frame.Buffers.push_back(Renderer::GetDevice().CreateBuffer(Capacity, GFrameBufferUsage, true));
+		Frame.MappedData = static_cast<uint8*>(Frame.Buffers.back()->GetMappedData());
+	}
+}
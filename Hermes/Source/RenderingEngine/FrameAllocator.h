@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "Core/Core.h"
+#include "Core/Misc/NonCopyableMovable.h"
+#include "Vulkan/Forward.h"
+
+namespace Hermes
+{
+	/*
+	 * A range of a frame allocator's buffer that is valid until the GPU has finished the frame it was allocated in
+	 */
+	struct HERMES_API FrameAllocation
+	{
+		const Vulkan::Buffer* Buffer = nullptr;
+		uint32 Offset = 0;
+		size_t Size = 0;
+
+		/*
+		 * Host pointer to the beginning of the range, Flush() must be called after writing through it
+		 */
+		uint8* Data = nullptr;
+
+		/*
+		 * Makes the data written through the host pointer visible to the GPU (only needed for non-coherent memory)
+		 */
+		void Flush() const;
+	};
+
+	/*
+	 * Linear allocator for transient data that the CPU writes once per frame and the GPU reads during the same frame
+	 * (vertices, uniform and storage buffer contents etc.)
+	 *
+	 * Every frame in flight has its own host-visible buffer that stays mapped for its whole lifetime. Allocations only
+	 * bump an offset, and the whole buffer is recycled in BeginFrame() once the GPU has finished the frame that used it
+	 * the last time. Uniform and storage buffer descriptors should use dynamic offsets, so that they can be written once
+	 * per buffer rather than once per allocation (see GetBuffer()).
+	 *
+	 * When a frame runs out of space, a larger buffer is created for the rest of that frame and it replaces the old
+	 * one the next time the frame is reused, so no buffers are created in the steady state.
+	 *
+	 * NOTE: must only be used from the render thread
+	 */
+	class HERMES_API FrameAllocator
+	{
+		MAKE_NON_COPYABLE(FrameAllocator)
+		MAKE_NON_MOVABLE(FrameAllocator)
+
+	public:
+		FrameAllocator(uint32 InFramesInFlightCount, size_t InitialCapacity);
+
+		~FrameAllocator();
+
+		/*
+		 * Must be called when the GPU has finished the frame that previously used the given frame index. All allocations
+		 * made while that frame was recorded become invalid, later allocations belong to this frame
+		 */
+		void BeginFrame(uint32 FrameIndex);
+
+		/*
+		 * The offset is always aligned to at least the minimal uniform and storage buffer offset alignment of the device
+		 */
+		FrameAllocation Allocate(size_t Size, size_t Alignment = 1);
+
+		/*
+		 * Allocates a range of the size of the data, copies the data into it and flushes it
+		 */
+		template<typename ElementType>
+		FrameAllocation Upload(std::span<const ElementType> Data, size_t Alignment = 1);
+
+		/*
+		 * Returns the buffer that the allocations of the current frame come from unless it runs out of space. Descriptors
+		 * that use dynamic offsets only need to be updated when the buffer of an allocation changes
+		 */
+		const Vulkan::Buffer& GetBuffer() const;
+
+	private:
+		struct FrameData
+		{
+			// Only the last buffer is allocated from, the other ones are released in BeginFrame()
+			std::vector<std::unique_ptr<Vulkan::Buffer>> Buffers;
+			uint8* MappedData = nullptr;
+			size_t UsedSize = 0;
+		};
+		std::vector<FrameData> Frames;
+		uint32 CurrentFrameIndex = 0;
+
+		size_t MinAlignment;
+
+		void AddBuffer(FrameData& Frame, size_t Capacity) const;
+	};
+
+	template<typename ElementType>
+	FrameAllocation FrameAllocator::Upload(std::span<const ElementType> Data, size_t Alignment)
+	{
+		auto Allocation = Allocate(Data.size_bytes(), Alignment);
+		memcpy(Allocation.Data, Data.data(), Data.size_bytes());
+		Allocation.Flush();
+		return Allocation;
+	}
+}
@@ -1,19 +1,27 @@
 ﻿#include "Graph.h"
 
 #include <algorithm>
+#include <functional>
+#include <unordered_set>
 #include <utility>
 
+#include <vulkan/vk_enum_string_helper.h>
+
 #include "Core/Profiling.h"
 #include "Logging/Logger.h"
+#include "RenderingEngine/CommandBufferAllocator.h"
 #include "RenderingEngine/Renderer.h"
 #include "RenderingEngine/FrameGraph/Resource.h"
+#include "RenderingEngine/Scene/GeometryList.h"
 #include "RenderingEngine/Scene/Scene.h"
+#include "RenderingEngine/SynchronizationPool.h"
 #include "Vulkan/Buffer.h"
-#include "Vulkan/Fence.h"
 #include "Vulkan/CommandBuffer.h"
 #include "Vulkan/Device.h"
 #include "Vulkan/Image.h"
+#include "Vulkan/MemoryBlock.h"
 #include "Vulkan/Queue.h"
+#include "Vulkan/Semaphore.h"
 
 namespace Hermes
 {
@@ -41,10 +49,101 @@ namespace Hermes
 		HERMES_ASSERT(false)
 	}
 
+	static std::pair<VkPipelineStageFlags2, VkAccessFlags2> PickStagesAndAccessForAttachment(const Attachment& Attachment, PassType Type)
+	{
+		switch (Attachment.Binding)
+		{
+		case BindingMode::DepthStencilAttachment:
+			// NOTE: the depth test reads the attachment even if it was cleared
+			return { VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+			         VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT };
+		case BindingMode::ColorAttachment:
+		{
+			VkAccessFlags2 Access = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT;
+			if (Attachment.LoadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+				Access |= VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT;
+			return { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, Access };
+		}
+		case BindingMode::SampledImage:
+			return { Type == PassType::Compute ? VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+			         VK_ACCESS_2_SHADER_SAMPLED_READ_BIT };
+		}
+		HERMES_ASSERT(false)
+	}
+
+	/*
+	 * Kahn's algorithm, the producers of every pass must be among the passes being sorted. Returns false if some passes
+	 * could not be ordered because they form a cycle or depend on one
+	 */
+	static bool SortPassesTopologically(std::vector<String> PassNames,
+	                                    const std::unordered_map<String, std::vector<String>>& Producers,
+	                                    std::vector<String>& OutPassExecutionOrder)
+	{
+		// NOTE: the passes are stored in a hash map, sorting their names keeps the execution order the same between runs
+		std::ranges::sort(PassNames);
+
+		std::unordered_map<String, size_t> UnorderedProducerCounts;
+		std::unordered_map<String, std::vector<String>> Consumers;
+		for (const auto& PassName : PassNames)
+		{
+			auto& UnorderedProducerCount = UnorderedProducerCounts[PassName];
+			auto PassProducers = Producers.find(PassName);
+			if (PassProducers == Producers.end())
+				continue;
+
+			for (const auto& ProducerName : PassProducers->second)
+			{
+				UnorderedProducerCount++;
+				Consumers[ProducerName].push_back(PassName);
+			}
+		}
+
+		OutPassExecutionOrder.clear();
+		OutPassExecutionOrder.reserve(PassNames.size());
+		for (const auto& PassName : PassNames)
+		{
+			if (UnorderedProducerCounts[PassName] == 0)
+				OutPassExecutionOrder.push_back(PassName);
+		}
+		// The passes that are already ordered serve as a queue of the passes whose consumers have to be visited
+		for (size_t PassIndex = 0; PassIndex < OutPassExecutionOrder.size(); PassIndex++)
+		{
+			for (const auto& ConsumerName : Consumers[OutPassExecutionOrder[PassIndex]])
+			{
+				if (--UnorderedProducerCounts[ConsumerName] == 0)
+					OutPassExecutionOrder.push_back(ConsumerName);
+			}
+		}
+
+		return OutPassExecutionOrder.size() == PassNames.size();
+	}
+
+	/*
+	 * Converts synchronization2 stages into the flags that semaphore waits of vkQueueSubmit() accept
+	 */
+	static VkPipelineStageFlags ConvertToLegacyPipelineStages(VkPipelineStageFlags2 Stages)
+	{
+		// NOTE: the lower 32 bits of both types have the same meaning, the stages above them are subdivisions of legacy stages
+		auto Result = static_cast<VkPipelineStageFlags>(Stages & 0xFFFFFFFF);
+		if (Stages & (VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_RESOLVE_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_CLEAR_BIT))
+			Result |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+		if (Stages & (VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT))
+			Result |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+		if (Stages & VK_PIPELINE_STAGE_2_PRE_RASTERIZATION_SHADERS_BIT)
+			Result |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT |
+				VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT | VK_PIPELINE_STAGE_GEOMETRY_SHADER_BIT;
+		return Result;
+	}
+
+	static constexpr VkAccessFlags2 WriteAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+		VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
 	void FrameGraphScheme::AddPass(const String& Name, const PassDesc& Desc)
 	{
 		HERMES_ASSERT_LOG(!Passes.contains(Name), "Trying to duplicate pass with name %s", Name.c_str());
 		Passes[Name] = Desc;
+		CachedPassExecutionOrder.reset();
 	}
 
 	void FrameGraphScheme::AddLink(const String& From, const String& To)
@@ -55,26 +154,34 @@ namespace Hermes
 
 		BackwardLinks[To] = From;
 		ForwardLinks[From] = To;
+		CachedPassExecutionOrder.reset();
 	}
 
 	void FrameGraphScheme::AddResource(const String& Name, const ImageResourceDescription& Description, bool IsExternal)
 	{
 		ImageResources.emplace_back(Name, Description, IsExternal);
+		CachedPassExecutionOrder.reset();
 	}
 
 	void FrameGraphScheme::AddResource(const String& Name, const BufferResourceDescription& Description, bool IsExternal)
 	{
 		BufferResources.emplace_back(Name, Description, IsExternal);
+		CachedPassExecutionOrder.reset();
 	}
 
 	std::unique_ptr<FrameGraph> FrameGraphScheme::Compile() const
 	{
-		if (!Validate())
+		if (!CachedPassExecutionOrder.has_value())
 		{
-			return nullptr;
+			if (!Validate())
+			{
+				return nullptr;
+			}
+
+			CachedPassExecutionOrder = ComputePassExecutionOrder();
 		}
 
-		return std::unique_ptr<FrameGraph>(new FrameGraph(*this));
+		return std::unique_ptr<FrameGraph>(new FrameGraph(*this, *CachedPassExecutionOrder));
 	}
 
 	// TODO: check that images are linked to images and buffers are linked to buffers
@@ -252,11 +359,89 @@ namespace Hermes
 			}
 		}
 
-		// TODO : add more checks (acyclic graphs, more than one component etc.)
+		// Step 3: check that there is something that produces the final image
+		if (!BackwardLinks.contains("$.FINAL_IMAGE"))
+		{
+			HERMES_LOG_ERROR("Render graph scheme does not contain link that points to a final image");
+			return false;
+		}
+
+		// Step 4: check that passes do not form a cycle, otherwise they cannot be executed in any order
+		std::vector<String> PassNames, SortedPassNames;
+		PassNames.reserve(Passes.size());
+		for (const auto& Pass : Passes)
+			PassNames.push_back(Pass.first);
+		if (!SortPassesTopologically(PassNames, CollectPassProducers(), SortedPassNames))
+		{
+			for (const auto& PassName : PassNames)
+			{
+				if (std::ranges::find(SortedPassNames, PassName) == SortedPassNames.end())
+					HERMES_LOG_ERROR("Render pass %s is a part of a cycle or depends on one", PassName.c_str());
+			}
+			return false;
+		}
+
+		// TODO : add more checks (more than one component etc.)
 
 		return true;
 	}
 
+	std::unordered_map<String, std::vector<String>> FrameGraphScheme::CollectPassProducers() const
+	{
+		std::unordered_map<String, std::vector<String>> Result;
+		for (const auto& [To, From] : BackwardLinks)
+		{
+			String ConsumerName, ConsumerAttachmentName, ProducerName, ProducerAttachmentName;
+			SplitResourceName(To, ConsumerName, ConsumerAttachmentName);
+			SplitResourceName(From, ProducerName, ProducerAttachmentName);
+
+			if (ConsumerName != "$" && ProducerName != "$")
+				Result[ConsumerName].push_back(ProducerName);
+		}
+		return Result;
+	}
+
+	std::vector<String> FrameGraphScheme::ComputePassExecutionOrder() const
+	{
+		auto Producers = CollectPassProducers();
+
+		// Step 1: find all passes that the final image depends on, directly or through other passes
+		String FinalImagePassName, Dummy;
+		SplitResourceName(BackwardLinks.at("$.FINAL_IMAGE"), FinalImagePassName, Dummy);
+
+		std::unordered_set<String> ContributingPassNames;
+		std::vector<String> PassesToVisit;
+		if (FinalImagePassName != "$")
+			PassesToVisit.push_back(FinalImagePassName);
+		while (!PassesToVisit.empty())
+		{
+			auto PassName = std::move(PassesToVisit.back());
+			PassesToVisit.pop_back();
+
+			if (!ContributingPassNames.insert(PassName).second)
+				continue;
+
+			auto PassProducers = Producers.find(PassName);
+			if (PassProducers != Producers.end())
+				PassesToVisit.insert(PassesToVisit.end(), PassProducers->second.begin(), PassProducers->second.end());
+		}
+
+		// Step 2: nothing uses the results of the other passes, so they are not executed at all
+		for (const auto& Pass : Passes)
+		{
+			if (!ContributingPassNames.contains(Pass.first))
+				HERMES_LOG_INFO("Frame graph culled render pass %s as it does not contribute to the final image", Pass.first.c_str());
+		}
+
+		// Step 3: get a linear sequence of passes where every resource for a pass is either a fresh one or was
+		//         written by a previous pass
+		std::vector<String> Result;
+		bool IsAcyclic = SortPassesTopologically({ ContributingPassNames.begin(), ContributingPassNames.end() }, Producers, Result);
+		HERMES_ASSERT(IsAcyclic);
+
+		return Result;
+	}
+
 	void FrameGraph::BindExternalResource(const String& Name, const Vulkan::Image& Image, const Vulkan::ImageView& View, VkImageLayout CurrentLayout)
 	{
 		HERMES_ASSERT(ImageResources.contains(Name) && ImageResources[Name].IsExternal);
@@ -273,6 +458,36 @@ namespace Hermes
 		BufferResources[Name].ExternalBuffer = &Buffer;
 	}
 
+	void FrameGraph::ResizeBufferResource(const String& Name, uint32 NewSize)
+	{
+		HERMES_ASSERT(BufferResources.contains(Name) && !BufferResources[Name].IsExternal);
+
+		auto& Resource = BufferResources[Name];
+		if (Resource.Desc.Size == NewSize)
+			return;
+
+		// The old buffer might still be used by the frames in flight
+		Renderer::GetDevice().WaitForIdle();
+
+		Resource.Desc.Size = NewSize;
+		if (Resource.TransientLifetime.has_value())
+		{
+			// Transient resources are only created once the viewport dimensions are known
+			if (CurrentViewportDimensions.X != 0 && CurrentViewportDimensions.Y != 0)
+				RecreateResources();
+		}
+		else
+		{
+			Resource.Buffer = Renderer::GetDevice().CreateBuffer(NewSize, TraverseBufferResourceUsageType(Name), TraverseCheckIfBufferIsMappable(Name));
+			Resource.QueueFamily = VK_QUEUE_FAMILY_IGNORED;
+		}
+	}
+
+	uint32 FrameGraph::GetBufferResourceSize(const String& Name) const
+	{
+		return BufferResources.at(Name).Desc.Size;
+	}
+
 	void FrameGraph::Execute(const Scene& Scene, const GeometryList& GeometryList, Vec2ui ViewportDimensions)
 	{
 		HERMES_PROFILE_FUNC();
@@ -285,128 +500,352 @@ namespace Hermes
 			CurrentViewportDimensions = ViewportDimensions;
 			HERMES_LOG_INFO("Frame graph viewport resized to %u x %u", ViewportDimensions.X, ViewportDimensions.Y);
 
+			// The resources that are about to be destroyed might still be used by the frames in flight
+			Renderer::GetDevice().WaitForIdle();
 			RecreateResources();
 		}
 
-		std::vector<std::unique_ptr<Vulkan::Fence>> Fences;
-		std::vector<std::unique_ptr<Vulkan::CommandBuffer>> CommandBuffers;
-		for (const auto& PassName : PassExecutionOrder)
+		for (auto& [Name, Resource] : ImageResources)
+			Resource.SyncState = {};
+		for (auto& [Name, Resource] : BufferResources)
+			Resource.SyncState = {};
+
+		auto& Device = Renderer::GetDevice();
+
+		// NOTE: the command buffers and semaphores are only reused once the GPU has finished the current frame
+		auto& CommandBufferAllocator = Renderer::GetCommandBufferAllocator();
+		auto& SynchronizationPool = Renderer::GetSynchronizationPool();
+		auto& GPUProfiler = Renderer::GetGPUProfiler();
+
+		const Vulkan::Semaphore* AsyncComputeFinishedSemaphore = nullptr;
+		bool IsFirstGraphicsBatch = true;
+		for (size_t BatchIndex = 0; BatchIndex < SubmissionBatches.size(); BatchIndex++)
 		{
-			HERMES_PROFILE_SCOPE("Hermes::FrameGraph::Execute per pass loop");
-			const auto& Pass = Passes[PassName];
+			const auto& Batch = SubmissionBatches[BatchIndex];
+			const auto& Queue = Device.GetQueue(Batch.IsAsyncCompute ? VK_QUEUE_COMPUTE_BIT : VK_QUEUE_GRAPHICS_BIT);
+			auto QueueFamily = Queue.GetQueueFamilyIndex();
 
-			VkQueueFlags QueueType = 0;
-			if (Scheme.Passes[PassName].Type == PassType::Graphics)
-				QueueType = VK_QUEUE_GRAPHICS_BIT;
-			else if (Scheme.Passes[PassName].Type == PassType::Compute)
-				QueueType = VK_QUEUE_COMPUTE_BIT;
-			auto& Queue = Renderer::GetDevice().GetQueue(QueueType);
+			auto& CommandBuffer = CommandBufferAllocator.Allocate(Queue);
+			CommandBuffer.BeginRecording();
 
-			auto CommandBuffer = Renderer::GetDevice().GetQueue(VK_QUEUE_GRAPHICS_BIT).CreateCommandBuffer();
-			CommandBuffer->BeginRecording();
+			if (!Batch.IsAsyncCompute && IsFirstGraphicsBatch)
+			{
+				// The resources of the graph are shared between all frames in flight, so the previous frame has to
+				// finish using them before the current one starts writing to them
+				VkMemoryBarrier FrameBoundaryBarrier = {};
+				FrameBoundaryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+				FrameBoundaryBarrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+				FrameBoundaryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+				CommandBuffer.InsertMemoryBarrier(FrameBoundaryBarrier, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+				IsFirstGraphicsBatch = false;
+			}
 
-			std::vector<VkImageMemoryBarrier> Barriers(Pass.ImageResourceLayouts.size());
-			size_t BarrierIndex = 0;
-			for (const auto& [ResourceName, Layout] : Pass.ImageResourceLayouts)
+			for (size_t PassIndex = Batch.Passes.First; PassIndex <= Batch.Passes.Last; PassIndex++)
 			{
-				auto& Resource = ImageResources[ResourceName];
+				HERMES_PROFILE_SCOPE("Hermes::FrameGraph::Execute per pass loop");
+				const auto& PassName = PassExecutionOrder[PassIndex];
+				const auto& Pass = Passes[PassName];
+
+				// The barriers of the pass are included in its time, they are the cost of the transitions it requires
+				auto ProfilerScope = GPUProfiler.BeginScope(CommandBuffer, Queue, PassName);
+
+				// All barriers of the pass are recorded at once, each of them only waits for the stages that actually
+				// accessed the resource before
+				std::vector<VkImageMemoryBarrier2> ImageBarriers;
+				for (const auto& Access : Pass.ImageAccesses)
+				{
+					auto& Resource = ImageResources[Access.ResourceName];
+					if (Resource.TransientLifetime.has_value() && Resource.TransientLifetime->First == PassIndex)
+					{
+						// The memory contains data of another resource, which is discarded, but whose accesses have to finish first
+						Resource.SyncState = Resource.AliasedPredecessor ? *Resource.AliasedPredecessor : ResourceSyncState{};
+						Resource.CurrentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+						Resource.QueueFamily = VK_QUEUE_FAMILY_IGNORED;
+					}
 
-				Barriers[BarrierIndex].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-				Barriers[BarrierIndex].image = Resource.GetImage().GetImage();
+					// The accesses from the other queue are already ordered before this one by a semaphore
+					auto PreviousQueueFamily = Resource.QueueFamily;
+					bool IsQueueFamilyChange = PreviousQueueFamily != VK_QUEUE_FAMILY_IGNORED && PreviousQueueFamily != QueueFamily;
+					bool IsOwnershipAcquire = IsQueueFamilyChange && !Resource.IsExternal && !Access.DiscardsContents;
+					if (IsQueueFamilyChange)
+					{
+						Resource.SyncState = {};
+						if (Access.DiscardsContents)
+							Resource.CurrentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+					}
+					Resource.QueueFamily = QueueFamily;
+
+					bool IsLayoutTransition = Resource.CurrentLayout != Access.Layout;
+					auto Scopes = TrackAccess(Resource.SyncState, Access.Stages, Access.Access, IsLayoutTransition || IsOwnershipAcquire);
+					// NOTE: the source scope of an acquire operation is ignored, the release on the other queue defines it
+					if (IsOwnershipAcquire)
+						Scopes = BarrierScopes{ VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, Access.Stages, Access.Access };
+					if (!Scopes.has_value())
+						continue;
+
+					VkImageMemoryBarrier2 Barrier = {
+						.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+						.pNext = nullptr,
+						.srcStageMask = Scopes->SourceStages,
+						.srcAccessMask = Scopes->SourceAccess,
+						.dstStageMask = Scopes->DestinationStages,
+						.dstAccessMask = Scopes->DestinationAccess,
+						.oldLayout = Resource.CurrentLayout,
+						.newLayout = Access.Layout,
+						.srcQueueFamilyIndex = IsOwnershipAcquire ? PreviousQueueFamily : VK_QUEUE_FAMILY_IGNORED,
+						.dstQueueFamilyIndex = IsOwnershipAcquire ? QueueFamily : VK_QUEUE_FAMILY_IGNORED,
+						.image = Resource.GetImage().GetImage(),
+						.subresourceRange = Resource.GetImage().GetFullSubresourceRange()
+					};
+					ImageBarriers.push_back(Barrier);
+
+					Resource.CurrentLayout = Access.Layout;
+				}
 
-				Barriers[BarrierIndex].subresourceRange = Resource.Image->GetFullSubresourceRange();
-				Barriers[BarrierIndex].oldLayout = Resource.CurrentLayout;
-				Barriers[BarrierIndex].newLayout = Layout;
+				std::vector<VkBufferMemoryBarrier2> BufferBarriers;
+				for (const auto& Access : Pass.BufferAccesses)
+				{
+					auto& Resource = BufferResources[Access.ResourceName];
+					if (Resource.TransientLifetime.has_value() && Resource.TransientLifetime->First == PassIndex)
+					{
+						Resource.SyncState = Resource.AliasedPredecessor ? *Resource.AliasedPredecessor : ResourceSyncState{};
+						Resource.QueueFamily = VK_QUEUE_FAMILY_IGNORED;
+					}
 
-				// TODO : this is a general solution that covers all required synchronization cases, but we should rather
-				// detect or require from user which types of operations would be performed and implement proper barrier
-				Barriers[BarrierIndex].srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
-				Barriers[BarrierIndex].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+					auto PreviousQueueFamily = Resource.QueueFamily;
+					bool IsQueueFamilyChange = PreviousQueueFamily != VK_QUEUE_FAMILY_IGNORED && PreviousQueueFamily != QueueFamily;
+					bool IsOwnershipAcquire = IsQueueFamilyChange && !Resource.IsExternal && !Access.DiscardsContents;
+					if (IsQueueFamilyChange)
+						Resource.SyncState = {};
+					Resource.QueueFamily = QueueFamily;
+
+					auto Scopes = TrackAccess(Resource.SyncState, Access.Stages, Access.Access, IsOwnershipAcquire);
+					if (IsOwnershipAcquire)
+						Scopes = BarrierScopes{ VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, Access.Stages, Access.Access };
+					if (!Scopes.has_value())
+						continue;
+
+					VkBufferMemoryBarrier2 Barrier = {
+						.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+						.pNext = nullptr,
+						.srcStageMask = Scopes->SourceStages,
+						.srcAccessMask = Scopes->SourceAccess,
+						.dstStageMask = Scopes->DestinationStages,
+						.dstAccessMask = Scopes->DestinationAccess,
+						.srcQueueFamilyIndex = IsOwnershipAcquire ? PreviousQueueFamily : VK_QUEUE_FAMILY_IGNORED,
+						.dstQueueFamilyIndex = IsOwnershipAcquire ? QueueFamily : VK_QUEUE_FAMILY_IGNORED,
+						.buffer = Resource.GetBuffer().GetBuffer(),
+						.offset = 0,
+						.size = VK_WHOLE_SIZE
+					};
+					BufferBarriers.push_back(Barrier);
+				}
 
-				Resource.CurrentLayout = Layout;
-				BarrierIndex++;
-			}
-			VkPipelineStageFlags ImageBarrierSourceStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
-				VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-			CommandBuffer->InsertImageMemoryBarriers({ Barriers.begin(), Barriers.end() }, ImageBarrierSourceStages,
-			                                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+				if (!ImageBarriers.empty() || !BufferBarriers.empty())
+					CommandBuffer.InsertDependency({}, BufferBarriers, ImageBarriers);
 
-			std::vector<VkBufferMemoryBarrier> BufferBarriers;
-			for (const auto& [BufferName, ResourceName] :Pass.BufferInputResourceNames)
-			{
-				const auto& Buffer = BufferResources[ResourceName];
+				std::unordered_map<String, PassResourceVariant> PassResources;
+				for (const auto& [AttachmentName, ResourceName] : Pass.ImageAttachmentResourceNames)
+				{
+					const auto& Resource = ImageResources.at(ResourceName);
+					PassResources[AttachmentName] = &Resource.GetView();
+				}
+				for (const auto& [BufferName, ResourceName] : Pass.BufferInputResourceNames)
+				{
+					const auto& Resource = BufferResources.at(ResourceName);
+					PassResources[BufferName] = &Resource.GetBuffer();
+				}
 
-				VkBufferMemoryBarrier Barrier = {};
-				Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-				Barrier.buffer = Buffer.GetBuffer().GetBuffer();
+				PassCallbackInfo CallbackInfo = {
+					.CommandBuffer = CommandBuffer,
+					.Resources = PassResources,
+					.Scene = Scene,
+					.GeometryList = GeometryList,
+					.ViewportDimensions = ViewportDimensions
+				};
 
-				// TODO : this is a general solution that covers all required synchronization cases, but we should rather
-				// detect or require from user which types of operations would be performed and implement proper barrier
-				Barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
-				Barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+				bool IsGraphicsPass = Scheme.Passes[PassName].Type == PassType::Graphics;
+				bool IsRecordedInChunks = IsGraphicsPass && Pass.ChunkCallback;
+				size_t MeshCount = GeometryList.GetMeshList().size();
 
-				Barrier.offset = 0;
-				Barrier.size = static_cast<uint32>(Buffer.GetBuffer().GetSize());
+				// Splitting a few meshes between the threads costs more than it saves. There are a few more chunks than
+				// threads so that a thread that got cheaper meshes can pick up another chunk
+				static constexpr size_t MinMeshesPerChunk = 64;
+				size_t ChunkCount = 1;
+				if (IsRecordedInChunks)
+				{
+					auto MaxChunkCount = static_cast<size_t>(Renderer::GetThreadPool().GetThreadCount()) * 2;
+					ChunkCount = std::clamp<size_t>((MeshCount + MinMeshesPerChunk - 1) / MinMeshesPerChunk, 1, MaxChunkCount);
 
-				BufferBarriers.push_back(Barrier);
-			}
+					if (Pass.Callback)
+						Pass.Callback(CallbackInfo);
+				}
+				bool IsRecordedInSecondaryBuffers = ChunkCount > 1;
 
-			// TODO: do we need more? (also see the TODO above)
-			VkPipelineStageFlags BufferBarrierSourceStages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
-			CommandBuffer->InsertBufferMemoryBarriers({ BufferBarriers.begin(), BufferBarriers.end() }, BufferBarrierSourceStages, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+				if (IsGraphicsPass)
+				{
+					VkRect2D RenderingArea = {
+						.offset = { 0, 0 },
+						.extent = { ViewportDimensions.X, ViewportDimensions.Y }
+					};
 
-			if (Scheme.Passes[PassName].Type == PassType::Graphics)
-			{
-				VkRect2D RenderingArea = {
-					.offset = { 0, 0 },
-					.extent = { ViewportDimensions.X, ViewportDimensions.Y }
-				};
+					std::vector<VkRenderingAttachmentInfo> ColorAttachmentsInfo;
+					for (const auto& [Name, Info] : Pass.ColorAttachments)
+						ColorAttachmentsInfo.push_back(Info);
 
-				std::vector<VkRenderingAttachmentInfo> ColorAttachmentsInfo;
-				for (const auto& [Name, Info] : Pass.ColorAttachments)
-					ColorAttachmentsInfo.push_back(Info);
+					auto DepthAttachmentInfo = Pass.DepthAttachment.has_value() ? std::make_optional(Pass.DepthAttachment.value().second) : std::nullopt;
+					CommandBuffer.BeginRendering(RenderingArea, ColorAttachmentsInfo, DepthAttachmentInfo, std::nullopt, IsRecordedInSecondaryBuffers);
+				}
+
+				if (IsRecordedInSecondaryBuffers)
+				{
+					auto SecondaryBuffers = RecordPassChunks(Pass, PassResources, Scene, GeometryList, ChunkCount);
+					CommandBuffer.ExecuteCommands(SecondaryBuffers);
+				}
+				else if (IsRecordedInChunks)
+				{
+					PassChunkCallbackInfo ChunkCallbackInfo = {
+						.CommandBuffer = CommandBuffer,
+						.Resources = PassResources,
+						.Scene = Scene,
+						.GeometryList = GeometryList,
+						.FirstMeshIndex = 0,
+						.MeshCount = MeshCount
+					};
+					Pass.ChunkCallback(ChunkCallbackInfo);
+				}
+				else
+				{
+					Pass.Callback(CallbackInfo);
+				}
+
+				if (IsGraphicsPass)
+				{
+					CommandBuffer.EndRendering();
+				}
 
-				auto DepthAttachmentInfo = Pass.DepthAttachment.has_value() ? std::make_optional(Pass.DepthAttachment.value().second) : std::nullopt;
-				CommandBuffer->BeginRendering(RenderingArea, ColorAttachmentsInfo, DepthAttachmentInfo, std::nullopt);
+				if (!Pass.OwnershipReleases.empty())
+				{
+					std::vector<VkImageMemoryBarrier2> ReleaseImageBarriers;
+					std::vector<VkBufferMemoryBarrier2> ReleaseBufferBarriers;
+					for (const auto& Release : Pass.OwnershipReleases)
+					{
+						// NOTE: the destination scope of a release operation is ignored, the acquire defines it
+						if (Release.IsImage)
+						{
+							const auto& Resource = ImageResources.at(Release.ResourceName);
+							ReleaseImageBarriers.push_back({
+								.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+								.pNext = nullptr,
+								.srcStageMask = Resource.SyncState.WriteStages | Resource.SyncState.ReadStages,
+								.srcAccessMask = Resource.SyncState.WriteAccess,
+								.dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+								.dstAccessMask = VK_ACCESS_2_NONE,
+								.oldLayout = Resource.CurrentLayout,
+								.newLayout = Release.NewLayout,
+								.srcQueueFamilyIndex = QueueFamily,
+								.dstQueueFamilyIndex = Release.DestinationQueueFamily,
+								.image = Resource.GetImage().GetImage(),
+								.subresourceRange = Resource.GetImage().GetFullSubresourceRange()
+							});
+						}
+						else
+						{
+							const auto& Resource = BufferResources.at(Release.ResourceName);
+							ReleaseBufferBarriers.push_back({
+								.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+								.pNext = nullptr,
+								.srcStageMask = Resource.SyncState.WriteStages | Resource.SyncState.ReadStages,
+								.srcAccessMask = Resource.SyncState.WriteAccess,
+								.dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+								.dstAccessMask = VK_ACCESS_2_NONE,
+								.srcQueueFamilyIndex = QueueFamily,
+								.dstQueueFamilyIndex = Release.DestinationQueueFamily,
+								.buffer = Resource.GetBuffer().GetBuffer(),
+								.offset = 0,
+								.size = VK_WHOLE_SIZE
+							});
+						}
+					}
+					CommandBuffer.InsertDependency({}, ReleaseBufferBarriers, ReleaseImageBarriers);
+				}
+
+				GPUProfiler.EndScope(CommandBuffer, ProfilerScope);
 			}
 
-			std::unordered_map<String, PassResourceVariant> PassResources;
-			for (const auto& [AttachmentName, ResourceName] : Pass.ImageAttachmentResourceNames)
+			CommandBuffer.EndRecording();
+
+			// NOTE: a batch that does not touch any shared resource still has to wait before the frame counts as finished,
+			//       it waits on all stages in that case as there is nothing it could overlap with anyway
+			auto WaitStages = Batch.WaitStages != 0 ? ConvertToLegacyPipelineStages(Batch.WaitStages) : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+			std::vector<Vulkan::SemaphoreWait> Waits;
+			std::vector<Vulkan::TimelineSemaphoreWait> TimelineWaits;
+			std::vector<const Vulkan::Semaphore*> Signals;
+			if (Batch.IsAsyncCompute)
 			{
-				const auto& Resource = ImageResources.at(ResourceName);
-				PassResources[AttachmentName] = &Resource.GetView();
+				// The async compute batch must not overwrite the resources that the graphics queue might still be reading
+				// in the previous frame. NOTE: the frame counter is used rather than a binary semaphore signaled by the
+				//      previous frame, which would stay signaled if the graph was recompiled or destroyed in between
+				TimelineWaits.push_back({ &Renderer::GetFrameCounterSemaphore(), Renderer::GetCurrentFrameNumber() - 1, WaitStages });
+
+				AsyncComputeFinishedSemaphore = &SynchronizationPool.AcquireFrameSemaphore();
+				Signals.push_back(AsyncComputeFinishedSemaphore);
 			}
-			for (const auto& [BufferName, ResourceName] : Pass.BufferInputResourceNames)
+			else
 			{
-				const auto& Resource = BufferResources.at(ResourceName);
-				PassResources[BufferName] = &Resource.GetBuffer();
+				if (Batch.WaitsForAsyncCompute)
+					Waits.push_back({ AsyncComputeFinishedSemaphore, WaitStages });
 			}
 
-			PassCallbackInfo CallbackInfo = {
-				.CommandBuffer = *CommandBuffer,
-				.Resources = PassResources,
-				.Scene = Scene,
-				.GeometryList = GeometryList,
-			};
+			Queue.SubmitCommandBuffer(CommandBuffer, Waits, TimelineWaits, Signals, {}, {});
+		}
+	}
 
-			Pass.Callback(CallbackInfo);
+	std::vector<const Vulkan::CommandBuffer*> FrameGraph::RecordPassChunks(
+		const PassContainer& Pass, const std::unordered_map<String, PassResourceVariant>& Resources,
+		const Scene& Scene, const GeometryList& GeometryList, size_t ChunkCount)
+	{
+		HERMES_PROFILE_FUNC();
 
-			if (Scheme.Passes[PassName].Type == PassType::Graphics)
-			{
-				CommandBuffer->EndRendering();
-			}
-			CommandBuffer->EndRecording();
+		const auto& GraphicsQueue = Renderer::GetDevice().GetQueue(VK_QUEUE_GRAPHICS_BIT);
+		auto& CommandBufferAllocator = Renderer::GetCommandBufferAllocator();
 
-			auto Fence = Renderer::GetDevice().CreateFence();
-			Queue.SubmitCommandBuffer(*CommandBuffer, Fence.get());
-			Fences.push_back(std::move(Fence));
+		// The secondary command buffers have to know the formats of the attachments they are going to render into
+		std::vector<VkFormat> ColorAttachmentFormats;
+		for (const auto& [ResourceName, Info] : Pass.ColorAttachments)
+			ColorAttachmentFormats.push_back(ImageResources.at(ResourceName).GetView().GetFormat());
+		VkFormat DepthAttachmentFormat = VK_FORMAT_UNDEFINED;
+		if (Pass.DepthAttachment.has_value())
+			DepthAttachmentFormat = ImageResources.at(Pass.DepthAttachment->first).GetView().GetFormat();
 
-			// NOTE: this way we can delay the destruction of command buffer until the end of function scope after we wait for it to finish
-			CommandBuffers.push_back(std::move(CommandBuffer));
-		}
+		size_t MeshCount = GeometryList.GetMeshList().size();
+		std::vector<const Vulkan::CommandBuffer*> SecondaryBuffers(ChunkCount);
+		Renderer::GetThreadPool().ParallelFor(ChunkCount, [&](size_t ChunkIndex, uint32 ThreadIndex)
+		{
+			HERMES_PROFILE_SCOPE("Hermes::FrameGraph::RecordPassChunks per chunk");
+
+			// Every thread allocates from its own command pools, so no locking is needed
+			auto& SecondaryBuffer = CommandBufferAllocator.Allocate(GraphicsQueue, ThreadIndex, false);
+			SecondaryBuffer.BeginRecording(ColorAttachmentFormats, DepthAttachmentFormat, VK_FORMAT_UNDEFINED);
 
-		for (const auto& Fence : Fences)
-			Fence->Wait(UINT64_MAX);
+			size_t FirstMeshIndex = MeshCount * ChunkIndex / ChunkCount;
+			size_t LastMeshIndex = MeshCount * (ChunkIndex + 1) / ChunkCount;
+			PassChunkCallbackInfo ChunkCallbackInfo = {
+				.CommandBuffer = SecondaryBuffer,
+				.Resources = Resources,
+				.Scene = Scene,
+				.GeometryList = GeometryList,
+				.FirstMeshIndex = FirstMeshIndex,
+				.MeshCount = LastMeshIndex - FirstMeshIndex
+			};
+			Pass.ChunkCallback(ChunkCallbackInfo);
+
+			SecondaryBuffer.EndRecording();
+			SecondaryBuffers[ChunkIndex] = &SecondaryBuffer;
+		});
+
+		return SecondaryBuffers;
 	}
 
 	std::pair<const Vulkan::Image*, VkImageLayout> FrameGraph::GetFinalImage() const
@@ -416,41 +855,124 @@ namespace Hermes
 		return std::make_pair(&Resource.GetImage(), Resource.CurrentLayout);
 	}
 
-	FrameGraph::FrameGraph(FrameGraphScheme InScheme)
-		: Scheme(std::move(InScheme))
+	String FrameGraph::DumpScheduleAsGraphviz() const
 	{
-		for (const auto& Resource : Scheme.ImageResources)
+		StringStream Result;
+		Result << "digraph FrameGraph\n{\n";
+		Result << "\trankdir=LR;\n";
+		Result << "\tnode [shape=record];\n";
+
+		auto WriteFlags = [&](const char* Name, uint64 Flags)
 		{
-			ImageResourceContainer Container = {};
+			Result << Name << " 0x" << std::hex << Flags << std::dec << "\\l";
+		};
 
-			Container.CurrentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			Container.Desc = Resource.Desc;
-			Container.IsExternal = Resource.IsExternal;
+		// Step 1: passes grouped by the submission they are recorded into, in the execution order
+		for (size_t BatchIndex = 0; BatchIndex < SubmissionBatches.size(); BatchIndex++)
+		{
+			const auto& Batch = SubmissionBatches[BatchIndex];
+			Result << "\tsubgraph cluster_" << BatchIndex << "\n\t{\n";
+			Result << "\t\tlabel=\"Submission " << BatchIndex << (Batch.IsAsyncCompute ? " (async compute queue)" : " (graphics queue)");
+			if (Batch.WaitsForAsyncCompute)
+				Result << ", waits for async compute (stages 0x" << std::hex << Batch.WaitStages << std::dec << ")";
+			Result << "\";\n";
+
+			for (size_t PassIndex = Batch.Passes.First; PassIndex <= Batch.Passes.Last; PassIndex++)
+			{
+				const auto& PassName = PassExecutionOrder[PassIndex];
+				const auto& Pass = Passes.at(PassName);
+				bool IsGraphicsPass = Scheme.Passes.at(PassName).Type == PassType::Graphics;
 
-			ImageResources[Resource.Name] = std::move(Container);
+				Result << "\t\t\"" << PassName << "\" [label=\"{" << PassIndex << ". " << PassName << (IsGraphicsPass ? " (graphics)" : " (compute)");
+				for (const auto& Access : Pass.ImageAccesses)
+				{
+					Result << "|" << Access.ResourceName << (Access.DiscardsContents ? " (discards contents)" : "") << "\\l";
+					Result << "layout " << string_VkImageLayout(Access.Layout) << "\\l";
+					WriteFlags("stages", Access.Stages);
+					WriteFlags("access", Access.Access);
+				}
+				for (const auto& Access : Pass.BufferAccesses)
+				{
+					Result << "|" << Access.ResourceName << (Access.DiscardsContents ? " (discards contents)" : "") << "\\l";
+					WriteFlags("stages", Access.Stages);
+					WriteFlags("access", Access.Access);
+				}
+				for (const auto& Release : Pass.OwnershipReleases)
+					Result << "|releases " << Release.ResourceName << " to queue family " << Release.DestinationQueueFamily << "\\l";
+				Result << "}\"];\n";
+			}
+			Result << "\t}\n";
 		}
 
-		for (const auto& Resource : Scheme.BufferResources)
+		// Step 2: the passes that were culled because the final image does not depend on them
+		for (const auto& Pass : Scheme.Passes)
 		{
-			BufferResourceContainer Container = {};
+			if (!Passes.contains(Pass.first))
+				Result << "\t\"" << Pass.first << "\" [label=\"" << Pass.first << " (culled)\", style=dashed];\n";
+		}
 
-			Container.Desc = Resource.Desc;
-			Container.IsExternal = Resource.IsExternal;
+		// Step 3: the resources, those that were culled are not created
+		for (const auto& Resource : Scheme.ImageResources)
+		{
+			auto Container = ImageResources.find(Resource.Name);
+			Result << "\t\"$." << Resource.Name << "\" [shape=ellipse, label=\"" << Resource.Name << "\\n" << string_VkFormat(Resource.Desc.Format);
+			if (Container == ImageResources.end())
+				Result << "\\nculled\", style=dashed];\n";
+			else if (Container->second.IsExternal)
+				Result << "\\nexternal\"];\n";
+			else if (Container->second.TransientLifetime.has_value())
+				Result << "\\ntransient in passes " << Container->second.TransientLifetime->First << "-" << Container->second.TransientLifetime->Last << "\"];\n";
+			else
+				Result << "\"];\n";
+		}
+		for (const auto& Resource : Scheme.BufferResources)
+		{
+			auto Container = BufferResources.find(Resource.Name);
+			Result << "\t\"$." << Resource.Name << "\" [shape=ellipse, label=\"" << Resource.Name << "\\n" << Resource.Desc.Size << " bytes";
+			if (Container == BufferResources.end())
+				Result << "\\nculled\", style=dashed];\n";
+			else if (Container->second.IsExternal)
+				Result << "\\nexternal\"];\n";
+			else if (Container->second.TransientLifetime.has_value())
+				Result << "\\ntransient in passes " << Container->second.TransientLifetime->First << "-" << Container->second.TransientLifetime->Last << "\"];\n";
+			else
+				Result << "\"];\n";
+		}
+		Result << "\t\"$.FINAL_IMAGE\" [shape=doubleoctagon, label=\"FINAL_IMAGE\"];\n";
 
-			if (!Resource.IsExternal)
-				Container.Buffer = Renderer::GetDevice().CreateBuffer(Resource.Desc.Size, TraverseBufferResourceUsageType(Resource.Name), TraverseCheckIfBufferIsMappable(Resource.Name));
+		// Step 4: the links, sorted because they are stored in a hash map. Only BackwardLinks has all of them as an
+		//         output can be linked to multiple inputs
+		std::vector<std::pair<String, String>> Links(Scheme.BackwardLinks.begin(), Scheme.BackwardLinks.end());
+		std::ranges::sort(Links);
+		for (const auto& [To, From] : Links)
+		{
+			String FromPassName, FromAttachmentName, ToPassName, ToAttachmentName;
+			SplitResourceName(From, FromPassName, FromAttachmentName);
+			SplitResourceName(To, ToPassName, ToAttachmentName);
 
-			BufferResources[Resource.Name] = std::move(Container);
+			Result << "\t\"" << (FromPassName == "$" ? From : FromPassName) << "\" -> \"" << (ToPassName == "$" ? To : ToPassName) << "\"";
+			Result << " [label=\"" << ToAttachmentName << "\"];\n";
 		}
 
-		for (const auto& [PassName, PassDesc] : Scheme.Passes)
+		Result << "}\n";
+		return Result.str();
+	}
+
+	FrameGraph::FrameGraph(FrameGraphScheme InScheme, std::vector<String> InPassExecutionOrder)
+		: Scheme(std::move(InScheme))
+		, PassExecutionOrder(std::move(InPassExecutionOrder))
+	{
+		std::unordered_set<String> UsedResourceNames;
+		for (const auto& PassName : PassExecutionOrder)
 		{
+			const auto& PassDesc = Scheme.Passes.at(PassName);
 			PassContainer NewPassContainer = {};
 			NewPassContainer.Callback = PassDesc.Callback;
+			NewPassContainer.ChunkCallback = PassDesc.ChunkCallback;
 
 			// TODO : clean this code up
 			NewPassContainer.ClearColors.reserve(PassDesc.Attachments.size());
-			NewPassContainer.ImageResourceLayouts.reserve(PassDesc.Attachments.size());
+			NewPassContainer.ImageAccesses.reserve(PassDesc.Attachments.size());
 			for (const auto& Attachment : PassDesc.Attachments)
 			{
 				String FullResourceName = TraverseResourceName(PassName + "." + Attachment.Name);
@@ -477,9 +999,12 @@ namespace Hermes
 					NewPassContainer.DepthAttachment = std::make_pair(ResourceOwnName, AttachmentInfo);
 
 				NewPassContainer.ClearColors.push_back(Attachment.ClearColor);
-				NewPassContainer.ImageResourceLayouts.emplace_back(ResourceOwnName, PickImageLayoutForBindingMode(Attachment.Binding));
+				auto [Stages, Access] = PickStagesAndAccessForAttachment(Attachment, PassDesc.Type);
+				bool DiscardsContents = Attachment.Binding != BindingMode::SampledImage && Attachment.LoadOp != VK_ATTACHMENT_LOAD_OP_LOAD;
+				NewPassContainer.ImageAccesses.push_back({ ResourceOwnName, PickImageLayoutForBindingMode(Attachment.Binding), Stages, Access, DiscardsContents });
 
 				NewPassContainer.ImageAttachmentResourceNames.emplace_back(Attachment.Name, ResourceOwnName);
+				UsedResourceNames.insert(ResourceOwnName);
 			}
 
 			for (const auto& BufferInput : PassDesc.BufferInputs)
@@ -490,6 +1015,9 @@ namespace Hermes
 				SplitResourceName(FullResourceName, Dummy, ResourceOwnName);
 
 				NewPassContainer.BufferInputResourceNames.emplace_back(BufferInput.Name, ResourceOwnName);
+				bool DiscardsContents = (BufferInput.Access & ~WriteAccessMask) == 0;
+				NewPassContainer.BufferAccesses.push_back({ ResourceOwnName, BufferInput.Stages, BufferInput.Access, DiscardsContents });
+				UsedResourceNames.insert(ResourceOwnName);
 			}
 
 			Passes[PassName] = std::move(NewPassContainer);
@@ -501,72 +1029,53 @@ namespace Hermes
 		String DummyDollarSign;
 		SplitResourceName(FinalImageResource, DummyDollarSign, FinalImageResourceName);
 
-		// NOTE : topological sort to get a linear sequence of render passes where every resource for render pass
-		//        is either fresh image or was generated by a previous render pass
+		// The resources that none of the executed passes access are culled together with the passes. The external ones
+		// are kept so that binding them does not depend on what was culled
+		auto IsResourceUsed = [&](const auto& Resource)
+		{
+			if (Resource.IsExternal || UsedResourceNames.contains(Resource.Name) || Resource.Name == FinalImageResourceName)
+				return true;
 
-		// Step 1: make a copy of the graph
-		auto LocalForwardLinks = Scheme.ForwardLinks;
-		auto LocalPasses = Scheme.Passes;
+			HERMES_LOG_INFO("Frame graph culled resource %s as no executed render pass uses it", Resource.Name.c_str());
+			return false;
+		};
 
-		// Step 2: remove any links from and to the '$' render pass
-		for (auto Link = LocalForwardLinks.begin(); Link != LocalForwardLinks.end();)
+		for (const auto& Resource : Scheme.ImageResources)
 		{
-			if (Link->first.starts_with("$.") || Link->second.starts_with("$."))
-			{
-				Link = LocalForwardLinks.erase(Link);
-			}
-			else
-			{
-				++Link;
-			}
+			if (!IsResourceUsed(Resource))
+				continue;
+
+			ImageResourceContainer Container = {};
+
+			Container.CurrentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			Container.Desc = Resource.Desc;
+			Container.IsExternal = Resource.IsExternal;
+
+			ImageResources[Resource.Name] = std::move(Container);
 		}
 
-		// Step 3: until there is at least one pass left untouched
-		while (!LocalPasses.empty())
+		for (const auto& Resource : Scheme.BufferResources)
 		{
-			// Step 3.1: iterate over all untouched passes
-			for (auto CurrentPass = LocalPasses.begin(); CurrentPass != LocalPasses.end();)
-			{
-				// Step 3.2: check if this pass does not have any outgoing links
-				bool HasOutgoingConnections = false;
-				for (const auto& Link : LocalForwardLinks)
-				{
-					if (Link.first.starts_with(CurrentPass->first + "."))
-					{
-						HasOutgoingConnections = true;
-						break;
-					}
-				}
+			if (!IsResourceUsed(Resource))
+				continue;
 
-				if (!HasOutgoingConnections)
-				{
-					// If it does not have any outgoing links then:
+			BufferResourceContainer Container = {};
 
-					// 1. Add this pass to the beginning of the pass execution order list then:
-					PassExecutionOrder.insert(PassExecutionOrder.begin(), CurrentPass->first);
+			Container.Desc = Resource.Desc;
+			Container.IsExternal = Resource.IsExternal;
 
-					// 2. Remove all links that point to it
-					for (auto Link = LocalForwardLinks.begin(); Link != LocalForwardLinks.end();)
-					{
-						if (Link->second.starts_with(CurrentPass->first + "."))
-						{
-							Link = LocalForwardLinks.erase(Link);
-						}
-						else
-						{
-							++Link;
-						}
-					}
+			BufferResources[Resource.Name] = std::move(Container);
+		}
 
-					// And remove it from the local graph copy
-					CurrentPass = LocalPasses.erase(CurrentPass);
-				}
-				else
-				{
-					// Otherwise keep iterating
-					++CurrentPass;
-				}
-			}
+		ScheduleSubmissions();
+		ComputeTransientLifetimes();
+		PlanQueueOwnershipTransfers();
+
+		// Transient resources are created together with the images that depend on the viewport dimensions
+		for (auto& [Name, Resource] : BufferResources)
+		{
+			if (!Resource.IsExternal && !Resource.TransientLifetime.has_value())
+				Resource.Buffer = Renderer::GetDevice().CreateBuffer(Resource.Desc.Size, TraverseBufferResourceUsageType(Name), TraverseCheckIfBufferIsMappable(Name));
 		}
 	}
 
@@ -702,16 +1211,73 @@ namespace Hermes
 		return Resource.Desc.Format;
 	}
 
+	void FrameGraph::ComputeTransientLifetimes()
+	{
+		std::unordered_map<String, PassRange> ImageLifetimes, BufferLifetimes;
+		std::unordered_set<String> PersistentImages, PersistentBuffers;
+		for (size_t PassIndex = 0; PassIndex < PassExecutionOrder.size(); PassIndex++)
+		{
+			const auto& Pass = Passes[PassExecutionOrder[PassIndex]];
+
+			// A resource whose first use in the frame reads its contents depends on the data from the previous frame
+			for (const auto& Access : Pass.ImageAccesses)
+			{
+				// NOTE: aliasing barriers cannot order the accesses of different queues, so the resources used by the
+				//       async compute passes get their own memory
+				if (Pass.IsAsyncCompute)
+					PersistentImages.insert(Access.ResourceName);
+
+				auto [It, IsFirstUse] = ImageLifetimes.try_emplace(Access.ResourceName, PassRange{ PassIndex, PassIndex });
+				It->second.Last = PassIndex;
+				if (IsFirstUse && !Access.DiscardsContents)
+					PersistentImages.insert(Access.ResourceName);
+			}
+			for (const auto& Access : Pass.BufferAccesses)
+			{
+				if (Pass.IsAsyncCompute)
+					PersistentBuffers.insert(Access.ResourceName);
+				auto [It, IsFirstUse] = BufferLifetimes.try_emplace(Access.ResourceName, PassRange{ PassIndex, PassIndex });
+				It->second.Last = PassIndex;
+				if (IsFirstUse && !Access.DiscardsContents)
+					PersistentBuffers.insert(Access.ResourceName);
+			}
+		}
+
+		for (auto& [Name, Lifetime] : ImageLifetimes)
+		{
+			auto& Resource = ImageResources.at(Name);
+			if (Resource.IsExternal || PersistentImages.contains(Name))
+				continue;
+
+			// The final image is used by the caller after all passes have finished
+			if (Name == FinalImageResourceName)
+				Lifetime.Last = PassExecutionOrder.size();
+			Resource.TransientLifetime = Lifetime;
+		}
+
+		for (const auto& [Name, Lifetime] : BufferLifetimes)
+		{
+			auto& Resource = BufferResources.at(Name);
+			if (Resource.IsExternal || PersistentBuffers.contains(Name) || TraverseCheckIfBufferIsMappable(Name))
+				continue;
+
+			Resource.TransientLifetime = Lifetime;
+		}
+	}
+
 	void FrameGraph::RecreateResources()
 	{
+		CreateTransientResources();
+
 		for (auto& Resource : ImageResources)
 		{
-			if (Resource.second.Desc.Dimensions.IsRelative() && !Resource.second.IsExternal)
+			if (Resource.second.Desc.Dimensions.IsRelative() && !Resource.second.IsExternal && !Resource.second.TransientLifetime.has_value())
 			{
 				Resource.second.Image = Renderer::GetDevice().CreateImage(Resource.second.Desc.Dimensions.GetAbsoluteDimensions(CurrentViewportDimensions), TraverseImageResourceUsageType(Resource.first), Resource.second.Desc.Format, Resource.second.Desc.MipLevels);
 				Resource.second.View = Resource.second.Image->CreateDefaultImageView();
 
 				Resource.second.CurrentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				Resource.second.QueueFamily = VK_QUEUE_FAMILY_IGNORED;
 			}
 		}
 
@@ -732,6 +1298,351 @@ namespace Hermes
 		}
 	}
 
+	void FrameGraph::CreateTransientResources()
+	{
+		auto& Device = Renderer::GetDevice();
+
+		// NOTE: the old resources have to be destroyed before the memory blocks that they are placed into
+		for (auto& [Name, Resource] : ImageResources)
+		{
+			if (!Resource.TransientLifetime.has_value())
+				continue;
+			Resource.View.reset();
+			Resource.Image.reset();
+		}
+		for (auto& [Name, Resource] : BufferResources)
+		{
+			if (Resource.TransientLifetime.has_value())
+				Resource.Buffer.reset();
+		}
+		TransientMemoryBlocks.clear();
+
+		struct AliasingCandidate
+		{
+			ImageResourceContainer* Image = nullptr;
+			BufferResourceContainer* Buffer = nullptr;
+			Vec2ui Dimensions = {};
+			VkFlags Usage = 0;
+			VkMemoryRequirements Requirements = {};
+			PassRange Lifetime = {};
+		};
+		std::vector<AliasingCandidate> Candidates;
+		for (auto& [Name, Resource] : ImageResources)
+		{
+			if (!Resource.TransientLifetime.has_value())
+				continue;
+
+			auto Dimensions = Resource.Desc.Dimensions.GetAbsoluteDimensions(CurrentViewportDimensions);
+			auto Usage = TraverseImageResourceUsageType(Name);
+			auto Requirements = Device.GetImageMemoryRequirements(Dimensions, Usage, Resource.Desc.Format, Resource.Desc.MipLevels);
+			Candidates.push_back({ &Resource, nullptr, Dimensions, Usage, Requirements, Resource.TransientLifetime.value() });
+		}
+		for (auto& [Name, Resource] : BufferResources)
+		{
+			if (!Resource.TransientLifetime.has_value())
+				continue;
+
+			auto Usage = TraverseBufferResourceUsageType(Name);
+			auto Requirements = Device.GetBufferMemoryRequirements(Resource.Desc.Size, Usage);
+			Candidates.push_back({ nullptr, &Resource, {}, Usage, Requirements, Resource.TransientLifetime.value() });
+		}
+
+		// NOTE: greedy interval packing; placing the largest resources first keeps the blocks close to the size of the
+		//       largest resource that they contain
+		std::ranges::sort(Candidates, std::greater{}, [](const AliasingCandidate& Candidate) { return Candidate.Requirements.size; });
+
+		struct BlockLayout
+		{
+			VkMemoryRequirements Requirements;
+			std::vector<const AliasingCandidate*> Residents;
+		};
+		std::vector<BlockLayout> Blocks;
+		for (const auto& Candidate : Candidates)
+		{
+			auto OverlapsWithCandidate = [&](const AliasingCandidate* Resident)
+			{
+				return Candidate.Lifetime.First <= Resident->Lifetime.Last && Resident->Lifetime.First <= Candidate.Lifetime.Last;
+			};
+			auto Block = std::ranges::find_if(Blocks, [&](const BlockLayout& Layout)
+			{
+				return (Layout.Requirements.memoryTypeBits & Candidate.Requirements.memoryTypeBits) != 0 &&
+				       std::ranges::none_of(Layout.Residents, OverlapsWithCandidate);
+			});
+
+			if (Block == Blocks.end())
+			{
+				Blocks.push_back({ Candidate.Requirements, {} });
+				Block = std::prev(Blocks.end());
+			}
+			else
+			{
+				Block->Requirements.size = std::max(Block->Requirements.size, Candidate.Requirements.size);
+				Block->Requirements.alignment = std::max(Block->Requirements.alignment, Candidate.Requirements.alignment);
+				Block->Requirements.memoryTypeBits &= Candidate.Requirements.memoryTypeBits;
+			}
+			Block->Residents.push_back(&Candidate);
+		}
+
+		VkDeviceSize TotalResourceSize = 0, TotalBlockSize = 0;
+		for (auto& Block : Blocks)
+		{
+			const auto& Memory = *TransientMemoryBlocks.emplace_back(Device.AllocateMemory(Block.Requirements));
+			TotalBlockSize += Memory.GetSize();
+
+			// Every resident has to wait for the accesses of the one that used the memory before it in the frame
+			std::ranges::sort(Block.Residents, {}, [](const AliasingCandidate* Resident) { return Resident->Lifetime.First; });
+			const ResourceSyncState* Predecessor = nullptr;
+			for (const auto* Resident : Block.Residents)
+			{
+				if (Resident->Image)
+				{
+					auto& Resource = *Resident->Image;
+					Resource.Image = Device.CreateAliasingImage(Memory, Resident->Dimensions, Resident->Usage, Resource.Desc.Format, Resource.Desc.MipLevels);
+					Resource.View = Resource.Image->CreateDefaultImageView();
+					Resource.CurrentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+					Resource.QueueFamily = VK_QUEUE_FAMILY_IGNORED;
+					Resource.AliasedPredecessor = Predecessor;
+					Predecessor = &Resource.SyncState;
+				}
+				else
+				{
+					auto& Resource = *Resident->Buffer;
+					Resource.Buffer = Device.CreateAliasingBuffer(Memory, Resource.Desc.Size, Resident->Usage);
+					Resource.QueueFamily = VK_QUEUE_FAMILY_IGNORED;
+					Resource.AliasedPredecessor = Predecessor;
+					Predecessor = &Resource.SyncState;
+				}
+				TotalResourceSize += Resident->Requirements.size;
+			}
+		}
+
+		HERMES_LOG_INFO("Frame graph placed %zu transient resources (%llu bytes) into %zu memory blocks (%llu bytes)", Candidates.size(),
+		                static_cast<unsigned long long>(TotalResourceSize), Blocks.size(), static_cast<unsigned long long>(TotalBlockSize));
+	}
+
+	void FrameGraph::ScheduleSubmissions()
+	{
+		auto& Device = Renderer::GetDevice();
+		// NOTE: if the device has no dedicated compute queue family the compute queue is the graphics queue itself
+		bool IsAsyncComputeAvailable = Device.GetQueue(VK_QUEUE_COMPUTE_BIT).GetQueueFamilyIndex() !=
+		                               Device.GetQueue(VK_QUEUE_GRAPHICS_BIT).GetQueueFamilyIndex();
+
+		String FinalImagePassName, Dummy;
+		SplitResourceName(Scheme.BackwardLinks.at("$.FINAL_IMAGE"), FinalImagePassName, Dummy);
+
+		// Step 1: find all passes that every pass depends on, directly or through other passes
+		std::unordered_map<String, std::unordered_set<String>> Dependencies;
+		for (const auto& PassName : PassExecutionOrder)
+		{
+			const auto& PassDesc = Scheme.Passes.at(PassName);
+			auto& PassDependencies = Dependencies[PassName];
+
+			auto AddProducer = [&](const String& InputName)
+			{
+				auto Link = Scheme.BackwardLinks.find(PassName + "." + InputName);
+				if (Link == Scheme.BackwardLinks.end())
+					return;
+
+				String ProducerName, ProducerOutputName;
+				SplitResourceName(Link->second, ProducerName, ProducerOutputName);
+				if (ProducerName == "$")
+					return;
+
+				// The producer precedes this pass in the execution order, so its own dependencies are already known
+				PassDependencies.insert(ProducerName);
+				PassDependencies.insert(Dependencies[ProducerName].begin(), Dependencies[ProducerName].end());
+			};
+			for (const auto& Attachment : PassDesc.Attachments)
+				AddProducer(Attachment.Name);
+			for (const auto& BufferInput : PassDesc.BufferInputs)
+				AddProducer(BufferInput.Name);
+		}
+
+		// Step 2: a compute pass whose inputs come only from the external resources or from other async compute passes
+		//         can run on the async compute queue. It is only worth it if there is a graphics pass that does not
+		//         depend on it and can overlap with it
+		std::vector<String> AsyncComputePassNames;
+		for (const auto& PassName : PassExecutionOrder)
+		{
+			if (!IsAsyncComputeAvailable || Scheme.Passes.at(PassName).Type != PassType::Compute || PassName == FinalImagePassName)
+				continue;
+
+			bool DependsOnGraphicsQueue = std::ranges::any_of(Dependencies[PassName], [&](const String& Dependency)
+			{
+				return !Passes[Dependency].IsAsyncCompute;
+			});
+			if (DependsOnGraphicsQueue)
+				continue;
+
+			bool HasIndependentGraphicsWork = std::ranges::any_of(PassExecutionOrder, [&](const String& OtherPassName)
+			{
+				return Scheme.Passes.at(OtherPassName).Type == PassType::Graphics && !Dependencies[OtherPassName].contains(PassName);
+			});
+			if (!HasIndependentGraphicsWork)
+				continue;
+
+			Passes[PassName].IsAsyncCompute = true;
+			AsyncComputePassNames.push_back(PassName);
+		}
+
+		// Step 3: the async compute passes do not depend on anything that runs on the graphics queue, so they can be
+		//         moved to the front without breaking the topological order
+		std::ranges::stable_partition(PassExecutionOrder, [&](const String& PassName) { return Passes[PassName].IsAsyncCompute; });
+
+		// Step 4: the graphics queue has to wait for the async compute work before the first pass that uses any of its
+		//         results or writes to anything it reads. Reads of the external resources (e.g. the scene data written
+		//         by the host) can happen on both queues at the same time
+		std::unordered_map<String, VkAccessFlags2> AsyncComputeImageAccess, AsyncComputeBufferAccess;
+		for (const auto& PassName : AsyncComputePassNames)
+		{
+			for (const auto& Access : Passes[PassName].ImageAccesses)
+				AsyncComputeImageAccess[Access.ResourceName] |= Access.Access;
+			for (const auto& Access : Passes[PassName].BufferAccesses)
+				AsyncComputeBufferAccess[Access.ResourceName] |= Access.Access;
+		}
+		auto ConflictsWithAsyncCompute = [](const auto& AsyncComputeAccess, const String& ResourceName, VkAccessFlags2 Access, bool IsExternal)
+		{
+			auto It = AsyncComputeAccess.find(ResourceName);
+			return It != AsyncComputeAccess.end() && (!IsExternal || ((It->second | Access) & WriteAccessMask) != 0);
+		};
+
+		SubmissionBatches.clear();
+		bool IsAsyncComputeWaitedFor = AsyncComputePassNames.empty();
+		for (size_t PassIndex = 0; PassIndex < PassExecutionOrder.size(); PassIndex++)
+		{
+			const auto& Pass = Passes[PassExecutionOrder[PassIndex]];
+
+			// The async compute batch waits for the previous frame before it touches anything, the graphics batch only
+			// before the stages that use the results of async compute or overwrite what it reads
+			bool HasConflictingAccess = false;
+			VkPipelineStageFlags2 ConflictingStages = 0;
+			for (const auto& Access : Pass.ImageAccesses)
+			{
+				if (Pass.IsAsyncCompute || ConflictsWithAsyncCompute(AsyncComputeImageAccess, Access.ResourceName, Access.Access, ImageResources.at(Access.ResourceName).IsExternal))
+				{
+					HasConflictingAccess = true;
+					ConflictingStages |= Access.Stages;
+				}
+			}
+			for (const auto& Access : Pass.BufferAccesses)
+			{
+				if (Pass.IsAsyncCompute || ConflictsWithAsyncCompute(AsyncComputeBufferAccess, Access.ResourceName, Access.Access, BufferResources.at(Access.ResourceName).IsExternal))
+				{
+					HasConflictingAccess = true;
+					ConflictingStages |= Access.Stages;
+				}
+			}
+
+			bool WaitsForAsyncCompute = !Pass.IsAsyncCompute && !IsAsyncComputeWaitedFor && HasConflictingAccess;
+			if (SubmissionBatches.empty() || SubmissionBatches.back().IsAsyncCompute != Pass.IsAsyncCompute || WaitsForAsyncCompute)
+				SubmissionBatches.push_back({ Pass.IsAsyncCompute, { PassIndex, PassIndex }, WaitsForAsyncCompute, 0 });
+			SubmissionBatches.back().Passes.Last = PassIndex;
+			IsAsyncComputeWaitedFor |= WaitsForAsyncCompute;
+
+			// NOTE: the waiting graphics batch lasts until the end of the frame, so the later passes that use the results
+			//       of async compute are covered by its semaphore wait only if their stages are included as well
+			if (SubmissionBatches.back().IsAsyncCompute || SubmissionBatches.back().WaitsForAsyncCompute)
+				SubmissionBatches.back().WaitStages |= ConflictingStages;
+		}
+
+		// The pass producing the final image runs on the graphics queue, so the last batch always does. The renderer
+		// considers the frame finished once this batch is, so it has to wait for the async compute work in any case
+		HERMES_ASSERT(!SubmissionBatches.back().IsAsyncCompute);
+		if (!IsAsyncComputeWaitedFor)
+			SubmissionBatches.back().WaitsForAsyncCompute = true;
+
+		if (!AsyncComputePassNames.empty())
+			HERMES_LOG_INFO("Frame graph runs %zu passes on the async compute queue in %zu submissions", AsyncComputePassNames.size(), SubmissionBatches.size());
+	}
+
+	void FrameGraph::PlanQueueOwnershipTransfers()
+	{
+		auto& Device = Renderer::GetDevice();
+		auto ComputeQueueFamily = Device.GetQueue(VK_QUEUE_COMPUTE_BIT).GetQueueFamilyIndex();
+		auto GraphicsQueueFamily = Device.GetQueue(VK_QUEUE_GRAPHICS_BIT).GetQueueFamilyIndex();
+
+		struct ResourceUse
+		{
+			PassContainer* Pass;
+			uint32 QueueFamily;
+			bool DiscardsContents;
+			VkImageLayout Layout;
+		};
+		std::unordered_map<String, std::vector<ResourceUse>> ImageUses, BufferUses;
+		for (const auto& PassName : PassExecutionOrder)
+		{
+			auto& Pass = Passes[PassName];
+			auto QueueFamily = Pass.IsAsyncCompute ? ComputeQueueFamily : GraphicsQueueFamily;
+
+			for (const auto& Access : Pass.ImageAccesses)
+				ImageUses[Access.ResourceName].push_back({ &Pass, QueueFamily, Access.DiscardsContents, Access.Layout });
+			for (const auto& Access : Pass.BufferAccesses)
+				BufferUses[Access.ResourceName].push_back({ &Pass, QueueFamily, Access.DiscardsContents, VK_IMAGE_LAYOUT_UNDEFINED });
+		}
+
+		// NOTE: the external resources belong to their owners, the graph only transfers the resources it creates
+		auto PlanReleases = [](const String& ResourceName, bool IsImage, const std::vector<ResourceUse>& Uses)
+		{
+			// The use that follows the last one in the frame is the first one in the next frame
+			for (size_t Index = 0; Index < Uses.size(); Index++)
+			{
+				const auto& Current = Uses[Index];
+				const auto& Next = Uses[(Index + 1) % Uses.size()];
+				if (Current.QueueFamily != Next.QueueFamily && !Next.DiscardsContents)
+					Current.Pass->OwnershipReleases.push_back({ ResourceName, IsImage, Next.QueueFamily, Next.Layout });
+			}
+		};
+		for (const auto& [Name, Uses] : ImageUses)
+		{
+			if (!ImageResources.at(Name).IsExternal)
+				PlanReleases(Name, true, Uses);
+		}
+		for (const auto& [Name, Uses] : BufferUses)
+		{
+			if (!BufferResources.at(Name).IsExternal)
+				PlanReleases(Name, false, Uses);
+		}
+	}
+
+	std::optional<FrameGraph::BarrierScopes> FrameGraph::TrackAccess(ResourceSyncState& State, VkPipelineStageFlags2 Stages,
+	                                                                 VkAccessFlags2 Access, bool IsLayoutTransition)
+	{
+		if (!IsLayoutTransition && (Access & WriteAccessMask) == 0)
+		{
+			// Reads only have to wait for the last write, and only once per stage and access type
+			bool IsAlreadyVisible = (Stages & ~State.VisibleStages) == 0 && (Access & ~State.VisibleAccess) == 0;
+			State.ReadStages |= Stages;
+			if (State.WriteStages == VK_PIPELINE_STAGE_2_NONE || IsAlreadyVisible)
+				return {};
+
+			State.VisibleStages |= Stages;
+			State.VisibleAccess |= Access;
+			return BarrierScopes{ State.WriteStages, State.WriteAccess, Stages, Access };
+		}
+
+		// Writes and layout transitions wait for the last write and for all reads since then, the reads only need
+		// an execution dependency
+		BarrierScopes Result = { State.WriteStages | State.ReadStages, State.WriteAccess, Stages, Access };
+
+		State.WriteStages = Stages;
+		State.WriteAccess = Access & WriteAccessMask;
+		State.ReadStages = VK_PIPELINE_STAGE_2_NONE;
+		State.VisibleStages = Stages;
+		State.VisibleAccess = Access;
+
+		if (Result.SourceStages == VK_PIPELINE_STAGE_2_NONE)
+		{
+			// First access in this frame, the previous frames are already synchronized with
+			if (!IsLayoutTransition)
+				return {};
+
+			// NOTE: the layout transition must not start before the barrier at the beginning of the frame, which is
+			//       only guaranteed if the execution dependencies form a chain
+			Result.SourceStages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		}
+		return Result;
+	}
+
 	const Vulkan::Image& FrameGraph::ImageResourceContainer::GetImage() const
 	{
 		if (IsExternal)
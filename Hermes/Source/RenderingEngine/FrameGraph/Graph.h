@@ -1,7 +1,9 @@
 ﻿#pragma once
 
 #include <memory>
+#include <optional>
 #include <unordered_map>
+#include <vector>
 
 #include "Core/Core.h"
 #include "RenderingEngine/FrameGraph/Pass.h"
@@ -25,6 +27,10 @@ namespace Hermes
 
 		void AddResource(const String& Name, const BufferResourceDescription& Description, bool IsExternal);
 
+		/*
+		 * Validates the scheme and creates a frame graph that only contains the passes and the resources that the final
+		 * image depends on. The pass execution order is cached and reused by the next calls until the scheme is modified
+		 */
 		std::unique_ptr<FrameGraph> Compile() const;
 
 	private:
@@ -53,7 +59,21 @@ namespace Hermes
 		std::unordered_map<String, String> ForwardLinks;
 		std::unordered_map<String, String> BackwardLinks;
 
+		// Empty if Compile() was not called yet or the scheme was modified after the last call
+		mutable std::optional<std::vector<String>> CachedPassExecutionOrder;
+
 		bool Validate() const;
+
+		/*
+		 * Returns the names of the passes that each pass reads the results of, a pass appears once for every link
+		 */
+		std::unordered_map<String, std::vector<String>> CollectPassProducers() const;
+
+		/*
+		 * Orders the passes that contribute to the final image so that every pass runs after all passes it depends on.
+		 * The scheme must be valid (and thus acyclic)
+		 */
+		std::vector<String> ComputePassExecutionOrder() const;
 	};
 
 	class HERMES_API FrameGraph
@@ -66,6 +86,14 @@ namespace Hermes
 
 		void BindExternalResource(const String& Name, const Vulkan::Buffer& Buffer);
 
+		/*
+		 * Replaces a buffer created by the graph with one of the new size, the contents are not preserved
+		 * NOTE: waits until the GPU is idle, so should not be called every frame
+		 */
+		void ResizeBufferResource(const String& Name, uint32 NewSize);
+
+		uint32 GetBufferResourceSize(const String& Name) const;
+
 		void Execute(const Scene& Scene, const GeometryList& GeometryList, Vec2ui ViewportDimensions);
 
 		/*
@@ -74,10 +102,16 @@ namespace Hermes
 		 */
 		std::pair<const Vulkan::Image*, VkImageLayout> GetFinalImage() const;
 
+		/*
+		 * Returns the compiled schedule in the Graphviz DOT format: the passes grouped by submission batch in the
+		 * execution order, the resources they access with the layouts, stages and access flags, and the culled passes
+		 */
+		String DumpScheduleAsGraphviz() const;
+
 	private:
 		friend class FrameGraphScheme;
 
-		explicit FrameGraph(FrameGraphScheme InScheme);
+		FrameGraph(FrameGraphScheme InScheme, std::vector<String> InPassExecutionOrder);
 
 		String TraverseResourceName(const String& FullAttachmentName);
 
@@ -89,10 +123,72 @@ namespace Hermes
 
 		VkFormat TraverseAttachmentDataFormat(const String& AttachmentName) const;
 
+		/*
+		 * Finds resources that can share memory with other resources because all their uses are confined to a range of
+		 * passes and their contents do not have to survive between frames
+		 */
+		void ComputeTransientLifetimes();
+
 		void RecreateResources();
 
+		void CreateTransientResources();
+
+		/*
+		 * Moves the compute passes that do not depend on any graphics work to the async compute queue and splits the
+		 * execution order into submission batches
+		 */
+		void ScheduleSubmissions();
+
+		/*
+		 * Finds the accesses after which a resource has to be released to another queue family because its next access
+		 * (possibly in the next frame) runs on a queue of that family and needs the contents of the resource
+		 */
+		void PlanQueueOwnershipTransfers();
+
 		FrameGraphScheme Scheme;
 
+		// NOTE: declared before the resources so that it is destroyed after the resources that are placed into it
+		std::vector<std::unique_ptr<Vulkan::MemoryBlock>> TransientMemoryBlocks;
+
+		// Inclusive range of indices into PassExecutionOrder
+		struct PassRange
+		{
+			size_t First;
+			size_t Last;
+		};
+
+		/*
+		 * Tracks the accesses to a resource within the current frame. Accesses from the previous frames are already
+		 * ordered by the barrier at the beginning of the frame, so the state starts empty every frame
+		 */
+		struct ResourceSyncState
+		{
+			// The last write (or layout transition) that the following accesses have to wait for
+			VkPipelineStageFlags2 WriteStages = VK_PIPELINE_STAGE_2_NONE;
+			VkAccessFlags2 WriteAccess = VK_ACCESS_2_NONE;
+
+			// All reads since the last write, the next write has to wait for them
+			VkPipelineStageFlags2 ReadStages = VK_PIPELINE_STAGE_2_NONE;
+
+			// Reads that are already synchronized with the last write and do not need another barrier
+			VkPipelineStageFlags2 VisibleStages = VK_PIPELINE_STAGE_2_NONE;
+			VkAccessFlags2 VisibleAccess = VK_ACCESS_2_NONE;
+		};
+
+		struct BarrierScopes
+		{
+			VkPipelineStageFlags2 SourceStages;
+			VkAccessFlags2 SourceAccess;
+			VkPipelineStageFlags2 DestinationStages;
+			VkAccessFlags2 DestinationAccess;
+		};
+
+		/*
+		 * Records an access in the sync state and returns the barrier that must precede it, if any
+		 */
+		static std::optional<BarrierScopes> TrackAccess(ResourceSyncState& State, VkPipelineStageFlags2 Stages,
+		                                                VkAccessFlags2 Access, bool IsLayoutTransition);
+
 		struct ImageResourceContainer
 		{
 			std::unique_ptr<Vulkan::Image> Image;
@@ -102,9 +198,16 @@ namespace Hermes
 			const Vulkan::ImageView* ExternalView = nullptr;
 
 			VkImageLayout CurrentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			ResourceSyncState SyncState;
+			// Queue family of the last access, VK_QUEUE_FAMILY_IGNORED if the contents are undefined
+			uint32 QueueFamily = VK_QUEUE_FAMILY_IGNORED;
 			ImageResourceDescription Desc;
 			bool IsExternal = false;
 
+			std::optional<PassRange> TransientLifetime;
+			// The resource that used the same memory earlier in the frame, its accesses have to finish before this one starts
+			const ResourceSyncState* AliasedPredecessor = nullptr;
+
 			const Vulkan::Image& GetImage() const;
 			const Vulkan::ImageView& GetView() const;
 		};
@@ -115,9 +218,14 @@ namespace Hermes
 			std::unique_ptr<Vulkan::Buffer> Buffer;
 			const Vulkan::Buffer* ExternalBuffer = nullptr;
 
+			ResourceSyncState SyncState;
+			uint32 QueueFamily = VK_QUEUE_FAMILY_IGNORED;
 			BufferResourceDescription Desc;
 			bool IsExternal = false;
 
+			std::optional<PassRange> TransientLifetime;
+			const ResourceSyncState* AliasedPredecessor = nullptr;
+
 			const Vulkan::Buffer& GetBuffer() const;
 		};
 		std::unordered_map<String, BufferResourceContainer> BufferResources;
@@ -128,18 +236,76 @@ namespace Hermes
 			std::vector<std::pair<String, VkRenderingAttachmentInfo>> ColorAttachments;
 			std::optional<std::pair<String, VkRenderingAttachmentInfo>> DepthAttachment;
 
-			// Pair of resource name and its layout at the start of render pass
-			std::vector<std::pair<String, VkImageLayout>> ImageResourceLayouts;
+			struct ImageAccess
+			{
+				String ResourceName;
+				// Layout the image must be in during the pass
+				VkImageLayout Layout;
+				VkPipelineStageFlags2 Stages;
+				VkAccessFlags2 Access;
+				// True if the pass overwrites the whole image without reading its previous contents
+				bool DiscardsContents;
+			};
+			std::vector<ImageAccess> ImageAccesses;
+
+			struct BufferAccess
+			{
+				String ResourceName;
+				VkPipelineStageFlags2 Stages;
+				VkAccessFlags2 Access;
+				// True if the pass only writes to the buffer
+				bool DiscardsContents;
+			};
+			std::vector<BufferAccess> BufferAccesses;
+
+			struct QueueOwnershipRelease
+			{
+				String ResourceName;
+				bool IsImage;
+				uint32 DestinationQueueFamily;
+				// The release and the acquire must specify the same layout transition
+				VkImageLayout NewLayout;
+			};
+			// Recorded after the pass, the acquire is recorded by the pass that accesses the resource next
+			std::vector<QueueOwnershipRelease> OwnershipReleases;
+
+			// Compute passes that do not depend on any graphics work run on the async compute queue
+			bool IsAsyncCompute = false;
 
 			std::vector<std::pair<String, String>> ImageAttachmentResourceNames;
 			std::vector<std::pair<String, String>> BufferInputResourceNames;
 
 			std::vector<VkClearValue> ClearColors;
 			PassDesc::PassCallbackType Callback;
+			PassDesc::PassChunkCallbackType ChunkCallback;
 		};
 		std::unordered_map<String, PassContainer> Passes;
 
 		std::vector<String> PassExecutionOrder;
+
+		/*
+		 * Consecutive passes that run on the same queue are recorded into a single command buffer and submitted
+		 * together. The async compute passes are executed first, the graphics queue only waits for them in the batch
+		 * that starts with the first pass using their results
+		 */
+		struct SubmissionBatch
+		{
+			bool IsAsyncCompute;
+			PassRange Passes;
+			bool WaitsForAsyncCompute;
+			// Stages of the batch that access resources shared with the other queue, the semaphore wait of the batch
+			// only blocks these. Zero if the batch waits for async compute only to finish the frame after it
+			VkPipelineStageFlags2 WaitStages;
+		};
+		std::vector<SubmissionBatch> SubmissionBatches;
+
+		/*
+		 * Records the chunk callback of a graphics pass for ChunkCount ranges of the mesh list in parallel and returns
+		 * the secondary command buffers that must be executed inside the rendering instance of the pass in order
+		 */
+		std::vector<const Vulkan::CommandBuffer*> RecordPassChunks(
+			const PassContainer& Pass, const std::unordered_map<String, PassResourceVariant>& Resources,
+			const Scene& Scene, const GeometryList& GeometryList, size_t ChunkCount);
 		
 		String FinalImageResourceName;
 
@@ -5,6 +5,7 @@
 #include <variant>
 
 #include "Core/Core.h"
+#include "Math/Vector2.h"
 #include "Vulkan/Forward.h"
 
 namespace Hermes
@@ -31,17 +32,44 @@ namespace Hermes
 
 		const Scene& Scene;
 		const GeometryList& GeometryList;
+
+		Vec2ui ViewportDimensions;
+	};
+
+	/*
+	 * Describes a range of meshes of the geometry list that must be recorded into the given command buffer
+	 */
+	struct PassChunkCallbackInfo
+	{
+		Vulkan::CommandBuffer& CommandBuffer;
+
+		const std::unordered_map<String, PassResourceVariant>& Resources;
+
+		const Scene& Scene;
+		const GeometryList& GeometryList;
+
+		size_t FirstMeshIndex;
+		size_t MeshCount;
 	};
 
 	struct PassDesc
 	{
 		using PassCallbackType = std::function<void(const PassCallbackInfo&)>;
+		using PassChunkCallbackType = std::function<void(const PassChunkCallbackInfo&)>;
 
 		std::vector<Attachment> Attachments;
 		std::vector<BufferInput> BufferInputs;
 
 		PassCallbackType Callback;
 
+		/*
+		 * Optional, only for graphics passes. If set, the mesh list is split into chunks that are recorded in parallel
+		 * on the worker threads of the renderer, each into its own secondary command buffer. Callback is then called
+		 * on the render thread before the rendering begins (so it must not record any draw commands) and has to do all
+		 * the work that is not thread-safe (descriptor set updates, pipeline creation etc.) for all meshes
+		 */
+		PassChunkCallbackType ChunkCallback;
+
 		PassType Type = PassType::Graphics;
 	};
 }
@@ -49,6 +49,10 @@ namespace Hermes
 		uint32 Size = 0;
 	};
 
+	/*
+	 * The pipeline stages and access types of an image attachment are derived from its binding mode, the type of the pass
+	 * and the load operation
+	 */
 	enum class BindingMode
 	{
 		SampledImage,
@@ -70,5 +74,10 @@ namespace Hermes
 		String Name;
 		VkBufferUsageFlags Usage = 0;
 		bool RequiresMapping = false;
+
+		// Pipeline stages in which the pass accesses the buffer and the types of these accesses, the frame graph derives
+		// the barriers between passes from them
+		VkPipelineStageFlags2 Stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		VkAccessFlags2 Access = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
 	};
 }
@@ -40,7 +40,7 @@ namespace Hermes
 		CommandBuffer->InsertImageMemoryBarrier(Barrier, SourceStage, DestinationStage);
 
 		CommandBuffer->EndRecording();
-		auto Fence = Renderer::GetDevice().CreateFence();
+		auto Fence = Renderer::GetSynchronizationPool().AcquireFence();
 		Queue.SubmitCommandBuffer(*CommandBuffer, Fence.get());
 		Fence->Wait(UINT64_MAX);
 	}
@@ -53,19 +53,15 @@ namespace Hermes
 		auto& CurrentStagingBuffer = EnsureStagingBuffer();
 		auto& TransferQueue = Device.GetQueue(VK_QUEUE_TRANSFER_BIT);
 		auto TransferCommandBuffer = TransferQueue.CreateCommandBuffer(true);
-		auto TransferFinishedFence = Device.CreateFence(true);
+		auto TransferFinishedFence = Renderer::GetSynchronizationPool().AcquireFence();
 		HERMES_ASSERT(TargetOffset + DataSize <= Target.GetSize())
 
 		for (size_t DataOffset = 0; DataOffset < DataSize; DataOffset += CurrentStagingBuffer.GetSize())
 		{
 			size_t NumBytesToCopy = Math::Min(DataSize - DataOffset, CurrentStagingBuffer.GetSize());
 
-			auto* MappedBufferData = CurrentStagingBuffer.Map();
-			memcpy(MappedBufferData, static_cast<const uint8*>(Data) + DataOffset, NumBytesToCopy);
-			CurrentStagingBuffer.Unmap();
-
-			TransferFinishedFence->Wait(UINT64_MAX);
-			TransferFinishedFence->Reset();
+			memcpy(CurrentStagingBuffer.GetMappedData(), static_cast<const uint8*>(Data) + DataOffset, NumBytesToCopy);
+			CurrentStagingBuffer.Flush(0, NumBytesToCopy);
 
 			TransferCommandBuffer->BeginRecording();
 			VkBufferCopy Copy;
@@ -77,6 +73,7 @@ namespace Hermes
 
 			TransferQueue.SubmitCommandBuffer(*TransferCommandBuffer, TransferFinishedFence.get());
 			TransferFinishedFence->Wait(UINT64_MAX);
+			TransferFinishedFence->Reset();
 		}
 	}
 
@@ -92,7 +89,7 @@ namespace Hermes
 		auto& CurrentStagingBuffer = EnsureStagingBuffer();
 		auto& TransferQueue = Device.GetQueue(VK_QUEUE_TRANSFER_BIT);
 		auto TransferCommandBuffer = TransferQueue.CreateCommandBuffer(true);
-		auto TransferFinishedFence = Device.CreateFence(true);
+		auto TransferFinishedFence = Renderer::GetSynchronizationPool().AcquireFence();
 
 		HERMES_ASSERT(Offset.X + Dimensions.X <= Destination.GetDimensions().X);
 		HERMES_ASSERT(Offset.Y + Dimensions.Y <= Destination.GetDimensions().Y);
@@ -106,11 +103,10 @@ namespace Hermes
 		{
 			uint32 RowsToCopy = std::min(RowsPerSingleTransfer, Dimensions.Y - Row);
 
-			auto* Memory = CurrentStagingBuffer.Map();
 			size_t OffsetIntoSourceData = static_cast<size_t>(Row) * Dimensions.X * BytesPerPixel;
 			const void* CurrentDataPointer = static_cast<const uint8*>(Data) + OffsetIntoSourceData;
-			memcpy(Memory, CurrentDataPointer, RowsToCopy * BytesPerRow);
-			CurrentStagingBuffer.Unmap();
+			memcpy(CurrentStagingBuffer.GetMappedData(), CurrentDataPointer, RowsToCopy * BytesPerRow);
+			CurrentStagingBuffer.Flush(0, RowsToCopy * BytesPerRow);
 
 			TransferCommandBuffer->BeginRecording();
 
@@ -276,7 +272,7 @@ namespace Hermes
 		                                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
 
 		CommandBuffer->EndRecording();
-		auto FinishFence = Device.CreateFence();
+		auto FinishFence = Renderer::GetSynchronizationPool().AcquireFence();
 		Queue.SubmitCommandBuffer(*CommandBuffer, FinishFence.get());
 		FinishFence->Wait(UINT64_MAX);
 	}
@@ -324,7 +320,7 @@ namespace Hermes
 		CommandBuffer->InsertImageMemoryBarrier(AfterClearBarrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
 
 		CommandBuffer->EndRecording();
-		auto Fence = Renderer::GetDevice().CreateFence();
+		auto Fence = Renderer::GetSynchronizationPool().AcquireFence();
 		Queue.SubmitCommandBuffer(*CommandBuffer, Fence.get());
 		Fence->Wait(UINT64_MAX);
 	}
@@ -0,0 +1,145 @@
+#include "GPUProfiler.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Core/Profiling.h"
+#include "RenderingEngine/Renderer.h"
+#include "Vulkan/CommandBuffer.h"
+#include "Vulkan/Device.h"
+#include "Vulkan/QueryPool.h"
+#include "Vulkan/Queue.h"
+
+#ifdef HERMES_ENABLE_PROFILING
+#include <tracy/TracyVulkan.hpp>
+#endif
+
+namespace Hermes
+{
+	GPUProfiler::GPUProfiler(uint32 InFramesInFlightCount)
+		: Frames(InFramesInFlightCount)
+	{
+		auto& Device = Renderer::GetDevice();
+		TimestampPeriod = Device.GetTimestampPeriod();
+
+		for (auto& Frame : Frames)
+		{
+			Frame.QueryPool = Device.CreateQueryPool(VK_QUERY_TYPE_TIMESTAMP, MaxScopesPerFrame * 2);
+			Frame.Scopes.reserve(MaxScopesPerFrame);
+		}
+
+#ifdef HERMES_ENABLE_PROFILING
+		OpenTracyScopes.resize(MaxScopesPerFrame);
+		for (auto [QueueType, ContextName] : { std::pair{ VK_QUEUE_GRAPHICS_BIT, "Graphics queue" }, std::pair{ VK_QUEUE_COMPUTE_BIT, "Compute queue" } })
+		{
+			const auto& Queue = Device.GetQueue(QueueType);
+			bool HasContext = std::ranges::any_of(TracyContexts, [&](const TracyContext& Context)
+			{
+				return Context.QueueFamilyIndex == Queue.GetQueueFamilyIndex();
+			});
+			if (HasContext || Queue.GetTimestampValidBits() == 0)
+				continue;
+
+			// NOTE: Tracy records and submits the command buffer itself to calibrate the GPU clock and waits for the queue to become idle
+			auto CommandBuffer = Queue.CreateCommandBuffer();
+			auto* Context = TracyVkContext(Device.GetPhysicalDevice(), Device.GetDevice(), Queue.GetQueue(), CommandBuffer->GetBuffer());
+			TracyVkContextName(Context, ContextName, static_cast<uint16>(std::strlen(ContextName)));
+			TracyContexts.push_back({ Queue.GetQueueFamilyIndex(), Context, false });
+		}
+#endif
+	}
+
+	GPUProfiler::~GPUProfiler()
+	{
+#ifdef HERMES_ENABLE_PROFILING
+		for (const auto& Context : TracyContexts)
+			TracyVkDestroy(Context.Context);
+#endif
+	}
+
+	void GPUProfiler::BeginFrame(uint32 FrameIndex)
+	{
+		HERMES_PROFILE_FUNC();
+
+		CurrentFrameIndex = FrameIndex;
+		auto& Frame = Frames[FrameIndex];
+
+#ifdef HERMES_ENABLE_PROFILING
+		for (auto& Context : TracyContexts)
+			Context.IsCollected = false;
+#endif
+
+		// NOTE: the frame might be retried without recording anything if the swapchain image could not be acquired
+		if (Frame.Scopes.empty())
+			return;
+
+		auto QueryCount = static_cast<uint32>(Frame.Scopes.size() * 2);
+		Timestamps.resize(QueryCount);
+		if (Frame.QueryPool->GetResults(0, Timestamps))
+		{
+			LastFrameTimings.resize(Frame.Scopes.size());
+			for (size_t ScopeIndex = 0; ScopeIndex < Frame.Scopes.size(); ScopeIndex++)
+			{
+				auto& Scope = Frame.Scopes[ScopeIndex];
+				uint64 Ticks = (Timestamps[ScopeIndex * 2 + 1] - Timestamps[ScopeIndex * 2]) & Scope.TimestampMask;
+
+				LastFrameTimings[ScopeIndex].Name = std::move(Scope.Name);
+				LastFrameTimings[ScopeIndex].Milliseconds = static_cast<float>(static_cast<double>(Ticks) * TimestampPeriod / 1'000'000.0);
+			}
+		}
+
+		Frame.QueryPool->Reset(0, QueryCount);
+		Frame.Scopes.clear();
+	}
+
+	uint32 GPUProfiler::BeginScope(Vulkan::CommandBuffer& CommandBuffer, const Vulkan::Queue& Queue, const String& Name)
+	{
+		auto& Frame = Frames[CurrentFrameIndex];
+
+		auto ValidBits = Queue.GetTimestampValidBits();
+		if (ValidBits == 0 || Frame.Scopes.size() == MaxScopesPerFrame)
+			return InvalidScopeIndex;
+
+		auto ScopeIndex = static_cast<uint32>(Frame.Scopes.size());
+		Frame.Scopes.push_back({ Name, ValidBits >= 64 ? UINT64_MAX : (1ull << ValidBits) - 1 });
+
+		// NOTE: both timestamps wait for all previous commands, so the time of the commands that overlap with the previous
+		//       scope is not counted twice
+		CommandBuffer.WriteTimestamp(*Frame.QueryPool, ScopeIndex * 2, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+
+#ifdef HERMES_ENABLE_PROFILING
+		auto Context = std::ranges::find(TracyContexts, Queue.GetQueueFamilyIndex(), &TracyContext::QueueFamilyIndex);
+		if (Context != TracyContexts.end())
+		{
+			if (!Context->IsCollected)
+			{
+				TracyVkCollect(Context->Context, CommandBuffer.GetBuffer());
+				Context->IsCollected = true;
+			}
+			OpenTracyScopes[ScopeIndex] = std::make_unique<tracy::VkCtxScope>(
+				Context->Context, __LINE__, __FILE__, std::strlen(__FILE__), __func__, std::strlen(__func__),
+				Name.c_str(), Name.size(), CommandBuffer.GetBuffer(), true);
+		}
+#endif
+
+		return ScopeIndex;
+	}
+
+	void GPUProfiler::EndScope(Vulkan::CommandBuffer& CommandBuffer, uint32 ScopeIndex)
+	{
+		if (ScopeIndex == InvalidScopeIndex)
+			return;
+
+		CommandBuffer.WriteTimestamp(*Frames[CurrentFrameIndex].QueryPool, ScopeIndex * 2 + 1, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+
+#ifdef HERMES_ENABLE_PROFILING
+		// NOTE: the destructor writes the end timestamp of the zone into the command buffer that the scope was created with
+		OpenTracyScopes[ScopeIndex].reset();
+#endif
+	}
+
+	std::span<const GPUProfiler::ScopeTiming> GPUProfiler::GetLastFrameTimings() const
+	{
+		return LastFrameTimings;
+	}
+}
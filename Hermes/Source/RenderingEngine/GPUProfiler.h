@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "Core/Core.h"
+#include "Core/Misc/NonCopyableMovable.h"
+#include "Vulkan/Forward.h"
+#include "Vulkan/VulkanCore.h"
+
+#ifdef HERMES_ENABLE_PROFILING
+namespace tracy
+{
+	class VkCtx;
+	class VkCtxScope;
+}
+#endif
+
+namespace Hermes
+{
+	/*
+	 * Measures the time the GPU spends on scopes of commands, e.g. on the passes of the frame graph
+	 *
+	 * Every frame in flight has its own timestamp query pool. The results of a frame are read in BeginFrame() once the
+	 * GPU has finished that frame, so reading them never stalls, but they lag behind the frame that is being recorded.
+	 * When profiling is enabled the scopes are also sent to Tracy as GPU zones.
+	 */
+	class HERMES_API GPUProfiler
+	{
+		MAKE_NON_COPYABLE(GPUProfiler)
+		MAKE_NON_MOVABLE(GPUProfiler)
+
+	public:
+		struct ScopeTiming
+		{
+			String Name;
+			float Milliseconds;
+		};
+
+		explicit GPUProfiler(uint32 InFramesInFlightCount);
+
+		~GPUProfiler();
+
+		/*
+		 * Must be called when the GPU has finished the frame that previously used the given frame index, reads the
+		 * timings of that frame
+		 */
+		void BeginFrame(uint32 FrameIndex);
+
+		/*
+		 * Writes a timestamp once the previously recorded commands have finished and returns the index of the scope
+		 * to pass to EndScope() after the commands of the scope were recorded into the same command buffer. Must only
+		 * be called from the render thread and not inside a rendering instance
+		 */
+		uint32 BeginScope(Vulkan::CommandBuffer& CommandBuffer, const Vulkan::Queue& Queue, const String& Name);
+
+		void EndScope(Vulkan::CommandBuffer& CommandBuffer, uint32 ScopeIndex);
+
+		/*
+		 * Returns the GPU time of every scope of the last frame whose results were read, in the order the scopes began
+		 */
+		std::span<const ScopeTiming> GetLastFrameTimings() const;
+
+	private:
+		static constexpr uint32 MaxScopesPerFrame = 64;
+		// Returned when the queue cannot write timestamps or the frame has too many scopes, EndScope() ignores it
+		static constexpr uint32 InvalidScopeIndex = UINT32_MAX;
+
+		struct Scope
+		{
+			String Name;
+			// The timestamps of the queue may have fewer than 64 valid bits, so their difference has to be masked
+			uint64 TimestampMask;
+		};
+
+		struct FrameQueries
+		{
+			// Scope with index I writes queries 2 * I at the beginning and 2 * I + 1 at the end
+			std::unique_ptr<Vulkan::QueryPool> QueryPool;
+			std::vector<Scope> Scopes;
+		};
+		std::vector<FrameQueries> Frames;
+		uint32 CurrentFrameIndex = 0;
+
+		float TimestampPeriod = 0.0f;
+		std::vector<uint64> Timestamps;
+		std::vector<ScopeTiming> LastFrameTimings;
+
+#ifdef HERMES_ENABLE_PROFILING
+		struct TracyContext
+		{
+			uint32 QueueFamilyIndex;
+			tracy::VkCtx* Context;
+			// Tracy reads its queries with a command recorded once per frame before the first zone on the queue
+			bool IsCollected;
+		};
+		std::vector<TracyContext> TracyContexts;
+		// Indexed by the scope index, a Tracy zone ends when its scope object is destroyed
+		std::vector<std::unique_ptr<tracy::VkCtxScope>> OpenTracyScopes;
+#endif
+	};
+}
@@ -0,0 +1,313 @@
+#include "LightClustering.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+	#include <xmmintrin.h>
+	#define HERMES_LIGHT_CLUSTERING_USE_SSE 1
+#else
+	#define HERMES_LIGHT_CLUSTERING_USE_SSE 0
+#endif
+
+namespace Hermes
+{
+	static uint32 GetXYClusterCount(const SceneData& SceneData)
+	{
+		return SceneData.NumberOfXYClusters.X * SceneData.NumberOfXYClusters.Y;
+	}
+
+	// Converts a point on the near plane given in framebuffer coordinates into view space
+	static Vec3 ScreenSpaceToViewSpace(Vec2 FramebufferCoordinates, const SceneData& SceneData)
+	{
+		Vec2 NormalizedCoordinates = FramebufferCoordinates / SceneData.ScreenDimensions * 2.0f - 1.0f;
+		Vec4 ClipSpaceCoordinates = { NormalizedCoordinates.X, NormalizedCoordinates.Y, 1.0f, 1.0f };
+
+		auto ViewSpaceCoordinates = SceneData.InverseProjection * ClipSpaceCoordinates;
+		return Vec3(ViewSpaceCoordinates.X, ViewSpaceCoordinates.Y, ViewSpaceCoordinates.Z) / ViewSpaceCoordinates.W;
+	}
+
+	static Vec3 ScaleToViewDepth(Vec3 PointOnRay, float ViewDepth)
+	{
+		return PointOnRay * (ViewDepth / -PointOnRay.Z);
+	}
+
+	/*
+	 * View space light spheres stored as a structure of arrays, padded to a multiple of LightsPerBatch with lights that
+	 * never intersect anything
+	 */
+	struct ViewSpaceLightList
+	{
+		static constexpr size_t LightsPerBatch = 4;
+
+		std::vector<float> X;
+		std::vector<float> Y;
+		std::vector<float> Z;
+		std::vector<float> RadiusSq;
+	};
+
+	static ViewSpaceLightList TransformLightsToViewSpace(std::span<const PointLight> Lights, const Mat4& ViewMatrix)
+	{
+		size_t PaddedLightCount = (Lights.size() + ViewSpaceLightList::LightsPerBatch - 1) / ViewSpaceLightList::LightsPerBatch *
+			ViewSpaceLightList::LightsPerBatch;
+
+		ViewSpaceLightList Result;
+		Result.X.resize(PaddedLightCount, 0.0f);
+		Result.Y.resize(PaddedLightCount, 0.0f);
+		Result.Z.resize(PaddedLightCount, 0.0f);
+		// NOTE: squared distance is never negative, so the padding fails the intersection test
+		Result.RadiusSq.resize(PaddedLightCount, -1.0f);
+
+		for (size_t LightIndex = 0; LightIndex < Lights.size(); LightIndex++)
+		{
+			const auto& Light = Lights[LightIndex];
+			auto ViewSpacePosition = ViewMatrix * Vec4(Light.Position.X, Light.Position.Y, Light.Position.Z, 1.0f);
+
+			Result.X[LightIndex] = ViewSpacePosition.X;
+			Result.Y[LightIndex] = ViewSpacePosition.Y;
+			Result.Z[LightIndex] = ViewSpacePosition.Z;
+			Result.RadiusSq[LightIndex] = Light.Position.W * Light.Position.W;
+		}
+
+		return Result;
+	}
+
+	/*
+	 * Same approach as light_cluster_marking.glsl: every column of clusters gets a mask of the Z slices that contain at
+	 * least one pixel, which is much cheaper than a flag per cluster. Only the pixels of the given rows of clusters are read
+	 */
+	static void MarkUsedZSlices(std::span<const float> DepthBuffer, const SceneData& SceneData, uint32 FirstClusterRow, uint32 LastClusterRow,
+	                            std::span<uint32> UsedZSlices)
+	{
+		HERMES_ASSERT(SceneData.NumberOfZClusters <= 32);
+
+		auto Dimensions = static_cast<Vec2ui>(SceneData.ScreenDimensions);
+		auto ClusterSize = static_cast<Vec2ui>(SceneData.MaxPixelsPerLightCluster);
+		HERMES_ASSERT(DepthBuffer.size() == static_cast<size_t>(Dimensions.X) * Dimensions.Y);
+
+		// NOTE: the last row of clusters also takes any pixels that are past it, the same way ComputeClusterIndex() clamps them
+		uint32 FirstPixelRow = Math::Min(FirstClusterRow * ClusterSize.Y, Dimensions.Y);
+		uint32 LastPixelRow = LastClusterRow == SceneData.NumberOfXYClusters.Y ? Dimensions.Y : Math::Min(LastClusterRow * ClusterSize.Y, Dimensions.Y);
+		for (uint32 Y = FirstPixelRow; Y < LastPixelRow; Y++)
+		{
+			uint32 ClusterY = Math::Min(Y / ClusterSize.Y, SceneData.NumberOfXYClusters.Y - 1);
+			for (uint32 X = 0; X < Dimensions.X; X++)
+			{
+				float Depth = DepthBuffer[static_cast<size_t>(Y) * Dimensions.X + X];
+
+				// Reverse-Z depth buffer is cleared to 0, so these pixels are not covered by any geometry
+				if (Depth == 0.0f)
+					continue;
+
+				uint32 ClusterX = Math::Min(X / ClusterSize.X, SceneData.NumberOfXYClusters.X - 1);
+				uint32 ClusterZ = LightClustering::ComputeClusterZSlice(LightClustering::LinearizeDepth(Depth, SceneData.CameraZBounds), SceneData);
+				UsedZSlices[ClusterX + ClusterY * SceneData.NumberOfXYClusters.X] |= 1u << ClusterZ;
+			}
+		}
+	}
+
+	static std::vector<uint32> CollectActiveClusters(std::span<const uint32> UsedZSlices, const SceneData& SceneData)
+	{
+		uint32 XYClusterCount = GetXYClusterCount(SceneData);
+
+		// Going slice by slice gives the indices in ascending order
+		std::vector<uint32> Result;
+		for (uint32 ClusterZ = 0; ClusterZ < SceneData.NumberOfZClusters; ClusterZ++)
+		{
+			for (uint32 IndexInSlice = 0; IndexInSlice < XYClusterCount; IndexInSlice++)
+			{
+				if (UsedZSlices[IndexInSlice] & (1u << ClusterZ))
+					Result.push_back(ClusterZ * XYClusterCount + IndexInSlice);
+			}
+		}
+		return Result;
+	}
+
+	// NOTE: must do the same floating point operations in the same order as DoesLightIntersectCluster(), otherwise the
+	//       results could differ for lights that barely touch a cluster
+	static void AssignLightsToCluster(const ViewSpaceLightList& Lights, const LightClusterBounds& Bounds, std::span<uint32> ClusterMasks)
+	{
+		std::ranges::fill(ClusterMasks, 0u);
+
+#if HERMES_LIGHT_CLUSTERING_USE_SSE
+		auto MinX = _mm_set1_ps(Bounds.MinCorner.X), MaxX = _mm_set1_ps(Bounds.MaxCorner.X);
+		auto MinY = _mm_set1_ps(Bounds.MinCorner.Y), MaxY = _mm_set1_ps(Bounds.MaxCorner.Y);
+		auto MinZ = _mm_set1_ps(Bounds.MinCorner.Z), MaxZ = _mm_set1_ps(Bounds.MaxCorner.Z);
+
+		for (size_t FirstLightIndex = 0; FirstLightIndex < Lights.X.size(); FirstLightIndex += ViewSpaceLightList::LightsPerBatch)
+		{
+			auto X = _mm_loadu_ps(&Lights.X[FirstLightIndex]);
+			auto Y = _mm_loadu_ps(&Lights.Y[FirstLightIndex]);
+			auto Z = _mm_loadu_ps(&Lights.Z[FirstLightIndex]);
+
+			auto OffsetX = _mm_sub_ps(X, _mm_max_ps(MinX, _mm_min_ps(MaxX, X)));
+			auto OffsetY = _mm_sub_ps(Y, _mm_max_ps(MinY, _mm_min_ps(MaxY, Y)));
+			auto OffsetZ = _mm_sub_ps(Z, _mm_max_ps(MinZ, _mm_min_ps(MaxZ, Z)));
+			auto DistanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(OffsetX, OffsetX), _mm_mul_ps(OffsetY, OffsetY)), _mm_mul_ps(OffsetZ, OffsetZ));
+
+			auto IntersectionBits = static_cast<uint32>(_mm_movemask_ps(_mm_cmple_ps(DistanceSq, _mm_loadu_ps(&Lights.RadiusSq[FirstLightIndex]))));
+			ClusterMasks[FirstLightIndex / 32] |= IntersectionBits << (FirstLightIndex % 32);
+		}
+#else
+		for (size_t LightIndex = 0; LightIndex < Lights.X.size(); LightIndex++)
+		{
+			float OffsetX = Lights.X[LightIndex] - Math::Clamp(Bounds.MinCorner.X, Bounds.MaxCorner.X, Lights.X[LightIndex]);
+			float OffsetY = Lights.Y[LightIndex] - Math::Clamp(Bounds.MinCorner.Y, Bounds.MaxCorner.Y, Lights.Y[LightIndex]);
+			float OffsetZ = Lights.Z[LightIndex] - Math::Clamp(Bounds.MinCorner.Z, Bounds.MaxCorner.Z, Lights.Z[LightIndex]);
+
+			if (OffsetX * OffsetX + OffsetY * OffsetY + OffsetZ * OffsetZ <= Lights.RadiusSq[LightIndex])
+				ClusterMasks[LightIndex / 32] |= 1u << (LightIndex % 32);
+		}
+#endif
+	}
+
+	float LightClustering::ComputeLightRadius(Vec3 Color, float Intensity)
+	{
+		return Math::Sqrt((Color * Intensity).Length() / GPointLightIntensityTolerance);
+	}
+
+	Vec2 LightClustering::ComputeClusterZScaleAndBias(float NearZ, float FarZ, uint32 NumberOfZClusters)
+	{
+		float LogDepthRange = std::log(FarZ / NearZ);
+		float Scale = static_cast<float>(NumberOfZClusters) / LogDepthRange;
+
+		return { Scale, -std::log(NearZ) * Scale };
+	}
+
+	float LightClustering::LinearizeDepth(float DeviceDepth, Vec2 CameraZBounds)
+	{
+		float NearZ = CameraZBounds.X;
+		float FarZ = CameraZBounds.Y;
+
+		return NearZ * FarZ / (DeviceDepth * (FarZ - NearZ) + NearZ);
+	}
+
+	uint32 LightClustering::ComputeClusterZSlice(float ViewDepth, const SceneData& SceneData)
+	{
+		float Slice = std::floor(std::log(ViewDepth) * SceneData.ClusterZScaleAndBias.X + SceneData.ClusterZScaleAndBias.Y);
+		return static_cast<uint32>(Math::Clamp(0.0f, static_cast<float>(SceneData.NumberOfZClusters - 1), Slice));
+	}
+
+	uint32 LightClustering::ComputeClusterIndex(Vec2ui Pixel, float DeviceDepth, const SceneData& SceneData)
+	{
+		auto ClusterSize = static_cast<Vec2ui>(SceneData.MaxPixelsPerLightCluster);
+		uint32 ClusterX = Math::Min(Pixel.X / ClusterSize.X, SceneData.NumberOfXYClusters.X - 1);
+		uint32 ClusterY = Math::Min(Pixel.Y / ClusterSize.Y, SceneData.NumberOfXYClusters.Y - 1);
+		uint32 ClusterZ = ComputeClusterZSlice(LinearizeDepth(DeviceDepth, SceneData.CameraZBounds), SceneData);
+
+		return ClusterX + ClusterY * SceneData.NumberOfXYClusters.X + ClusterZ * GetXYClusterCount(SceneData);
+	}
+
+	LightClusterBounds LightClustering::ComputeClusterBounds(uint32 ClusterIndex, const SceneData& SceneData)
+	{
+		uint32 IndexInSlice = ClusterIndex % GetXYClusterCount(SceneData);
+		uint32 ClusterX = IndexInSlice % SceneData.NumberOfXYClusters.X;
+		uint32 ClusterY = IndexInSlice / SceneData.NumberOfXYClusters.X;
+		uint32 ClusterZ = ClusterIndex / GetXYClusterCount(SceneData);
+
+		float NearZ = SceneData.CameraZBounds.X;
+		float FarZ = SceneData.CameraZBounds.Y;
+		float ClusterNearZ = NearZ * std::pow(FarZ / NearZ, static_cast<float>(ClusterZ) / static_cast<float>(SceneData.NumberOfZClusters));
+		float ClusterFarZ = NearZ * std::pow(FarZ / NearZ, static_cast<float>(ClusterZ + 1) / static_cast<float>(SceneData.NumberOfZClusters));
+
+		auto ClusterSize = SceneData.MaxPixelsPerLightCluster;
+		Vec2 MinPixel = { Math::Min(ClusterSize.X * static_cast<float>(ClusterX), SceneData.ScreenDimensions.X),
+		                  Math::Min(ClusterSize.Y * static_cast<float>(ClusterY), SceneData.ScreenDimensions.Y) };
+		Vec2 MaxPixel = { Math::Min(ClusterSize.X * static_cast<float>(ClusterX + 1), SceneData.ScreenDimensions.X),
+		                  Math::Min(ClusterSize.Y * static_cast<float>(ClusterY + 1), SceneData.ScreenDimensions.Y) };
+		auto MinCornerOnNearPlane = ScreenSpaceToViewSpace(MinPixel, SceneData);
+		auto MaxCornerOnNearPlane = ScreenSpaceToViewSpace(MaxPixel, SceneData);
+
+		Vec3 Points[] = {
+			ScaleToViewDepth(MinCornerOnNearPlane, ClusterNearZ),
+			ScaleToViewDepth(MaxCornerOnNearPlane, ClusterNearZ),
+			ScaleToViewDepth(MinCornerOnNearPlane, ClusterFarZ),
+			ScaleToViewDepth(MaxCornerOnNearPlane, ClusterFarZ)
+		};
+
+		LightClusterBounds Result = { Points[0], Points[0] };
+		for (const auto& Point : Points)
+		{
+			Result.MinCorner = { Math::Min(Result.MinCorner.X, Point.X), Math::Min(Result.MinCorner.Y, Point.Y), Math::Min(Result.MinCorner.Z, Point.Z) };
+			Result.MaxCorner = { Math::Max(Result.MaxCorner.X, Point.X), Math::Max(Result.MaxCorner.Y, Point.Y), Math::Max(Result.MaxCorner.Z, Point.Z) };
+		}
+		return Result;
+	}
+
+	bool LightClustering::DoesLightIntersectCluster(const PointLight& Light, const LightClusterBounds& Bounds, const Mat4& ViewMatrix)
+	{
+		auto ViewSpacePosition = ViewMatrix * Vec4(Light.Position.X, Light.Position.Y, Light.Position.Z, 1.0f);
+		float Radius = Light.Position.W;
+
+		Vec3 ClosestPoint = {
+			Math::Clamp(Bounds.MinCorner.X, Bounds.MaxCorner.X, ViewSpacePosition.X),
+			Math::Clamp(Bounds.MinCorner.Y, Bounds.MaxCorner.Y, ViewSpacePosition.Y),
+			Math::Clamp(Bounds.MinCorner.Z, Bounds.MaxCorner.Z, ViewSpacePosition.Z)
+		};
+		auto Offset = Vec3(ViewSpacePosition.X, ViewSpacePosition.Y, ViewSpacePosition.Z) - ClosestPoint;
+
+		return Offset.LengthSq() <= Radius * Radius;
+	}
+
+	std::vector<uint32> LightClustering::FindActiveClusters(std::span<const float> DepthBuffer, const SceneData& SceneData)
+	{
+		std::vector<uint32> UsedZSlices(GetXYClusterCount(SceneData), 0);
+		MarkUsedZSlices(DepthBuffer, SceneData, 0, SceneData.NumberOfXYClusters.Y, UsedZSlices);
+
+		return CollectActiveClusters(UsedZSlices, SceneData);
+	}
+
+	std::vector<uint32> LightClustering::FindActiveClusters(std::span<const float> DepthBuffer, const SceneData& SceneData, ThreadPool& ThreadPool)
+	{
+		uint32 ClusterRowCount = SceneData.NumberOfXYClusters.Y;
+		auto ChunkCount = std::clamp<size_t>(ClusterRowCount, 1, static_cast<size_t>(ThreadPool.GetThreadCount()) * 2);
+
+		// Every chunk covers whole rows of clusters, so the threads never write to the same column mask
+		std::vector<uint32> UsedZSlices(GetXYClusterCount(SceneData), 0);
+		ThreadPool.ParallelFor(ChunkCount, [&](size_t ChunkIndex, uint32)
+		{
+			auto FirstClusterRow = static_cast<uint32>(ClusterRowCount * ChunkIndex / ChunkCount);
+			auto LastClusterRow = static_cast<uint32>(ClusterRowCount * (ChunkIndex + 1) / ChunkCount);
+			MarkUsedZSlices(DepthBuffer, SceneData, FirstClusterRow, LastClusterRow, UsedZSlices);
+		});
+
+		return CollectActiveClusters(UsedZSlices, SceneData);
+	}
+
+	void LightClustering::AssignLights(std::span<const PointLight> Lights, std::span<const uint32> Clusters, const SceneData& SceneData,
+	                                   std::span<uint32> Masks)
+	{
+		HERMES_ASSERT(Lights.size() <= static_cast<size_t>(SceneData.LightMaskWordsPerCluster) * 32);
+
+		auto ViewSpaceLights = TransformLightsToViewSpace(Lights, SceneData.View);
+		for (auto ClusterIndex : Clusters)
+		{
+			auto ClusterMasks = Masks.subspan(static_cast<size_t>(ClusterIndex) * SceneData.LightMaskWordsPerCluster, SceneData.LightMaskWordsPerCluster);
+			AssignLightsToCluster(ViewSpaceLights, ComputeClusterBounds(ClusterIndex, SceneData), ClusterMasks);
+		}
+	}
+
+	void LightClustering::AssignLights(std::span<const PointLight> Lights, std::span<const uint32> Clusters, const SceneData& SceneData,
+	                                   std::span<uint32> Masks, ThreadPool& ThreadPool)
+	{
+		HERMES_ASSERT(Lights.size() <= static_cast<size_t>(SceneData.LightMaskWordsPerCluster) * 32);
+
+		// NOTE: a few more chunks than threads so that a thread that got clusters with fewer lights can pick up another chunk
+		static constexpr size_t MinClustersPerChunk = 32;
+		auto MaxChunkCount = static_cast<size_t>(ThreadPool.GetThreadCount()) * 2;
+		auto ChunkCount = std::clamp<size_t>((Clusters.size() + MinClustersPerChunk - 1) / MinClustersPerChunk, 1, MaxChunkCount);
+
+		// Every cluster owns a separate range of the masks, so the threads never write to the same word
+		auto ViewSpaceLights = TransformLightsToViewSpace(Lights, SceneData.View);
+		ThreadPool.ParallelFor(ChunkCount, [&](size_t ChunkIndex, uint32)
+		{
+			size_t FirstClusterIndex = Clusters.size() * ChunkIndex / ChunkCount;
+			size_t LastClusterIndex = Clusters.size() * (ChunkIndex + 1) / ChunkCount;
+			for (auto ClusterIndex : Clusters.subspan(FirstClusterIndex, LastClusterIndex - FirstClusterIndex))
+			{
+				auto ClusterMasks = Masks.subspan(static_cast<size_t>(ClusterIndex) * SceneData.LightMaskWordsPerCluster, SceneData.LightMaskWordsPerCluster);
+				AssignLightsToCluster(ViewSpaceLights, ComputeClusterBounds(ClusterIndex, SceneData), ClusterMasks);
+			}
+		});
+	}
+}
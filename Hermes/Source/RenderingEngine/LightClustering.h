@@ -0,0 +1,84 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "Core/Core.h"
+#include "Core/Misc/ThreadPool.h"
+#include "Math/Math.h"
+#include "RenderingEngine/SharedData.h"
+
+namespace Hermes
+{
+	/*
+	 * View space axis-aligned bounding box of a light cluster
+	 */
+	struct HERMES_API LightClusterBounds
+	{
+		Vec3 MinCorner;
+		Vec3 MaxCorner;
+	};
+
+	/*
+	 * CPU implementation of the clustered light assignment that the light culling pass does on the GPU. It follows
+	 * light_clusters.glsl, light_cluster_marking.glsl and light_culling.glsl step by step, so it can be used to test the
+	 * algorithm and to check the results of the GPU
+	 *
+	 * The cluster related fields of SceneData must be filled the same way SceneRenderer fills them for the GPU. Unlike the
+	 * rest of the functions AssignLights() is optimized, so it can also be used as a fallback when the GPU path is not available
+	 */
+	class HERMES_API LightClustering
+	{
+	public:
+		/*
+		 * Radius outside of which a point light contributes less than GPointLightIntensityTolerance
+		 */
+		static float ComputeLightRadius(Vec3 Color, float Intensity);
+
+		/*
+		 * Returns the coefficients that map the logarithm of a view space depth to a Z slice, see SceneData::ClusterZScaleAndBias
+		 */
+		static Vec2 ComputeClusterZScaleAndBias(float NearZ, float FarZ, uint32 NumberOfZClusters);
+
+		/*
+		 * Converts a value from the reverse-Z depth buffer into the distance from the camera along its view direction
+		 */
+		static float LinearizeDepth(float DeviceDepth, Vec2 CameraZBounds);
+
+		static uint32 ComputeClusterZSlice(float ViewDepth, const SceneData& SceneData);
+
+		/*
+		 * Returns the linear index of the cluster that contains the given pixel of the depth buffer
+		 */
+		static uint32 ComputeClusterIndex(Vec2ui Pixel, float DeviceDepth, const SceneData& SceneData);
+
+		static LightClusterBounds ComputeClusterBounds(uint32 ClusterIndex, const SceneData& SceneData);
+
+		static bool DoesLightIntersectCluster(const PointLight& Light, const LightClusterBounds& Bounds, const Mat4& ViewMatrix);
+
+		/*
+		 * Returns the sorted indices of the clusters that contain at least one pixel covered by geometry, the depth buffer
+		 * is stored row by row and has the dimensions of SceneData::ScreenDimensions
+		 */
+		static std::vector<uint32> FindActiveClusters(std::span<const float> DepthBuffer, const SceneData& SceneData);
+
+		/*
+		 * Same as above, but splits the rows of clusters between the threads of the pool
+		 */
+		static std::vector<uint32> FindActiveClusters(std::span<const float> DepthBuffer, const SceneData& SceneData, ThreadPool& ThreadPool);
+
+		/*
+		 * Writes the light masks of the given clusters, the masks of the other clusters are not touched. Gives the same
+		 * result as testing every light against every cluster with DoesLightIntersectCluster(), but transforms the lights
+		 * only once and tests four of them at a time using SSE
+		 */
+		static void AssignLights(std::span<const PointLight> Lights, std::span<const uint32> Clusters, const SceneData& SceneData,
+		                         std::span<uint32> Masks);
+
+		/*
+		 * Same as above, but splits the clusters between the threads of the pool
+		 */
+		static void AssignLights(std::span<const PointLight> Lights, std::span<const uint32> Clusters, const SceneData& SceneData,
+		                         std::span<uint32> Masks, ThreadPool& ThreadPool);
+	};
+}
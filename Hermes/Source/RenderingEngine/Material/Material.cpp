@@ -1,10 +1,12 @@
 ﻿#include "Material.h"
 
+#include <utility>
+#include <vector>
+
 #include "AssetSystem/AssetHeaders.h"
 #include "AssetSystem/AssetLoader.h"
 #include "JSON/JSONObject.h"
 #include "JSON/JSONValue.h"
-#include "RenderingEngine/DescriptorAllocator.h"
 #include "RenderingEngine/Renderer.h"
 #include "RenderingEngine/SharedData.h"
 #include "Vulkan/Device.h"
@@ -15,40 +17,63 @@ namespace Hermes
 {
 	HERMES_ADD_TEXT_ASSET_LOADER(Material, "material");
 
+	// Pairs of color and depth attachment formats, see Material::AddPrecompiledAttachmentFormats()
+	static std::vector<std::pair<VkFormat, VkFormat>> GPrecompiledAttachmentFormats;
+
+	/*
+	 * Vertex attributes are always bound to locations 0-3 (position, texture coordinates, normal and tangent) so that the same vertex
+	 * shader can consume both vertex formats; for compressed vertices the normal and tangent attributes only provide the two
+	 * components of the octahedral encoding, which the shader decodes when GlobalDrawcallData::AreVerticesCompressed is set
+	 */
+	static void AddVertexInputDescription(Vulkan::PipelineDescription& PipelineDesc, MeshVertexFormat VertexFormat)
+	{
+		bool IsCompressed = VertexFormat == MeshVertexFormat::Compressed;
+
+		VkVertexInputBindingDescription VertexInput = {};
+		VertexInput.binding = 0;
+		VertexInput.stride = IsCompressed ? sizeof(CompressedVertex) : sizeof(Vertex);
+		VertexInput.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		PipelineDesc.VertexInputBindings.push_back(VertexInput);
+
+		VkVertexInputAttributeDescription PositionAttribute = {}, TextureCoordinatesAttribute = {}, NormalAttribute = {}, TangentAttribute = {};
+		PositionAttribute.binding = 0;
+		PositionAttribute.location = 0;
+		PositionAttribute.offset = IsCompressed ? offsetof(CompressedVertex, Position) : offsetof(Vertex, Position);
+		PositionAttribute.format = IsCompressed ? VK_FORMAT_R16G16B16A16_UNORM : VK_FORMAT_R32G32B32_SFLOAT;
+		PipelineDesc.VertexInputAttributes.push_back(PositionAttribute);
+
+		TextureCoordinatesAttribute.binding = 0;
+		TextureCoordinatesAttribute.location = 1;
+		TextureCoordinatesAttribute.offset = IsCompressed ? offsetof(CompressedVertex, TextureCoordinates) : offsetof(Vertex, TextureCoordinates);
+		TextureCoordinatesAttribute.format = IsCompressed ? VK_FORMAT_R16G16_SFLOAT : VK_FORMAT_R32G32_SFLOAT;
+		PipelineDesc.VertexInputAttributes.push_back(TextureCoordinatesAttribute);
+
+		NormalAttribute.binding = 0;
+		NormalAttribute.location = 2;
+		NormalAttribute.offset = IsCompressed ? offsetof(CompressedVertex, Normal) : offsetof(Vertex, Normal);
+		NormalAttribute.format = IsCompressed ? VK_FORMAT_R16G16_SNORM : VK_FORMAT_R32G32B32_SFLOAT;
+		PipelineDesc.VertexInputAttributes.push_back(NormalAttribute);
+
+		TangentAttribute.binding = 0;
+		TangentAttribute.location = 3;
+		TangentAttribute.offset = IsCompressed ? offsetof(CompressedVertex, Tangent) : offsetof(Vertex, Tangent);
+		TangentAttribute.format = IsCompressed ? VK_FORMAT_R16G16_SNORM : VK_FORMAT_R32G32B32_SFLOAT;
+		PipelineDesc.VertexInputAttributes.push_back(TangentAttribute);
+	}
+
 	Material::Material(String InName, String InVertexShaderPath, String InFragmentShaderPath)
 		: Asset(std::move(InName), AssetType::Material)
 		, VertexShaderName(std::move(InVertexShaderPath))
 		, FragmentShaderName(std::move(InFragmentShaderPath))
 	{
-		const auto& Reflection = Renderer::GetShaderCache().GetShaderReflection(FragmentShaderName, VK_SHADER_STAGE_FRAGMENT_BIT);
-
-		std::vector<VkDescriptorSetLayoutBinding> PerMaterialDataBindings;
-		if (Reflection.RequiresUniformBuffer())
+		for (auto [ColorAttachmentFormat, DepthAttachmentFormat] : GPrecompiledAttachmentFormats)
 		{
-			// Binding 0 is always material uniform buffer that stores numeric properties
-			VkDescriptorSetLayoutBinding UBOBinding = {};
-			UBOBinding.binding = 0;
-			UBOBinding.descriptorCount = 1;
-			UBOBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-			UBOBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			PerMaterialDataBindings.push_back(UBOBinding);
+			for (auto VertexFormat : { MeshVertexFormat::Full, MeshVertexFormat::Compressed })
+			{
+				RequestPipeline({ ColorAttachmentFormat, DepthAttachmentFormat, VertexFormat });
+				RequestPipeline({ VK_FORMAT_UNDEFINED, DepthAttachmentFormat, VertexFormat });
+			}
 		}
-
-		// Iterate over texture properties and add their corresponding bindings to the list
-		for (const auto& Property : Reflection.GetProperties())
-		{
-			if (Property.second.Type != MaterialPropertyType::Texture)
-				continue;
-
-			VkDescriptorSetLayoutBinding Binding = {};
-			Binding.binding = Property.second.Binding;
-			Binding.descriptorCount = 1;
-			Binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-			Binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			PerMaterialDataBindings.push_back(Binding);
-		}
-
-		DescriptorSetLayout = Renderer::GetDevice().CreateDescriptorSetLayout(PerMaterialDataBindings);
 	}
 
 	AssetHandle<Material> Material::Create(String Name, String VertexShaderPath, String FragmentShaderPath)
@@ -84,6 +109,12 @@ namespace Hermes
 		return Create(String(CallbackInfo.Name), std::move(VertexShader), std::move(FragmentShader));
 	}
 
+	void Material::AddPrecompiledAttachmentFormats(VkFormat ColorAttachmentFormat, VkFormat DepthAttachmentFormat)
+	{
+		HERMES_ASSERT(ColorAttachmentFormat != VK_FORMAT_UNDEFINED && DepthAttachmentFormat != VK_FORMAT_UNDEFINED);
+		GPrecompiledAttachmentFormats.emplace_back(ColorAttachmentFormat, DepthAttachmentFormat);
+	}
+
 	const MaterialProperty* Material::FindProperty(const String& PropertyName) const
 	{
 		auto& ShaderCache = Renderer::GetShaderCache();
@@ -92,75 +123,74 @@ namespace Hermes
 		return Reflection.FindProperty(PropertyName);
 	}
 
-	const Vulkan::DescriptorSetLayout& Material::GetDescriptorSetLayout() const
+	const Vulkan::Pipeline* Material::RequestFullPipeline(VkFormat ColorAttachmentFormat, VkFormat DepthAttachmentFormat, MeshVertexFormat VertexFormat) const
 	{
-		return *DescriptorSetLayout;
+		HERMES_ASSERT(ColorAttachmentFormat != VK_FORMAT_UNDEFINED && DepthAttachmentFormat != VK_FORMAT_UNDEFINED);
+		return RequestPipeline({ ColorAttachmentFormat, DepthAttachmentFormat, VertexFormat });
 	}
 
-	const Vulkan::Pipeline& Material::GetFullPipeline(VkFormat ColorAttachmentFormat, VkFormat DepthAttachmentFormat) const
+	const Vulkan::Pipeline* Material::RequestVertexOnlyPipeline(VkFormat DepthAttachmentFormat, MeshVertexFormat VertexFormat) const
 	{
-		if (!FullPipeline || CachedPipelineColorAttachmentFormat != ColorAttachmentFormat || CachedPipelineDepthAttachmentFormat != DepthAttachmentFormat)
-			CreatePipelines(ColorAttachmentFormat, DepthAttachmentFormat);
-		return *FullPipeline;
+		HERMES_ASSERT(DepthAttachmentFormat != VK_FORMAT_UNDEFINED);
+		return RequestPipeline({ VK_FORMAT_UNDEFINED, DepthAttachmentFormat, VertexFormat });
 	}
 
-	const Vulkan::Pipeline& Material::GetVertexOnlyPipeline(VkFormat DepthAttachmentFormat) const
+	const Vulkan::Pipeline* Material::FindFullPipeline(VkFormat ColorAttachmentFormat, VkFormat DepthAttachmentFormat, MeshVertexFormat VertexFormat) const
 	{
-		if (!VertexOnlyPipeline || CachedPipelineDepthAttachmentFormat != DepthAttachmentFormat)
-			CreatePipelines(VK_FORMAT_UNDEFINED, DepthAttachmentFormat);
-		return *VertexOnlyPipeline;
+		return FindPipeline({ ColorAttachmentFormat, DepthAttachmentFormat, VertexFormat });
 	}
 
-	size_t Material::GetUniformBufferSize() const
+	const Vulkan::Pipeline* Material::FindVertexOnlyPipeline(VkFormat DepthAttachmentFormat, MeshVertexFormat VertexFormat) const
+	{
+		return FindPipeline({ VK_FORMAT_UNDEFINED, DepthAttachmentFormat, VertexFormat });
+	}
+
+	size_t Material::GetMaterialDataSize() const
 	{
 		auto& ShaderCache = Renderer::GetShaderCache();
 		const auto& Reflection = ShaderCache.GetShaderReflection(FragmentShaderName, VK_SHADER_STAGE_FRAGMENT_BIT);
 
-		return Reflection.GetTotalSizeForUniformBuffer();
+		return Reflection.GetMaterialDataSize();
 	}
 
-	void Material::CreatePipelines(VkFormat ColorAttachmentFormat, VkFormat DepthAttachmentFormat) const
+	size_t Material::PipelineKeyHasher::operator()(const PipelineKey& Key) const
 	{
-		const auto& VertexShader = Renderer::GetShaderCache().GetShader(VertexShaderName, VK_SHADER_STAGE_VERTEX_BIT);
-		const auto& FragmentShader = Renderer::GetShaderCache().GetShader(FragmentShaderName, VK_SHADER_STAGE_FRAGMENT_BIT);
-
-		Vulkan::PipelineDescription PipelineDesc = {};
-		PipelineDesc.PushConstants.push_back({ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GlobalDrawcallData) });
-		PipelineDesc.ShaderStages = { &VertexShader, &FragmentShader };
-		PipelineDesc.DescriptorSetLayouts = {
-			&Renderer::GetGlobalDataDescriptorSetLayout(), DescriptorSetLayout.get()
-		};
+		auto Hash = static_cast<size_t>(Key.ColorAttachmentFormat);
+		Hash = Hash * 31 + static_cast<size_t>(Key.DepthAttachmentFormat);
+		Hash = Hash * 31 + static_cast<size_t>(Key.VertexFormat);
+		return Hash;
+	}
 
-		VkVertexInputBindingDescription VertexInput = {};
-		VertexInput.binding = 0;
-		VertexInput.stride = sizeof(Vertex);
-		VertexInput.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-		PipelineDesc.VertexInputBindings.push_back(VertexInput);
+	const Vulkan::Pipeline* Material::RequestPipeline(const PipelineKey& Key) const
+	{
+		if (const auto* CachedPipeline = FindPipeline(Key))
+			return CachedPipeline;
 
-		VkVertexInputAttributeDescription PositionAttribute = {}, TextureCoordinatesAttribute = {}, NormalAttribute = {}, TangentAttribute = {};
-		PositionAttribute.binding = 0;
-		PositionAttribute.location = 0;
-		PositionAttribute.offset = offsetof(Vertex, Position);
-		PositionAttribute.format = VK_FORMAT_R32G32B32_SFLOAT;
-		PipelineDesc.VertexInputAttributes.push_back(PositionAttribute);
+		bool IsVertexOnly = Key.ColorAttachmentFormat == VK_FORMAT_UNDEFINED;
 
-		TextureCoordinatesAttribute.binding = 0;
-		TextureCoordinatesAttribute.location = 1;
-		TextureCoordinatesAttribute.offset = offsetof(Vertex, TextureCoordinates);
-		TextureCoordinatesAttribute.format = VK_FORMAT_R32G32_SFLOAT;
-		PipelineDesc.VertexInputAttributes.push_back(TextureCoordinatesAttribute);
+		const auto& VertexShader = Renderer::GetShaderCache().GetShader(VertexShaderName, VK_SHADER_STAGE_VERTEX_BIT);
+		const auto& FragmentShader = Renderer::GetShaderCache().GetShader(FragmentShaderName, VK_SHADER_STAGE_FRAGMENT_BIT);
 
-		NormalAttribute.binding = 0;
-		NormalAttribute.location = 2;
-		NormalAttribute.offset = offsetof(Vertex, Normal);
-		NormalAttribute.format = VK_FORMAT_R32G32B32_SFLOAT;
-		PipelineDesc.VertexInputAttributes.push_back(NormalAttribute);
+		Vulkan::PipelineDescription PipelineDesc = {};
+		if (IsVertexOnly)
+		{
+			PipelineDesc.PushConstants.push_back({ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GlobalDrawcallData) });
+			PipelineDesc.ShaderStages = { &VertexShader };
+			// NOTE: vertex shaders don't have any user-defined material properties for now
+			PipelineDesc.DescriptorSetLayouts = { &Renderer::GetGlobalDataDescriptorSetLayout() };
+		}
+		else
+		{
+			// NOTE: the fragment shader reads the material index from the push constants
+			PipelineDesc.PushConstants.push_back({ VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(GlobalDrawcallData) });
+			PipelineDesc.ShaderStages = { &VertexShader, &FragmentShader };
+			// NOTE: all materials share the layout of the material data set, so it only has to be bound once per command buffer
+			PipelineDesc.DescriptorSetLayouts = {
+				&Renderer::GetGlobalDataDescriptorSetLayout(), &Renderer::GetMaterialResourceTable()->GetDescriptorSetLayout()
+			};
+		}
 
-		TangentAttribute.binding = 0;
-		TangentAttribute.location = 3;
-		TangentAttribute.offset = offsetof(Vertex, Tangent);
-		TangentAttribute.format = VK_FORMAT_R32G32B32_SFLOAT;
-		PipelineDesc.VertexInputAttributes.push_back(TangentAttribute);
+		AddVertexInputDescription(PipelineDesc, Key.VertexFormat);
 
 		PipelineDesc.Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
@@ -174,17 +204,22 @@ namespace Hermes
 
 		PipelineDesc.DynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
 
-		if (ColorAttachmentFormat != VK_FORMAT_UNDEFINED && DepthAttachmentFormat != VK_FORMAT_UNDEFINED)
-			FullPipeline = Renderer::GetDevice().CreatePipeline(PipelineDesc, { &ColorAttachmentFormat, 1 }, DepthAttachmentFormat);
+		std::span<const VkFormat> ColorAttachmentFormats;
+		if (!IsVertexOnly)
+			ColorAttachmentFormats = { &Key.ColorAttachmentFormat, 1 };
 
-		PipelineDesc.ShaderStages = { &VertexShader };
-		// NOTE: vertex shaders don't have any user-defined material properties for now
-		PipelineDesc.DescriptorSetLayouts = { &Renderer::GetGlobalDataDescriptorSetLayout() };
+		const auto* Pipeline = Renderer::GetPipelineStateCache().RequestPipeline(PipelineDesc, ColorAttachmentFormats, Key.DepthAttachmentFormat, GetName());
+		if (Pipeline)
+			Pipelines[Key] = Pipeline;
 
-		if (DepthAttachmentFormat != VK_FORMAT_UNDEFINED)
-			VertexOnlyPipeline = Renderer::GetDevice().CreatePipeline(PipelineDesc, {}, DepthAttachmentFormat);
+		return Pipeline;
+	}
 
-		CachedPipelineColorAttachmentFormat = ColorAttachmentFormat;
-		CachedPipelineDepthAttachmentFormat = DepthAttachmentFormat;
+	const Vulkan::Pipeline* Material::FindPipeline(const PipelineKey& Key) const
+	{
+		auto MaybeCachedPipeline = Pipelines.find(Key);
+		if (MaybeCachedPipeline != Pipelines.end())
+			return MaybeCachedPipeline->second;
+		return nullptr;
 	}
 }
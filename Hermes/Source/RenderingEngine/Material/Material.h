@@ -1,6 +1,9 @@
 ﻿#pragma once
 
+#include <unordered_map>
+
 #include "AssetSystem/Asset.h"
+#include "AssetSystem/AssetHeaders.h"
 #include "AssetSystem/AssetLoader.h"
 #include "Core/Core.h"
 #include "RenderingEngine/Material/MaterialProperty.h"
@@ -28,32 +31,68 @@ namespace Hermes
 
 		static AssetHandle<Asset> Load(const AssetLoaderCallbackInfo& CallbackInfo, const JSONObject& Data);
 
+		/*
+		 * Every material created after this call starts compiling its pipelines for these attachment formats (both full and
+		 * vertex-only ones, for all vertex formats) in the background right away, so they are usually ready by the time the
+		 * material is drawn for the first time
+		 */
+		static void AddPrecompiledAttachmentFormats(VkFormat ColorAttachmentFormat, VkFormat DepthAttachmentFormat);
+
 		const MaterialProperty* FindProperty(const String& PropertyName) const;
 
-		const Vulkan::DescriptorSetLayout& GetDescriptorSetLayout() const;
+		/*
+		 * Returns a pipeline whose vertex input layout matches meshes with the given vertex format, or nullptr while it is
+		 * still being compiled in the background (the compilation is started by the first call). Must be called from the
+		 * render thread, meshes whose pipeline is not ready yet should be skipped
+		 */
+		const Vulkan::Pipeline* RequestFullPipeline(VkFormat ColorAttachmentFormat, VkFormat DepthAttachmentFormat, MeshVertexFormat VertexFormat) const;
 
-		const Vulkan::Pipeline& GetFullPipeline(VkFormat ColorAttachmentFormat, VkFormat DepthAttachmentFormat) const;
+		/*
+		 * Same as RequestFullPipeline(), but for a pipeline with vertex shader only that can be used for things like depth pass etc.
+		 */
+		const Vulkan::Pipeline* RequestVertexOnlyPipeline(VkFormat DepthAttachmentFormat, MeshVertexFormat VertexFormat) const;
 
 		/*
-		 * Returns a pipeline with vertex shader only that can be used for things like depth pass etc.
+		 * Return the pipeline only if an earlier Request*Pipeline() call has returned it. Unlike those they can be called
+		 * from multiple threads at once, as long as no Request*Pipeline() call runs at the same time
 		 */
-		const Vulkan::Pipeline& GetVertexOnlyPipeline(VkFormat DepthAttachmentFormat) const;
+		const Vulkan::Pipeline* FindFullPipeline(VkFormat ColorAttachmentFormat, VkFormat DepthAttachmentFormat, MeshVertexFormat VertexFormat) const;
+		const Vulkan::Pipeline* FindVertexOnlyPipeline(VkFormat DepthAttachmentFormat, MeshVertexFormat VertexFormat) const;
 
-		size_t GetUniformBufferSize() const;
+		/*
+		 * Returns the size of the data of a single material instance in the material data buffer (see MaterialResourceTable),
+		 * or 0 if the material has no properties
+		 */
+		size_t GetMaterialDataSize() const;
 
 	private:
 		String VertexShaderName, FragmentShaderName;
 
-		std::unique_ptr<Vulkan::DescriptorSetLayout> DescriptorSetLayout;
+		/*
+		 * Vertex-only pipelines have an undefined color attachment format
+		 */
+		struct PipelineKey
+		{
+			VkFormat ColorAttachmentFormat;
+			VkFormat DepthAttachmentFormat;
+			MeshVertexFormat VertexFormat;
+
+			bool operator==(const PipelineKey&) const = default;
+		};
 
-		mutable std::unique_ptr<Vulkan::Pipeline> FullPipeline;
-		mutable std::unique_ptr<Vulkan::Pipeline> VertexOnlyPipeline;
+		struct PipelineKeyHasher
+		{
+			size_t operator()(const PipelineKey& Key) const;
+		};
 
-		mutable VkFormat CachedPipelineColorAttachmentFormat = VK_FORMAT_UNDEFINED;
-		mutable VkFormat CachedPipelineDepthAttachmentFormat = VK_FORMAT_UNDEFINED;
+		// NOTE: the pipelines are owned by the renderer's PipelineStateCache, this map only saves building a full pipeline
+		//       description for every draw call. Only pipelines that have finished compiling are added
+		mutable std::unordered_map<PipelineKey, const Vulkan::Pipeline*, PipelineKeyHasher> Pipelines;
 
 		Material(String InName, String InVertexShaderPath, String InFragmentShaderPath);
 
-		void CreatePipelines(VkFormat ColorAttachmentFormat, VkFormat DepthAttachmentFormat) const;
+		const Vulkan::Pipeline* RequestPipeline(const PipelineKey& Key) const;
+
+		const Vulkan::Pipeline* FindPipeline(const PipelineKey& Key) const;
 	};
 }
@@ -1,11 +1,11 @@
 #include "MaterialInstance.h"
 
+#include <algorithm>
+
 #include "ApplicationCore/GameLoop.h"
 #include "JSON/JSONParser.h"
-#include "RenderingEngine/DescriptorAllocator.h"
 #include "RenderingEngine/Renderer.h"
 #include "RenderingEngine/Texture.h"
-#include "Vulkan/Device.h"
 
 namespace Hermes
 {
@@ -52,28 +52,43 @@ namespace Hermes
 		return Instance;
 	}
 
+	MaterialInstance::~MaterialInstance()
+	{
+		for (const auto& [PropertyName, BoundTexture] : CurrentlyBoundTextures)
+			ResourceTable->ReleaseTexture(BoundTexture.TextureIndex);
+
+		if (HasMaterialData)
+			ResourceTable->FreeMaterialData(MaterialIndex, CPUBuffer.size());
+	}
+
 	void MaterialInstance::SetTextureProperty(const String& PropertyName, AssetHandle<Texture2D> Texture, ColorSpace ColorSpace)
 	{
-		auto* Property = GetBaseMaterial().FindProperty(PropertyName);
-		HERMES_ASSERT(Property);
+		const auto* Property = GetBaseMaterial().FindProperty(PropertyName);
+		HERMES_ASSERT(Property && Property->Type == MaterialPropertyType::Texture);
 
-		DescriptorSet->UpdateWithImageAndSampler(Property->Binding, 0, Texture->GetView(ColorSpace), Renderer::GetDefaultSampler(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-		CurrentlyBoundTextures[PropertyName] = std::move(Texture);
+		// NOTE: acquire the new texture first so that rebinding the same texture does not release its index
+		auto TextureIndex = ResourceTable->AcquireTexture(Texture->GetView(ColorSpace));
+
+		auto MaybePreviousTexture = CurrentlyBoundTextures.find(PropertyName);
+		if (MaybePreviousTexture != CurrentlyBoundTextures.end())
+			ResourceTable->ReleaseTexture(MaybePreviousTexture->second.TextureIndex);
+
+		CurrentlyBoundTextures[PropertyName] = { std::move(Texture), ColorSpace, TextureIndex };
+
+		memcpy(CPUBuffer.data() + Property->Offset, &TextureIndex, sizeof(TextureIndex));
+		MarkDirty();
 	}
 
 	void MaterialInstance::PrepareForRender() const
 	{
-		if (IsDirty && HasUniformBuffer)
-		{
-			// TODO : use frame local allocator for better performance
-			auto BufferSize = UniformBuffer->GetSize();
-			auto* MappedMemory = UniformBuffer->Map();
-			HERMES_ASSERT(MappedMemory);
-			memcpy(MappedMemory, CPUBuffer.data(), BufferSize);
-			UniformBuffer->Unmap();
-
-			IsDirty = false;
-		}
+		auto FrameIndex = Renderer::GetCurrentFrameIndex();
+		if (!IsDirtyInFrame[FrameIndex])
+			return;
+
+		if (HasMaterialData)
+			ResourceTable->UpdateMaterialData(MaterialIndex, CPUBuffer);
+
+		IsDirtyInFrame[FrameIndex] = false;
 	}
 
 	const Material& MaterialInstance::GetBaseMaterial() const
@@ -81,31 +96,30 @@ namespace Hermes
 		return *BaseMaterial;
 	}
 
-	const Vulkan::DescriptorSet& MaterialInstance::GetMaterialDescriptorSet() const
+	uint32 MaterialInstance::GetMaterialIndex() const
 	{
-		return *DescriptorSet;
+		HERMES_ASSERT(!IsDirtyInFrame[Renderer::GetCurrentFrameIndex()]);
+		return MaterialIndex;
 	}
 
 	MaterialInstance::MaterialInstance(String InName, AssetHandle<Material> InBaseMaterial)
 		: Asset(std::move(InName), AssetType::MaterialInstance)
 		, BaseMaterial(std::move(InBaseMaterial))
+		, ResourceTable(Renderer::GetMaterialResourceTable())
 	{
-		auto UniformBufferSize = BaseMaterial->GetUniformBufferSize();
-		HasUniformBuffer = (UniformBufferSize > 0);
+		auto MaterialDataSize = BaseMaterial->GetMaterialDataSize();
+		HasMaterialData = (MaterialDataSize > 0);
 
-		CPUBuffer.resize(UniformBufferSize);
+		CPUBuffer.resize(MaterialDataSize);
+		if (HasMaterialData)
+			MaterialIndex = ResourceTable->AllocateMaterialData(MaterialDataSize);
 
-		auto& Device = Renderer::GetDevice();
-		auto& DescriptorAllocator = Renderer::GetDescriptorAllocator();
-
-		DescriptorSet = DescriptorAllocator.Allocate(BaseMaterial->GetDescriptorSetLayout());
+		IsDirtyInFrame.resize(Renderer::GetFramesInFlightCount(), true);
+	}
 
-		if (HasUniformBuffer)
-		{
-			UniformBuffer = Device.CreateBuffer(UniformBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, true);
-			DescriptorSet->UpdateWithBuffer(0, 0, *UniformBuffer, 0, static_cast<uint32>(UniformBuffer->GetSize()));
-			IsDirty = true;
-		}		
+	void MaterialInstance::MarkDirty()
+	{
+		std::fill(IsDirtyInFrame.begin(), IsDirtyInFrame.end(), true);
 	}
 
 	void MaterialInstance::SetScalarPropertyFromJSON(StringView PropertyName, const MaterialProperty& Property, const JSONValue& JSONValue)
@@ -8,8 +8,7 @@
 #include "Core/Core.h"
 #include "Logging/Logger.h"
 #include "RenderingEngine/Material/Material.h"
-#include "Vulkan/Buffer.h"
-#include "Vulkan/Descriptor.h"
+#include "RenderingEngine/Material/MaterialResourceTable.h"
 
 namespace Hermes
 {
@@ -33,6 +32,8 @@ namespace Hermes
 
 		static AssetHandle<Asset> Load(const AssetLoaderCallbackInfo& CallbackInfo, const JSONObject& Data);
 
+		~MaterialInstance() override;
+
 		template<typename ValueType>
 		void SetNumericProperty(const String& Name, const ValueType& Value, size_t ArrayIndex = 0);
 
@@ -41,23 +42,48 @@ namespace Hermes
 		
 		void SetTextureProperty(const String& PropertyName, AssetHandle<Texture2D> Texture, ColorSpace ColorSpace);
 
+		/*
+		 * Uploads the property values to the material data buffer of the current frame if they were changed since it was last used
+		 */
 		void PrepareForRender() const;
 
 		const Material& GetBaseMaterial() const;
 
-		const Vulkan::DescriptorSet& GetMaterialDescriptorSet() const;
+		/*
+		 * Returns the index of the data of this instance in the material data buffer, the shaders receive it through
+		 * GlobalDrawcallData::MaterialIndex. PrepareForRender() must be called before the draw in every frame
+		 */
+		uint32 GetMaterialIndex() const;
 
 	private:
-		mutable bool IsDirty = false;
-		bool HasUniformBuffer = false;
+		bool HasMaterialData = false;
 
 		AssetHandle<Material> BaseMaterial;
 
+		// NOTE: the table is kept alive by the instance because assets can be destroyed after the renderer was shut down
+		std::shared_ptr<MaterialResourceTable> ResourceTable;
+		uint32 MaterialIndex = 0;
+
+		/*
+		 * Contents of the material data struct, textures are stored as their indices in the bindless texture array
+		 */
 		std::vector<uint8> CPUBuffer;
-		std::unordered_map<String, AssetHandle<Texture2D>> CurrentlyBoundTextures;
 
-		std::unique_ptr<Vulkan::DescriptorSet> DescriptorSet;
-		std::unique_ptr<Vulkan::Buffer> UniformBuffer;
+		struct BoundTexture
+		{
+			AssetHandle<Texture2D> Texture;
+			ColorSpace ColorSpace;
+			uint32 TextureIndex;
+		};
+		std::unordered_map<String, BoundTexture> CurrentlyBoundTextures;
+
+		/*
+		 * The values can change while previous frames that use them are still in flight, so every frame has its own
+		 * copy of the material data buffer that is brought up to date lazily in PrepareForRender()
+		 */
+		mutable std::vector<bool> IsDirtyInFrame;
+
+		void MarkDirty();
 
 		MaterialInstance(String InName, AssetHandle<Material> InBaseMaterial);
 
@@ -93,6 +119,6 @@ namespace Hermes
 		HERMES_ASSERT(ArrayIndex < Property.ArrayLength);
 		memcpy(CPUBuffer.data() + Property.Offset + ArrayIndex * SizeOfSingleElement, &Value, sizeof(ValueType));
 
-		IsDirty = true;
+		MarkDirty();
 	}
 }
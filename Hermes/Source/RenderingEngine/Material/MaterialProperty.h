@@ -50,13 +50,13 @@ namespace Hermes
 		/*
 		 * Full size of this property in bytes
 		 *
-		 * Must always be zero for non-value properties (e.g. textures, samplers etc.)
+		 * For textures it is the size of the index into the bindless texture array
 		 */
 		size_t Size = 0;
 
 		/*
-		 * Offset of the memory address that holds this property in the uniform
-		 * buffer relative to the beginning of this uniform buffer
+		 * Offset of the memory address that holds this property relative to the
+		 * beginning of the material data struct
 		 */
 		size_t Offset = 0;
 
@@ -64,16 +64,8 @@ namespace Hermes
 		 * Length of the array if this property is an array, 1 otherwise
 		 *
 		 * NOTE: must be 1 for non-numeric properties because we currently don't
-		 *       support arrays of descriptors.
+		 *       support arrays of textures.
 		 */
 		size_t ArrayLength = 1;
-
-		/*
-		 * Index of the binding of this property
-		 *
-		 * NOTE: must be 0 for any value property (property that is stored in a uniform buffer)
-		 *       because we only support one uniform buffer at binding 0 at the moment.
-		 */
-		uint32 Binding = 0;
 	};
 }
@@ -0,0 +1,191 @@
+#include "MaterialResourceTable.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Logging/Logger.h"
+#include "RenderingEngine/Renderer.h"
+#include "RenderingEngine/SharedData.h"
+#include "Vulkan/Buffer.h"
+#include "Vulkan/Descriptor.h"
+#include "Vulkan/Device.h"
+#include "Vulkan/Image.h"
+
+namespace Hermes
+{
+	MaterialResourceTable::MaterialResourceTable(uint32 InFramesInFlightCount)
+		: Frames(InFramesInFlightCount)
+		, MaterialDataAllocator(InitialMaterialDataBufferSize)
+	{
+		auto& Device = Renderer::GetDevice();
+
+		VkDescriptorSetLayoutBinding MaterialDataBinding = {};
+		MaterialDataBinding.binding = GMaterialDataBufferBinding;
+		MaterialDataBinding.descriptorCount = 1;
+		MaterialDataBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		MaterialDataBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		VkDescriptorSetLayoutBinding TexturesBinding = {};
+		TexturesBinding.binding = GBindlessTexturesBinding;
+		TexturesBinding.descriptorCount = GMaxBindlessTextureCount;
+		TexturesBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		TexturesBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+		// NOTE: textures are added while the descriptor sets of the previous frames are still bound, and the unused
+		//       elements of the array are never written
+		VkDescriptorBindingFlags TexturesBindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+		DescriptorSetLayout = Device.CreateDescriptorSetLayout({ MaterialDataBinding, TexturesBinding }, { 0, TexturesBindingFlags });
+
+		auto FramesInFlightCount = static_cast<uint32>(Frames.size());
+		std::vector<VkDescriptorPoolSize> PoolSizes = {
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, FramesInFlightCount },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, FramesInFlightCount * GMaxBindlessTextureCount }
+		};
+		DescriptorSetPool = Device.CreateDescriptorSetPool(FramesInFlightCount, PoolSizes, false, true);
+
+		for (auto& Frame : Frames)
+		{
+			Frame.DescriptorSet = DescriptorSetPool->AllocateDescriptorSet(*DescriptorSetLayout);
+			HERMES_ASSERT(Frame.DescriptorSet);
+			ResizeMaterialDataBuffer(Frame, InitialMaterialDataBufferSize);
+		}
+	}
+
+	MaterialResourceTable::~MaterialResourceTable() = default;
+
+	uint32 MaterialResourceTable::AllocateMaterialData(size_t Size)
+	{
+		HERMES_ASSERT(Size > 0);
+
+		auto Offset = MaterialDataAllocator.Allocate(Size, Size);
+		if (!Offset.has_value())
+		{
+			// NOTE: the free range at the end of the address space starts at the old capacity at the latest
+			auto OldCapacity = MaterialDataAllocator.GetCapacity();
+			auto NewCapacity = std::max(OldCapacity * 2, (OldCapacity + Size - 1) / Size * Size + Size);
+			HERMES_LOG_WARNING("Material data buffer ran out of space, growing it to %zu bytes", NewCapacity);
+			MaterialDataAllocator.Grow(NewCapacity);
+
+			// NOTE: the current frame might update the new slot before its BeginFrame() is called again
+			auto& CurrentFrame = Frames[CurrentFrameIndex];
+			if (!CurrentFrame.IsDescriptorSetInUse)
+				ResizeMaterialDataBuffer(CurrentFrame, NewCapacity);
+
+			Offset = MaterialDataAllocator.Allocate(Size, Size);
+			HERMES_ASSERT(Offset.has_value());
+		}
+
+		HERMES_ASSERT(Offset.value() % Size == 0);
+		return static_cast<uint32>(Offset.value() / Size);
+	}
+
+	void MaterialResourceTable::FreeMaterialData(uint32 MaterialIndex, size_t Size)
+	{
+		Frames[CurrentFrameIndex].PendingMaterialDataFrees.push_back(MaterialIndex * Size);
+	}
+
+	void MaterialResourceTable::UpdateMaterialData(uint32 MaterialIndex, std::span<const uint8> Data)
+	{
+		auto Offset = MaterialIndex * Data.size();
+		auto& Frame = Frames[CurrentFrameIndex];
+		HERMES_ASSERT_LOG(Offset + Data.size() <= Frame.MaterialDataBuffer->GetSize(),
+		                  "Material data slot was allocated after the descriptor set of the current frame had been bound");
+
+		memcpy(Frame.MappedMaterialData + Offset, Data.data(), Data.size());
+		Frame.MaterialDataBuffer->Flush(Offset, Data.size());
+	}
+
+	uint32 MaterialResourceTable::AcquireTexture(const Vulkan::ImageView& View)
+	{
+		auto MaybeIndex = TextureIndices.find(&View);
+		if (MaybeIndex != TextureIndices.end())
+		{
+			TextureSlots[MaybeIndex->second].ReferenceCount++;
+			return MaybeIndex->second;
+		}
+
+		uint32 Index;
+		if (!FreeTextureIndices.empty())
+		{
+			Index = FreeTextureIndices.back();
+			FreeTextureIndices.pop_back();
+		}
+		else
+		{
+			HERMES_ASSERT_LOG(TextureSlots.size() < GMaxBindlessTextureCount, "Too many textures are used by materials");
+			Index = static_cast<uint32>(TextureSlots.size());
+			TextureSlots.emplace_back();
+		}
+
+		TextureSlots[Index] = { &View, 1 };
+		TextureIndices[&View] = Index;
+
+		// The element is not used by any frame that is still in flight, so all copies of the set can be updated right away
+		for (auto& Frame : Frames)
+			Frame.DescriptorSet->UpdateWithImageAndSampler(GBindlessTexturesBinding, Index, View, Renderer::GetDefaultSampler(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		return Index;
+	}
+
+	void MaterialResourceTable::ReleaseTexture(uint32 TextureIndex)
+	{
+		HERMES_ASSERT(TextureIndex < TextureSlots.size());
+
+		auto& Slot = TextureSlots[TextureIndex];
+		HERMES_ASSERT(Slot.ReferenceCount > 0);
+		if (--Slot.ReferenceCount > 0)
+			return;
+
+		TextureIndices.erase(Slot.View);
+		Slot.View = nullptr;
+		Frames[CurrentFrameIndex].PendingTextureFrees.push_back(TextureIndex);
+	}
+
+	void MaterialResourceTable::BeginFrame(uint32 FrameIndex)
+	{
+		HERMES_ASSERT(FrameIndex < Frames.size());
+
+		auto& Frame = Frames[FrameIndex];
+		Frame.IsDescriptorSetInUse = false;
+		if (Frame.MaterialDataBuffer->GetSize() < MaterialDataAllocator.GetCapacity())
+			ResizeMaterialDataBuffer(Frame, MaterialDataAllocator.GetCapacity());
+
+		for (auto Offset : Frame.PendingMaterialDataFrees)
+			MaterialDataAllocator.Free(Offset);
+		Frame.PendingMaterialDataFrees.clear();
+
+		FreeTextureIndices.insert(FreeTextureIndices.end(), Frame.PendingTextureFrees.begin(), Frame.PendingTextureFrees.end());
+		Frame.PendingTextureFrees.clear();
+
+		CurrentFrameIndex = FrameIndex;
+	}
+
+	const Vulkan::DescriptorSetLayout& MaterialResourceTable::GetDescriptorSetLayout() const
+	{
+		return *DescriptorSetLayout;
+	}
+
+	const Vulkan::DescriptorSet& MaterialResourceTable::GetDescriptorSet() const
+	{
+		auto& Frame = Frames[CurrentFrameIndex];
+		Frame.IsDescriptorSetInUse = true;
+		return *Frame.DescriptorSet;
+	}
+
+	void MaterialResourceTable::ResizeMaterialDataBuffer(FrameData& Frame, size_t NewSize) const
+	{
+		auto NewBuffer = Renderer::GetDevice().CreateBuffer(NewSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+		auto* NewMappedData = static_cast<uint8*>(NewBuffer->GetMappedData());
+
+		// NOTE: the slots that are not dirty in this frame are not written again, so their current contents have to be kept
+		if (Frame.MaterialDataBuffer)
+		{
+			auto OldSize = Frame.MaterialDataBuffer->GetSize();
+			memcpy(NewMappedData, Frame.MappedMaterialData, OldSize);
+			NewBuffer->Flush(0, OldSize);
+		}
+
+		Frame.MaterialDataBuffer = std::move(NewBuffer);
+		Frame.MappedMaterialData = NewMappedData;
+		Frame.DescriptorSet->UpdateWithBuffer(GMaterialDataBufferBinding, 0, *Frame.MaterialDataBuffer, 0, static_cast<uint32>(NewSize));
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "Core/Core.h"
+#include "Core/Misc/NonCopyableMovable.h"
+#include "Core/Misc/RangeAllocator.h"
+#include "Vulkan/Forward.h"
+
+namespace Hermes
+{
+	/*
+	 * Owns the material descriptor set that all material pipelines share (see MATERIAL_DATA_DESCRIPTOR_SET in SharedData.h):
+	 * a storage buffer with the data of every material instance and a bindless array of all textures they use. Draws only
+	 * pass the index of their material instance, so the set is bound once per command buffer regardless of the number of
+	 * materials
+	 *
+	 * A data slot is aligned to the size of the data of its material, so that the shader can address it as an element of
+	 * an array of the material's data struct. The buffer and the descriptor set have a copy for every frame in flight because
+	 * the data can change while the previous frames are still rendered. Released slots and texture indices are not reused
+	 * until the GPU has finished all frames that might still read them, see BeginFrame().
+	 *
+	 * When the slots run out, the address space grows immediately and so does the buffer of the current frame unless its
+	 * descriptor set was already handed out for binding. The copies of the other frames, which the GPU might still read,
+	 * are only replaced by larger ones in BeginFrame() of the respective frame.
+	 */
+	class HERMES_API MaterialResourceTable
+	{
+		MAKE_NON_COPYABLE(MaterialResourceTable)
+		MAKE_NON_MOVABLE(MaterialResourceTable)
+
+	public:
+		explicit MaterialResourceTable(uint32 InFramesInFlightCount);
+
+		~MaterialResourceTable();
+
+		/*
+		 * Returns the index of a new data slot, the size must be the array stride of the data struct of the material
+		 */
+		uint32 AllocateMaterialData(size_t Size);
+
+		/*
+		 * The index becomes invalid immediately, the slot is released once the current frame has finished on the GPU
+		 */
+		void FreeMaterialData(uint32 MaterialIndex, size_t Size);
+
+		/*
+		 * Writes the data of a material instance into the copy of the buffer that the current frame uses
+		 */
+		void UpdateMaterialData(uint32 MaterialIndex, std::span<const uint8> Data);
+
+		/*
+		 * Returns the index of the image view in the bindless texture array, adding it if it is not there yet. The views
+		 * are reference counted, every call must be matched by a ReleaseTexture() call
+		 */
+		uint32 AcquireTexture(const Vulkan::ImageView& View);
+
+		void ReleaseTexture(uint32 TextureIndex);
+
+		/*
+		 * Must be called when the GPU has finished the frame that previously used the given frame index. Releases the
+		 * slots and texture indices that were freed while that frame was recorded, later frees are attributed to this frame
+		 */
+		void BeginFrame(uint32 FrameIndex);
+
+		const Vulkan::DescriptorSetLayout& GetDescriptorSetLayout() const;
+
+		/*
+		 * Returns the descriptor set of the current frame. Data slots allocated after this call cannot be updated until
+		 * the next frame if the buffer has to grow for them
+		 */
+		const Vulkan::DescriptorSet& GetDescriptorSet() const;
+
+	private:
+		std::unique_ptr<Vulkan::DescriptorSetLayout> DescriptorSetLayout;
+		std::unique_ptr<Vulkan::DescriptorSetPool> DescriptorSetPool;
+
+		struct FrameData
+		{
+			std::unique_ptr<Vulkan::Buffer> MaterialDataBuffer;
+			uint8* MappedMaterialData = nullptr;
+			std::unique_ptr<Vulkan::DescriptorSet> DescriptorSet;
+			// Set once the descriptor set was returned for binding, it cannot be updated until the GPU finishes the frame
+			mutable bool IsDescriptorSetInUse = false;
+
+			std::vector<size_t> PendingMaterialDataFrees;
+			std::vector<uint32> PendingTextureFrees;
+		};
+		std::vector<FrameData> Frames;
+		uint32 CurrentFrameIndex = 0;
+
+		RangeAllocator MaterialDataAllocator;
+
+		void ResizeMaterialDataBuffer(FrameData& Frame, size_t NewSize) const;
+
+		struct TextureSlot
+		{
+			const Vulkan::ImageView* View = nullptr;
+			uint32 ReferenceCount = 0;
+		};
+		std::vector<TextureSlot> TextureSlots;
+		std::vector<uint32> FreeTextureIndices;
+		std::unordered_map<const Vulkan::ImageView*, uint32> TextureIndices;
+
+		static constexpr size_t InitialMaterialDataBufferSize = 64 * 1024;
+	};
+}
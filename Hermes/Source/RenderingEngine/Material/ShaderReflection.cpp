@@ -4,6 +4,7 @@
 
 #include "Logging/Logger.h"
 #include "Platform/GenericPlatform/PlatformFile.h"
+#include "RenderingEngine/SharedData.h"
 #include "VirtualFilesystem/VirtualFilesystem.h"
 
 namespace Hermes
@@ -30,91 +31,90 @@ namespace Hermes
 		HERMES_ASSERT(ShaderFile->Read(ShaderCode.data(), ShaderFile->Size()));
 
 		spirv_cross::Compiler Compiler(std::move(ShaderCode));
-		const auto& UniformBuffers = Compiler.get_shader_resources().uniform_buffers;
+		const auto& StorageBuffers = Compiler.get_shader_resources().storage_buffers;
 
-		const spirv_cross::Resource* MaterialDataUBO = nullptr;
-		for (const auto& Buffer : UniformBuffers)
+		const spirv_cross::Resource* MaterialDataBuffer = nullptr;
+		for (const auto& Buffer : StorageBuffers)
 		{
-			// NOTE : at the moment only a single uniform buffer at descriptor set 0 binding 0 is supported
-			if (Compiler.get_decoration(Buffer.id, spv::DecorationDescriptorSet) == 1 &&
-				Compiler.get_decoration(Buffer.id, spv::DecorationBinding) == 0)
+			if (Compiler.get_decoration(Buffer.id, spv::DecorationDescriptorSet) == GMaterialDataDescriptorSet &&
+				Compiler.get_decoration(Buffer.id, spv::DecorationBinding) == GMaterialDataBufferBinding)
 			{
-				MaterialDataUBO = &Buffer;
+				MaterialDataBuffer = &Buffer;
 				break;
 			}
 		}
 
-		// Numeric properties (in UBO at binding 0)
-		if (MaterialDataUBO)
+		if (!MaterialDataBuffer)
+			return;
+
+		// NOTE : the buffer must contain a single runtime array of the material data struct that is indexed with the material index
+		const auto& BufferType = Compiler.get_type(MaterialDataBuffer->base_type_id);
+		HERMES_ASSERT_LOG(BufferType.member_types.size() == 1, "Material data buffer must contain a single array of material data structs");
+		const auto& InstanceArrayType = Compiler.get_type(BufferType.member_types[0]);
+		HERMES_ASSERT_LOG(InstanceArrayType.array.size() == 1 && InstanceArrayType.basetype == spirv_cross::SPIRType::Struct,
+		                  "Material data buffer must contain a single array of material data structs");
+
+		MaterialDataSize = Compiler.type_struct_member_array_stride(BufferType, 0);
+		const auto& TypeContainer = Compiler.get_type(InstanceArrayType.self);
+		for (uint32 MemberIndex = 0; MemberIndex < TypeContainer.member_types.size(); MemberIndex++)
 		{
-			const auto& TypeContainer = Compiler.get_type(MaterialDataUBO->base_type_id);
-			SizeForUniformBuffer = Compiler.get_declared_struct_size(TypeContainer);
-			for (uint32 MemberIndex = 0; MemberIndex < TypeContainer.member_types.size(); MemberIndex++)
+			const auto& Name = Compiler.get_member_name(TypeContainer.self, MemberIndex);
+
+			auto& NativeType = Compiler.get_type(TypeContainer.member_types[MemberIndex]);
+			auto Size = Compiler.get_declared_struct_member_size(TypeContainer, MemberIndex);
+			auto Offset = Compiler.type_struct_member_offset(TypeContainer, MemberIndex);
+
+			// Texture property (index into the bindless texture array)
+			if (NativeType.basetype == spirv_cross::SPIRType::Struct)
 			{
-				const auto& Name = Compiler.get_member_name(TypeContainer.self, MemberIndex);
-
-				auto& NativeType = Compiler.get_type(TypeContainer.member_types[MemberIndex]);
-				auto DataType = SPIRVTypeToMaterialPropertyDataType(NativeType.basetype);
-
-				auto Size = Compiler.get_declared_struct_member_size(TypeContainer, MemberIndex);
-				auto Offset = Compiler.type_struct_member_offset(TypeContainer, MemberIndex);
-				size_t ArraySize = 1;
-				if (!NativeType.array.empty())
-					ArraySize = NativeType.array[0];
-				HERMES_ASSERT_LOG(NativeType.array.size() <= 1,
-				                  "Multidimensional array as material properties are not currently supported.");
-
-				auto Type = MaterialPropertyType::Undefined;
-				if (NativeType.vecsize == 1 && NativeType.columns == 1)
-				{
-					Type = MaterialPropertyType::Value;
-				}
-				else if (NativeType.vecsize > 1 && NativeType.columns == 1)
-				{
-					Type = MaterialPropertyType::Vector;
-				}
-				else
-				{
-					HERMES_ASSERT_LOG(NativeType.vecsize == NativeType.columns,
-					                  "Reflection of non-square matrices is not supported");
-					Type = MaterialPropertyType::Matrix;
-				}
+				HERMES_ASSERT_LOG(Compiler.get_name(NativeType.self) == "TextureHandle", "Only TextureHandle structs are supported as material properties");
+				HERMES_ASSERT_LOG(NativeType.array.empty(), "Arrays of textures as material properties are not supported");
+				HERMES_ASSERT(Size == sizeof(uint32));
 
 				MaterialProperty Property;
-				Property.Type = Type;
-				Property.DataType = DataType;
-				Property.Width = NativeType.vecsize;
+				Property.Type = MaterialPropertyType::Texture;
+				Property.DataType = MaterialPropertyDataType::Undefined;
+				Property.Width = 1;
 				Property.Size = Size;
 				Property.Offset = Offset;
-				Property.ArrayLength = ArraySize;
-				Property.Binding = 0;
+				Property.ArrayLength = 1;
 
 				Properties[std::move(Name)] = Property;
+				continue;
 			}
-		}
 
-		// Texture property (DescriptorType::CombinedImageSampler)
-		for (const auto& Texture : Compiler.get_shader_resources().sampled_images)
-		{
-			// NOTE: material properties are located only in descriptor set 1
-			if (Compiler.get_decoration(Texture.id, spv::DecorationDescriptorSet) != 1)
-				continue;
-			
-			const auto& Name = Compiler.get_name(Texture.id);
+			// Numeric property
+			auto DataType = SPIRVTypeToMaterialPropertyDataType(NativeType.basetype);
 
-			HERMES_ASSERT_LOG(Compiler.get_type(Texture.type_id).array.empty(),
-			                  "Arrays of textures as material properties are not supported");
+			size_t ArraySize = 1;
+			if (!NativeType.array.empty())
+				ArraySize = NativeType.array[0];
+			HERMES_ASSERT_LOG(NativeType.array.size() <= 1,
+			                  "Multidimensional array as material properties are not currently supported.");
 
-			auto Binding = Compiler.get_decoration(Texture.id, spv::DecorationBinding);
+			auto Type = MaterialPropertyType::Undefined;
+			if (NativeType.vecsize == 1 && NativeType.columns == 1)
+			{
+				Type = MaterialPropertyType::Value;
+			}
+			else if (NativeType.vecsize > 1 && NativeType.columns == 1)
+			{
+				Type = MaterialPropertyType::Vector;
+			}
+			else
+			{
+				HERMES_ASSERT_LOG(NativeType.vecsize == NativeType.columns,
+				                  "Reflection of non-square matrices is not supported");
+				Type = MaterialPropertyType::Matrix;
+			}
 
 			MaterialProperty Property;
-			Property.Type = MaterialPropertyType::Texture;
-			Property.DataType = MaterialPropertyDataType::Undefined;
-			Property.Width = 1;
-			Property.Size = 0;
-			Property.Offset = 0;
-			Property.ArrayLength = 1;
-			Property.Binding = Binding;
+			Property.Type = Type;
+			Property.DataType = DataType;
+			Property.Width = NativeType.vecsize;
+			Property.Size = Size;
+			Property.Offset = Offset;
+			Property.ArrayLength = ArraySize;
 
 			Properties[std::move(Name)] = Property;
 		}
@@ -133,13 +133,13 @@ namespace Hermes
 		return Properties;
 	}
 
-	bool ShaderReflection::RequiresUniformBuffer() const
+	bool ShaderReflection::HasMaterialData() const
 	{
-		return SizeForUniformBuffer > 0;
+		return MaterialDataSize > 0;
 	}
 
-	size_t ShaderReflection::GetTotalSizeForUniformBuffer() const
+	size_t ShaderReflection::GetMaterialDataSize() const
 	{
-		return SizeForUniformBuffer;
+		return MaterialDataSize;
 	}
 }
@@ -11,8 +11,10 @@ namespace Hermes
 	 * Stores a list of exposed properties of a single shader
 	 *
 	 * Currently in development, the functionality is very limited.
-	 * At the moment, only supports a single uniform buffer at
-	 * descriptor set 1 binding 0.
+	 * At the moment, only reflects the members of the material data struct,
+	 * which is the element type of the storage buffer at descriptor set 1
+	 * binding 0 (see material_data.glsl). Textures are members of type
+	 * TextureHandle that hold an index into the bindless texture array.
 	 */
 	class HERMES_API ShaderReflection
 	{
@@ -23,12 +25,15 @@ namespace Hermes
 
 		const std::unordered_map<String, MaterialProperty>& GetProperties() const;
 
-		bool RequiresUniformBuffer() const;
+		bool HasMaterialData() const;
 
-		size_t GetTotalSizeForUniformBuffer() const;
+		/*
+		 * Returns the array stride of the material data struct, i.e. its size including the padding between instances
+		 */
+		size_t GetMaterialDataSize() const;
 
 	private:
 		std::unordered_map<String, MaterialProperty> Properties;
-		size_t SizeForUniformBuffer = 0;
+		size_t MaterialDataSize = 0;
 	};
 }
@@ -1,6 +1,9 @@
 ﻿#include "Mesh.h"
 
+#include <algorithm>
+
 #include "AssetSystem/AssetLoader.h"
+#include "Logging/Logger.h"
 #include "RenderingEngine/GPUInteractionUtilities.h"
 #include "RenderingEngine/Renderer.h"
 #include "Vulkan/Device.h"
@@ -9,24 +12,45 @@ namespace Hermes
 {
 	HERMES_ADD_BINARY_ASSET_LOADER(Mesh, Mesh);
 
-	Mesh::Mesh(String Name, std::span<const Vertex> Vertices, std::span<const uint32> Indices, std::vector<PrimitiveDrawInformation> InPrimitives)
+	Mesh::Mesh(String Name, std::span<const uint8> VertexData, MeshVertexFormat InVertexFormat, Vec3 InPositionOffset, Vec3 InPositionScale,
+	           std::span<const uint8> IndexData, VkIndexType InIndexType, std::vector<PrimitiveDrawInformation> InPrimitives,
+	           std::span<const Meshlet> Meshlets, float Radius)
 		: Asset(std::move(Name), AssetType::Mesh)
+		, Arena(Renderer::GetMeshArena())
+		, IndexType(InIndexType)
+		, MeshletCount(static_cast<uint32>(Meshlets.size()))
 		, Primitives(std::move(InPrimitives))
-		, BoundingVolume(CalculateMeshRadius(Vertices))
+		, VertexFormat(InVertexFormat)
+		, PositionOffset(InPositionOffset)
+		, PositionScale(InPositionScale)
+		, BoundingVolume(Radius)
 	{
 		auto& Device = Renderer::GetDevice();
 
-		auto VertexBufferSize = Vertices.size() * sizeof(Vertex);
-		VertexBuffer = Device.CreateBuffer(VertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+		auto VertexStride = static_cast<uint32>(VertexFormat == MeshVertexFormat::Compressed ? sizeof(CompressedVertex) : sizeof(Vertex));
+		VertexAllocation = Arena->AllocateVertices(VertexData, VertexStride);
+		IndexAllocation = Arena->AllocateIndices(IndexData, IndexType);
 
-		auto IndexBufferSize = Indices.size() * sizeof(uint32);
-		IndexBuffer = Device.CreateBuffer(IndexBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+		if (!Meshlets.empty())
+		{
+			MeshletBuffer = Device.CreateBuffer(Meshlets.size_bytes(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+			GPUInteractionUtilities::UploadDataToGPUBuffer(Meshlets.data(), Meshlets.size_bytes(), 0, *MeshletBuffer);
 
-		GPUInteractionUtilities::UploadDataToGPUBuffer(Vertices.data(), VertexBufferSize, 0, *VertexBuffer);
-		GPUInteractionUtilities::UploadDataToGPUBuffer(Indices.data(), IndexBufferSize, 0, *IndexBuffer);
+			MeshletDescriptorSet = Renderer::GetDescriptorAllocator().Allocate(Renderer::GetMeshletDataDescriptorSetLayout());
+			MeshletDescriptorSet->UpdateWithBuffer(0, 0, *MeshletBuffer, 0, static_cast<uint32>(Meshlets.size_bytes()));
+		}
 	}
 
-	float Mesh::CalculateMeshRadius(std::span<const Vertex> Vertices) const
+	Mesh::~Mesh()
+	{
+		Arena->Free(VertexAllocation);
+		Arena->Free(IndexAllocation);
+
+		// NOTE: the meshlet culling pass of a frame that is still in flight might read the meshlet list
+		Arena->Retire(std::move(MeshletBuffer), std::move(MeshletDescriptorSet));
+	}
+
+	float Mesh::CalculateMeshRadius(std::span<const Vertex> Vertices)
 	{
 		float MaxDistanceSquared = 0.0f;
 		for (const auto& Vertex : Vertices)
@@ -37,17 +61,144 @@ namespace Hermes
 		return Math::Sqrt(MaxDistanceSquared);
 	}
 
+	float Mesh::CalculateMeshRadius(std::span<const CompressedVertex> Vertices, Vec3 PositionOffset, Vec3 PositionScale)
+	{
+		float MaxDistanceSquared = 0.0f;
+		for (const auto& Vertex : Vertices)
+		{
+			auto NormalizedPosition = Vec3(Vertex.Position[0], Vertex.Position[1], Vertex.Position[2]) / 65535.0f;
+			auto Position = PositionOffset + PositionScale * NormalizedPosition;
+			MaxDistanceSquared = Math::Max(MaxDistanceSquared, Position.LengthSq());
+		}
+
+		return Math::Sqrt(MaxDistanceSquared);
+	}
+
+	std::vector<uint8> Mesh::PackIndices(std::span<const uint32> Indices, VkIndexType& IndexType)
+	{
+		bool FitsIntoUInt16 = std::ranges::all_of(Indices, [](uint32 Index) { return Index <= UINT16_MAX; });
+		if (!FitsIntoUInt16)
+		{
+			IndexType = VK_INDEX_TYPE_UINT32;
+			std::vector<uint8> Result(Indices.size_bytes());
+			memcpy(Result.data(), Indices.data(), Indices.size_bytes());
+			return Result;
+		}
+
+		IndexType = VK_INDEX_TYPE_UINT16;
+		std::vector<uint8> Result(Indices.size() * sizeof(uint16));
+		auto* Destination = reinterpret_cast<uint16*>(Result.data());
+		for (size_t Index = 0; Index < Indices.size(); Index++)
+			Destination[Index] = static_cast<uint16>(Indices[Index]);
+		return Result;
+	}
+
+	std::optional<std::vector<Meshlet>> Mesh::ConvertMeshlets(const String& MeshName, std::span<const MeshletHeader> MeshletHeaders,
+	                                                          std::vector<PrimitiveDrawInformation>& Primitives)
+	{
+		std::vector<Meshlet> Result(MeshletHeaders.size());
+		for (uint32 MeshletIndex = 0; MeshletIndex < static_cast<uint32>(MeshletHeaders.size()); MeshletIndex++)
+		{
+			const auto& Header = MeshletHeaders[MeshletIndex];
+			if (Header.PrimitiveIndex >= Primitives.size())
+			{
+				HERMES_LOG_ERROR("Meshlet %u of mesh %s refers to primitive %u, but the mesh has only %zu primitives", MeshletIndex, MeshName.data(),
+				                 Header.PrimitiveIndex, Primitives.size());
+				return {};
+			}
+
+			auto& Primitive = Primitives[Header.PrimitiveIndex];
+			// NOTE: meshlets of a primitive must be stored contiguously, which MeshToAsset guarantees
+			if (Primitive.MeshletCount == 0)
+				Primitive.MeshletOffset = MeshletIndex;
+			if (Primitive.MeshletOffset + Primitive.MeshletCount != MeshletIndex)
+			{
+				HERMES_LOG_ERROR("Meshlets of primitive %u of mesh %s are not stored contiguously", Header.PrimitiveIndex, MeshName.data());
+				return {};
+			}
+			Primitive.MeshletCount++;
+
+			auto& Meshlet = Result[MeshletIndex];
+			Meshlet.BoundingSphere = Vec4(Header.Center, Header.Radius);
+			Meshlet.Cone = Vec4(Header.ConeAxis, Header.ConeCutoff);
+			Meshlet.IndexOffset = Header.IndexOffset;
+			Meshlet.IndexCount = Header.IndexCount;
+			Meshlet.PrimitiveIndex = Header.PrimitiveIndex;
+		}
+
+		// Every meshlet stores the first meshlet of its primitive so that the culling shader can find the draw command range of the primitive
+		for (auto& Meshlet : Result)
+			Meshlet.FirstMeshletOfPrimitive = Primitives[Meshlet.PrimitiveIndex].MeshletOffset;
+
+		return Result;
+	}
+
 	AssetHandle<Mesh> Mesh::Create(String Name, std::span<const Vertex> Vertices, std::span<const uint32> Indices, std::vector<PrimitiveDrawInformation> Primitives)
 	{
-		return AssetHandle<Mesh>(new Mesh(std::move(Name), Vertices, Indices, std::move(Primitives)));
+		auto VertexData = std::span(reinterpret_cast<const uint8*>(Vertices.data()), Vertices.size_bytes());
+		auto Radius = CalculateMeshRadius(Vertices);
+
+		VkIndexType IndexType;
+		auto IndexData = PackIndices(Indices, IndexType);
+
+		return AssetHandle<Mesh>(new Mesh(std::move(Name), VertexData, MeshVertexFormat::Full, Vec3(0.0f), Vec3(1.0f),
+		                                  IndexData, IndexType, std::move(Primitives), {}, Radius));
+	}
+
+	AssetHandle<Mesh> Mesh::Create(String Name, std::span<const CompressedVertex> Vertices, Vec3 BoundingBoxMin, Vec3 BoundingBoxMax,
+	                               std::span<const uint32> Indices, std::vector<PrimitiveDrawInformation> Primitives)
+	{
+		auto VertexData = std::span(reinterpret_cast<const uint8*>(Vertices.data()), Vertices.size_bytes());
+		auto PositionScale = BoundingBoxMax - BoundingBoxMin;
+		auto Radius = CalculateMeshRadius(Vertices, BoundingBoxMin, PositionScale);
+
+		VkIndexType IndexType;
+		auto IndexData = PackIndices(Indices, IndexType);
+
+		return AssetHandle<Mesh>(new Mesh(std::move(Name), VertexData, MeshVertexFormat::Compressed, BoundingBoxMin, PositionScale,
+		                                  IndexData, IndexType, std::move(Primitives), {}, Radius));
 	}
 
 	AssetHandle<Asset> Mesh::Load(String Name, std::span<const uint8> BinaryData)
 	{
+		if (BinaryData.size() < sizeof(MeshAssetHeader))
+		{
+			HERMES_LOG_ERROR("Mesh %s is too small to contain a mesh header", Name.data());
+			return nullptr;
+		}
+
 		const uint8* DataPtr = BinaryData.data();
 		const auto* Header = reinterpret_cast<const MeshAssetHeader*>(DataPtr);
 		DataPtr += sizeof(*Header);
 
+		// NOTE: meshes written before the version field existed are rejected either here or by the size check below
+		if (Header->Version != MeshAssetHeader::CurrentVersion)
+		{
+			HERMES_LOG_ERROR("Mesh %s has format version %u, but version %u is expected; convert it again with MeshToAsset", Name.data(),
+			                 Header->Version, MeshAssetHeader::CurrentVersion);
+			return nullptr;
+		}
+
+		bool HasKnownVertexFormat = Header->VertexFormat == MeshVertexFormat::Full || Header->VertexFormat == MeshVertexFormat::Compressed;
+		bool HasKnownIndexType = Header->IndexType == MeshIndexType::UInt32 || Header->IndexType == MeshIndexType::UInt16;
+		if (!HasKnownVertexFormat || !HasKnownIndexType)
+		{
+			HERMES_LOG_ERROR("Mesh %s has unknown vertex format or index type, it was probably written by an older MeshToAsset", Name.data());
+			return nullptr;
+		}
+
+		// NOTE: the sizes are computed in 64 bits, so a corrupted header cannot make them wrap around
+		size_t ExpectedDataSize = sizeof(MeshAssetHeader) +
+			static_cast<size_t>(Header->PrimitiveCount) * sizeof(MeshPrimitiveHeader) +
+			static_cast<size_t>(Header->VertexBufferSize) * (Header->VertexFormat == MeshVertexFormat::Compressed ? sizeof(CompressedVertex) : sizeof(Vertex)) +
+			static_cast<size_t>(Header->IndexBufferSize) * (Header->IndexType == MeshIndexType::UInt16 ? sizeof(uint16) : sizeof(uint32)) +
+			static_cast<size_t>(Header->MeshletCount) * sizeof(MeshletHeader);
+		if (ExpectedDataSize != BinaryData.size())
+		{
+			HERMES_LOG_ERROR("Mesh %s has %zu bytes of data, but its header describes %zu bytes", Name.data(), BinaryData.size(), ExpectedDataSize);
+			return nullptr;
+		}
+
 		std::vector<PrimitiveDrawInformation> Primitives(Header->PrimitiveCount);
 		for (auto& Primitive : Primitives)
 		{
@@ -58,27 +209,59 @@ namespace Hermes
 			Primitive.IndexCount = PrimitiveHeader->IndexCount;
 		}
 
-		std::vector<Vertex> Vertices(Header->VertexBufferSize);
-		memcpy(Vertices.data(), DataPtr, Header->VertexBufferSize * sizeof(Vertex));
-		DataPtr += Header->VertexBufferSize * sizeof(Vertex);
+		bool IsCompressed = Header->VertexFormat == MeshVertexFormat::Compressed;
+		size_t VertexDataSize = Header->VertexBufferSize * (IsCompressed ? sizeof(CompressedVertex) : sizeof(Vertex));
+		auto VertexData = std::span(DataPtr, VertexDataSize);
+		DataPtr += VertexDataSize;
+
+		bool HasShortIndices = Header->IndexType == MeshIndexType::UInt16;
+		size_t IndexDataSize = Header->IndexBufferSize * (HasShortIndices ? sizeof(uint16) : sizeof(uint32));
+		auto IndexData = std::span(DataPtr, IndexDataSize);
+		DataPtr += IndexDataSize;
+
+		auto MeshletHeaders = std::span(reinterpret_cast<const MeshletHeader*>(DataPtr), Header->MeshletCount);
+		DataPtr += MeshletHeaders.size_bytes();
+		auto Meshlets = ConvertMeshlets(Name, MeshletHeaders, Primitives);
+		if (!Meshlets.has_value())
+			return nullptr;
 
-		std::vector<uint32> Indices(Header->IndexBufferSize);
-		memcpy(Indices.data(), DataPtr, Header->IndexBufferSize * sizeof(uint32));
-		DataPtr += Header->IndexBufferSize * sizeof(uint32);
-		
 		HERMES_ASSERT(DataPtr == BinaryData.data() + BinaryData.size());
 
-		return Create(std::move(Name), Vertices, Indices, Primitives);
+		auto IndexType = HasShortIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+		// NOTE: vertices are copied because the vertex data in the file is not necessarily aligned
+		if (IsCompressed)
+		{
+			std::vector<CompressedVertex> Vertices(Header->VertexBufferSize);
+			memcpy(Vertices.data(), VertexData.data(), VertexDataSize);
+
+			auto PositionScale = Header->BoundingBoxMax - Header->BoundingBoxMin;
+			auto Radius = CalculateMeshRadius(Vertices, Header->BoundingBoxMin, PositionScale);
+			return AssetHandle<Asset>(new Mesh(std::move(Name), VertexData, MeshVertexFormat::Compressed, Header->BoundingBoxMin, PositionScale,
+			                                   IndexData, IndexType, std::move(Primitives), Meshlets.value(), Radius));
+		}
+
+		std::vector<Vertex> Vertices(Header->VertexBufferSize);
+		memcpy(Vertices.data(), VertexData.data(), VertexDataSize);
+
+		auto Radius = CalculateMeshRadius(Vertices);
+		return AssetHandle<Asset>(new Mesh(std::move(Name), VertexData, MeshVertexFormat::Full, Vec3(0.0f), Vec3(1.0f),
+		                                   IndexData, IndexType, std::move(Primitives), Meshlets.value(), Radius));
+	}
+
+	int32 Mesh::GetVertexOffset() const
+	{
+		return static_cast<int32>(Arena->GetFirstElement(VertexAllocation));
 	}
 
-	const Vulkan::Buffer& Mesh::GetVertexBuffer() const
+	uint32 Mesh::GetFirstIndex() const
 	{
-		return *VertexBuffer;
+		return Arena->GetFirstElement(IndexAllocation);
 	}
 
-	const Vulkan::Buffer& Mesh::GetIndexBuffer() const
+	VkIndexType Mesh::GetIndexType() const
 	{
-		return *IndexBuffer;
+		return IndexType;
 	}
 
 	std::span<const Mesh::PrimitiveDrawInformation> Mesh::GetPrimitives() const
@@ -86,8 +269,39 @@ namespace Hermes
 		return Primitives;
 	}
 
+	MeshVertexFormat Mesh::GetVertexFormat() const
+	{
+		return VertexFormat;
+	}
+
+	Vec3 Mesh::GetPositionOffset() const
+	{
+		return PositionOffset;
+	}
+
+	Vec3 Mesh::GetPositionScale() const
+	{
+		return PositionScale;
+	}
+
 	const SphereBoundingVolume& Mesh::GetBoundingVolume() const
 	{
 		return BoundingVolume;
 	}
+
+	bool Mesh::HasMeshlets() const
+	{
+		return MeshletCount > 0;
+	}
+
+	uint32 Mesh::GetMeshletCount() const
+	{
+		return MeshletCount;
+	}
+
+	const Vulkan::DescriptorSet& Mesh::GetMeshletDescriptorSet() const
+	{
+		HERMES_ASSERT(MeshletDescriptorSet);
+		return *MeshletDescriptorSet;
+	}
 }
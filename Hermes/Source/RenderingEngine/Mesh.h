@@ -1,13 +1,17 @@
 ﻿#pragma once
 
 #include <memory>
+#include <optional>
 #include <span>
 #include <vector>
 
 #include "AssetSystem/AssetHeaders.h"
 #include "Core/Core.h"
 #include "Math/BoundingVolume.h"
+#include "RenderingEngine/MeshArena.h"
+#include "RenderingEngine/SharedData.h"
 #include "Vulkan/Buffer.h"
+#include "Vulkan/Descriptor.h"
 
 namespace Hermes
 {
@@ -20,27 +24,91 @@ namespace Hermes
 		{
 			uint32 IndexOffset;
 			uint32 IndexCount;
+
+			// Range of the meshlet list that covers this primitive, empty if the mesh has no meshlets
+			uint32 MeshletOffset = 0;
+			uint32 MeshletCount = 0;
 		};
 
 		static AssetHandle<Mesh> Create(String Name, std::span<const Vertex> Vertices, std::span<const uint32> Indices, std::vector<PrimitiveDrawInformation> Primitives);
 
+		/*
+		 * Creates a mesh from compressed vertices whose positions were quantized relative to the bounding box [BoundingBoxMin; BoundingBoxMax]
+		 */
+		static AssetHandle<Mesh> Create(String Name, std::span<const CompressedVertex> Vertices, Vec3 BoundingBoxMin, Vec3 BoundingBoxMax,
+		                                std::span<const uint32> Indices, std::vector<PrimitiveDrawInformation> Primitives);
+
 		static AssetHandle<Asset> Load(String Name, std::span<const uint8> BinaryData);
 
-		const Vulkan::Buffer& GetVertexBuffer() const;
-		const Vulkan::Buffer& GetIndexBuffer() const;
+		~Mesh() override;
+
+		/*
+		 * Vertices and indices are stored in the global mesh arena (see Renderer::GetMeshArena()); these values have to be
+		 * passed as vertexOffset and added to firstIndex of every draw. They can change when the arena is defragmented,
+		 * so they must be queried every frame
+		 */
+		int32 GetVertexOffset() const;
+		uint32 GetFirstIndex() const;
+		VkIndexType GetIndexType() const;
 		std::span<const PrimitiveDrawInformation> GetPrimitives() const;
 
+		MeshVertexFormat GetVertexFormat() const;
+
+		/*
+		 * Returns the offset and scale that need to be applied to the vertex positions stored in the vertex buffer to get
+		 * the actual positions in model space
+		 */
+		Vec3 GetPositionOffset() const;
+		Vec3 GetPositionScale() const;
+
 		const SphereBoundingVolume& GetBoundingVolume() const;
 
+		/*
+		 * Returns true if the mesh was split into meshlets when it was imported, only such meshes can be culled and drawn on the GPU
+		 */
+		bool HasMeshlets() const;
+		uint32 GetMeshletCount() const;
+
+		/*
+		 * Returns a descriptor set with the layout Renderer::GetMeshletDataDescriptorSetLayout() that contains the meshlet list
+		 * of the mesh. Must only be called if HasMeshlets() returns true
+		 */
+		const Vulkan::DescriptorSet& GetMeshletDescriptorSet() const;
+
 	private:
-		Mesh(String Name, std::span<const Vertex> Vertices, std::span<const uint32> Indices, std::vector<PrimitiveDrawInformation> InPrimitives);
+		Mesh(String Name, std::span<const uint8> VertexData, MeshVertexFormat InVertexFormat, Vec3 InPositionOffset, Vec3 InPositionScale,
+		     std::span<const uint8> IndexData, VkIndexType InIndexType, std::vector<PrimitiveDrawInformation> InPrimitives,
+		     std::span<const Meshlet> Meshlets, float Radius);
 		
-		std::unique_ptr<Vulkan::Buffer> VertexBuffer, IndexBuffer;
+		std::shared_ptr<MeshArena> Arena;
+		MeshArena::AllocationHandle VertexAllocation, IndexAllocation;
+		VkIndexType IndexType;
+
+		std::unique_ptr<Vulkan::Buffer> MeshletBuffer;
+		std::unique_ptr<Vulkan::DescriptorSet> MeshletDescriptorSet;
+		uint32 MeshletCount = 0;
 
 		std::vector<PrimitiveDrawInformation> Primitives;
 
+		MeshVertexFormat VertexFormat;
+		Vec3 PositionOffset;
+		Vec3 PositionScale;
+
 		SphereBoundingVolume BoundingVolume;
 
-		float CalculateMeshRadius(std::span<const Vertex> Vertices) const;
+		static float CalculateMeshRadius(std::span<const Vertex> Vertices);
+		static float CalculateMeshRadius(std::span<const CompressedVertex> Vertices, Vec3 PositionOffset, Vec3 PositionScale);
+
+		/*
+		 * Converts the indices to 16-bit if all of them fit into 16 bits and returns the raw index buffer data
+		 */
+		static std::vector<uint8> PackIndices(std::span<const uint32> Indices, VkIndexType& IndexType);
+
+		/*
+		 * Converts meshlet headers from the asset file into the GPU representation and assigns meshlet ranges to the primitives.
+		 * Returns nothing if a meshlet refers to a nonexistent primitive or the meshlets of a primitive are not contiguous
+		 */
+		static std::optional<std::vector<Meshlet>> ConvertMeshlets(const String& MeshName, std::span<const MeshletHeader> MeshletHeaders,
+		                                                           std::vector<PrimitiveDrawInformation>& Primitives);
 	};
 }
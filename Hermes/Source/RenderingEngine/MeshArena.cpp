@@ -0,0 +1,264 @@
+#include "MeshArena.h"
+
+#include <algorithm>
+#include <array>
+
+#include "Logging/Logger.h"
+#include "RenderingEngine/GPUInteractionUtilities.h"
+#include "RenderingEngine/Renderer.h"
+#include "Vulkan/Buffer.h"
+#include "Vulkan/CommandBuffer.h"
+#include "Vulkan/Descriptor.h"
+#include "Vulkan/Device.h"
+#include "Vulkan/Fence.h"
+#include "Vulkan/Queue.h"
+
+namespace Hermes
+{
+	MeshArena::MeshArena(uint32 InFramesInFlightCount)
+		: VertexRegion(CreateRegion(InitialVertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT))
+		, IndexRegion(CreateRegion(InitialIndexBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT))
+		, Frames(InFramesInFlightCount)
+	{
+	}
+
+	MeshArena::~MeshArena() = default;
+
+	MeshArena::AllocationHandle MeshArena::AllocateVertices(std::span<const uint8> VertexData, uint32 VertexStride)
+	{
+		return Allocate(false, VertexData, VertexStride);
+	}
+
+	MeshArena::AllocationHandle MeshArena::AllocateIndices(std::span<const uint8> IndexData, VkIndexType IndexType)
+	{
+		HERMES_ASSERT(IndexType == VK_INDEX_TYPE_UINT16 || IndexType == VK_INDEX_TYPE_UINT32);
+		return Allocate(true, IndexData, IndexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16) : sizeof(uint32));
+	}
+
+	void MeshArena::Free(AllocationHandle Handle)
+	{
+		HERMES_ASSERT(Handle < Allocations.size() && Allocations[Handle].IsUsed);
+
+		auto& Record = Allocations[Handle];
+		Frames[CurrentFrameIndex].PendingFrees.push_back({ Record.IsIndexData, Record.Offset });
+
+		Record = {};
+		FreeHandles.push_back(Handle);
+	}
+
+	void MeshArena::Retire(std::unique_ptr<Vulkan::Buffer> Buffer, std::unique_ptr<Vulkan::DescriptorSet> DescriptorSet)
+	{
+		auto& Frame = Frames[CurrentFrameIndex];
+		if (DescriptorSet)
+			Frame.RetiredDescriptorSets.push_back(std::move(DescriptorSet));
+		if (Buffer)
+			Frame.RetiredBuffers.push_back(std::move(Buffer));
+	}
+
+	void MeshArena::BeginFrame(uint32 FrameIndex)
+	{
+		HERMES_ASSERT(FrameIndex < Frames.size());
+
+		ReleasePendingFrees(FrameIndex);
+		Frames[FrameIndex].RetiredDescriptorSets.clear();
+		Frames[FrameIndex].RetiredBuffers.clear();
+		CurrentFrameIndex = FrameIndex;
+
+		if (IsDefragmentationRequested)
+		{
+			ReleaseAllPendingFrees();
+			Defragment(VertexRegion, false);
+			Defragment(IndexRegion, true);
+			IsDefragmentationRequested = false;
+		}
+	}
+
+	uint32 MeshArena::GetFirstElement(AllocationHandle Handle) const
+	{
+		HERMES_ASSERT(Handle < Allocations.size() && Allocations[Handle].IsUsed);
+
+		const auto& Record = Allocations[Handle];
+		HERMES_ASSERT(Record.Offset % Record.ElementSize == 0);
+		return static_cast<uint32>(Record.Offset / Record.ElementSize);
+	}
+
+	const Vulkan::Buffer& MeshArena::GetVertexBuffer() const
+	{
+		return *VertexRegion.Buffer;
+	}
+
+	const Vulkan::Buffer& MeshArena::GetIndexBuffer() const
+	{
+		return *IndexRegion.Buffer;
+	}
+
+	void MeshArena::Defragment()
+	{
+		IsDefragmentationRequested = true;
+	}
+
+	MeshArena::AllocationHandle MeshArena::Allocate(bool IsIndexData, std::span<const uint8> Data, uint32 ElementSize)
+	{
+		auto& Region = IsIndexData ? IndexRegion : VertexRegion;
+		auto Size = Data.size();
+
+		auto Offset = Region.Allocator.Allocate(Size, ElementSize);
+		if (!Offset.has_value())
+		{
+			// The ranges freed in the previous frames might be enough, waiting for them is cheaper than growing the buffer
+			ReleaseAllPendingFrees();
+			Offset = Region.Allocator.Allocate(Size, ElementSize);
+		}
+		if (!Offset.has_value())
+		{
+			// NOTE: the free space might be enough in total and just too fragmented, but the allocations cannot be moved
+			//       in the middle of a frame, so the buffer grows now and is compacted at the beginning of the next frame
+			auto FreeSize = Region.Allocator.GetCapacity() - Region.Allocator.GetAllocatedSize();
+			if (FreeSize >= Size + ElementSize)
+				IsDefragmentationRequested = true;
+
+			Grow(Region, Region.Allocator.GetCapacity() + Size + ElementSize);
+			Offset = Region.Allocator.Allocate(Size, ElementSize);
+		}
+		HERMES_ASSERT(Offset.has_value());
+
+		GPUInteractionUtilities::UploadDataToGPUBuffer(Data.data(), Size, Offset.value(), *Region.Buffer);
+
+		AllocationHandle Handle;
+		if (!FreeHandles.empty())
+		{
+			Handle = FreeHandles.back();
+			FreeHandles.pop_back();
+		}
+		else
+		{
+			Handle = static_cast<AllocationHandle>(Allocations.size());
+			Allocations.emplace_back();
+		}
+
+		Allocations[Handle] = { true, IsIndexData, Offset.value(), ElementSize };
+		return Handle;
+	}
+
+	void MeshArena::Grow(Region& Region, size_t MinimalCapacity)
+	{
+		auto& Device = Renderer::GetDevice();
+
+		auto OldCapacity = Region.Allocator.GetCapacity();
+		auto NewCapacity = std::max(OldCapacity * 2, MinimalCapacity);
+		HERMES_LOG_INFO("Growing mesh arena buffer from %zu to %zu bytes", OldCapacity, NewCapacity);
+
+		auto NewBuffer = Device.CreateBuffer(NewCapacity, Region.Usage);
+
+		// NOTE: the offsets of the allocations do not change, so the whole old buffer can be copied with a single region.
+		//       All uploads have already finished and the frames in flight only read the old buffer, so there is no need to wait for them
+		auto& Queue = Device.GetQueue(VK_QUEUE_TRANSFER_BIT);
+		auto CommandBuffer = Queue.CreateCommandBuffer();
+		CommandBuffer->BeginRecording();
+		VkBufferCopy Copy = {};
+		Copy.srcOffset = 0;
+		Copy.dstOffset = 0;
+		Copy.size = OldCapacity;
+		CommandBuffer->CopyBuffer(*Region.Buffer, *NewBuffer, { &Copy, 1 });
+		CommandBuffer->EndRecording();
+
+		auto Fence = Renderer::GetSynchronizationPool().AcquireFence();
+		Queue.SubmitCommandBuffer(*CommandBuffer, Fence.get());
+		Fence->Wait(UINT64_MAX);
+
+		Frames[CurrentFrameIndex].RetiredBuffers.push_back(std::move(Region.Buffer));
+		Region.Buffer = std::move(NewBuffer);
+		Region.Allocator.Grow(NewCapacity);
+	}
+
+	void MeshArena::Defragment(Region& Region, bool IsIndexData)
+	{
+		auto Relocations = Region.Allocator.Defragment();
+		if (Relocations.empty())
+			return;
+
+		auto& Device = Renderer::GetDevice();
+
+		// NOTE: source and destination ranges of a copy within the same buffer must not overlap, so the relocated
+		//       allocations are first copied into a temporary buffer and then back to their new offsets
+		std::vector<VkBufferCopy> CopiesToTemporaryBuffer, CopiesFromTemporaryBuffer;
+		size_t TemporaryBufferSize = 0;
+		for (const auto& Relocation : Relocations)
+		{
+			CopiesToTemporaryBuffer.push_back({ Relocation.OldOffset, TemporaryBufferSize, Relocation.Size });
+			CopiesFromTemporaryBuffer.push_back({ TemporaryBufferSize, Relocation.NewOffset, Relocation.Size });
+			TemporaryBufferSize += Relocation.Size;
+		}
+		auto TemporaryBuffer = Device.CreateBuffer(TemporaryBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+
+		Device.WaitForIdle();
+
+		auto& Queue = Device.GetQueue(VK_QUEUE_TRANSFER_BIT);
+		auto CommandBuffer = Queue.CreateCommandBuffer();
+		CommandBuffer->BeginRecording();
+
+		CommandBuffer->CopyBuffer(*Region.Buffer, *TemporaryBuffer, CopiesToTemporaryBuffer);
+
+		VkBufferMemoryBarrier Barrier = {
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+			.pNext = nullptr,
+			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT,
+			.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.buffer = VK_NULL_HANDLE,
+			.offset = 0,
+			.size = VK_WHOLE_SIZE
+		};
+		std::array<VkBufferMemoryBarrier, 2> Barriers = { Barrier, Barrier };
+		Barriers[0].buffer = Region.Buffer->GetBuffer();
+		Barriers[1].buffer = TemporaryBuffer->GetBuffer();
+		CommandBuffer->InsertBufferMemoryBarriers(Barriers, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+		CommandBuffer->CopyBuffer(*TemporaryBuffer, *Region.Buffer, CopiesFromTemporaryBuffer);
+		CommandBuffer->EndRecording();
+
+		auto Fence = Renderer::GetSynchronizationPool().AcquireFence();
+		Queue.SubmitCommandBuffer(*CommandBuffer, Fence.get());
+		Fence->Wait(UINT64_MAX);
+
+		// Relocations are sorted by their old offset, so the new offset of every allocation can be found with a binary search
+		for (auto& Record : Allocations)
+		{
+			if (!Record.IsUsed || Record.IsIndexData != IsIndexData)
+				continue;
+
+			auto It = std::ranges::lower_bound(Relocations, Record.Offset, {}, &RangeAllocator::Relocation::OldOffset);
+			if (It != Relocations.end() && It->OldOffset == Record.Offset)
+				Record.Offset = It->NewOffset;
+		}
+	}
+
+	void MeshArena::ReleaseAllPendingFrees()
+	{
+		Renderer::GetDevice().WaitForIdle();
+		for (uint32 FrameIndex = 0; FrameIndex < Frames.size(); FrameIndex++)
+		{
+			if (FrameIndex != CurrentFrameIndex)
+				ReleasePendingFrees(FrameIndex);
+		}
+	}
+
+	void MeshArena::ReleasePendingFrees(uint32 FrameIndex)
+	{
+		auto& Frame = Frames[FrameIndex];
+		for (const auto& Pending : Frame.PendingFrees)
+		{
+			auto& Region = Pending.IsIndexData ? IndexRegion : VertexRegion;
+			Region.Allocator.Free(Pending.Offset);
+		}
+		Frame.PendingFrees.clear();
+	}
+
+	MeshArena::Region MeshArena::CreateRegion(size_t Capacity, VkBufferUsageFlags Usage)
+	{
+		// NOTE: the buffers are also a transfer source because their contents are copied when the arena grows or is defragmented
+		Usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		return { RangeAllocator(Capacity), Renderer::GetDevice().CreateBuffer(Capacity, Usage), Usage };
+	}
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "Core/Core.h"
+#include "Core/Misc/NonCopyableMovable.h"
+#include "Core/Misc/RangeAllocator.h"
+#include "Vulkan/Forward.h"
+#include "Vulkan/VulkanCore.h"
+
+namespace Hermes
+{
+	/*
+	 * Owns one large vertex buffer and one large index buffer and sub-allocates them to meshes, so that all meshes
+	 * can be drawn after binding the buffers only once
+	 *
+	 * Allocations are referred to by handles because their offsets change when the arena is defragmented. Offsets
+	 * are returned in elements (vertices of the stride the data was allocated with or indices of the given type),
+	 * so they can be passed directly as vertexOffset and firstIndex to indexed draws.
+	 *
+	 * Freed ranges are not reused until the GPU has finished all frames that might still read from them, see BeginFrame().
+	 * The same applies to the old buffers when the arena grows, as the current frame might have recorded them already.
+	 *
+	 * NOTE: defragmentation waits for the device to become idle, as the data of all meshes is moved. It only runs in
+	 *       BeginFrame(), because the draws recorded in the current frame use the offsets the allocations had at the time
+	 */
+	class HERMES_API MeshArena
+	{
+		MAKE_NON_COPYABLE(MeshArena)
+		MAKE_NON_MOVABLE(MeshArena)
+
+	public:
+		using AllocationHandle = uint32;
+
+		explicit MeshArena(uint32 InFramesInFlightCount);
+
+		~MeshArena();
+
+		/*
+		 * Allocates space for the vertices and uploads them
+		 */
+		AllocationHandle AllocateVertices(std::span<const uint8> VertexData, uint32 VertexStride);
+
+		/*
+		 * Allocates space for the indices and uploads them
+		 */
+		AllocationHandle AllocateIndices(std::span<const uint8> IndexData, VkIndexType IndexType);
+
+		/*
+		 * The handle becomes invalid immediately, the memory is released once the current frame has finished on the GPU
+		 */
+		void Free(AllocationHandle Handle);
+
+		/*
+		 * Keeps the GPU objects of a mesh that live outside of the arena (e.g. its meshlet list) alive until the current
+		 * frame has finished on the GPU, the same way as the ranges released by Free()
+		 */
+		void Retire(std::unique_ptr<Vulkan::Buffer> Buffer, std::unique_ptr<Vulkan::DescriptorSet> DescriptorSet);
+
+		/*
+		 * Must be called when the GPU has finished the frame that previously used the given frame index. Releases the
+		 * ranges that were freed while that frame was recorded, later frees are attributed to this frame
+		 */
+		void BeginFrame(uint32 FrameIndex);
+
+		/*
+		 * Returns the offset of the allocation in elements of the size it was allocated with
+		 */
+		uint32 GetFirstElement(AllocationHandle Handle) const;
+
+		const Vulkan::Buffer& GetVertexBuffer() const;
+		const Vulkan::Buffer& GetIndexBuffer() const;
+
+		/*
+		 * Moves all allocations to the beginning of the buffers so that the free space becomes contiguous. This happens
+		 * in the next BeginFrame(), the offsets do not change before that
+		 */
+		void Defragment();
+
+	private:
+		struct Region
+		{
+			RangeAllocator Allocator;
+			std::unique_ptr<Vulkan::Buffer> Buffer;
+			VkBufferUsageFlags Usage;
+		};
+
+		struct AllocationRecord
+		{
+			bool IsUsed = false;
+			bool IsIndexData = false;
+			size_t Offset = 0;
+			uint32 ElementSize = 0;
+		};
+
+		struct PendingFree
+		{
+			bool IsIndexData;
+			size_t Offset;
+		};
+
+		Region VertexRegion;
+		Region IndexRegion;
+
+		std::vector<AllocationRecord> Allocations;
+		std::vector<AllocationHandle> FreeHandles;
+
+		struct FrameData
+		{
+			std::vector<PendingFree> PendingFrees;
+			std::vector<std::unique_ptr<Vulkan::Buffer>> RetiredBuffers;
+			std::vector<std::unique_ptr<Vulkan::DescriptorSet>> RetiredDescriptorSets;
+		};
+		std::vector<FrameData> Frames;
+		uint32 CurrentFrameIndex = 0;
+
+		bool IsDefragmentationRequested = false;
+
+		static constexpr size_t InitialVertexBufferSize = 64 * 1024 * 1024;
+		static constexpr size_t InitialIndexBufferSize = 32 * 1024 * 1024;
+
+		AllocationHandle Allocate(bool IsIndexData, std::span<const uint8> Data, uint32 ElementSize);
+
+		void Grow(Region& Region, size_t MinimalCapacity);
+
+		void Defragment(Region& Region, bool IsIndexData);
+
+		/*
+		 * Waits for the device to become idle, after which none of the ranges freed in the previous frames can be in use
+		 * anymore. The ranges freed in the current frame stay pending as its commands might not have been submitted yet
+		 */
+		void ReleaseAllPendingFrees();
+
+		void ReleasePendingFrees(uint32 FrameIndex);
+
+		static Region CreateRegion(size_t Capacity, VkBufferUsageFlags Usage);
+	};
+}
@@ -1,13 +1,17 @@
 #include "DepthPass.h"
 
+#include <optional>
+
 #include "Core/Profiling.h"
 #include "RenderingEngine/FrameGraph/Resource.h"
 #include "RenderingEngine/Material/MaterialInstance.h"
 #include "RenderingEngine/Mesh.h"
+#include "RenderingEngine/Passes/MeshletCullingPass.h"
 #include "RenderingEngine/Renderer.h"
 #include "RenderingEngine/FrameGraph/Graph.h"
 #include "RenderingEngine/Scene/Camera.h"
 #include "RenderingEngine/Scene/GeometryList.h"
+#include "RenderingEngine/SharedData.h"
 #include "Vulkan/CommandBuffer.h"
 
 namespace Hermes
@@ -16,9 +20,11 @@ namespace Hermes
 	{
 		auto& DescriptorAllocator = Renderer::GetDescriptorAllocator();
 
-		SceneUBODescriptorSet = DescriptorAllocator.Allocate(Renderer::GetGlobalDataDescriptorSetLayout());
+		for (uint32 FrameIndex = 0; FrameIndex < Renderer::GetFramesInFlightCount(); FrameIndex++)
+			SceneUBODescriptorSets.push_back(DescriptorAllocator.Allocate(Renderer::GetGlobalDataDescriptorSetLayout()));
 
 		Description.Callback = [this](const PassCallbackInfo& CallbackInfo) { PassCallback(CallbackInfo); };
+		Description.ChunkCallback = [this](const PassChunkCallbackInfo& ChunkInfo) { RecordChunk(ChunkInfo); };
 
 		Attachment DepthAttachment = {};
 		DepthAttachment.Name = "Depth";
@@ -31,7 +37,10 @@ namespace Hermes
 
 		Description.BufferInputs =
 		{
-			{ "SceneData", VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, false }
+			{ "DrawCommands", VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT },
+			{ "DrawCounts", VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT },
+			{ "SceneData", VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, false,
+			  VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_UNIFORM_READ_BIT }
 		};
 	}
 
@@ -39,44 +48,103 @@ namespace Hermes
 	{
 		HERMES_PROFILE_FUNC();
 
-		auto& CommandBuffer = CallbackInfo.CommandBuffer;
-
 		const auto* DepthBuffer = std::get<const Vulkan::ImageView*>(CallbackInfo.Resources.at("Depth"));
 		HERMES_ASSERT(DepthBuffer);
-		auto FramebufferDimensions = DepthBuffer->GetDimensions();
-		auto ViewportDimensions = Vec2(FramebufferDimensions);
 
 		const auto& SceneDataBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("SceneData"));
-		SceneUBODescriptorSet->UpdateWithBuffer(0, 0, SceneDataBuffer, 0, static_cast<uint32>(SceneDataBuffer.GetSize()));
+		auto& SceneUBODescriptorSet = *SceneUBODescriptorSets[Renderer::GetCurrentFrameIndex()];
+		SceneUBODescriptorSet.UpdateWithBuffer(0, 0, SceneDataBuffer, 0, static_cast<uint32>(SceneDataBuffer.GetSize()));
 
+		DrawCommandRanges = MeshletCullingPass::ComputeDrawCommandRanges(CallbackInfo.GeometryList);
+
+		// Pipelines are requested lazily and material data is updated on first use, neither is safe to do from the chunks
 		for (const auto& DrawableMesh : CallbackInfo.GeometryList.GetMeshList())
 		{
+			if (!DrawableMesh.Mesh)
+				continue;
+
+			DrawableMesh.Material->GetBaseMaterial().RequestVertexOnlyPipeline(DepthBuffer->GetFormat(), DrawableMesh.Mesh->GetVertexFormat());
+			DrawableMesh.Material->PrepareForRender();
+		}
+	}
+
+	void DepthPass::RecordChunk(const PassChunkCallbackInfo& ChunkInfo)
+	{
+		HERMES_PROFILE_FUNC();
+
+		auto& CommandBuffer = ChunkInfo.CommandBuffer;
+
+		const auto* DepthBuffer = std::get<const Vulkan::ImageView*>(ChunkInfo.Resources.at("Depth"));
+		auto FramebufferDimensions = DepthBuffer->GetDimensions();
+		auto ViewportDimensions = Vec2(FramebufferDimensions);
+
+		const auto& SceneUBODescriptorSet = *SceneUBODescriptorSets[Renderer::GetCurrentFrameIndex()];
+
+		const auto& DrawCommandBuffer = *std::get<const Vulkan::Buffer*>(ChunkInfo.Resources.at("DrawCommands"));
+		const auto& DrawCountBuffer = *std::get<const Vulkan::Buffer*>(ChunkInfo.Resources.at("DrawCounts"));
+
+		const auto& MeshList = ChunkInfo.GeometryList.GetMeshList();
+
+		// All meshes share the buffers of the mesh arena; the index buffer only has to be rebound when the index type changes
+		auto Arena = Renderer::GetMeshArena();
+		CommandBuffer.BindVertexBuffer(Arena->GetVertexBuffer());
+		std::optional<VkIndexType> BoundIndexType;
+
+		for (size_t MeshIndex = ChunkInfo.FirstMeshIndex; MeshIndex < ChunkInfo.FirstMeshIndex + ChunkInfo.MeshCount; MeshIndex++)
+		{
+			const auto& DrawableMesh = MeshList[MeshIndex];
 			auto& Material = DrawableMesh.Material;
-			auto& MaterialPipeline = Material->GetBaseMaterial().GetVertexOnlyPipeline(DepthBuffer->GetFormat());
 			const auto* Mesh = DrawableMesh.Mesh;
 
 			if (!Mesh)
 				continue;
 
-			Material->PrepareForRender();
+			// NOTE: meshes are not drawn until their pipeline has finished compiling in the background. The forward pass
+			//       does not rely on the prepass for correct depth, it only loses some early-z and occlusion culling
+			const auto* MaybeMaterialPipeline = Material->GetBaseMaterial().FindVertexOnlyPipeline(DepthBuffer->GetFormat(), Mesh->GetVertexFormat());
+			if (!MaybeMaterialPipeline)
+				continue;
+			const auto& MaterialPipeline = *MaybeMaterialPipeline;
 
 			CommandBuffer.BindPipeline(MaterialPipeline);
 
 			CommandBuffer.SetViewport({ 0.0f, 0.0f, ViewportDimensions.X, ViewportDimensions.Y, 0.0f, 1.0f });
 			CommandBuffer.SetScissor({ { 0, 0 }, { FramebufferDimensions.X, FramebufferDimensions.Y } });
 
-			CommandBuffer.BindDescriptorSet(*SceneUBODescriptorSet, MaterialPipeline, 0);
-			CommandBuffer.BindVertexBuffer(Mesh->GetVertexBuffer());
-			CommandBuffer.BindIndexBuffer(Mesh->GetIndexBuffer(), VK_INDEX_TYPE_UINT32);
+			CommandBuffer.BindDescriptorSet(SceneUBODescriptorSet, MaterialPipeline, 0);
+			if (BoundIndexType != Mesh->GetIndexType())
+			{
+				CommandBuffer.BindIndexBuffer(Arena->GetIndexBuffer(), Mesh->GetIndexType());
+				BoundIndexType = Mesh->GetIndexType();
+			}
 
-			auto TransformationMatrix = DrawableMesh.TransformationMatrix;
+			GlobalDrawcallData DrawcallData = {};
+			DrawcallData.ModelMatrix = DrawableMesh.TransformationMatrix;
+			DrawcallData.PositionOffset = Vec4(Mesh->GetPositionOffset(), 0.0f);
+			DrawcallData.PositionScale = Vec4(Mesh->GetPositionScale(), 0.0f);
+			DrawcallData.AreVerticesCompressed = Mesh->GetVertexFormat() == MeshVertexFormat::Compressed;
 
 			CommandBuffer.UploadPushConstants(MaterialPipeline, VK_SHADER_STAGE_VERTEX_BIT,
-			                                  &TransformationMatrix, sizeof(TransformationMatrix), 0);
+			                                  &DrawcallData, sizeof(DrawcallData), 0);
 
-			for (const auto& Primitive : Mesh->GetPrimitives())
+			const auto& DrawCommandRange = DrawCommandRanges[MeshIndex];
+			auto Primitives = Mesh->GetPrimitives();
+			for (uint32 PrimitiveIndex = 0; PrimitiveIndex < static_cast<uint32>(Primitives.size()); PrimitiveIndex++)
 			{
-				CommandBuffer.DrawIndexed(Primitive.IndexCount, 1, Primitive.IndexOffset, 0, 0);
+				const auto& Primitive = Primitives[PrimitiveIndex];
+				if (DrawCommandRange.IsValid)
+				{
+					// Meshlets of this primitive that survived the culling
+					auto FirstDrawCommand = DrawCommandRange.FirstDrawCommand + Primitive.MeshletOffset;
+					auto DrawCountIndex = DrawCommandRange.FirstDrawCount + PrimitiveIndex;
+					CommandBuffer.DrawIndexedIndirectCount(DrawCommandBuffer, FirstDrawCommand * sizeof(VkDrawIndexedIndirectCommand),
+					                                       DrawCountBuffer, DrawCountIndex * sizeof(uint32),
+					                                       Primitive.MeshletCount, sizeof(VkDrawIndexedIndirectCommand));
+				}
+				else
+				{
+					CommandBuffer.DrawIndexed(Primitive.IndexCount, 1, Mesh->GetFirstIndex() + Primitive.IndexOffset, Mesh->GetVertexOffset(), 0);
+				}
 			}
 		}
 	}
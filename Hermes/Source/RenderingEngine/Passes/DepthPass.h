@@ -1,9 +1,11 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "Core/Core.h"
 #include "RenderingEngine/FrameGraph/Pass.h"
+#include "RenderingEngine/Passes/MeshletCullingPass.h"
 
 namespace Hermes
 {
@@ -14,10 +16,21 @@ namespace Hermes
 
 		const PassDesc& GetPassDescription() const;
 	private:
-		std::unique_ptr<Vulkan::DescriptorSet> SceneUBODescriptorSet;
+		std::vector<std::unique_ptr<Vulkan::DescriptorSet>> SceneUBODescriptorSets;
+
+		// Computed by PassCallback() for the current frame, only read while the chunks are recorded
+		std::vector<MeshletCullingPass::DrawCommandRange> DrawCommandRanges;
 
 		PassDesc Description;
 
+		/*
+		 * Updates the descriptor sets and creates the pipelines and material data of all meshes on the render thread
+		 */
 		void PassCallback(const PassCallbackInfo& CallbackInfo);
+
+		/*
+		 * Records the draw commands of a range of meshes, can be called concurrently from multiple threads
+		 */
+		void RecordChunk(const PassChunkCallbackInfo& ChunkInfo);
 	};
 }
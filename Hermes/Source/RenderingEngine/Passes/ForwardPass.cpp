@@ -1,19 +1,24 @@
 #include "ForwardPass.h"
 
+#include <optional>
+
 #include "Core/Profiling.h"
 #include "RenderingEngine/DescriptorAllocator.h"
 #include "RenderingEngine/FrameGraph/Graph.h"
 #include "RenderingEngine/Material/Material.h"
 #include "RenderingEngine/Mesh.h"
+#include "RenderingEngine/Passes/MeshletCullingPass.h"
 #include "RenderingEngine/Renderer.h"
 #include "RenderingEngine/Scene/GeometryList.h"
 #include "RenderingEngine/Scene/Scene.h"
+#include "RenderingEngine/SharedData.h"
 #include "Vulkan/Buffer.h"
 #include "Vulkan/CommandBuffer.h"
 #include "Vulkan/Device.h"
 #include "Vulkan/Fence.h"
 #include "Vulkan/Framebuffer.h"
 #include "Vulkan/Pipeline.h"
+#include "Vulkan/Queue.h"
 #include "Vulkan/RenderPass.h"
 
 namespace Hermes
@@ -26,7 +31,8 @@ namespace Hermes
 	{
 		auto& Device = Renderer::GetDevice();
 
-		SceneUBODescriptorSet = Renderer::GetDescriptorAllocator().Allocate(Renderer::GetGlobalDataDescriptorSetLayout());
+		for (uint32 FrameIndex = 0; FrameIndex < Renderer::GetFramesInFlightCount(); FrameIndex++)
+			SceneUBODescriptorSets.push_back(Renderer::GetDescriptorAllocator().Allocate(Renderer::GetGlobalDataDescriptorSetLayout()));
 
 		Vulkan::SamplerDescription SamplerDesc = {};
 		SamplerDesc.AddressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
@@ -40,6 +46,7 @@ namespace Hermes
 		EnvmapSampler = Device.CreateSampler(SamplerDesc);
 
 		Description.Callback = [this](const PassCallbackInfo& CallbackInfo) { PassCallback(CallbackInfo); };
+		Description.ChunkCallback = [this](const PassChunkCallbackInfo& ChunkInfo) { RecordChunk(ChunkInfo); };
 
 		Attachment Color = {};
 		Color.Name = "Color";
@@ -61,9 +68,12 @@ namespace Hermes
 
 		Description.BufferInputs =
 		{
-			{ "LightClusterList", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false },
-			{ "LightIndexList", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false },
-			{ "SceneData", VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, false }
+			{ "DrawCommands", VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT },
+			{ "DrawCounts", VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, false, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT },
+			{ "LightClusterMasks", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT },
+			{ "PointLights", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT },
+			{ "SceneData", VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, false,
+			  VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_UNIFORM_READ_BIT }
 		};
 	}
 
@@ -80,57 +90,127 @@ namespace Hermes
 			EnsurePrecomputedBRDF();
 		}
 
-		auto& CommandBuffer = CallbackInfo.CommandBuffer;
 		const auto& Scene = CallbackInfo.Scene;
 
 		const auto* ColorBuffer = std::get<const Vulkan::ImageView*>(CallbackInfo.Resources.at("Color"));
 		const auto* DepthBuffer = std::get<const Vulkan::ImageView*>(CallbackInfo.Resources.at("Depth"));
 
+		const auto& SceneDataBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("SceneData"));
+		const auto& LightClusterMasksBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("LightClusterMasks"));
+		const auto& PointLightsBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("PointLights"));
+		auto& SceneUBODescriptorSet = *SceneUBODescriptorSets[Renderer::GetCurrentFrameIndex()];
+		SceneUBODescriptorSet.UpdateWithBuffer(0, 0, SceneDataBuffer, 0, static_cast<uint32>(SceneDataBuffer.GetSize()));
+		SceneUBODescriptorSet.UpdateWithImageAndSampler(1, 0, Scene.GetIrradianceEnvmap().GetView(),
+		                                                *EnvmapSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		SceneUBODescriptorSet.UpdateWithImageAndSampler(2, 0, Scene.GetSpecularEnvmap().GetView(),
+		                                                *EnvmapSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		SceneUBODescriptorSet.UpdateWithImageAndSampler(3, 0, *PrecomputedBRDFView, *PrecomputedBRDFSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		SceneUBODescriptorSet.UpdateWithBuffer(4, 0, LightClusterMasksBuffer, 0, static_cast<uint32>(LightClusterMasksBuffer.GetSize()));
+		SceneUBODescriptorSet.UpdateWithBuffer(5, 0, PointLightsBuffer, 0, static_cast<uint32>(PointLightsBuffer.GetSize()));
+
+		DrawCommandRanges = MeshletCullingPass::ComputeDrawCommandRanges(CallbackInfo.GeometryList);
+
+		// Pipelines are requested lazily and material data is updated on first use, neither is safe to do from the chunks
+		for (const auto& DrawableMesh : CallbackInfo.GeometryList.GetMeshList())
+		{
+			if (!DrawableMesh.Mesh)
+				continue;
+
+			DrawableMesh.Material->GetBaseMaterial().RequestFullPipeline(ColorBuffer->GetFormat(), DepthBuffer->GetFormat(), DrawableMesh.Mesh->GetVertexFormat());
+			// TODO : move it into the renderer?
+			DrawableMesh.Material->PrepareForRender();
+		}
+	}
+
+	void ForwardPass::RecordChunk(const PassChunkCallbackInfo& ChunkInfo)
+	{
+		HERMES_PROFILE_FUNC();
+
+		auto& CommandBuffer = ChunkInfo.CommandBuffer;
+
+		const auto* ColorBuffer = std::get<const Vulkan::ImageView*>(ChunkInfo.Resources.at("Color"));
+		const auto* DepthBuffer = std::get<const Vulkan::ImageView*>(ChunkInfo.Resources.at("Depth"));
+
 		auto FramebufferDimensions = ColorBuffer->GetDimensions();
 		auto ViewportDimensions = Vec2(FramebufferDimensions);
 
-		const auto& SceneDataBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("SceneData"));
-		const auto& LightClusterListBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("LightClusterList"));
-		const auto& LightIndexListBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("LightIndexList"));
-		SceneUBODescriptorSet->UpdateWithBuffer(0, 0, SceneDataBuffer, 0, static_cast<uint32>(SceneDataBuffer.GetSize()));
-		SceneUBODescriptorSet->UpdateWithImageAndSampler(1, 0, Scene.GetIrradianceEnvmap().GetView(),
-		                                                 *EnvmapSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-		SceneUBODescriptorSet->UpdateWithImageAndSampler(2, 0, Scene.GetSpecularEnvmap().GetView(),
-		                                                 *EnvmapSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-		SceneUBODescriptorSet->UpdateWithImageAndSampler(3, 0, *PrecomputedBRDFView, *PrecomputedBRDFSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-		SceneUBODescriptorSet->UpdateWithBuffer(4, 0, LightClusterListBuffer, 0, static_cast<uint32>(LightClusterListBuffer.GetSize()));
-		SceneUBODescriptorSet->UpdateWithBuffer(5, 0, LightIndexListBuffer, 0, static_cast<uint32>(LightIndexListBuffer.GetSize()));
+		const auto& SceneUBODescriptorSet = *SceneUBODescriptorSets[Renderer::GetCurrentFrameIndex()];
 
-		for (const auto& DrawableMesh : CallbackInfo.GeometryList.GetMeshList())
+		const auto& DrawCommandBuffer = *std::get<const Vulkan::Buffer*>(ChunkInfo.Resources.at("DrawCommands"));
+		const auto& DrawCountBuffer = *std::get<const Vulkan::Buffer*>(ChunkInfo.Resources.at("DrawCounts"));
+
+		const auto& MeshList = ChunkInfo.GeometryList.GetMeshList();
+
+		// All meshes share the buffers of the mesh arena; the index buffer only has to be rebound when the index type changes
+		auto Arena = Renderer::GetMeshArena();
+		CommandBuffer.BindVertexBuffer(Arena->GetVertexBuffer());
+		std::optional<VkIndexType> BoundIndexType;
+
+		// NOTE: all material pipelines have compatible layouts, so the global and the material data descriptor sets stay
+		//       bound across pipeline changes and only the material index differs between draws
+		const auto& MaterialDataDescriptorSet = Renderer::GetMaterialResourceTable()->GetDescriptorSet();
+		bool AreDescriptorSetsBound = false;
+
+		for (size_t MeshIndex = ChunkInfo.FirstMeshIndex; MeshIndex < ChunkInfo.FirstMeshIndex + ChunkInfo.MeshCount; MeshIndex++)
 		{
+			const auto& DrawableMesh = MeshList[MeshIndex];
 			auto& Material = DrawableMesh.Material;
-			auto& MaterialPipeline = Material->GetBaseMaterial().GetFullPipeline(ColorBuffer->GetFormat(), DepthBuffer->GetFormat());
 			const auto* Mesh = DrawableMesh.Mesh;
 
 			if (!Mesh)
 				continue;
 
-			// TODO : move it into the renderer?
-			Material->PrepareForRender();
+			// NOTE: meshes are not drawn until their pipeline has finished compiling in the background
+			const auto* MaybeMaterialPipeline = Material->GetBaseMaterial().FindFullPipeline(ColorBuffer->GetFormat(), DepthBuffer->GetFormat(), Mesh->GetVertexFormat());
+			if (!MaybeMaterialPipeline)
+				continue;
+			const auto& MaterialPipeline = *MaybeMaterialPipeline;
 
 			CommandBuffer.BindPipeline(MaterialPipeline);
 
 			CommandBuffer.SetViewport({ 0.0f, 0.0f, ViewportDimensions.X, ViewportDimensions.Y, 0.0f, 1.0f });
 			CommandBuffer.SetScissor({ { 0, 0 }, { FramebufferDimensions.X, FramebufferDimensions.Y } });
 
-			CommandBuffer.BindDescriptorSet(*SceneUBODescriptorSet, MaterialPipeline, 0);
-			CommandBuffer.BindDescriptorSet(Material->GetMaterialDescriptorSet(), MaterialPipeline, 1);
-			CommandBuffer.BindVertexBuffer(Mesh->GetVertexBuffer());
-			CommandBuffer.BindIndexBuffer(Mesh->GetIndexBuffer(), VK_INDEX_TYPE_UINT32);
+			if (!AreDescriptorSetsBound)
+			{
+				CommandBuffer.BindDescriptorSet(SceneUBODescriptorSet, MaterialPipeline, 0);
+				CommandBuffer.BindDescriptorSet(MaterialDataDescriptorSet, MaterialPipeline, GMaterialDataDescriptorSet);
+				AreDescriptorSetsBound = true;
+			}
+			if (BoundIndexType != Mesh->GetIndexType())
+			{
+				CommandBuffer.BindIndexBuffer(Arena->GetIndexBuffer(), Mesh->GetIndexType());
+				BoundIndexType = Mesh->GetIndexType();
+			}
 
-			auto TransformationMatrix = DrawableMesh.TransformationMatrix;
+			GlobalDrawcallData DrawcallData = {};
+			DrawcallData.ModelMatrix = DrawableMesh.TransformationMatrix;
+			DrawcallData.PositionOffset = Vec4(Mesh->GetPositionOffset(), 0.0f);
+			DrawcallData.PositionScale = Vec4(Mesh->GetPositionScale(), 0.0f);
+			DrawcallData.AreVerticesCompressed = Mesh->GetVertexFormat() == MeshVertexFormat::Compressed;
+			DrawcallData.MaterialIndex = Material->GetMaterialIndex();
 
-			CommandBuffer.UploadPushConstants(MaterialPipeline, VK_SHADER_STAGE_VERTEX_BIT,
-			                                  &TransformationMatrix, sizeof(TransformationMatrix), 0);
+			CommandBuffer.UploadPushConstants(MaterialPipeline, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+			                                  &DrawcallData, sizeof(DrawcallData), 0);
 
-			for (const auto& Primitive : Mesh->GetPrimitives())
+			const auto& DrawCommandRange = DrawCommandRanges[MeshIndex];
+			auto Primitives = Mesh->GetPrimitives();
+			for (uint32 PrimitiveIndex = 0; PrimitiveIndex < static_cast<uint32>(Primitives.size()); PrimitiveIndex++)
 			{
-				CommandBuffer.DrawIndexed(Primitive.IndexCount, 1, Primitive.IndexOffset, 0, 0);
+				const auto& Primitive = Primitives[PrimitiveIndex];
+				if (DrawCommandRange.IsValid)
+				{
+					// Meshlets of this primitive that survived the culling
+					auto FirstDrawCommand = DrawCommandRange.FirstDrawCommand + Primitive.MeshletOffset;
+					auto DrawCountIndex = DrawCommandRange.FirstDrawCount + PrimitiveIndex;
+					CommandBuffer.DrawIndexedIndirectCount(DrawCommandBuffer, FirstDrawCommand * sizeof(VkDrawIndexedIndirectCommand),
+					                                       DrawCountBuffer, DrawCountIndex * sizeof(uint32),
+					                                       Primitive.MeshletCount, sizeof(VkDrawIndexedIndirectCommand));
+				}
+				else
+				{
+					CommandBuffer.DrawIndexed(Primitive.IndexCount, 1, Mesh->GetFirstIndex() + Primitive.IndexOffset, Mesh->GetVertexOffset(), 0);
+				}
 			}
 		}
 	}
@@ -192,7 +272,7 @@ namespace Hermes
 
 		auto& Queue = Device.GetQueue(VK_QUEUE_GRAPHICS_BIT);
 		auto CommandBuffer = Queue.CreateCommandBuffer(true);
-		auto Fence = Device.CreateFence();
+		auto Fence = Renderer::GetSynchronizationPool().AcquireFence();
 
 		/*
 		 * NOTE : steps to take:
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "Core/Core.h"
 #include "RenderingEngine/FrameGraph/Pass.h"
+#include "RenderingEngine/Passes/MeshletCullingPass.h"
 #include "Vulkan/Buffer.h"
 #include "Vulkan/Image.h"
 #include "Vulkan/Pipeline.h"
@@ -21,7 +23,7 @@ namespace Hermes
 		const PassDesc& GetPassDescription() const;
 
 	private:
-		std::unique_ptr<Vulkan::DescriptorSet> SceneUBODescriptorSet;
+		std::vector<std::unique_ptr<Vulkan::DescriptorSet>> SceneUBODescriptorSets;
 
 		std::unique_ptr<Vulkan::Sampler> EnvmapSampler;
 
@@ -29,10 +31,21 @@ namespace Hermes
 		static std::unique_ptr<Vulkan::ImageView> PrecomputedBRDFView;
 		static std::unique_ptr<Vulkan::Sampler> PrecomputedBRDFSampler;
 
+		// Computed by PassCallback() for the current frame, only read while the chunks are recorded
+		std::vector<MeshletCullingPass::DrawCommandRange> DrawCommandRanges;
+
 		PassDesc Description;
 
+		/*
+		 * Updates the descriptor sets and creates the pipelines and material data of all meshes on the render thread
+		 */
 		void PassCallback(const PassCallbackInfo& CallbackInfo);
 
+		/*
+		 * Records the draw commands of a range of meshes, can be called concurrently from multiple threads
+		 */
+		void RecordChunk(const PassChunkCallbackInfo& ChunkInfo);
+
 		/*
 		 * Recreates and recomputes the precomputed BRDF image and the corresponding sampler
 		 */
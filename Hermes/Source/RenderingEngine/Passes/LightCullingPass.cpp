@@ -1,11 +1,17 @@
 #include "LightCullingPass.h"
 
+#include <array>
+
 #include "Core/Profiling.h"
 #include "RenderingEngine/FrameGraph/Graph.h"
 #include "RenderingEngine/FrameGraph/Pass.h"
 #include "RenderingEngine/FrameGraph/Resource.h"
 #include "RenderingEngine/Renderer.h"
+#include "RenderingEngine/SharedData.h"
+#include "Vulkan/Buffer.h"
 #include "Vulkan/CommandBuffer.h"
+#include "Vulkan/Device.h"
+#include "Vulkan/Image.h"
 
 namespace Hermes
 {
@@ -14,23 +20,51 @@ namespace Hermes
 		auto& Device = Renderer::GetDevice();
 		auto& DescriptorAllocator = Renderer::GetDescriptorAllocator();
 
-		auto DescriptorSetLayout = Device.CreateDescriptorSetLayout(
+		auto MarkingDescriptorSetLayout = Device.CreateDescriptorSetLayout(
+			{
+				{ 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+				{ 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+				{ 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
+			});
+		auto CullingDescriptorSetLayout = Device.CreateDescriptorSetLayout(
 			{
 				{ 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
 				{ 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
-				{ 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
+				{ 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+				{ 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
 			});
-		DescriptorSet = DescriptorAllocator.Allocate(*DescriptorSetLayout);
+		for (uint32 FrameIndex = 0; FrameIndex < Renderer::GetFramesInFlightCount(); FrameIndex++)
+		{
+			MarkingDescriptorSets.push_back(DescriptorAllocator.Allocate(*MarkingDescriptorSetLayout));
+			CullingDescriptorSets.push_back(DescriptorAllocator.Allocate(*CullingDescriptorSetLayout));
+		}
+
+		auto MarkingShader = Device.CreateShader("/Shaders/Bin/light_cluster_marking.glsl.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		MarkingPipeline = Device.CreateComputePipeline({ MarkingDescriptorSetLayout.get() }, *MarkingShader);
+
+		auto CullingShader = Device.CreateShader("/Shaders/Bin/light_culling.glsl.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		CullingPipeline = Device.CreateComputePipeline({ CullingDescriptorSetLayout.get() }, *CullingShader);
 
-		auto Shader = Device.CreateShader("/Shaders/Bin/light_culling.glsl.spv", VK_SHADER_STAGE_COMPUTE_BIT);
-		Pipeline = Device.CreateComputePipeline({ DescriptorSetLayout.get() }, *Shader);
+		Attachment DepthAttachment = {};
+		DepthAttachment.Name = "Depth";
+		DepthAttachment.LoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		DepthAttachment.StencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		DepthAttachment.Binding = BindingMode::SampledImage;
 
 		PassDescription.Type = PassType::Compute;
+		PassDescription.Attachments = { std::move(DepthAttachment) };
 		PassDescription.BufferInputs =
 		{
-			{ "LightClusterList", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false },
-			{ "LightIndexList", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false },
-			{ "SceneData", VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, false }
+			// Cleared with a transfer command so that clusters that are not marked as active contain no lights
+			{ "LightClusterMasks", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false,
+			  VK_PIPELINE_STAGE_2_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			  VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT },
+			// Filled by the marking dispatch and then consumed as the indirect arguments of the culling dispatch
+			{ "ActiveLightClusters", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false,
+			  VK_PIPELINE_STAGE_2_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+			  VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT },
+			{ "SceneData", VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, false, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_UNIFORM_READ_BIT },
+			{ "ViewSpacePointLights", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT }
 		};
 		PassDescription.Callback = [this](const PassCallbackInfo& CallbackInfo) { PassCallback(CallbackInfo); };
 	}
@@ -40,25 +74,104 @@ namespace Hermes
 		return PassDescription;
 	}
 
+	Vec2ui LightCullingPass::GetNumberOfXYClusters(Vec2ui ViewportDimensions)
+	{
+		return (ViewportDimensions + ClusterSizeInPixels - 1) / ClusterSizeInPixels;
+	}
+
+	uint32 LightCullingPass::GetLightMaskWordsPerCluster(uint32 PointLightCount)
+	{
+		return (PointLightCount + 31) / 32;
+	}
+
+	size_t LightCullingPass::GetLightClusterMasksSize(Vec2ui ViewportDimensions, uint32 PointLightCount)
+	{
+		auto NumberOfXYClusters = GetNumberOfXYClusters(ViewportDimensions);
+		size_t ClusterCount = static_cast<size_t>(NumberOfXYClusters.X) * NumberOfXYClusters.Y * NumberOfZSlices;
+
+		return ClusterCount * GetLightMaskWordsPerCluster(PointLightCount) * sizeof(uint32);
+	}
+
+	size_t LightCullingPass::GetActiveLightClusterListSize(Vec2ui ViewportDimensions)
+	{
+		auto NumberOfXYClusters = GetNumberOfXYClusters(ViewportDimensions);
+		size_t ClusterCount = static_cast<size_t>(NumberOfXYClusters.X) * NumberOfXYClusters.Y * NumberOfZSlices;
+
+		return GActiveLightClusterListHeaderSize + ClusterCount * sizeof(uint32);
+	}
+
 	void LightCullingPass::PassCallback(const PassCallbackInfo& CallbackInfo)
 	{
 		HERMES_PROFILE_FUNC();
 
 		const auto& SceneDataBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("SceneData"));
-		const auto& LightClusterListBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("LightClusterList"));
-		const auto& LightIndexListBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("LightIndexList"));
+		const auto& LightClusterMasksBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("LightClusterMasks"));
+		const auto& ActiveLightClustersBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("ActiveLightClusters"));
+		const auto& ViewSpacePointLightsBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("ViewSpacePointLights"));
+		const auto* DepthBuffer = std::get<const Vulkan::ImageView*>(CallbackInfo.Resources.at("Depth"));
+		HERMES_ASSERT(DepthBuffer);
 
-		DescriptorSet->UpdateWithBuffer(0, 0, SceneDataBuffer, 0, static_cast<uint32>(SceneDataBuffer.GetSize()));
-		DescriptorSet->UpdateWithBuffer(1, 0, LightClusterListBuffer, 0, static_cast<uint32>(LightClusterListBuffer.GetSize()));
-		DescriptorSet->UpdateWithBuffer(2, 0, LightIndexListBuffer, 0, static_cast<uint32>(LightIndexListBuffer.GetSize()));
+		auto& MarkingDescriptorSet = *MarkingDescriptorSets[Renderer::GetCurrentFrameIndex()];
+		MarkingDescriptorSet.UpdateWithBuffer(0, 0, SceneDataBuffer, 0, static_cast<uint32>(SceneDataBuffer.GetSize()));
+		MarkingDescriptorSet.UpdateWithBuffer(1, 0, ActiveLightClustersBuffer, 0, static_cast<uint32>(ActiveLightClustersBuffer.GetSize()));
+		MarkingDescriptorSet.UpdateWithImageAndSampler(2, 0, *DepthBuffer, Renderer::GetDefaultSampler(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-		// FIXME: we shouldn't depend on swapchain dimensions
-		auto SwapchainDimensions = Renderer::GetSwapchainDimensions();
-		auto NumOfClustersXY = (SwapchainDimensions + ClusterSizeInPixels - 1) / ClusterSizeInPixels;
+		auto& CullingDescriptorSet = *CullingDescriptorSets[Renderer::GetCurrentFrameIndex()];
+		CullingDescriptorSet.UpdateWithBuffer(0, 0, SceneDataBuffer, 0, static_cast<uint32>(SceneDataBuffer.GetSize()));
+		CullingDescriptorSet.UpdateWithBuffer(1, 0, LightClusterMasksBuffer, 0, static_cast<uint32>(LightClusterMasksBuffer.GetSize()));
+		CullingDescriptorSet.UpdateWithBuffer(2, 0, ViewSpacePointLightsBuffer, 0, static_cast<uint32>(ViewSpacePointLightsBuffer.GetSize()));
+		CullingDescriptorSet.UpdateWithBuffer(3, 0, ActiveLightClustersBuffer, 0, static_cast<uint32>(ActiveLightClustersBuffer.GetSize()));
 
 		auto& CommandBuffer = CallbackInfo.CommandBuffer;
-		CommandBuffer.BindPipeline(*Pipeline);
-		CommandBuffer.BindDescriptorSet(*DescriptorSet, *Pipeline, 0);
-		CommandBuffer.Dispatch(NumOfClustersXY.X, NumOfClustersXY.Y, NumberOfZSlices);
+
+		// NOTE: the active cluster list header is a VkDispatchIndirectCommand: X is accumulated atomically by the
+		//       marking shader, Y and Z are always 1
+		CommandBuffer.FillBuffer(LightClusterMasksBuffer, 0, VK_WHOLE_SIZE, 0);
+		CommandBuffer.FillBuffer(ActiveLightClustersBuffer, 0, sizeof(uint32), 0);
+		CommandBuffer.FillBuffer(ActiveLightClustersBuffer, sizeof(uint32), 2 * sizeof(uint32), 1);
+
+		VkBufferMemoryBarrier2 ClearBarrier = {
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+			.pNext = nullptr,
+			.srcStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT,
+			.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.buffer = VK_NULL_HANDLE,
+			.offset = 0,
+			.size = VK_WHOLE_SIZE
+		};
+
+		std::array<VkBufferMemoryBarrier2, 2> ClearBarriers = { ClearBarrier, ClearBarrier };
+		ClearBarriers[0].buffer = LightClusterMasksBuffer.GetBuffer();
+		ClearBarriers[1].buffer = ActiveLightClustersBuffer.GetBuffer();
+		CommandBuffer.InsertDependency({}, ClearBarriers, {});
+
+		auto NumOfClustersXY = GetNumberOfXYClusters(CallbackInfo.ViewportDimensions);
+
+		CommandBuffer.BindPipeline(*MarkingPipeline);
+		CommandBuffer.BindDescriptorSet(MarkingDescriptorSet, *MarkingPipeline, 0);
+		CommandBuffer.Dispatch(NumOfClustersXY.X, NumOfClustersXY.Y, 1);
+
+		VkBufferMemoryBarrier2 MarkingBarrier = {
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+			.pNext = nullptr,
+			.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.buffer = ActiveLightClustersBuffer.GetBuffer(),
+			.offset = 0,
+			.size = VK_WHOLE_SIZE
+		};
+		CommandBuffer.InsertDependency({}, { &MarkingBarrier, 1 }, {});
+
+		CommandBuffer.BindPipeline(*CullingPipeline);
+		CommandBuffer.BindDescriptorSet(CullingDescriptorSet, *CullingPipeline, 0);
+		CommandBuffer.DispatchIndirect(ActiveLightClustersBuffer, 0);
 	}
 }
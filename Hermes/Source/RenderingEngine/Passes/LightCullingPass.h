@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "Core/Core.h"
 #include "Math/Vector2.h"
@@ -19,10 +20,28 @@ namespace Hermes
 
 		static constexpr Vec2ui ClusterSizeInPixels = { 32 };
 		static constexpr uint32 NumberOfZSlices = 32;
+		// NOTE: the marking shader stores the used Z slices of a cluster column in a single 32 bit mask
+		static_assert(NumberOfZSlices <= 32);
+
+		static Vec2ui GetNumberOfXYClusters(Vec2ui ViewportDimensions);
+
+		static uint32 GetLightMaskWordsPerCluster(uint32 PointLightCount);
+
+		/*
+		 * Returns the size in bytes of the light cluster masks for the given viewport and number of point lights
+		 */
+		static size_t GetLightClusterMasksSize(Vec2ui ViewportDimensions, uint32 PointLightCount);
+
+		/*
+		 * Returns the size in bytes of the list of clusters that contain at least one visible pixel
+		 */
+		static size_t GetActiveLightClusterListSize(Vec2ui ViewportDimensions);
 
 	private:
-		std::unique_ptr<Vulkan::ComputePipeline> Pipeline;
-		std::unique_ptr<Vulkan::DescriptorSet> DescriptorSet;
+		std::unique_ptr<Vulkan::ComputePipeline> MarkingPipeline;
+		std::unique_ptr<Vulkan::ComputePipeline> CullingPipeline;
+		std::vector<std::unique_ptr<Vulkan::DescriptorSet>> MarkingDescriptorSets;
+		std::vector<std::unique_ptr<Vulkan::DescriptorSet>> CullingDescriptorSets;
 
 		PassDesc PassDescription = {};
 
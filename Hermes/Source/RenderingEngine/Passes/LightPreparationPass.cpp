@@ -0,0 +1,75 @@
+#include "LightPreparationPass.h"
+
+#include "Core/Profiling.h"
+#include "Math/Vector4.h"
+#include "RenderingEngine/FrameGraph/Graph.h"
+#include "RenderingEngine/FrameGraph/Resource.h"
+#include "RenderingEngine/Renderer.h"
+#include "Vulkan/Buffer.h"
+#include "Vulkan/CommandBuffer.h"
+#include "Vulkan/Device.h"
+
+namespace Hermes
+{
+	static constexpr uint32 LightPreparationGroupSize = 64;
+
+	LightPreparationPass::LightPreparationPass()
+	{
+		auto& Device = Renderer::GetDevice();
+		auto& DescriptorAllocator = Renderer::GetDescriptorAllocator();
+
+		auto DescriptorSetLayout = Device.CreateDescriptorSetLayout(
+			{
+				{ 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+				{ 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+				{ 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
+			});
+		for (uint32 FrameIndex = 0; FrameIndex < Renderer::GetFramesInFlightCount(); FrameIndex++)
+			DescriptorSets.push_back(DescriptorAllocator.Allocate(*DescriptorSetLayout));
+
+		auto Shader = Device.CreateShader("/Shaders/Bin/light_preparation.glsl.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		Pipeline = Device.CreateComputePipeline({ DescriptorSetLayout.get() }, *Shader);
+
+		PassDescription.Type = PassType::Compute;
+		PassDescription.BufferInputs =
+		{
+			{ "SceneData", VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, false, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_UNIFORM_READ_BIT },
+			{ "PointLights", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT },
+			{ "ViewSpacePointLights", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, false, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT }
+		};
+		PassDescription.Callback = [this](const PassCallbackInfo& CallbackInfo) { PassCallback(CallbackInfo); };
+	}
+
+	const PassDesc& LightPreparationPass::GetPassDescription() const
+	{
+		return PassDescription;
+	}
+
+	size_t LightPreparationPass::GetViewSpacePointLightListSize(uint32 PointLightCount)
+	{
+		// NOTE: XYZ = position in view space, W = radius
+		return static_cast<size_t>(PointLightCount) * sizeof(Vec4);
+	}
+
+	void LightPreparationPass::PassCallback(const PassCallbackInfo& CallbackInfo)
+	{
+		HERMES_PROFILE_FUNC();
+
+		const auto& SceneDataBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("SceneData"));
+		const auto& PointLightsBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("PointLights"));
+		const auto& ViewSpacePointLightsBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("ViewSpacePointLights"));
+
+		auto& DescriptorSet = *DescriptorSets[Renderer::GetCurrentFrameIndex()];
+		DescriptorSet.UpdateWithBuffer(0, 0, SceneDataBuffer, 0, static_cast<uint32>(SceneDataBuffer.GetSize()));
+		DescriptorSet.UpdateWithBuffer(1, 0, PointLightsBuffer, 0, static_cast<uint32>(PointLightsBuffer.GetSize()));
+		DescriptorSet.UpdateWithBuffer(2, 0, ViewSpacePointLightsBuffer, 0, static_cast<uint32>(ViewSpacePointLightsBuffer.GetSize()));
+
+		// NOTE: the number of visible lights is only known to the shader, the list is always large enough for all of them
+		auto LightCapacity = static_cast<uint32>(ViewSpacePointLightsBuffer.GetSize() / GetViewSpacePointLightListSize(1));
+
+		auto& CommandBuffer = CallbackInfo.CommandBuffer;
+		CommandBuffer.BindPipeline(*Pipeline);
+		CommandBuffer.BindDescriptorSet(DescriptorSet, *Pipeline, 0);
+		CommandBuffer.Dispatch((LightCapacity + LightPreparationGroupSize - 1) / LightPreparationGroupSize, 1, 1);
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Core/Core.h"
+#include "RenderingEngine/FrameGraph/Pass.h"
+#include "Vulkan/ComputePipeline.h"
+#include "Vulkan/Descriptor.h"
+
+namespace Hermes
+{
+	/*
+	 * Transforms the visible point lights into view space once per frame, so that the light culling shader does not
+	 * repeat it for every cluster. It only reads external resources, so the frame graph can run it on the async compute
+	 * queue while the graphics queue culls meshlets and draws the depth prepass
+	 */
+	class HERMES_API LightPreparationPass
+	{
+	public:
+		LightPreparationPass();
+
+		const PassDesc& GetPassDescription() const;
+
+		/*
+		 * Returns the size in bytes of the list of view space lights for the given number of point lights
+		 */
+		static size_t GetViewSpacePointLightListSize(uint32 PointLightCount);
+
+	private:
+		std::unique_ptr<Vulkan::ComputePipeline> Pipeline;
+		std::vector<std::unique_ptr<Vulkan::DescriptorSet>> DescriptorSets;
+
+		PassDesc PassDescription = {};
+
+		void PassCallback(const PassCallbackInfo& CallbackInfo);
+	};
+}
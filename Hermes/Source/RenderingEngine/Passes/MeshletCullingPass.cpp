@@ -0,0 +1,286 @@
+#include "MeshletCullingPass.h"
+
+#include "Core/Profiling.h"
+#include "RenderingEngine/FrameGraph/Graph.h"
+#include "RenderingEngine/FrameGraph/Resource.h"
+#include "RenderingEngine/GPUInteractionUtilities.h"
+#include "RenderingEngine/Mesh.h"
+#include "RenderingEngine/Renderer.h"
+#include "RenderingEngine/Scene/GeometryList.h"
+#include "RenderingEngine/SharedData.h"
+#include "Vulkan/Buffer.h"
+#include "Vulkan/CommandBuffer.h"
+#include "Vulkan/Device.h"
+
+namespace Hermes
+{
+	static constexpr uint32 MeshletCullingGroupSize = 64;
+	static constexpr uint32 DepthReductionGroupSize = 8;
+
+	static float ComputeMaxScale(const Mat4& Matrix)
+	{
+		float MaxScaleSquared = 0.0f;
+		for (size_t Column = 0; Column < 3; Column++)
+		{
+			Vec3 Axis = { Matrix[0][Column], Matrix[1][Column], Matrix[2][Column] };
+			MaxScaleSquared = Math::Max(MaxScaleSquared, Axis.LengthSq());
+		}
+		return Math::Sqrt(MaxScaleSquared);
+	}
+
+	MeshletCullingPass::MeshletCullingPass(bool InIsOcclusionCullingEnabled)
+		: IsOcclusionCullingEnabled(InIsOcclusionCullingEnabled)
+	{
+		auto& Device = Renderer::GetDevice();
+		auto& DescriptorAllocator = Renderer::GetDescriptorAllocator();
+
+		DescriptorSetLayout = Device.CreateDescriptorSetLayout(
+			{
+				{ 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+				{ 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+				{ 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+				{ 3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
+			});
+		for (uint32 FrameIndex = 0; FrameIndex < Renderer::GetFramesInFlightCount(); FrameIndex++)
+			DescriptorSets.push_back(DescriptorAllocator.Allocate(*DescriptorSetLayout));
+
+		auto Shader = Device.CreateShader("/Shaders/Bin/meshlet_culling.glsl.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		Pipeline = Device.CreateComputePipeline({ DescriptorSetLayout.get(), &Renderer::GetMeshletDataDescriptorSetLayout() }, *Shader,
+		                                        { { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(MeshletCullingDrawcallData) } });
+
+		Description.Type = PassType::Compute;
+		Description.BufferInputs =
+		{
+			{ "DrawCommands", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false,
+			  VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT },
+			// Cleared with a transfer command and then incremented atomically
+			{ "DrawCounts", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, false,
+			  VK_PIPELINE_STAGE_2_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			  VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT },
+			{ "SceneData", VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, false, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_UNIFORM_READ_BIT }
+		};
+		Description.Callback = [this](const PassCallbackInfo& CallbackInfo) { PassCallback(CallbackInfo); };
+
+		if (IsOcclusionCullingEnabled)
+		{
+			DepthReductionDescriptorSetLayout = Device.CreateDescriptorSetLayout(
+				{
+					{ 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+					{ 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
+				});
+
+			auto DepthReductionShader = Device.CreateShader("/Shaders/Bin/depth_reduce.glsl.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+			DepthReductionPipeline = Device.CreateComputePipeline({ DepthReductionDescriptorSetLayout.get() }, *DepthReductionShader,
+			                                                      { { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DepthPyramidReductionData) } });
+
+			Attachment DepthAttachment = {};
+			DepthAttachment.Name = "Depth";
+			DepthAttachment.LoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			DepthAttachment.StencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			DepthAttachment.Binding = BindingMode::SampledImage;
+			Description.Attachments = { std::move(DepthAttachment) };
+		}
+		else
+		{
+			DepthPyramid = Device.CreateImage({ 1, 1 }, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_FORMAT_R32_SFLOAT, 1);
+			DepthPyramidView = DepthPyramid->CreateDefaultImageView();
+
+			auto FullRange = DepthPyramid->GetFullSubresourceRange();
+			GPUInteractionUtilities::ClearImage(*DepthPyramid, Vec4(0.0f), { &FullRange, 1 }, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+		}
+	}
+
+	const PassDesc& MeshletCullingPass::GetPassDescription() const
+	{
+		return Description;
+	}
+
+	std::vector<MeshletCullingPass::DrawCommandRange> MeshletCullingPass::ComputeDrawCommandRanges(const GeometryList& GeometryList)
+	{
+		const auto& MeshList = GeometryList.GetMeshList();
+		std::vector<DrawCommandRange> Result(MeshList.size());
+
+		uint32 NextDrawCommand = 0, NextDrawCount = 0;
+		for (size_t MeshIndex = 0; MeshIndex < MeshList.size(); MeshIndex++)
+		{
+			const auto* Mesh = MeshList[MeshIndex].Mesh;
+			if (!Mesh || !Mesh->HasMeshlets())
+				continue;
+
+			auto PrimitiveCount = static_cast<uint32>(Mesh->GetPrimitives().size());
+			if (NextDrawCommand + Mesh->GetMeshletCount() > MaxDrawCommandCount || NextDrawCount + PrimitiveCount > MaxDrawCountCount)
+				continue;
+
+			Result[MeshIndex].FirstDrawCommand = NextDrawCommand;
+			Result[MeshIndex].FirstDrawCount = NextDrawCount;
+			Result[MeshIndex].IsValid = true;
+
+			NextDrawCommand += Mesh->GetMeshletCount();
+			NextDrawCount += PrimitiveCount;
+		}
+
+		return Result;
+	}
+
+	void MeshletCullingPass::PassCallback(const PassCallbackInfo& CallbackInfo)
+	{
+		HERMES_PROFILE_FUNC();
+
+		auto& CommandBuffer = CallbackInfo.CommandBuffer;
+		const auto& MeshList = CallbackInfo.GeometryList.GetMeshList();
+
+		const auto& SceneDataBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("SceneData"));
+		const auto& DrawCommandBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("DrawCommands"));
+		const auto& DrawCountBuffer = *std::get<const Vulkan::Buffer*>(CallbackInfo.Resources.at("DrawCounts"));
+
+		if (IsOcclusionCullingEnabled)
+		{
+			const auto* DepthBuffer = std::get<const Vulkan::ImageView*>(CallbackInfo.Resources.at("Depth"));
+			HERMES_ASSERT(DepthBuffer);
+
+			if (DepthBuffer != CurrentDepthBuffer || DepthBuffer->GetDimensions() != CurrentDepthBufferDimensions)
+				RecreateDepthPyramid(*DepthBuffer);
+
+			BuildDepthPyramid(CommandBuffer);
+		}
+
+		// Draw counts are accumulated atomically by the culling shader, so they have to be reset every frame
+		CommandBuffer.FillBuffer(DrawCountBuffer, 0, VK_WHOLE_SIZE, 0);
+
+		VkBufferMemoryBarrier2 ClearBarrier = {
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+			.pNext = nullptr,
+			.srcStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT,
+			.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.buffer = DrawCountBuffer.GetBuffer(),
+			.offset = 0,
+			.size = VK_WHOLE_SIZE
+		};
+		CommandBuffer.InsertDependency({}, { &ClearBarrier, 1 }, {});
+
+		auto& DescriptorSet = *DescriptorSets[Renderer::GetCurrentFrameIndex()];
+		DescriptorSet.UpdateWithBuffer(0, 0, SceneDataBuffer, 0, static_cast<uint32>(SceneDataBuffer.GetSize()));
+		DescriptorSet.UpdateWithBuffer(1, 0, DrawCommandBuffer, 0, static_cast<uint32>(DrawCommandBuffer.GetSize()));
+		DescriptorSet.UpdateWithBuffer(2, 0, DrawCountBuffer, 0, static_cast<uint32>(DrawCountBuffer.GetSize()));
+		DescriptorSet.UpdateWithImageAndSampler(3, 0, *DepthPyramidView, Renderer::GetDefaultSampler(), VK_IMAGE_LAYOUT_GENERAL);
+
+		CommandBuffer.BindPipeline(*Pipeline);
+		CommandBuffer.BindDescriptorSet(DescriptorSet, *Pipeline, 0);
+
+		auto DrawCommandRanges = ComputeDrawCommandRanges(CallbackInfo.GeometryList);
+		for (size_t MeshIndex = 0; MeshIndex < MeshList.size(); MeshIndex++)
+		{
+			const auto& Range = DrawCommandRanges[MeshIndex];
+			if (!Range.IsValid)
+				continue;
+
+			const auto& DrawableMesh = MeshList[MeshIndex];
+			const auto* Mesh = DrawableMesh.Mesh;
+
+			MeshletCullingDrawcallData DrawcallData = {};
+			DrawcallData.ModelMatrix = DrawableMesh.TransformationMatrix;
+			DrawcallData.MeshletCount = Mesh->GetMeshletCount();
+			DrawcallData.FirstDrawCommand = Range.FirstDrawCommand;
+			DrawcallData.FirstDrawCount = Range.FirstDrawCount;
+			DrawcallData.IsOcclusionCullingEnabled = IsOcclusionCullingEnabled;
+			DrawcallData.DepthPyramidDimensions = DepthPyramid->GetDimensions();
+			DrawcallData.DepthPyramidMipLevelCount = DepthPyramid->GetMipLevelsCount();
+			DrawcallData.MaxModelScale = ComputeMaxScale(DrawableMesh.TransformationMatrix);
+			DrawcallData.FirstIndex = Mesh->GetFirstIndex();
+			DrawcallData.VertexOffset = Mesh->GetVertexOffset();
+
+			CommandBuffer.BindDescriptorSet(Mesh->GetMeshletDescriptorSet(), *Pipeline, 1);
+			CommandBuffer.UploadPushConstants(*Pipeline, &DrawcallData, sizeof(DrawcallData), 0);
+			CommandBuffer.Dispatch((DrawcallData.MeshletCount + MeshletCullingGroupSize - 1) / MeshletCullingGroupSize, 1, 1);
+		}
+
+		// NOTE: the frame graph inserts the barrier before the indirect draws from the declared accesses of the passes
+	}
+
+	void MeshletCullingPass::RecreateDepthPyramid(const Vulkan::ImageView& DepthBuffer)
+	{
+		auto& Device = Renderer::GetDevice();
+
+		// NOTE: the depth buffer only changes when the frame graph recreates its resources after waiting for the device
+		//       to become idle, so the old pyramid and descriptor sets are not used by any frame in flight at this point
+		CurrentDepthBuffer = &DepthBuffer;
+		CurrentDepthBufferDimensions = DepthBuffer.GetDimensions();
+
+		// NOTE: level 0 is already a reduction of the depth buffer, the last level is always 1x1
+		auto Dimensions = (CurrentDepthBufferDimensions + 1) / 2;
+		uint32 MipLevelCount = 1;
+		for (auto LevelDimensions = Dimensions; LevelDimensions.X > 1 || LevelDimensions.Y > 1; LevelDimensions = (LevelDimensions + 1) / 2)
+			MipLevelCount++;
+
+		DepthPyramid = Device.CreateImage(Dimensions, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, VK_FORMAT_R32_SFLOAT, MipLevelCount);
+		DepthPyramidView = DepthPyramid->CreateDefaultImageView();
+
+		DepthPyramidMipViews.clear();
+		DepthReductionDescriptorSets.clear();
+		for (uint32 MipLevel = 0; MipLevel < MipLevelCount; MipLevel++)
+		{
+			VkImageSubresourceRange Range = { VK_IMAGE_ASPECT_COLOR_BIT, MipLevel, 1, 0, 1 };
+			DepthPyramidMipViews.push_back(DepthPyramid->CreateImageView(Range));
+
+			auto DescriptorSet = Renderer::GetDescriptorAllocator().Allocate(*DepthReductionDescriptorSetLayout);
+			if (MipLevel > 0)
+				DescriptorSet->UpdateWithImageAndSampler(0, 0, *DepthPyramidMipViews[MipLevel - 1], Renderer::GetDefaultSampler(), VK_IMAGE_LAYOUT_GENERAL);
+			else
+				DescriptorSet->UpdateWithImageAndSampler(0, 0, DepthBuffer, Renderer::GetDefaultSampler(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			DescriptorSet->UpdateWithImage(1, 0, *DepthPyramidMipViews[MipLevel], VK_IMAGE_LAYOUT_GENERAL);
+			DepthReductionDescriptorSets.push_back(std::move(DescriptorSet));
+		}
+	}
+
+	void MeshletCullingPass::BuildDepthPyramid(Vulkan::CommandBuffer& CommandBuffer)
+	{
+		HERMES_PROFILE_FUNC();
+
+		// NOTE: the contents of the previous frame are not needed, so the old layout can be discarded
+		VkImageMemoryBarrier2 ToGeneralBarrier = {
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+			.pNext = nullptr,
+			.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.srcAccessMask = VK_ACCESS_2_SHADER_READ_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+			.dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
+			.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			.newLayout = VK_IMAGE_LAYOUT_GENERAL,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = DepthPyramid->GetImage(),
+			.subresourceRange = DepthPyramid->GetFullSubresourceRange()
+		};
+		CommandBuffer.InsertDependency({}, {}, { &ToGeneralBarrier, 1 });
+
+		CommandBuffer.BindPipeline(*DepthReductionPipeline);
+
+		auto SourceDimensions = CurrentDepthBufferDimensions;
+		for (uint32 MipLevel = 0; MipLevel < DepthPyramid->GetMipLevelsCount(); MipLevel++)
+		{
+			auto DestinationDimensions = (SourceDimensions + 1) / 2;
+
+			DepthPyramidReductionData ReductionData = {};
+			ReductionData.SourceDimensions = SourceDimensions;
+			ReductionData.DestinationDimensions = DestinationDimensions;
+
+			CommandBuffer.BindDescriptorSet(*DepthReductionDescriptorSets[MipLevel], *DepthReductionPipeline, 0);
+			CommandBuffer.UploadPushConstants(*DepthReductionPipeline, &ReductionData, sizeof(ReductionData), 0);
+			CommandBuffer.Dispatch((DestinationDimensions.X + DepthReductionGroupSize - 1) / DepthReductionGroupSize,
+			                       (DestinationDimensions.Y + DepthReductionGroupSize - 1) / DepthReductionGroupSize, 1);
+
+			auto MipBarrier = ToGeneralBarrier;
+			MipBarrier.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+			MipBarrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
+			MipBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+			MipBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, MipLevel, 1, 0, 1 };
+			CommandBuffer.InsertDependency({}, {}, { &MipBarrier, 1 });
+
+			SourceDimensions = DestinationDimensions;
+		}
+	}
+}
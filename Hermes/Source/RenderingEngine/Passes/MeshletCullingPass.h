@@ -0,0 +1,80 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Core/Core.h"
+#include "RenderingEngine/FrameGraph/Pass.h"
+#include "Vulkan/ComputePipeline.h"
+#include "Vulkan/Descriptor.h"
+#include "Vulkan/Image.h"
+
+namespace Hermes
+{
+	/*
+	 * Culls meshlets of the meshes in the geometry list on the GPU and writes indirect draw commands for the ones that survived
+	 *
+	 * Every meshlet is tested against the view frustum and its normal cone. If occlusion culling is enabled, the pass
+	 * additionally takes a depth buffer, builds a hierarchical min-depth pyramid from it and rejects the meshlets that
+	 * are completely hidden behind it.
+	 *
+	 * Each primitive of a mesh gets a range of draw commands and a draw count, see ComputeDrawCommandRanges(). The draw
+	 * passes consume them with vkCmdDrawIndexedIndirectCount.
+	 */
+	class HERMES_API MeshletCullingPass
+	{
+	public:
+		explicit MeshletCullingPass(bool InIsOcclusionCullingEnabled);
+
+		const PassDesc& GetPassDescription() const;
+
+		struct DrawCommandRange
+		{
+			uint32 FirstDrawCommand = 0;
+			uint32 FirstDrawCount = 0;
+			bool IsValid = false;
+		};
+
+		/*
+		 * Assigns ranges of the draw command and draw count buffers to the meshes in the geometry list. Meshes without meshlets
+		 * or meshes that do not fit into the buffers get an invalid range and have to be drawn without GPU culling.
+		 * The result only depends on the geometry list, so the culling and drawing passes can compute it independently
+		 */
+		static std::vector<DrawCommandRange> ComputeDrawCommandRanges(const GeometryList& GeometryList);
+
+		static constexpr uint32 MaxDrawCommandCount = 256 * 1024;
+		static constexpr uint32 MaxDrawCountCount = 16 * 1024;
+
+		static constexpr uint32 DrawCommandBufferSize = MaxDrawCommandCount * sizeof(VkDrawIndexedIndirectCommand);
+		static constexpr uint32 DrawCountBufferSize = MaxDrawCountCount * sizeof(uint32);
+
+	private:
+		bool IsOcclusionCullingEnabled;
+
+		std::unique_ptr<Vulkan::DescriptorSetLayout> DescriptorSetLayout;
+		std::vector<std::unique_ptr<Vulkan::DescriptorSet>> DescriptorSets;
+		std::unique_ptr<Vulkan::ComputePipeline> Pipeline;
+
+		std::unique_ptr<Vulkan::DescriptorSetLayout> DepthReductionDescriptorSetLayout;
+		std::unique_ptr<Vulkan::ComputePipeline> DepthReductionPipeline;
+
+		/*
+		 * Min-depth pyramid; level 0 has half the resolution of the depth buffer. If occlusion culling is disabled it is a
+		 * 1x1 image that is only bound to satisfy the descriptor set layout
+		 */
+		std::unique_ptr<Vulkan::Image> DepthPyramid;
+		std::unique_ptr<Vulkan::ImageView> DepthPyramidView;
+		std::vector<std::unique_ptr<Vulkan::ImageView>> DepthPyramidMipViews;
+		std::vector<std::unique_ptr<Vulkan::DescriptorSet>> DepthReductionDescriptorSets;
+		const Vulkan::ImageView* CurrentDepthBuffer = nullptr;
+		Vec2ui CurrentDepthBufferDimensions = {};
+
+		PassDesc Description;
+
+		void PassCallback(const PassCallbackInfo& CallbackInfo);
+
+		void RecreateDepthPyramid(const Vulkan::ImageView& DepthBuffer);
+
+		void BuildDepthPyramid(Vulkan::CommandBuffer& CommandBuffer);
+	};
+}
@@ -23,7 +23,8 @@ namespace Hermes
 		InputColorBinding.descriptorCount = 1;
 
 		DescriptorLayout = Device.CreateDescriptorSetLayout({ InputColorBinding });
-		DescriptorSet = DescriptorAllocator.Allocate(*DescriptorLayout);
+		for (uint32 FrameIndex = 0; FrameIndex < Renderer::GetFramesInFlightCount(); FrameIndex++)
+			DescriptorSets.push_back(DescriptorAllocator.Allocate(*DescriptorLayout));
 
 		Vulkan::SamplerDescription InputSamplerDesc = {
 			.MagnificationFilter = VK_FILTER_NEAREST,
@@ -78,14 +79,15 @@ namespace Hermes
 		auto& CommandBuffer = CallbackInfo.CommandBuffer;
 
 		HERMES_ASSERT(CallbackInfo.Resources.contains("InputColor"));
-		DescriptorSet->UpdateWithImageAndSampler(0, 0, *std::get<const Vulkan::ImageView*>(CallbackInfo.Resources.at("InputColor")), *InputColorSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		auto& DescriptorSet = *DescriptorSets[Renderer::GetCurrentFrameIndex()];
+		DescriptorSet.UpdateWithImageAndSampler(0, 0, *std::get<const Vulkan::ImageView*>(CallbackInfo.Resources.at("InputColor")), *InputColorSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 		CommandBuffer.BindPipeline(*Pipeline);
 
 		CommandBuffer.SetViewport({ 0.0f, 0.0f, ViewportDimensions.X, ViewportDimensions.Y, 0.0f, 1.0f });
 		CommandBuffer.SetScissor({ { 0, 0 }, { FramebufferDimensions.X, FramebufferDimensions.Y } });
 
-		CommandBuffer.BindDescriptorSet(*DescriptorSet, *Pipeline, 0);
+		CommandBuffer.BindDescriptorSet(DescriptorSet, *Pipeline, 0);
 		CommandBuffer.Draw(6, 1, 0, 0);
 	}
 
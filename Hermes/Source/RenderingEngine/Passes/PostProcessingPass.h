@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "Core/Core.h"
 #include "Core/Misc/NonCopyableMovable.h"
@@ -26,7 +27,7 @@ namespace Hermes
 
 	private:
 		std::shared_ptr<Vulkan::DescriptorSetLayout> DescriptorLayout;
-		std::unique_ptr<Vulkan::DescriptorSet> DescriptorSet;
+		std::vector<std::unique_ptr<Vulkan::DescriptorSet>> DescriptorSets;
 		
 		std::unique_ptr<Vulkan::Pipeline> Pipeline;
 		std::unique_ptr<Vulkan::Sampler> InputColorSampler;
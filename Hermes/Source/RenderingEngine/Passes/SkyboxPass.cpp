@@ -29,7 +29,8 @@ namespace Hermes
 		CubemapTextureBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 		DataDescriptorLayout = Device.CreateDescriptorSetLayout({ CubemapTextureBinding });
 
-		DataDescriptorSet = DescriptorAllocator.Allocate(*DataDescriptorLayout);
+		for (uint32 FrameIndex = 0; FrameIndex < Renderer::GetFramesInFlightCount(); FrameIndex++)
+			DataDescriptorSets.push_back(DescriptorAllocator.Allocate(*DataDescriptorLayout));
 
 		Vulkan::SamplerDescription SamplerDesc = {};
 		SamplerDesc.AddressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
@@ -84,15 +85,16 @@ namespace Hermes
 		auto ViewProjectionMatrix = ProjectionMatrix * ViewMatrix;
 
 		const auto& ReflectionEnvmap = Scene.GetReflectionEnvmap();
-		DataDescriptorSet->UpdateWithImageAndSampler(0, 0, ReflectionEnvmap.GetView(), *EnvmapSampler,
-		                                             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		auto& DataDescriptorSet = *DataDescriptorSets[Renderer::GetCurrentFrameIndex()];
+		DataDescriptorSet.UpdateWithImageAndSampler(0, 0, ReflectionEnvmap.GetView(), *EnvmapSampler,
+		                                            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 		CommandBuffer.BindPipeline(*Pipeline);
 
 		CommandBuffer.SetViewport({ 0.0f, 0.0f, ViewportDimensions.X, ViewportDimensions.Y, 0.0f, 1.0f });
 		CommandBuffer.SetScissor({ { 0, 0 }, { FramebufferDimensions.X, FramebufferDimensions.Y } });
 
-		CommandBuffer.BindDescriptorSet(*DataDescriptorSet, *Pipeline, 0);
+		CommandBuffer.BindDescriptorSet(DataDescriptorSet, *Pipeline, 0);
 		CommandBuffer.UploadPushConstants(*Pipeline, VK_SHADER_STAGE_VERTEX_BIT, &ViewProjectionMatrix,
 		                                  sizeof(ViewProjectionMatrix), 0);
 		// Drawing 36 vertices without bound vertex buffer because their coordinates
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "Core/Core.h"
 #include "RenderingEngine/FrameGraph/Pass.h"
@@ -23,7 +24,7 @@ namespace Hermes
 
 	private:
 		std::unique_ptr<Vulkan::DescriptorSetLayout> DataDescriptorLayout;
-		std::unique_ptr<Vulkan::DescriptorSet> DataDescriptorSet;
+		std::vector<std::unique_ptr<Vulkan::DescriptorSet>> DataDescriptorSets;
 		std::unique_ptr<Vulkan::Sampler> EnvmapSampler;
 		
 		std::unique_ptr<Vulkan::Pipeline> Pipeline;
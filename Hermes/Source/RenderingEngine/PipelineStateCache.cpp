@@ -0,0 +1,270 @@
+#include "PipelineStateCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <type_traits>
+
+#include "Core/Profiling.h"
+#include "Logging/Logger.h"
+#include "Vulkan/Descriptor.h"
+#include "Vulkan/Device.h"
+#include "Vulkan/Shader.h"
+
+namespace Hermes
+{
+	template<typename ValueType>
+	static void AppendToKey(String& Key, const ValueType& Value)
+	{
+		static_assert(std::is_trivially_copyable_v<ValueType>);
+		Key.append(reinterpret_cast<const char*>(&Value), sizeof(Value));
+	}
+
+	template<typename ValueType>
+	static void AppendToKey(String& Key, std::span<const ValueType> Values)
+	{
+		AppendToKey(Key, Values.size());
+		for (const auto& Value : Values)
+			AppendToKey(Key, Value);
+	}
+
+	PipelineStateCache::PipelineStateCache(Vulkan::Device& InDevice, uint32 CompileThreadCount)
+		: Device(InDevice)
+	{
+		HERMES_ASSERT(CompileThreadCount > 0);
+
+		CompileThreads.reserve(CompileThreadCount);
+		for (uint32 ThreadIndex = 0; ThreadIndex < CompileThreadCount; ThreadIndex++)
+			CompileThreads.emplace_back(&PipelineStateCache::CompileThreadLoop, this);
+	}
+
+	PipelineStateCache::~PipelineStateCache()
+	{
+		{
+			std::lock_guard Lock(Mutex);
+			IsShuttingDown = true;
+			PendingEntries.clear();
+		}
+		CompilationRequested.notify_all();
+
+		for (auto& Thread : CompileThreads)
+			Thread.join();
+	}
+
+	const Vulkan::Pipeline& PipelineStateCache::GetPipeline(const Vulkan::PipelineDescription& Description, std::span<const VkFormat> ColorAttachmentFormats, std::optional<VkFormat> DepthAttachmentFormat)
+	{
+		auto Key = SerializeKey(Description, ColorAttachmentFormats, DepthAttachmentFormat);
+
+		auto MaybeCachedEntry = Entries.find(Key);
+		if (MaybeCachedEntry != Entries.end())
+		{
+			auto& Entry = *MaybeCachedEntry->second;
+			if (Entry.IsReady.load(std::memory_order_acquire))
+				return *Entry.Pipeline;
+
+			HERMES_PROFILE_SCOPE("Waiting for a background pipeline compilation");
+			std::unique_lock Lock(Mutex);
+			// NOTE: if no compile thread has picked the entry up yet it is faster to compile it here than to wait in the queue
+			auto MaybePendingEntry = std::find(PendingEntries.begin(), PendingEntries.end(), &Entry);
+			if (MaybePendingEntry != PendingEntries.end())
+			{
+				PendingEntries.erase(MaybePendingEntry);
+				Lock.unlock();
+
+				CompileEntry(Device, Entry);
+				Lock.lock();
+				FinishedEntries.push_back(&Entry);
+				return *Entry.Pipeline;
+			}
+
+			CompilationFinished.wait(Lock, [&]() { return Entry.IsReady.load(std::memory_order_acquire); });
+			return *Entry.Pipeline;
+		}
+
+		auto NewEntry = std::make_unique<CacheEntry>();
+		NewEntry->Name = "<synchronous>";
+		NewEntry->Description = Description;
+		NewEntry->ColorAttachmentFormats.assign(ColorAttachmentFormats.begin(), ColorAttachmentFormats.end());
+		NewEntry->DepthAttachmentFormat = DepthAttachmentFormat;
+		CompileEntry(Device, *NewEntry);
+
+		Statistics.CompiledPipelineCount++;
+		Statistics.TotalCompileMilliseconds += NewEntry->CompileMilliseconds;
+		Statistics.LongestCompileMilliseconds = std::max(Statistics.LongestCompileMilliseconds, NewEntry->CompileMilliseconds);
+
+		auto Result = Entries.insert(std::make_pair(std::move(Key), std::move(NewEntry)));
+		return *Result.first->second->Pipeline;
+	}
+
+	const Vulkan::Pipeline* PipelineStateCache::RequestPipeline(const Vulkan::PipelineDescription& Description, std::span<const VkFormat> ColorAttachmentFormats, std::optional<VkFormat> DepthAttachmentFormat, const String& Name)
+	{
+		auto Key = SerializeKey(Description, ColorAttachmentFormats, DepthAttachmentFormat);
+
+		auto MaybeCachedEntry = Entries.find(Key);
+		if (MaybeCachedEntry != Entries.end())
+		{
+			const auto& Entry = *MaybeCachedEntry->second;
+			if (Entry.IsReady.load(std::memory_order_acquire))
+				return Entry.Pipeline.get();
+			return nullptr;
+		}
+
+		auto NewEntry = std::make_unique<CacheEntry>();
+		NewEntry->Name = Name;
+		NewEntry->Description = Description;
+		NewEntry->ColorAttachmentFormats.assign(ColorAttachmentFormats.begin(), ColorAttachmentFormats.end());
+		NewEntry->DepthAttachmentFormat = DepthAttachmentFormat;
+
+		for (auto& Layout : NewEntry->Description.DescriptorSetLayouts)
+		{
+			auto LayoutKey = SerializeDescriptorSetLayout(*Layout);
+			auto& CachedLayout = DescriptorSetLayouts[LayoutKey];
+			if (!CachedLayout)
+				CachedLayout = Device.CreateDescriptorSetLayout(Layout->GetBindings(), Layout->GetBindingFlags());
+			Layout = CachedLayout.get();
+		}
+
+		auto* Entry = NewEntry.get();
+		Entries.insert(std::make_pair(std::move(Key), std::move(NewEntry)));
+		Statistics.PendingPipelineCount++;
+
+		{
+			std::lock_guard Lock(Mutex);
+			PendingEntries.push_back(Entry);
+		}
+		CompilationRequested.notify_one();
+
+		return nullptr;
+	}
+
+	void PipelineStateCache::ReportFinishedCompilations()
+	{
+		std::vector<CacheEntry*> NewlyFinishedEntries;
+		{
+			std::lock_guard Lock(Mutex);
+			std::swap(NewlyFinishedEntries, FinishedEntries);
+		}
+
+		for (const auto* Entry : NewlyFinishedEntries)
+		{
+			HERMES_ASSERT(Statistics.PendingPipelineCount > 0);
+			Statistics.PendingPipelineCount--;
+			Statistics.CompiledPipelineCount++;
+			Statistics.TotalCompileMilliseconds += Entry->CompileMilliseconds;
+			Statistics.LongestCompileMilliseconds = std::max(Statistics.LongestCompileMilliseconds, Entry->CompileMilliseconds);
+
+			HERMES_LOG_INFO("Compiled pipeline for %s in %.2f ms, %u compilations pending", Entry->Name.c_str(), Entry->CompileMilliseconds, Statistics.PendingPipelineCount);
+		}
+
+		HERMES_PROFILE_TAG("Pending pipeline compilations", static_cast<int64>(Statistics.PendingPipelineCount));
+	}
+
+	const PipelineStateCache::CompileStatistics& PipelineStateCache::GetCompileStatistics() const
+	{
+		return Statistics;
+	}
+
+	size_t PipelineStateCache::GetPipelineCount() const
+	{
+		return Entries.size();
+	}
+
+	void PipelineStateCache::CompileThreadLoop()
+	{
+		HERMES_PROFILE_THREAD("Hermes pipeline compiler");
+
+		while (true)
+		{
+			CacheEntry* Entry = nullptr;
+			{
+				std::unique_lock Lock(Mutex);
+				CompilationRequested.wait(Lock, [this]() { return IsShuttingDown || !PendingEntries.empty(); });
+				if (IsShuttingDown)
+					return;
+				Entry = PendingEntries.front();
+				PendingEntries.pop_front();
+			}
+
+			CompileEntry(Device, *Entry);
+
+			{
+				std::lock_guard Lock(Mutex);
+				FinishedEntries.push_back(Entry);
+			}
+			CompilationFinished.notify_all();
+		}
+	}
+
+	void PipelineStateCache::CompileEntry(Vulkan::Device& Device, CacheEntry& Entry)
+	{
+		HERMES_PROFILE_FUNC();
+
+		auto StartTime = std::chrono::steady_clock::now();
+		Entry.Pipeline = Device.CreatePipeline(Entry.Description, Entry.ColorAttachmentFormats, Entry.DepthAttachmentFormat);
+		auto EndTime = std::chrono::steady_clock::now();
+
+		Entry.CompileMilliseconds = std::chrono::duration<float, std::milli>(EndTime - StartTime).count();
+		Entry.IsReady.store(true, std::memory_order_release);
+	}
+
+	String PipelineStateCache::SerializeKey(const Vulkan::PipelineDescription& Description, std::span<const VkFormat> ColorAttachmentFormats, std::optional<VkFormat> DepthAttachmentFormat)
+	{
+		String Key;
+		Key.reserve(512);
+
+		AppendToKey<VkPushConstantRange>(Key, Description.PushConstants);
+
+		AppendToKey(Key, Description.DescriptorSetLayouts.size());
+		for (const auto* Layout : Description.DescriptorSetLayouts)
+			Key += SerializeDescriptorSetLayout(*Layout);
+
+		// NOTE: the shader cache never unloads shaders, so a module handle always identifies the same code
+		AppendToKey(Key, Description.ShaderStages.size());
+		for (const auto* Shader : Description.ShaderStages)
+		{
+			AppendToKey(Key, Shader->GetShader());
+			AppendToKey(Key, Shader->GetType());
+		}
+
+		AppendToKey<VkVertexInputBindingDescription>(Key, Description.VertexInputBindings);
+		AppendToKey<VkVertexInputAttributeDescription>(Key, Description.VertexInputAttributes);
+
+		AppendToKey(Key, Description.Topology);
+		AppendToKey(Key, Description.Viewport);
+		AppendToKey(Key, Description.Scissor);
+		AppendToKey(Key, Description.PolygonMode);
+		AppendToKey(Key, Description.CullMode);
+		AppendToKey(Key, Description.FaceDirection);
+		AppendToKey<VkPipelineColorBlendAttachmentState>(Key, Description.AttachmentColorBlending);
+		AppendToKey(Key, Description.BlendingConstants);
+		AppendToKey(Key, Description.IsDepthTestEnabled);
+		AppendToKey(Key, Description.IsDepthWriteEnabled);
+		AppendToKey(Key, Description.DepthCompareOperator);
+		AppendToKey<VkDynamicState>(Key, Description.DynamicStates);
+
+		AppendToKey<VkFormat>(Key, ColorAttachmentFormats);
+		AppendToKey(Key, DepthAttachmentFormat.has_value());
+		AppendToKey(Key, DepthAttachmentFormat.value_or(VK_FORMAT_UNDEFINED));
+
+		return Key;
+	}
+
+	String PipelineStateCache::SerializeDescriptorSetLayout(const Vulkan::DescriptorSetLayout& Layout)
+	{
+		String Key;
+
+		const auto& Bindings = Layout.GetBindings();
+		AppendToKey(Key, Bindings.size());
+		// NOTE: immutable samplers are not used by the engine, so the pointer is left out of the key
+		for (const auto& Binding : Bindings)
+		{
+			HERMES_ASSERT(Binding.pImmutableSamplers == nullptr);
+			AppendToKey(Key, Binding.binding);
+			AppendToKey(Key, Binding.descriptorType);
+			AppendToKey(Key, Binding.descriptorCount);
+			AppendToKey(Key, Binding.stageFlags);
+		}
+		AppendToKey<VkDescriptorBindingFlags>(Key, Layout.GetBindingFlags());
+
+		return Key;
+	}
+}
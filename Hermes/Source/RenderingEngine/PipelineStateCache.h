@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Core/Core.h"
+#include "Core/Misc/NonCopyableMovable.h"
+#include "Vulkan/Pipeline.h"
+
+namespace Hermes
+{
+	/*
+	 * Renderer-wide storage of graphics pipelines keyed by everything that affects the compiled pipeline: the pipeline
+	 * description (shader modules, contents of the descriptor set layouts, fixed function state) and the attachment formats.
+	 * Users that request identical pipelines share one object, and pipelines for different attachment formats live side
+	 * by side instead of replacing each other
+	 *
+	 * Pipelines can either be created right away (GetPipeline()) or compiled on background threads (RequestPipeline()) so
+	 * that streaming in new materials does not stall the render thread. All functions must be called from the render thread
+	 */
+	class HERMES_API PipelineStateCache
+	{
+		MAKE_NON_COPYABLE(PipelineStateCache)
+		MAKE_NON_MOVABLE(PipelineStateCache)
+
+	public:
+		struct CompileStatistics
+		{
+			uint32 CompiledPipelineCount = 0;
+			uint32 PendingPipelineCount = 0;
+			float TotalCompileMilliseconds = 0.0f;
+			float LongestCompileMilliseconds = 0.0f;
+		};
+
+		PipelineStateCache(Vulkan::Device& InDevice, uint32 CompileThreadCount);
+
+		/*
+		 * Unfinished background compilations that have not started yet are dropped
+		 */
+		~PipelineStateCache();
+
+		/*
+		 * Returns a pipeline matching the description and attachment formats, it is created on the first request only
+		 * (or waited for if it is being compiled in the background). The returned reference stays valid until the renderer
+		 * shuts down
+		 *
+		 * NOTE: descriptor set layouts are compared by their bindings, so the pipeline may have been created with other
+		 *       (compatible) layout objects than the ones in the description
+		 */
+		const Vulkan::Pipeline& GetPipeline(const Vulkan::PipelineDescription& Description, std::span<const VkFormat> ColorAttachmentFormats, std::optional<VkFormat> DepthAttachmentFormat);
+
+		/*
+		 * Same as GetPipeline(), but a pipeline that does not exist yet is compiled on a background thread and nullptr is
+		 * returned until it is ready. The description does not have to outlive the call. The name is only used to report
+		 * the compile time
+		 */
+		const Vulkan::Pipeline* RequestPipeline(const Vulkan::PipelineDescription& Description, std::span<const VkFormat> ColorAttachmentFormats, std::optional<VkFormat> DepthAttachmentFormat, const String& Name);
+
+		/*
+		 * Logs the compile times of the pipelines that finished in the background since the last call, called once per frame
+		 * by the renderer
+		 */
+		void ReportFinishedCompilations();
+
+		const CompileStatistics& GetCompileStatistics() const;
+
+		size_t GetPipelineCount() const;
+
+	private:
+		Vulkan::Device& Device;
+
+		struct CacheEntry
+		{
+			String Name;
+			Vulkan::PipelineDescription Description;
+			std::vector<VkFormat> ColorAttachmentFormats;
+			std::optional<VkFormat> DepthAttachmentFormat;
+
+			std::unique_ptr<Vulkan::Pipeline> Pipeline;
+			float CompileMilliseconds = 0.0f;
+			// NOTE: Pipeline and CompileMilliseconds may only be read by the render thread once this is set
+			std::atomic<bool> IsReady = false;
+		};
+
+		// NOTE: the key is a byte string with all the state that goes into the pipeline, so the map compares full keys
+		//       and a hash collision can never return a wrong pipeline
+		std::unordered_map<String, std::unique_ptr<CacheEntry>> Entries;
+
+		// Background compilations refer to these instead of the layouts of the caller, which may be destroyed before
+		// the compilation finishes, keyed the same way as the layouts in the pipeline key
+		std::unordered_map<String, std::unique_ptr<Vulkan::DescriptorSetLayout>> DescriptorSetLayouts;
+
+		std::vector<std::thread> CompileThreads;
+
+		// All of these are protected by the mutex
+		std::mutex Mutex;
+		std::condition_variable CompilationRequested;
+		std::condition_variable CompilationFinished;
+		std::deque<CacheEntry*> PendingEntries;
+		std::vector<CacheEntry*> FinishedEntries;
+		bool IsShuttingDown = false;
+
+		CompileStatistics Statistics;
+
+		void CompileThreadLoop();
+
+		static void CompileEntry(Vulkan::Device& Device, CacheEntry& Entry);
+
+		static String SerializeKey(const Vulkan::PipelineDescription& Description, std::span<const VkFormat> ColorAttachmentFormats, std::optional<VkFormat> DepthAttachmentFormat);
+
+		static String SerializeDescriptorSetLayout(const Vulkan::DescriptorSetLayout& Layout);
+	};
+}
@@ -1,6 +1,8 @@
 #include "Renderer.h"
 
+#include <algorithm>
 #include <functional>
+#include <thread>
 
 #include "ApplicationCore/GameLoop.h"
 #include "Core/Profiling.h"
@@ -9,8 +11,10 @@
 #include "RenderingEngine/SceneRenderer.h"
 #include "RenderingEngine/Scene/Scene.h"
 #include "RenderingEngine/UIRenderer.h"
+#include "Vulkan/CommandBuffer.h"
 #include "Vulkan/Device.h"
-#include "Vulkan/Fence.h"
+#include "Vulkan/Queue.h"
+#include "Vulkan/Semaphore.h"
 #include "Vulkan/Swapchain.h"
 
 namespace Hermes
@@ -22,17 +26,46 @@ namespace Hermes
 		std::unique_ptr<Vulkan::Instance> VulkanInstance;
 		std::unique_ptr<Vulkan::Device> Device;
 		std::unique_ptr<Vulkan::Swapchain> Swapchain;
+		std::unique_ptr<SynchronizationPool> SynchronizationPool;
+		std::unique_ptr<GPUProfiler> GPUProfiler;
 
 		std::unique_ptr<DescriptorAllocator> DescriptorAllocator;
+		std::shared_ptr<MeshArena> MeshArena;
 		std::unique_ptr<Vulkan::DescriptorSetLayout> GlobalDataDescriptorSetLayout;
+		std::unique_ptr<Vulkan::DescriptorSetLayout> MeshletDataDescriptorSetLayout;
 		std::unique_ptr<Vulkan::Sampler> DefaultSampler;
+		std::shared_ptr<MaterialResourceTable> MaterialResourceTable;
 
 		std::unique_ptr<SceneRenderer> SceneRenderer;
 		std::unique_ptr<UIRenderer> UIRenderer;
 
 		ShaderCache ShaderCache;
+		// NOTE: declared after the shader cache because its compile threads use the shaders until they are joined
+		std::unique_ptr<PipelineStateCache> PipelineStateCache;
+
+		std::unique_ptr<ThreadPool> ThreadPool;
+		std::unique_ptr<CommandBufferAllocator> CommandBufferAllocator;
+		std::unique_ptr<FrameAllocator> FrameAllocator;
+
+		struct FrameResources
+		{
+			std::unique_ptr<Vulkan::Semaphore> ImageAcquiredSemaphore;
+		};
+		std::vector<FrameResources> Frames;
+		uint32 CurrentFrameIndex = 0;
+
+		// The last submission of every frame sets it to the number of the frame, so it tells which frames the GPU has
+		// finished, see GetCompletedFrameNumber()
+		std::unique_ptr<Vulkan::TimelineSemaphore> FrameCounterSemaphore;
+		uint64 CurrentFrameNumber = 1;
+
+		// NOTE: these are per swapchain image rather than per frame because presentation has no fence that would tell
+		//       when the presentation engine has finished waiting on them
+		std::vector<std::unique_ptr<Vulkan::Semaphore>> RenderingFinishedSemaphores;
+		uint32 CurrentSwapchainImageIndex = 0;
 
 		static constexpr uint32 NumberOfBackBuffers = 3; // TODO : let user modify
+		static constexpr size_t FrameAllocatorInitialCapacity = 1024 * 1024;
 	};
 
 	RendererState* GRendererState = nullptr;
@@ -65,11 +98,30 @@ namespace Hermes
 			return false;
 		DumpGPUProperties();
 
+		GRendererState->SynchronizationPool = std::make_unique<SynchronizationPool>(RendererState::NumberOfBackBuffers);
+		GRendererState->FrameCounterSemaphore = GRendererState->Device->CreateTimelineSemaphore(0);
+		GRendererState->GPUProfiler = std::make_unique<GPUProfiler>(RendererState::NumberOfBackBuffers);
+
 		GRendererState->Swapchain = GRendererState->Device->CreateSwapchain(RendererState::NumberOfBackBuffers);
 		if (!GRendererState->Swapchain)
 			return false;
 
+		GRendererState->Frames.resize(RendererState::NumberOfBackBuffers);
+		for (auto& Frame : GRendererState->Frames)
+			Frame.ImageAcquiredSemaphore = GRendererState->Device->CreateBinarySemaphore();
+
+		// NOTE: hardware_concurrency() may return 0, the render thread itself is always used for recording as well
+		auto WorkerThreadCount = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+		GRendererState->ThreadPool = std::make_unique<ThreadPool>(WorkerThreadCount);
+		GRendererState->CommandBufferAllocator = std::make_unique<CommandBufferAllocator>(RendererState::NumberOfBackBuffers, GRendererState->ThreadPool->GetThreadCount());
+		GRendererState->FrameAllocator = std::make_unique<FrameAllocator>(RendererState::NumberOfBackBuffers, RendererState::FrameAllocatorInitialCapacity);
+
+		// NOTE: pipeline compilation runs in the background alongside the frame, so it only gets a fraction of the cores
+		auto PipelineCompileThreadCount = std::max(std::thread::hardware_concurrency() / 4, 1u);
+		GRendererState->PipelineStateCache = std::make_unique<PipelineStateCache>(*GRendererState->Device, PipelineCompileThreadCount);
+
 		GRendererState->DescriptorAllocator = std::make_unique<DescriptorAllocator>();
+		GRendererState->MeshArena = std::make_shared<MeshArena>(RendererState::NumberOfBackBuffers);
 
 		VkDescriptorSetLayoutBinding SceneUBOBinding = {};
 		SceneUBOBinding.binding = 0;
@@ -91,21 +143,29 @@ namespace Hermes
 		PrecomputedBRDFBinding.descriptorCount = 1;
 		PrecomputedBRDFBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 		PrecomputedBRDFBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		VkDescriptorSetLayoutBinding LightClusterListBinding = {};
-		LightClusterListBinding.binding = 4;
-		LightClusterListBinding.descriptorCount = 1;
-		LightClusterListBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-		LightClusterListBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-		VkDescriptorSetLayoutBinding LightIndexListBinding = {};
-		LightIndexListBinding.binding = 5;
-		LightIndexListBinding.descriptorCount = 1;
-		LightIndexListBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-		LightIndexListBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		VkDescriptorSetLayoutBinding LightClusterMasksBinding = {};
+		LightClusterMasksBinding.binding = 4;
+		LightClusterMasksBinding.descriptorCount = 1;
+		LightClusterMasksBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		LightClusterMasksBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		VkDescriptorSetLayoutBinding PointLightListBinding = {};
+		PointLightListBinding.binding = 5;
+		PointLightListBinding.descriptorCount = 1;
+		PointLightListBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		PointLightListBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 
 		GRendererState->GlobalDataDescriptorSetLayout = GRendererState->Device->CreateDescriptorSetLayout({
-			SceneUBOBinding, IrradianceCubemapBinding, SpecularCubemapBinding, PrecomputedBRDFBinding, LightClusterListBinding, LightIndexListBinding
+			SceneUBOBinding, IrradianceCubemapBinding, SpecularCubemapBinding, PrecomputedBRDFBinding, LightClusterMasksBinding, PointLightListBinding
 		});
 
+		VkDescriptorSetLayoutBinding MeshletListBinding = {};
+		MeshletListBinding.binding = 0;
+		MeshletListBinding.descriptorCount = 1;
+		MeshletListBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		MeshletListBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+		GRendererState->MeshletDataDescriptorSetLayout = GRendererState->Device->CreateDescriptorSetLayout({ MeshletListBinding });
+
 		Vulkan::SamplerDescription SamplerDesc = {};
 		SamplerDesc.AddressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 		SamplerDesc.MinificationFilter = VK_FILTER_LINEAR;
@@ -117,6 +177,8 @@ namespace Hermes
 		SamplerDesc.LODBias = 0.0f;
 		GRendererState->DefaultSampler = GRendererState->Device->CreateSampler(SamplerDesc);
 
+		GRendererState->MaterialResourceTable = std::make_shared<MaterialResourceTable>(RendererState::NumberOfBackBuffers);
+
 		GRendererState->SceneRenderer = std::make_unique<SceneRenderer>();
 		GRendererState->UIRenderer = std::make_unique<UIRenderer>();
 
@@ -129,6 +191,9 @@ namespace Hermes
 
 		HERMES_ASSERT(GRendererState);
 
+		if (!BeginFrame())
+			return;
+
 		auto SceneViewport = GRendererState->UIRenderer->PrepareToRender(RootWidget, GetSwapchainDimensions());
 
 		auto [SceneImage, SceneImageLayout] = GRendererState->SceneRenderer->Render(Scene, SceneViewport.Dimensions());
@@ -139,6 +204,9 @@ namespace Hermes
 
 		Present(*FinalImage, FinalImageLayout, { { 0, 0 }, GetSwapchainDimensions() });
 
+		GRendererState->CurrentFrameIndex = (GRendererState->CurrentFrameIndex + 1) % RendererState::NumberOfBackBuffers;
+		GRendererState->CurrentFrameNumber++;
+
 		HERMES_PROFILE_TAG("Draw call count", static_cast<int64>(Vulkan::GProfilingMetrics.DrawCallCount));
 		HERMES_PROFILE_TAG("Compute dispatch count", static_cast<int64>(Vulkan::GProfilingMetrics.ComputeDispatchCount));
 		HERMES_PROFILE_TAG("Pipeline bind count", static_cast<int64>(Vulkan::GProfilingMetrics.PipelineBindCount));
@@ -150,6 +218,8 @@ namespace Hermes
 	void Renderer::Shutdown()
 	{
 		HERMES_ASSERT_LOG(GRendererState, "Trying to shut down the renderer twice");
+		GRendererState->Device->WaitForIdle();
+		GRendererState->Device->SavePipelineCache();
 		delete GRendererState;
 		GRendererState = nullptr;
 	}
@@ -178,18 +248,108 @@ namespace Hermes
 		return GRendererState->ShaderCache;
 	}
 
+	PipelineStateCache& Renderer::GetPipelineStateCache()
+	{
+		HERMES_ASSERT(GRendererState);
+		return *GRendererState->PipelineStateCache;
+	}
+
+	ThreadPool& Renderer::GetThreadPool()
+	{
+		HERMES_ASSERT(GRendererState);
+		return *GRendererState->ThreadPool;
+	}
+
+	CommandBufferAllocator& Renderer::GetCommandBufferAllocator()
+	{
+		HERMES_ASSERT(GRendererState);
+		return *GRendererState->CommandBufferAllocator;
+	}
+
+	FrameAllocator& Renderer::GetFrameAllocator()
+	{
+		HERMES_ASSERT(GRendererState);
+		return *GRendererState->FrameAllocator;
+	}
+
+	SynchronizationPool& Renderer::GetSynchronizationPool()
+	{
+		HERMES_ASSERT(GRendererState);
+		return *GRendererState->SynchronizationPool;
+	}
+
+	GPUProfiler& Renderer::GetGPUProfiler()
+	{
+		HERMES_ASSERT(GRendererState);
+		return *GRendererState->GPUProfiler;
+	}
+
+	uint32 Renderer::GetFramesInFlightCount()
+	{
+		return RendererState::NumberOfBackBuffers;
+	}
+
+	uint32 Renderer::GetCurrentFrameIndex()
+	{
+		HERMES_ASSERT(GRendererState);
+		return GRendererState->CurrentFrameIndex;
+	}
+
+	uint64 Renderer::GetCurrentFrameNumber()
+	{
+		HERMES_ASSERT(GRendererState);
+		return GRendererState->CurrentFrameNumber;
+	}
+
+	uint64 Renderer::GetCompletedFrameNumber()
+	{
+		HERMES_ASSERT(GRendererState);
+		return GRendererState->FrameCounterSemaphore->GetValue();
+	}
+
+	void Renderer::WaitForFrame(uint64 FrameNumber)
+	{
+		HERMES_ASSERT(GRendererState);
+		HERMES_ASSERT(FrameNumber < GRendererState->CurrentFrameNumber);
+		GRendererState->FrameCounterSemaphore->Wait(FrameNumber, UINT64_MAX);
+	}
+
+	const Vulkan::TimelineSemaphore& Renderer::GetFrameCounterSemaphore()
+	{
+		HERMES_ASSERT(GRendererState);
+		return *GRendererState->FrameCounterSemaphore;
+	}
+
+	std::shared_ptr<MeshArena> Renderer::GetMeshArena()
+	{
+		HERMES_ASSERT(GRendererState);
+		return GRendererState->MeshArena;
+	}
+
 	const Vulkan::DescriptorSetLayout& Renderer::GetGlobalDataDescriptorSetLayout()
 	{
 		HERMES_ASSERT(GRendererState);
 		return *GRendererState->GlobalDataDescriptorSetLayout;
 	}
 
+	const Vulkan::DescriptorSetLayout& Renderer::GetMeshletDataDescriptorSetLayout()
+	{
+		HERMES_ASSERT(GRendererState);
+		return *GRendererState->MeshletDataDescriptorSetLayout;
+	}
+
 	const Vulkan::Sampler& Renderer::GetDefaultSampler()
 	{
 		HERMES_ASSERT(GRendererState);
 		return *GRendererState->DefaultSampler;
 	}
 
+	std::shared_ptr<MaterialResourceTable> Renderer::GetMaterialResourceTable()
+	{
+		HERMES_ASSERT(GRendererState);
+		return GRendererState->MaterialResourceTable;
+	}
+
 	void Renderer::DumpGPUProperties()
 	{
 		HERMES_ASSERT(GRendererState);
@@ -198,6 +358,45 @@ namespace Hermes
 		HERMES_LOG_INFO("Anisotropy: %s, %f", GRendererState->GPUProperties.AnisotropySupport ? "true" : "false", GRendererState->GPUProperties.MaxAnisotropyLevel);
 	}
 
+	bool Renderer::BeginFrame()
+	{
+		HERMES_ASSERT(GRendererState);
+		HERMES_PROFILE_FUNC();
+
+		auto& Frame = GRendererState->Frames[GRendererState->CurrentFrameIndex];
+		if (GRendererState->CurrentFrameNumber > RendererState::NumberOfBackBuffers)
+		{
+			HERMES_PROFILE_SCOPE("Waiting for the GPU to finish the frame");
+			WaitForFrame(GRendererState->CurrentFrameNumber - RendererState::NumberOfBackBuffers);
+		}
+
+		// The GPU no longer uses anything that was freed while this frame was recorded the last time
+		GRendererState->MeshArena->BeginFrame(GRendererState->CurrentFrameIndex);
+		GRendererState->MaterialResourceTable->BeginFrame(GRendererState->CurrentFrameIndex);
+		GRendererState->CommandBufferAllocator->BeginFrame(GRendererState->CurrentFrameIndex);
+		GRendererState->FrameAllocator->BeginFrame(GRendererState->CurrentFrameIndex);
+		GRendererState->SynchronizationPool->BeginFrame(GRendererState->CurrentFrameIndex);
+		GRendererState->GPUProfiler->BeginFrame(GRendererState->CurrentFrameIndex);
+		GRendererState->PipelineStateCache->ReportFinishedCompilations();
+
+		bool SwapchainWasRecreated = false;
+		auto MaybeSwapchainImageIndex = GRendererState->Swapchain->AcquireImage(UINT64_MAX, *Frame.ImageAcquiredSemaphore, SwapchainWasRecreated);
+		if (!MaybeSwapchainImageIndex.has_value())
+		{
+			if (!SwapchainWasRecreated)
+				HERMES_LOG_ERROR("Presentation failed: swapchain did not return valid image index.");
+			// NOTE: nothing was submitted and the frame number did not change, so the frame can be retried
+			return false;
+		}
+		GRendererState->CurrentSwapchainImageIndex = MaybeSwapchainImageIndex.value();
+
+		// The swapchain might have more images after it was recreated
+		while (GRendererState->RenderingFinishedSemaphores.size() < GRendererState->Swapchain->GetImageCount())
+			GRendererState->RenderingFinishedSemaphores.push_back(GRendererState->Device->CreateBinarySemaphore());
+
+		return true;
+	}
+
 	void Renderer::Present(const Vulkan::Image& SourceImage, VkImageLayout CurrentLayout, Rect2Dui Viewport)
 	{
 		HERMES_ASSERT(GRendererState);
@@ -206,20 +405,15 @@ namespace Hermes
 		HERMES_ASSERT(Viewport.Max.X <= GRendererState->Swapchain->GetDimensions().X);
 		HERMES_ASSERT(Viewport.Max.Y <= GRendererState->Swapchain->GetDimensions().Y);
 
+		auto& Frame = GRendererState->Frames[GRendererState->CurrentFrameIndex];
+		auto SwapchainImageIndex = GRendererState->CurrentSwapchainImageIndex;
+
 		auto& Queue = GRendererState->Device->GetQueue(VK_QUEUE_GRAPHICS_BIT);
-		auto CommandBuffer = Queue.CreateCommandBuffer();
+		auto& CommandBuffer = GRendererState->CommandBufferAllocator->Allocate(Queue);
 
-		bool Dummy;
-		auto SwapchainImageAcquireFence = GRendererState->Device->CreateFence();
-		auto MaybeSwapchainImageIndex = GRendererState->Swapchain->AcquireImage(UINT64_MAX, *SwapchainImageAcquireFence, Dummy);
-		if (!MaybeSwapchainImageIndex.has_value())
-		{
-			HERMES_LOG_ERROR("Presentation failed: swapchain did not return valid image index.");
-			return;
-		}
-		const auto& SwapchainImage = GRendererState->Swapchain->GetImage(MaybeSwapchainImageIndex.value());
+		const auto& SwapchainImage = GRendererState->Swapchain->GetImage(SwapchainImageIndex);
 
-		CommandBuffer->BeginRecording();
+		CommandBuffer.BeginRecording();
 
 		VkImageMemoryBarrier BarriersBeforeBlit[2];
 		// Source image to transfer source optimal
@@ -248,7 +442,9 @@ namespace Hermes
 			.image = SwapchainImage.GetImage(),
 			.subresourceRange = SwapchainImage.GetFullSubresourceRange()
 		};
-		CommandBuffer->InsertImageMemoryBarriers(BarriersBeforeBlit, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+		// NOTE: the transfer stage is in the source scope so that the layout transition of the swapchain image happens after
+		//       the wait on the image acquisition semaphore
+		CommandBuffer.InsertImageMemoryBarriers(BarriersBeforeBlit, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
 		VkImageBlit BlitRegion = {};
 		BlitRegion.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
@@ -258,7 +454,7 @@ namespace Hermes
 		BlitRegion.dstOffsets[0] = { static_cast<int32>(Viewport.Min.X), static_cast<int32>(Viewport.Min.Y), 0 };
 		BlitRegion.dstOffsets[1] = { static_cast<int32>(Viewport.Max.X), static_cast<int32>(Viewport.Max.Y), 1 };
 
-		CommandBuffer->BlitImage(SourceImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, SwapchainImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, { &BlitRegion, 1 }, VK_FILTER_LINEAR);
+		CommandBuffer.BlitImage(SourceImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, SwapchainImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, { &BlitRegion, 1 }, VK_FILTER_LINEAR);
 
 		// Source image back to its original layout
 		VkImageMemoryBarrier SourceImageAfterBlitBarrier = {
@@ -273,7 +469,7 @@ namespace Hermes
 			.image = SourceImage.GetImage(),
 			.subresourceRange = SourceImage.GetFullSubresourceRange()
 		};
-		CommandBuffer->InsertImageMemoryBarrier(SourceImageAfterBlitBarrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+		CommandBuffer.InsertImageMemoryBarrier(SourceImageAfterBlitBarrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
 
 		// Swapchain image to presentation optimal
 		VkImageMemoryBarrier SwapchainImageToPresentationBarrier = {
@@ -288,16 +484,18 @@ namespace Hermes
 			.image = SwapchainImage.GetImage(),
 			.subresourceRange = SwapchainImage.GetFullSubresourceRange()
 		};
-		CommandBuffer->InsertImageMemoryBarrier(SwapchainImageToPresentationBarrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-
-		CommandBuffer->EndRecording();
+		CommandBuffer.InsertImageMemoryBarrier(SwapchainImageToPresentationBarrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
-		SwapchainImageAcquireFence->Wait(UINT64_MAX);
+		CommandBuffer.EndRecording();
 
-		auto BlitFinishedFence = GRendererState->Device->CreateFence();
-		Queue.SubmitCommandBuffer(*CommandBuffer, BlitFinishedFence.get());
-		BlitFinishedFence->Wait(UINT64_MAX);
+		// NOTE: all graphics work of the frame was submitted to the same queue before and the graphics work waits for the
+		//       async compute work, so the frame counter also tells when the whole frame is finished
+		Vulkan::SemaphoreWait ImageAcquiredWait = { Frame.ImageAcquiredSemaphore.get(), VK_PIPELINE_STAGE_TRANSFER_BIT };
+		const auto* RenderingFinishedSemaphore = GRendererState->RenderingFinishedSemaphores[SwapchainImageIndex].get();
+		Vulkan::TimelineSemaphoreSignal FrameFinishedSignal = { GRendererState->FrameCounterSemaphore.get(), GRendererState->CurrentFrameNumber };
+		Queue.SubmitCommandBuffer(CommandBuffer, { &ImageAcquiredWait, 1 }, { &RenderingFinishedSemaphore, 1 }, { &FrameFinishedSignal, 1 }, {});
 
-		GRendererState->Swapchain->Present(MaybeSwapchainImageIndex.value(), Dummy);
+		bool Dummy;
+		GRendererState->Swapchain->Present(SwapchainImageIndex, *RenderingFinishedSemaphore, Dummy);
 	}
 }
@@ -3,10 +3,18 @@
 #include <memory>
 
 #include "Core/Core.h"
+#include "Core/Misc/ThreadPool.h"
 #include "Math/Rect2D.h"
+#include "RenderingEngine/CommandBufferAllocator.h"
 #include "RenderingEngine/DescriptorAllocator.h"
+#include "RenderingEngine/FrameAllocator.h"
+#include "RenderingEngine/GPUProfiler.h"
+#include "RenderingEngine/Material/MaterialResourceTable.h"
+#include "RenderingEngine/MeshArena.h"
+#include "RenderingEngine/PipelineStateCache.h"
 #include "RenderingEngine/Scene/Scene.h"
 #include "RenderingEngine/ShaderCache.h"
+#include "RenderingEngine/SynchronizationPool.h"
 #include "UIEngine/Widgets/Widget.h"
 #include "Vulkan/Forward.h"
 
@@ -29,13 +37,95 @@ namespace Hermes
 
 		static ShaderCache& GetShaderCache();
 
+		/*
+		 * Graphics pipelines shared by all materials, see PipelineStateCache
+		 */
+		static PipelineStateCache& GetPipelineStateCache();
+
+		/*
+		 * Worker threads used for parallel command recording, must only be used from the render thread
+		 */
+		static ThreadPool& GetThreadPool();
+
+		/*
+		 * Command buffers for the work of the current frame, the thread index is the one given by GetThreadPool()
+		 */
+		static CommandBufferAllocator& GetCommandBufferAllocator();
+
+		/*
+		 * Transient GPU data of the current frame, must only be used from the render thread
+		 */
+		static FrameAllocator& GetFrameAllocator();
+
+		static SynchronizationPool& GetSynchronizationPool();
+
+		/*
+		 * GPU timings of the frame graph passes, they are a few frames old because the renderer never waits for them
+		 */
+		static GPUProfiler& GetGPUProfiler();
+
+		/*
+		 * Number of frames the CPU can record ahead of the GPU. Resources that the CPU writes or updates every frame
+		 * (uniform buffers, descriptor sets, command buffers) need one copy per frame in flight
+		 */
+		static uint32 GetFramesInFlightCount();
+
+		/*
+		 * Index of the frame that is currently being recorded, in range [0, GetFramesInFlightCount()). The GPU has
+		 * finished the previous frame that had the same index, so its resources can be safely overwritten
+		 */
+		static uint32 GetCurrentFrameIndex();
+
+		/*
+		 * Number of the frame that is currently being recorded. Unlike the frame index it increases by one every frame,
+		 * the first frame has number 1
+		 */
+		static uint64 GetCurrentFrameNumber();
+
+		/*
+		 * Number of the last frame whose GPU work has completed, 0 if there is none yet. Only reads the value of
+		 * a timeline semaphore, so it is cheap enough to be called whenever needed
+		 */
+		static uint64 GetCompletedFrameNumber();
+
+		/*
+		 * Blocks until the GPU has finished the frame with the given number, must not be called for the current frame
+		 * or a later one as they are not submitted yet
+		 */
+		static void WaitForFrame(uint64 FrameNumber);
+
+		/*
+		 * Timeline semaphore whose value is the number of the last completed frame (see GetCompletedFrameNumber()), queue
+		 * submissions can wait on it to depend on the work of the previous frames
+		 */
+		static const Vulkan::TimelineSemaphore& GetFrameCounterSemaphore();
+
+		/*
+		 * Returns a shared pointer because meshes keep the arena alive until they release their allocations, which
+		 * can happen after the renderer was shut down
+		 */
+		static std::shared_ptr<MeshArena> GetMeshArena();
+
 		static const Vulkan::DescriptorSetLayout& GetGlobalDataDescriptorSetLayout();
 
+		/*
+		 * Layout of the per-mesh descriptor set that contains the meshlet storage buffer (see Mesh::GetMeshletDescriptorSet())
+		 */
+		static const Vulkan::DescriptorSetLayout& GetMeshletDataDescriptorSetLayout();
+
 		static const Vulkan::Sampler& GetDefaultSampler();
 
+		/*
+		 * Returns a shared pointer for the same reason as GetMeshArena(), material instances release their data slots
+		 * and textures when they are destroyed
+		 */
+		static std::shared_ptr<MaterialResourceTable> GetMaterialResourceTable();
+
 	private:
 		static void DumpGPUProperties();
 
+		static bool BeginFrame();
+
 		static void Present(const Vulkan::Image& SourceImage, VkImageLayout CurrentLayout, Rect2Dui Viewport);
 	};
 }
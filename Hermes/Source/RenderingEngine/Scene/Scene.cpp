@@ -191,7 +191,7 @@ namespace Hermes
 
 		CommandBuffer->EndRecording();
 
-		auto Fence = Device.CreateFence();
+		auto Fence = Renderer::GetSynchronizationPool().AcquireFence();
 		Queue.SubmitCommandBuffer(*CommandBuffer, Fence.get());
 		Fence->Wait(UINT64_MAX);
 
@@ -385,7 +385,7 @@ namespace Hermes
 
 		CommandBuffer->EndRecording();
 
-		auto Fence = Device.CreateFence();
+		auto Fence = Renderer::GetSynchronizationPool().AcquireFence();
 		Queue.SubmitCommandBuffer(*CommandBuffer, Fence.get());
 		Fence->Wait(UINT64_MAX);
 
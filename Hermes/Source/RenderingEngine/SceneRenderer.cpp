@@ -1,6 +1,14 @@
 #include "SceneRenderer.h"
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
 #include "Core/Profiling.h"
+#include "Math/BoundingVolume.h"
+#include "Math/Frustum.h"
+#include "RenderingEngine/LightClustering.h"
+#include "RenderingEngine/Material/Material.h"
 #include "RenderingEngine/Renderer.h"
 #include "RenderingEngine/Scene/Camera.h"
 #include "RenderingEngine/SharedData.h"
@@ -9,14 +17,22 @@ namespace Hermes
 {
 	SceneRenderer::SceneRenderer()
 	{
+		LightPreparationPass = std::make_unique<class LightPreparationPass>();
 		LightCullingPass = std::make_unique<class LightCullingPass>();
+		// NOTE: meshlets are culled twice: the depth prepass draws everything that passes the frustum and cone tests and
+		//       the forward pass additionally skips the meshlets that are hidden behind the depth buffer produced by the prepass
+		MeshletCullingPass = std::make_unique<class MeshletCullingPass>(false);
+		MeshletOcclusionCullingPass = std::make_unique<class MeshletCullingPass>(true);
 		DepthPass = std::make_unique<class DepthPass>();
 		ForwardPass = std::make_unique<class ForwardPass>(true);
 		PostProcessingPass = std::make_unique<class PostProcessingPass>();
 		SkyboxPass = std::make_unique<class SkyboxPass>();
 
 		FrameGraphScheme Scheme;
+		Scheme.AddPass("LightPreparationPass", LightPreparationPass->GetPassDescription());
 		Scheme.AddPass("LightCullingPass", LightCullingPass->GetPassDescription());
+		Scheme.AddPass("MeshletCullingPass", MeshletCullingPass->GetPassDescription());
+		Scheme.AddPass("MeshletOcclusionCullingPass", MeshletOcclusionCullingPass->GetPassDescription());
 		Scheme.AddPass("DepthPass", DepthPass->GetPassDescription());
 		Scheme.AddPass("ForwardPass", ForwardPass->GetPassDescription());
 		Scheme.AddPass("PostProcessingPass", PostProcessingPass->GetPassDescription());
@@ -40,14 +56,38 @@ namespace Hermes
 		DepthBufferResource.MipLevels = 1;
 		Scheme.AddResource("DepthBuffer", DepthBufferResource, false);
 
-		BufferResourceDescription LightClusterListResource = {};
-		// FIXME: find a way to compute this value instead of guessing
-		LightClusterListResource.Size = 4 * 1024 * 1024;
-		Scheme.AddResource("LightClusterList", LightClusterListResource, false);
+		// NOTE: resized every frame to fit the viewport and the number of visible point lights, see UpdateSceneDataBuffer()
+		BufferResourceDescription LightClusterMasksResource =
+		{
+			.Size = sizeof(uint32)
+		};
+		Scheme.AddResource("LightClusterMasks", LightClusterMasksResource, false);
+
+		// NOTE: resized together with the light cluster masks
+		BufferResourceDescription ActiveLightClustersResource =
+		{
+			.Size = GActiveLightClusterListHeaderSize
+		};
+		Scheme.AddResource("ActiveLightClusters", ActiveLightClustersResource, false);
 
-		BufferResourceDescription LightIndexListResource = {};
-		LightIndexListResource.Size = 64 * 1024 * 1024; // FIXME: see above
-		Scheme.AddResource("LightIndexList", LightIndexListResource, false);
+		// NOTE: grows together with the point light buffers
+		BufferResourceDescription ViewSpacePointLightsResource =
+		{
+			.Size = LightPreparationPass::GetViewSpacePointLightListSize(InitialPointLightCapacity)
+		};
+		Scheme.AddResource("ViewSpacePointLights", ViewSpacePointLightsResource, false);
+
+		BufferResourceDescription MeshletDrawCommandsResource =
+		{
+			.Size = MeshletCullingPass::DrawCommandBufferSize
+		};
+		Scheme.AddResource("MeshletDrawCommands", MeshletDrawCommandsResource, false);
+
+		BufferResourceDescription MeshletDrawCountsResource =
+		{
+			.Size = MeshletCullingPass::DrawCountBufferSize
+		};
+		Scheme.AddResource("MeshletDrawCounts", MeshletDrawCountsResource, false);
 
 		BufferResourceDescription SceneDataResource =
 		{
@@ -55,18 +95,45 @@ namespace Hermes
 		};
 		Scheme.AddResource("SceneData", SceneDataResource, true);
 
-		Scheme.AddLink("$.LightClusterList", "LightCullingPass.LightClusterList");
-		Scheme.AddLink("$.LightIndexList", "LightCullingPass.LightIndexList");
-		Scheme.AddLink("$.SceneData", "LightCullingPass.SceneData");
+		BufferResourceDescription PointLightsResource =
+		{
+			.Size = InitialPointLightCapacity * sizeof(PointLight)
+		};
+		Scheme.AddResource("PointLights", PointLightsResource, true);
+
+		Scheme.AddLink("$.MeshletDrawCommands", "MeshletCullingPass.DrawCommands");
+		Scheme.AddLink("$.MeshletDrawCounts", "MeshletCullingPass.DrawCounts");
+		Scheme.AddLink("$.SceneData", "MeshletCullingPass.SceneData");
 
 		Scheme.AddLink("$.DepthBuffer", "DepthPass.Depth");
+		Scheme.AddLink("MeshletCullingPass.DrawCommands", "DepthPass.DrawCommands");
+		Scheme.AddLink("MeshletCullingPass.DrawCounts", "DepthPass.DrawCounts");
 		Scheme.AddLink("$.SceneData", "DepthPass.SceneData");
 
+		// NOTE: only reads external resources, so it runs on the async compute queue when the device has one
+		Scheme.AddLink("$.SceneData", "LightPreparationPass.SceneData");
+		Scheme.AddLink("$.PointLights", "LightPreparationPass.PointLights");
+		Scheme.AddLink("$.ViewSpacePointLights", "LightPreparationPass.ViewSpacePointLights");
+
+		// NOTE: only the clusters that contain at least one pixel of the depth prepass are assigned lights
+		Scheme.AddLink("DepthPass.Depth", "LightCullingPass.Depth");
+		Scheme.AddLink("$.LightClusterMasks", "LightCullingPass.LightClusterMasks");
+		Scheme.AddLink("$.ActiveLightClusters", "LightCullingPass.ActiveLightClusters");
+		Scheme.AddLink("$.SceneData", "LightCullingPass.SceneData");
+		Scheme.AddLink("LightPreparationPass.ViewSpacePointLights", "LightCullingPass.ViewSpacePointLights");
+
+		Scheme.AddLink("LightCullingPass.Depth", "MeshletOcclusionCullingPass.Depth");
+		Scheme.AddLink("DepthPass.DrawCommands", "MeshletOcclusionCullingPass.DrawCommands");
+		Scheme.AddLink("DepthPass.DrawCounts", "MeshletOcclusionCullingPass.DrawCounts");
+		Scheme.AddLink("$.SceneData", "MeshletOcclusionCullingPass.SceneData");
+
 		Scheme.AddLink("$.HDRColorBuffer", "ForwardPass.Color");
-		Scheme.AddLink("DepthPass.Depth", "ForwardPass.Depth");
-		Scheme.AddLink("LightCullingPass.LightClusterList", "ForwardPass.LightClusterList");
-		Scheme.AddLink("LightCullingPass.LightIndexList", "ForwardPass.LightIndexList");
+		Scheme.AddLink("MeshletOcclusionCullingPass.Depth", "ForwardPass.Depth");
+		Scheme.AddLink("MeshletOcclusionCullingPass.DrawCommands", "ForwardPass.DrawCommands");
+		Scheme.AddLink("MeshletOcclusionCullingPass.DrawCounts", "ForwardPass.DrawCounts");
+		Scheme.AddLink("LightCullingPass.LightClusterMasks", "ForwardPass.LightClusterMasks");
 		Scheme.AddLink("$.SceneData", "ForwardPass.SceneData");
+		Scheme.AddLink("$.PointLights", "ForwardPass.PointLights");
 
 		Scheme.AddLink("ForwardPass.Color", "SkyboxPass.ColorBuffer");
 		Scheme.AddLink("ForwardPass.Depth", "SkyboxPass.DepthBuffer");
@@ -79,15 +146,24 @@ namespace Hermes
 		FrameGraph = Scheme.Compile();
 		HERMES_ASSERT_LOG(FrameGraph, "Failed to compile a frame graph");
 
-		SceneDataBuffer = Renderer::GetDevice().CreateBuffer(sizeof(SceneData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
-		FrameGraph->BindExternalResource("SceneData", *SceneDataBuffer);
+		// Depth and forward passes draw materials into these
+		Material::AddPrecompiledAttachmentFormats(HDRColorBufferResource.Format, DepthBufferResource.Format);
+
+		for (uint32 FrameIndex = 0; FrameIndex < Renderer::GetFramesInFlightCount(); FrameIndex++)
+		{
+			SceneDataBuffers.push_back(Renderer::GetDevice().CreateBuffer(sizeof(SceneData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true));
+			PointLightBuffers.push_back(Renderer::GetDevice().CreateBuffer(InitialPointLightCapacity * sizeof(PointLight), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true));
+		}
 	}
 
 	std::pair<const Vulkan::Image*, VkImageLayout> SceneRenderer::Render(const Scene& Scene, Vec2ui ViewportDimensions) const
 	{
 		HERMES_PROFILE_FUNC();
 
-		UpdateSceneDataBuffer(Scene, ViewportDimensions);
+		auto& SceneDataBuffer = *SceneDataBuffers[Renderer::GetCurrentFrameIndex()];
+		UpdateSceneDataBuffer(SceneDataBuffer, Scene, ViewportDimensions);
+		FrameGraph->BindExternalResource("SceneData", SceneDataBuffer);
+		FrameGraph->BindExternalResource("PointLights", *PointLightBuffers[Renderer::GetCurrentFrameIndex()]);
 
 		auto GeometryList = Scene.BakeGeometryList(Vec2(ViewportDimensions));
 		FrameGraph->Execute(Scene, GeometryList, ViewportDimensions);
@@ -95,13 +171,13 @@ namespace Hermes
 		return FrameGraph->GetFinalImage();
 	}
 
-	void SceneRenderer::UpdateSceneDataBuffer(const Scene& Scene, Vec2ui ViewportDimensions) const
+	void SceneRenderer::UpdateSceneDataBuffer(Vulkan::Buffer& SceneDataBuffer, const Scene& Scene, Vec2ui ViewportDimensions) const
 	{
 		HERMES_PROFILE_FUNC();
 
 		auto& Camera = Scene.GetActiveCamera();
 
-		auto* SceneDataForCurrentFrame = static_cast<SceneData*>(SceneDataBuffer->Map());
+		auto* SceneDataForCurrentFrame = static_cast<SceneData*>(SceneDataBuffer.GetMappedData());
 
 		auto ViewMatrix = Camera.GetViewMatrix();
 		auto ProjectionMatrix = Camera.GetProjectionMatrix(Vec2(ViewportDimensions));
@@ -114,56 +190,102 @@ namespace Hermes
 		SceneDataForCurrentFrame->ScreenDimensions = Vec2(ViewportDimensions);
 		SceneDataForCurrentFrame->MaxPixelsPerLightCluster = static_cast<Vec2>(LightCullingPass->ClusterSizeInPixels);
 		SceneDataForCurrentFrame->CameraZBounds = { Camera.GetNearZPlane(), Camera.GetFarZPlane() };
-		SceneDataForCurrentFrame->NumberOfZClusters.X = LightCullingPass->NumberOfZSlices;
+		SceneDataForCurrentFrame->NumberOfXYClusters = LightCullingPass::GetNumberOfXYClusters(ViewportDimensions);
+		SceneDataForCurrentFrame->NumberOfZClusters = LightCullingPass::NumberOfZSlices;
+		SceneDataForCurrentFrame->ClusterZScaleAndBias = LightClustering::ComputeClusterZScaleAndBias(Camera.GetNearZPlane(), Camera.GetFarZPlane(),
+		                                                                                             LightCullingPass::NumberOfZSlices);
 
-		size_t NextPointLightIndex = 0, NextDirectionalLightIndex = 0;
-		std::function<void(const SceneNode&)> TraverseSceneHierarchy = [&](const SceneNode& Node) -> void
-		{
-			for (size_t ChildIndex = 0; ChildIndex < Node.GetChildrenCount(); ChildIndex++)
-				TraverseSceneHierarchy(Node.GetChild(ChildIndex));
+		auto Frustum = Camera.GetFrustum(Vec2(ViewportDimensions));
 
-			if (Node.GetType() == SceneNodeType::PointLight)
-			{
-				if (NextPointLightIndex > SceneData::MaxPointLightCount)
-					return;
+		auto& PointLightBuffer = PointLightBuffers[Renderer::GetCurrentFrameIndex()];
+		auto* PointLights = static_cast<PointLight*>(PointLightBuffer->GetMappedData());
+		size_t PointLightCapacity = PointLightBuffer->GetSize() / sizeof(PointLight);
 
-				const auto& PointLight = static_cast<const PointLightNode&>(Node);
-				auto WorldTransform = PointLight.GetWorldTransformationMatrix();
-				Vec4 WorldPosition = { WorldTransform[0][3], WorldTransform[1][3], WorldTransform[2][3], 1.0f };
+		uint32 PointLightCount = 0, DirectionalLightCount = 0;
+		bool HasTooManyDirectionalLights = false;
 
-				SceneDataForCurrentFrame->PointLights[NextPointLightIndex].Position = WorldPosition;
-				SceneDataForCurrentFrame->PointLights[NextPointLightIndex].Color = Vec4(PointLight.GetColor(), PointLight.GetIntensity());
+		// NOTE: world transforms are propagated from parents to children during the traversal instead of calling
+		//       GetWorldTransformationMatrix() on every light, which would walk up the hierarchy each time
+		struct NodeToVisit
+		{
+			const SceneNode* Node;
+			Mat4 ParentTransform;
+		};
+		std::vector<NodeToVisit> NodesToVisit = { { &Scene.GetRootNode(), Mat4::Identity() } };
+		while (!NodesToVisit.empty())
+		{
+			auto [Node, ParentTransform] = NodesToVisit.back();
+			NodesToVisit.pop_back();
 
-				NextPointLightIndex++;
-			}
+			auto WorldTransform = ParentTransform * Node->GetLocalTransformationMatrix();
+			for (size_t ChildIndex = 0; ChildIndex < Node->GetChildrenCount(); ChildIndex++)
+				NodesToVisit.push_back({ &Node->GetChild(ChildIndex), WorldTransform });
 
-			if (Node.GetType() == SceneNodeType::DirectionalLight)
+			if (Node->GetType() == SceneNodeType::PointLight)
 			{
-				if (NextDirectionalLightIndex > SceneData::MaxDirectionalLightCount)
-					return;
-
-				const auto& DirectionalLight = static_cast<const DirectionalLightNode&>(Node);
+				const auto& Light = static_cast<const PointLightNode&>(*Node);
+
+				float Radius = LightClustering::ComputeLightRadius(Light.GetColor(), Light.GetIntensity());
+				SphereBoundingVolume LightVolume(Radius);
+				if (!Frustum.IsInside(LightVolume, WorldTransform))
+					continue;
+
+				if (PointLightCount == PointLightCapacity)
+				{
+					// The buffer of the current frame is no longer used by the GPU, so it can be replaced right away
+					PointLightCapacity *= 2;
+					auto NewBuffer = Renderer::GetDevice().CreateBuffer(PointLightCapacity * sizeof(PointLight), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, true);
+					memcpy(NewBuffer->GetMappedData(), PointLights, PointLightCount * sizeof(PointLight));
+
+					PointLightBuffer = std::move(NewBuffer);
+					PointLights = static_cast<PointLight*>(PointLightBuffer->GetMappedData());
+				}
+
+				PointLights[PointLightCount].Position = { WorldTransform[0][3], WorldTransform[1][3], WorldTransform[2][3], Radius };
+				PointLights[PointLightCount].Color = Vec4(Light.GetColor(), Light.GetIntensity());
+				PointLightCount++;
+			}
 
-				auto WorldTransform = Node.GetWorldTransformationMatrix();
-				auto WorldDirection = WorldTransform * Vec4(DirectionalLight.GetDirection(), 0.0f);
+			if (Node->GetType() == SceneNodeType::DirectionalLight)
+			{
+				if (DirectionalLightCount == SceneData::MaxDirectionalLightCount)
+				{
+					HasTooManyDirectionalLights = true;
+					continue;
+				}
+
+				const auto& Light = static_cast<const DirectionalLightNode&>(*Node);
+				auto WorldDirection = WorldTransform * Vec4(Light.GetDirection(), 0.0f);
+
+				SceneDataForCurrentFrame->DirectionalLights[DirectionalLightCount].Direction = WorldDirection;
+				SceneDataForCurrentFrame->DirectionalLights[DirectionalLightCount].Color = Vec4(Light.GetColor(), Light.GetIntensity());
+				DirectionalLightCount++;
+			}
+		}
 
-				SceneDataForCurrentFrame->DirectionalLights[NextDirectionalLightIndex].Direction = WorldDirection;
-				SceneDataForCurrentFrame->DirectionalLights[NextDirectionalLightIndex].Color = Vec4(DirectionalLight.GetColor(), DirectionalLight.GetIntensity());
+		if (HasTooManyDirectionalLights)
+			HERMES_LOG_WARNING("There are more directional lights in the scene than the shader can process, some of them will be ignored");
 
-				NextDirectionalLightIndex++;
-			}
-		};
+		SceneDataForCurrentFrame->PointLightCount = PointLightCount;
+		SceneDataForCurrentFrame->DirectionalLightCount = DirectionalLightCount;
+		SceneDataForCurrentFrame->LightMaskWordsPerCluster = LightCullingPass::GetLightMaskWordsPerCluster(PointLightCount);
 
-		TraverseSceneHierarchy(Scene.GetRootNode());
+		// NOTE: resizing waits for the GPU, so the buffer grows to the next power of two and only shrinks when most of it
+		//       is unused to avoid doing it every time the number of visible lights changes a bit
+		auto RequiredMasksSize = static_cast<uint32>(std::max(LightCullingPass::GetLightClusterMasksSize(ViewportDimensions, PointLightCount), sizeof(uint32)));
+		auto CurrentMasksSize = FrameGraph->GetBufferResourceSize("LightClusterMasks");
+		if (RequiredMasksSize > CurrentMasksSize || RequiredMasksSize < CurrentMasksSize / 4)
+			FrameGraph->ResizeBufferResource("LightClusterMasks", std::bit_ceil(RequiredMasksSize));
 
-		if (NextPointLightIndex >= SceneData::MaxPointLightCount)
-			HERMES_LOG_WARNING("There are more point lights in the scene than the shader can process, some of them will be ignored");
-		if (NextDirectionalLightIndex >= SceneData::MaxDirectionalLightCount)
-			HERMES_LOG_WARNING("There are more directional lights in the scene than the shader can process, some of them will be ignored");
+		auto RequiredViewSpaceLightListSize = static_cast<uint32>(LightPreparationPass::GetViewSpacePointLightListSize(static_cast<uint32>(PointLightCapacity)));
+		if (RequiredViewSpaceLightListSize > FrameGraph->GetBufferResourceSize("ViewSpacePointLights"))
+			FrameGraph->ResizeBufferResource("ViewSpacePointLights", RequiredViewSpaceLightListSize);
 
-		SceneDataForCurrentFrame->PointLightCount = static_cast<uint32>(NextPointLightIndex);
-		SceneDataForCurrentFrame->DirectionalLightCount = static_cast<uint32>(NextDirectionalLightIndex);
+		auto RequiredActiveClusterListSize = static_cast<uint32>(LightCullingPass::GetActiveLightClusterListSize(ViewportDimensions));
+		if (RequiredActiveClusterListSize != FrameGraph->GetBufferResourceSize("ActiveLightClusters"))
+			FrameGraph->ResizeBufferResource("ActiveLightClusters", RequiredActiveClusterListSize);
 
-		SceneDataBuffer->Unmap();
+		PointLightBuffer->Flush(0, PointLightCount * sizeof(PointLight));
+		SceneDataBuffer.Flush(0, sizeof(SceneData));
 	}
 }
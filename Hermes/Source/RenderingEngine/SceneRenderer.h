@@ -1,10 +1,15 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "Core/Core.h"
 #include "RenderingEngine/FrameGraph/Graph.h"
 #include "RenderingEngine/Passes/DepthPass.h"
 #include "RenderingEngine/Passes/ForwardPass.h"
 #include "RenderingEngine/Passes/LightCullingPass.h"
+#include "RenderingEngine/Passes/LightPreparationPass.h"
+#include "RenderingEngine/Passes/MeshletCullingPass.h"
 #include "RenderingEngine/Passes/PostProcessingPass.h"
 #include "RenderingEngine/Passes/SkyboxPass.h"
 #include "Vulkan/Buffer.h"
@@ -19,15 +24,26 @@ namespace Hermes
 		std::pair<const Vulkan::Image*, VkImageLayout> Render(const Scene& Scene, Vec2ui ViewportDimensions) const;
 
 	private:
-		std::unique_ptr<Vulkan::Buffer> SceneDataBuffer;
+		// NOTE: the scene data is written by the CPU every frame, so each frame in flight needs its own buffer
+		std::vector<std::unique_ptr<Vulkan::Buffer>> SceneDataBuffers;
+
+		/*
+		 * Dense arrays of the point lights that are visible in the frame, a buffer is replaced with one twice as large
+		 * when the lights do not fit into it
+		 */
+		static constexpr size_t InitialPointLightCapacity = 1024;
+		mutable std::vector<std::unique_ptr<Vulkan::Buffer>> PointLightBuffers;
 
 		std::unique_ptr<FrameGraph> FrameGraph;
+		std::unique_ptr<LightPreparationPass> LightPreparationPass;
 		std::unique_ptr<LightCullingPass> LightCullingPass;
+		std::unique_ptr<MeshletCullingPass> MeshletCullingPass;
+		std::unique_ptr<class MeshletCullingPass> MeshletOcclusionCullingPass;
 		std::unique_ptr<DepthPass> DepthPass;
 		std::unique_ptr<ForwardPass> ForwardPass;
 		std::unique_ptr<PostProcessingPass> PostProcessingPass;
 		std::unique_ptr<SkyboxPass> SkyboxPass;
 
-		void UpdateSceneDataBuffer(const Scene& Scene, Vec2ui ViewportDimensions) const;
+		void UpdateSceneDataBuffer(Vulkan::Buffer& SceneDataBuffer, const Scene& Scene, Vec2ui ViewportDimensions) const;
 	};
 }
@@ -24,6 +24,7 @@
 #else
 
 #define uint32 uint
+#define int32 int
 #define Vec2 vec2
 #define Vec2ui uvec2
 #define Vec3 vec3
@@ -41,7 +42,7 @@ namespace Hermes
 
 	struct ALIGNAS_16 PointLight
 	{
-		/* Only first 3 components are meaningful, 4th is added for alignment purposes */
+		/* XYZ = position in world space, W = radius outside of which the light is ignored */
 		Vec4 Position;
 		Vec4 Color;
 	};
@@ -55,17 +56,78 @@ namespace Hermes
 	struct ALIGNAS_16 GlobalDrawcallData
 	{
 		Mat4 ModelMatrix;
+
+		/* Vertex position is reconstructed as PositionOffset + PositionScale * Position; identity for meshes with full precision vertices */
+		Vec4 PositionOffset;
+		Vec4 PositionScale;
+		uint32 AreVerticesCompressed; // Non-zero if normals and tangents are octahedral-encoded, see CompressedVertex in AssetHeaders.h
+		uint32 MaterialIndex; // Index of the material instance's data in the material data buffer, see MaterialResourceTable
 	};
 
-	struct ALIGNAS_16 SceneData
+	/*
+	 * Material data lives in descriptor set 1, which is the same for all materials: binding 0 is a storage buffer with the
+	 * numeric properties and texture indices of every material instance and binding 1 is an array of all textures
+	 */
+#define MATERIAL_DATA_DESCRIPTOR_SET 1
+#define MATERIAL_DATA_BUFFER_BINDING 0
+#define BINDLESS_TEXTURES_BINDING 1
+#define MAX_BINDLESS_TEXTURE_COUNT 4096
+#ifndef _GLSL_
+	static constexpr uint32 GMaterialDataDescriptorSet = MATERIAL_DATA_DESCRIPTOR_SET;
+	static constexpr uint32 GMaterialDataBufferBinding = MATERIAL_DATA_BUFFER_BINDING;
+	static constexpr uint32 GBindlessTexturesBinding = BINDLESS_TEXTURES_BINDING;
+	static constexpr uint32 GMaxBindlessTextureCount = MAX_BINDLESS_TEXTURE_COUNT;
+#endif
+
+	/*
+	 * GPU representation of MeshletHeader from AssetHeaders.h
+	 */
+	struct ALIGNAS_16 Meshlet
+	{
+		Vec4 BoundingSphere; // XYZ = center in model space, W = radius
+		Vec4 Cone; // XYZ = cone axis in model space, W = cone cutoff
+
+		uint32 IndexOffset;
+		uint32 IndexCount;
+		uint32 PrimitiveIndex;
+		uint32 FirstMeshletOfPrimitive;
+	};
+
+	struct ALIGNAS_16 MeshletCullingDrawcallData
+	{
+		Mat4 ModelMatrix;
+
+		uint32 MeshletCount;
+		uint32 FirstDrawCommand; // Index of the first draw command of the mesh in the draw command buffer
+		uint32 FirstDrawCount; // Index of the draw count of the first primitive of the mesh in the draw count buffer
+		uint32 IsOcclusionCullingEnabled;
+
+		Vec2ui DepthPyramidDimensions;
+		uint32 DepthPyramidMipLevelCount;
+		float MaxModelScale; // Largest scale factor of the model matrix, used to transform the radii of the bounding spheres
+
+		/* Location of the mesh in the mesh arena, added to the index ranges of the meshlets */
+		uint32 FirstIndex;
+		int32 VertexOffset;
+	};
+
+	struct ALIGNAS_16 DepthPyramidReductionData
 	{
-#define MAX_POINT_LIGHT_COUNT 1024
+		Vec2ui SourceDimensions;
+		Vec2ui DestinationDimensions;
+	};
+
+	/*
+	 * Point lights are not stored in SceneData: the ones that intersect the view frustum are written densely into a
+	 * separate storage buffer, so their number is only limited by the size of that buffer
+	 */
+#define POINT_LIGHT_INTENSITY_TOLERANCE 0.01
 #ifndef _GLSL_
-		static constexpr uint32 MaxPointLightCount = MAX_POINT_LIGHT_COUNT;
-#else
-#define MaxPointLightCount MAX_POINT_LIGHT_COUNT
+	static constexpr float GPointLightIntensityTolerance = static_cast<float>(POINT_LIGHT_INTENSITY_TOLERANCE);
 #endif
 
+	struct ALIGNAS_16 SceneData
+	{
 #define MAX_DIRECTIONAL_LIGHT_COUNT 4
 #ifndef _GLSL_
 		static constexpr uint32 MaxDirectionalLightCount = MAX_DIRECTIONAL_LIGHT_COUNT;
@@ -73,8 +135,6 @@ namespace Hermes
 #define MaxDirectionalLightCount MAX_DIRECTIONAL_LIGHT_COUNT
 #endif
 
-#define MAX_POINT_LIGHTS_IN_CLUSTER 1024
-
 		Mat4 ViewProjection;
 		Mat4 View;
 		Mat4 InverseProjection;
@@ -84,14 +144,30 @@ namespace Hermes
 		Vec2 ScreenDimensions;
 		Vec2 MaxPixelsPerLightCluster;
 		Vec2 CameraZBounds; // X = NearZ, Y = FarZ
-		Vec2ui NumberOfZClusters; // Only X component is meaningful, Y is added for alignment purposes
 
-		PointLight PointLights[MaxPointLightCount];
+		/*
+		 * Every light cluster stores a bitmask of the point lights that intersect it, bit N of word W corresponds
+		 * to the light with index W * 32 + N. The clusters are laid out as X + Y * NumberOfXYClusters.X + Z * XYClusterCount
+		 */
+		Vec2ui NumberOfXYClusters;
+		uint32 NumberOfZClusters;
+		uint32 LightMaskWordsPerCluster;
+		Vec2 ClusterZScaleAndBias; // Z slice of a view space depth D is floor(log(D) * X + Y), see LightClustering
+
 		DirectionalLight DirectionalLights[MaxDirectionalLightCount];
-		uint32 PointLightCount;
+		uint32 PointLightCount; // Number of valid elements in the point light buffer
 		uint32 DirectionalLightCount;
 	};
 
+	/*
+	 * The list of the light clusters that contain at least one pixel starts with the VkDispatchIndirectCommand of the light
+	 * culling dispatch padded to 16 bytes, followed by the indices of the clusters
+	 */
+#define ACTIVE_LIGHT_CLUSTER_LIST_HEADER_SIZE 16
+#ifndef _GLSL_
+	static constexpr uint32 GActiveLightClusterListHeaderSize = ACTIVE_LIGHT_CLUSTER_LIST_HEADER_SIZE;
+#endif
+
 #define MAX_RECTANGLE_TEXTURE_COUNT 64
 #ifndef _GLSL_
 	static constexpr uint32 GMaxRectangleTextureCount = MAX_RECTANGLE_TEXTURE_COUNT;
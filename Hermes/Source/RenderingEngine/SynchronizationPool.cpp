@@ -0,0 +1,64 @@
+#include "SynchronizationPool.h"
+
+#include "RenderingEngine/Renderer.h"
+#include "Vulkan/Device.h"
+#include "Vulkan/Semaphore.h"
+
+namespace Hermes
+{
+	void PooledFenceDeleter::operator()(Vulkan::Fence* Fence) const
+	{
+		HERMES_ASSERT(Pool);
+		Pool->ReleaseFence(Fence);
+	}
+
+	SynchronizationPool::SynchronizationPool(uint32 InFramesInFlightCount)
+		: PerFrameSemaphores(InFramesInFlightCount)
+	{
+	}
+
+	SynchronizationPool::~SynchronizationPool() = default;
+
+	PooledFence SynchronizationPool::AcquireFence()
+	{
+		{
+			std::scoped_lock Lock(FenceMutex);
+			if (!FreeFences.empty())
+			{
+				auto* Fence = FreeFences.back().release();
+				FreeFences.pop_back();
+				return PooledFence(Fence, PooledFenceDeleter{ this });
+			}
+		}
+
+		return PooledFence(Renderer::GetDevice().CreateFence().release(), PooledFenceDeleter{ this });
+	}
+
+	void SynchronizationPool::BeginFrame(uint32 FrameIndex)
+	{
+		HERMES_ASSERT(FrameIndex < PerFrameSemaphores.size());
+
+		// NOTE: every semaphore of the frame was waited on by another submission of the same frame, so all of them are
+		//       unsignaled now. Dependencies between frames have to use the frame counter semaphore of the renderer instead
+		CurrentFrameIndex = FrameIndex;
+		PerFrameSemaphores[FrameIndex].UsedCount = 0;
+	}
+
+	const Vulkan::Semaphore& SynchronizationPool::AcquireFrameSemaphore()
+	{
+		auto& Frame = PerFrameSemaphores[CurrentFrameIndex];
+		if (Frame.UsedCount == Frame.Semaphores.size())
+			Frame.Semaphores.push_back(Renderer::GetDevice().CreateBinarySemaphore());
+
+		return *Frame.Semaphores[Frame.UsedCount++];
+	}
+
+	void SynchronizationPool::ReleaseFence(Vulkan::Fence* Fence)
+	{
+		std::unique_ptr<Vulkan::Fence> OwnedFence(Fence);
+		OwnedFence->Reset();
+
+		std::scoped_lock Lock(FenceMutex);
+		FreeFences.push_back(std::move(OwnedFence));
+	}
+}
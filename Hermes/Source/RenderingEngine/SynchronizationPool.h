@@ -0,0 +1,83 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Core/Core.h"
+#include "Core/Misc/NonCopyableMovable.h"
+#include "Vulkan/Fence.h"
+#include "Vulkan/Forward.h"
+
+namespace Hermes
+{
+	class SynchronizationPool;
+
+	/*
+	 * Returns the fence to the pool it was acquired from instead of destroying it
+	 */
+	struct PooledFenceDeleter
+	{
+		SynchronizationPool* Pool = nullptr;
+
+		void operator()(Vulkan::Fence* Fence) const;
+	};
+
+	/*
+	 * A fence from SynchronizationPool, it must not be pending on the GPU when it goes out of scope
+	 */
+	using PooledFence = std::unique_ptr<Vulkan::Fence, PooledFenceDeleter>;
+
+	/*
+	 * Recycles the fences and binary semaphores that are needed for every submission instead of creating and
+	 * destroying them every time
+	 *
+	 * Fences are returned to the pool as soon as their owner is done with them (the owner has waited for them).
+	 * Binary semaphores of a frame are only valid until the GPU has finished that frame and are all returned at once
+	 * in BeginFrame(), the same way the command buffers of the frame are.
+	 */
+	class HERMES_API SynchronizationPool
+	{
+		MAKE_NON_COPYABLE(SynchronizationPool)
+		MAKE_NON_MOVABLE(SynchronizationPool)
+
+	public:
+		explicit SynchronizationPool(uint32 InFramesInFlightCount);
+
+		~SynchronizationPool();
+
+		/*
+		 * Returns an unsignaled fence, can be called from any thread
+		 */
+		PooledFence AcquireFence();
+
+		/*
+		 * Must be called when the GPU has finished the frame that previously used the given frame index
+		 */
+		void BeginFrame(uint32 FrameIndex);
+
+		/*
+		 * Returns an unsignaled binary semaphore that can be used by the submissions of the current frame, must only be
+		 * called from the render thread. Every signal of the semaphore must be waited on by a submission of the same frame
+		 */
+		const Vulkan::Semaphore& AcquireFrameSemaphore();
+
+	private:
+		std::mutex FenceMutex;
+		std::vector<std::unique_ptr<Vulkan::Fence>> FreeFences;
+
+		struct FrameSemaphores
+		{
+			// The first UsedCount of them were handed out while the frame was recorded
+			std::vector<std::unique_ptr<Vulkan::Semaphore>> Semaphores;
+			size_t UsedCount = 0;
+		};
+		std::vector<FrameSemaphores> PerFrameSemaphores;
+
+		uint32 CurrentFrameIndex = 0;
+
+		void ReleaseFence(Vulkan::Fence* Fence);
+
+		friend struct PooledFenceDeleter;
+	};
+}
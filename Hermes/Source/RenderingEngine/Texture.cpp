@@ -473,7 +473,7 @@ namespace Hermes
 		PipelineDescription.IsDepthWriteEnabled = false;
 		auto Pipeline = Device.CreatePipeline(*RenderPass, PipelineDescription);
 
-		auto RenderingFinishFence = Device.CreateFence();
+		auto RenderingFinishFence = Renderer::GetSynchronizationPool().AcquireFence();
 
 		constexpr Vulkan::CubemapSide Sides[6] =
 		{
@@ -4,13 +4,11 @@
 #include "Core/UTF8/UTF8Iterator.h"
 #include "RenderingEngine/DescriptorAllocator.h"
 #include "RenderingEngine/FontPack.h"
-#include "RenderingEngine/GPUInteractionUtilities.h"
 #include "RenderingEngine/Renderer.h"
 #include "RenderingEngine/SharedData.h"
 #include "UIEngine/TextLayout.h"
 #include "Vulkan/CommandBuffer.h"
 #include "Vulkan/Device.h"
-#include "Vulkan/Fence.h"
 #include "Vulkan/Queue.h"
 
 namespace Hermes
@@ -39,7 +37,7 @@ namespace Hermes
 		 */
 		VkDescriptorSetLayoutBinding RectangleListBinding = {
 			.binding = RectanglePrimitivesDescriptorBinding,
-			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
 			.descriptorCount = 1,
 			.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
 			.pImmutableSamplers = nullptr
@@ -52,7 +50,9 @@ namespace Hermes
 			.pImmutableSamplers = nullptr
 		};
 		auto RectangleDescriptorSetLayout = Device.CreateDescriptorSetLayout({ RectangleListBinding, RectangleTexturesBinding });
-		RectangleDescriptorSet = Renderer::GetDescriptorAllocator().Allocate(*RectangleDescriptorSetLayout);
+		PerFrameData.resize(Renderer::GetFramesInFlightCount());
+		for (auto& Frame : PerFrameData)
+			Frame.RectangleDescriptorSet = Renderer::GetDescriptorAllocator().Allocate(*RectangleDescriptorSetLayout);
 
 
 		/*
@@ -135,9 +135,12 @@ namespace Hermes
 		};
 		RectangleTextureSampler = Device.CreateSampler(RectangleTextureSamplerDesc);
 		EmptyTexture = Texture2D::Create("UI_RENDERER_EMPTY_TEXTURE", { 1 }, ImageFormat::RGBA, 1, Vec4(0.0f));
-		for (uint32 DescriptorIndex = 0; DescriptorIndex < GMaxRectangleTextureCount; DescriptorIndex++)
+		for (auto& Frame : PerFrameData)
 		{
-			RectangleDescriptorSet->UpdateWithImageAndSampler(RectangleTexturesDescriptorBinding, DescriptorIndex, EmptyTexture->GetView(ColorSpace::Linear), *RectangleTextureSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			for (uint32 DescriptorIndex = 0; DescriptorIndex < GMaxRectangleTextureCount; DescriptorIndex++)
+			{
+				Frame.RectangleDescriptorSet->UpdateWithImageAndSampler(RectangleTexturesDescriptorBinding, DescriptorIndex, EmptyTexture->GetView(ColorSpace::Linear), *RectangleTextureSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			}
 		}
 		
 
@@ -152,7 +155,8 @@ namespace Hermes
 			.pImmutableSamplers = nullptr
 		};
 		auto TextDescriptorSetLayout = Device.CreateDescriptorSetLayout({ GlyphTextureBinding });
-		TextDescriptorSet = Renderer::GetDescriptorAllocator().Allocate(*TextDescriptorSetLayout);
+		for (auto& Frame : PerFrameData)
+			Frame.TextDescriptorSet = Renderer::GetDescriptorAllocator().Allocate(*TextDescriptorSetLayout);
 
 		VkVertexInputBindingDescription TextVertexInputBindingDescription = {
 			.binding = 0,
@@ -255,9 +259,10 @@ namespace Hermes
 		/*
 		 * Allocating command buffer
 		 */
+		auto& Frame = PerFrameData[Renderer::GetCurrentFrameIndex()];
 		auto& GraphicsQueue = Renderer::GetDevice().GetQueue(VK_QUEUE_GRAPHICS_BIT);
-		auto CommandBuffer = GraphicsQueue.CreateCommandBuffer();
-		CommandBuffer->BeginRecording();
+		auto& CommandBuffer = Renderer::GetCommandBufferAllocator().Allocate(GraphicsQueue);
+		CommandBuffer.BeginRecording();
 
 
 		/*
@@ -290,18 +295,18 @@ namespace Hermes
 			.image = RenderedScene.GetImage(),
 			.subresourceRange = RenderedScene.GetFullSubresourceRange()
 		};
-		CommandBuffer->InsertImageMemoryBarriers(BeforeBlitBarriers, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+		CommandBuffer.InsertImageMemoryBarriers(BeforeBlitBarriers, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
 		VkClearColorValue ClearColor = { .float32 = { 0.0f, 0.0f, 0.0f, 1.0f } };
 		VkImageSubresourceRange ClearRange = DestinationImage->GetFullSubresourceRange();
-		CommandBuffer->ClearColorImage(*DestinationImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, ClearColor, { &ClearRange, 1 });
+		CommandBuffer.ClearColorImage(*DestinationImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, ClearColor, { &ClearRange, 1 });
 		VkImageBlit Blit = {
 			.srcSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1 },
 			.srcOffsets = { { 0, 0, 0 }, { static_cast<int32>(RenderedScene.GetDimensions().X), static_cast<int32>(RenderedScene.GetDimensions().Y), 1 } },
 			.dstSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1 },
 			.dstOffsets = { { static_cast<int32>(SceneViewport.Min.X), static_cast<int32>(SceneViewport.Min.Y), 0 }, { static_cast<int32>(SceneViewport.Max.X), static_cast<int32>(SceneViewport.Max.Y), 1 } }
 		};
-		CommandBuffer->BlitImage(RenderedScene, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, *DestinationImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, { &Blit, 1 }, VK_FILTER_NEAREST);
+		CommandBuffer.BlitImage(RenderedScene, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, *DestinationImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, { &Blit, 1 }, VK_FILTER_NEAREST);
 
 		VkImageMemoryBarrier AfterBlitBarriers[2];
 		// Scene image back to its original layout
@@ -330,7 +335,7 @@ namespace Hermes
 			.image = DestinationImage->GetImage(),
 			.subresourceRange = DestinationImage->GetFullSubresourceRange()
 		};
-		CommandBuffer->InsertImageMemoryBarriers(AfterBlitBarriers, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		CommandBuffer.InsertImageMemoryBarriers(AfterBlitBarriers, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
 
 
 		/*
@@ -364,7 +369,7 @@ namespace Hermes
 			.offset = { 0, 0 },
 			.extent = { CurrentDimensions.X, CurrentDimensions.Y }
 		};
-		CommandBuffer->BeginRendering(RenderingArea, { &Attachment, 1 }, std::nullopt, std::nullopt);
+		CommandBuffer.BeginRendering(RenderingArea, { &Attachment, 1 }, std::nullopt, std::nullopt);
 
 
 		/*
@@ -372,14 +377,15 @@ namespace Hermes
 		 */
 		if (HasRectanglesToDraw)
 		{
-			CommandBuffer->BindPipeline(*RectanglePipeline);
-			CommandBuffer->SetViewport(Viewport);
-			CommandBuffer->SetScissor(Scissor);
+			CommandBuffer.BindPipeline(*RectanglePipeline);
+			CommandBuffer.SetViewport(Viewport);
+			CommandBuffer.SetScissor(Scissor);
 
-			CommandBuffer->BindDescriptorSet(*RectangleDescriptorSet, *RectanglePipeline, 0);
-			CommandBuffer->BindVertexBuffer(*RectangleMeshBuffer);
+			uint32 RectanglePrimitivesOffset = Frame.RectanglePrimitives.Offset;
+			CommandBuffer.BindDescriptorSet(*Frame.RectangleDescriptorSet, *RectanglePipeline, 0, { &RectanglePrimitivesOffset, 1 });
+			CommandBuffer.BindVertexBuffer(*Frame.RectangleVertices.Buffer, Frame.RectangleVertices.Offset);
 
-			CommandBuffer->Draw(static_cast<uint32>(RectangleMeshBuffer->GetSize() / sizeof(Vec2)), 1, 0, 0);
+			CommandBuffer.Draw(Frame.RectangleVertexCount, 1, 0, 0);
 		}
 
 
@@ -388,35 +394,36 @@ namespace Hermes
 		 */
 		if (HasTextToDraw)
 		{
-			CommandBuffer->BindPipeline(*TextPipeline);
-			CommandBuffer->SetViewport(Viewport);
-			CommandBuffer->SetScissor(Scissor);
+			CommandBuffer.BindPipeline(*TextPipeline);
+			CommandBuffer.SetViewport(Viewport);
+			CommandBuffer.SetScissor(Scissor);
 
-			CommandBuffer->BindDescriptorSet(*TextDescriptorSet, *TextPipeline, 0);
-			CommandBuffer->BindVertexBuffer(*TextMeshBuffer);
+			CommandBuffer.BindDescriptorSet(*Frame.TextDescriptorSet, *TextPipeline, 0);
+			CommandBuffer.BindVertexBuffer(*Frame.TextVertices.Buffer, Frame.TextVertices.Offset);
 
-			CommandBuffer->Draw(static_cast<uint32>(TextMeshBuffer->GetSize() / sizeof(FontVertex2D)), 1, 0, 0);
+			CommandBuffer.Draw(Frame.TextVertexCount, 1, 0, 0);
 		}
 
 		/*
 		 * Finishing command buffer recording
 		 */
-		CommandBuffer->EndRendering();
-		CommandBuffer->EndRecording();
+		CommandBuffer.EndRendering();
+		CommandBuffer.EndRecording();
 
 
 		/*
-		 * Submitting the command buffer and waiting for its fence
+		 * Submitting the command buffer, the renderer waits for it to finish before this frame's resources are reused
 		 */
-		auto Fence = Renderer::GetDevice().CreateFence();
-		GraphicsQueue.SubmitCommandBuffer(*CommandBuffer, Fence.get());
-		Fence->Wait(UINT64_MAX);
+		GraphicsQueue.SubmitCommandBuffer(CommandBuffer, {});
 
 		return std::make_pair(DestinationImage.get(), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
 	}
 
 	void UIRenderer::RecreateDestinationImage()
 	{
+		// The old image might still be used by the frames in flight
+		Renderer::GetDevice().WaitForIdle();
+
 		DestinationImage = Renderer::GetDevice().CreateImage(CurrentDimensions, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, DestinationImageFormat, 1);
 		DestinationImageView = DestinationImage->CreateDefaultImageView();
 	}
@@ -425,7 +432,8 @@ namespace Hermes
 	{
 		HERMES_PROFILE_FUNC();
 
-		RectangleTextures.clear();
+		auto& Frame = PerFrameData[Renderer::GetCurrentFrameIndex()];
+		Frame.RectangleTextures.clear();
 
 		auto RectangleCount = DrawingContext.GetRectangles().size();
 		HERMES_ASSERT(RectangleCount < GMaxRectangleTextureCount);
@@ -460,8 +468,8 @@ namespace Hermes
 			RectanglePrimitives[RectangleIndex].OutlineRadius = Rectangle.OutlineRadius;
 			RectanglePrimitives[RectangleIndex].TextureWeight = Rectangle.TextureWeight;
 
-			RectangleDescriptorSet->UpdateWithImageAndSampler(RectangleTexturesDescriptorBinding, RectangleIndex, Rectangle.Texture->GetView(ColorSpace::SRGB), *RectangleTextureSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-			RectangleTextures.push_back(Rectangle.Texture);
+			Frame.RectangleDescriptorSet->UpdateWithImageAndSampler(RectangleTexturesDescriptorBinding, RectangleIndex, Rectangle.Texture->GetView(ColorSpace::SRGB), *RectangleTextureSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			Frame.RectangleTextures.push_back(Rectangle.Texture);
 
 			RectangleIndex++;
 		}
@@ -469,20 +477,32 @@ namespace Hermes
 		// Update the rest of textures in the rectangle texture array with an empty texture to be compatible with the spec
 		for (; RectangleIndex < GMaxRectangleTextureCount; RectangleIndex++)
 		{
-			RectangleDescriptorSet->UpdateWithImageAndSampler(RectangleTexturesDescriptorBinding, RectangleIndex, EmptyTexture->GetView(ColorSpace::SRGB), *RectangleTextureSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			Frame.RectangleDescriptorSet->UpdateWithImageAndSampler(RectangleTexturesDescriptorBinding, RectangleIndex, EmptyTexture->GetView(ColorSpace::SRGB), *RectangleTextureSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 		}
 
 		// No rectangles to draw so we don't need to update the buffers
 		if (RectanglePrimitives.empty())
+		{
+			// NOTE: the frame allocator might release the buffer before this frame draws rectangles again
+			Frame.RectanglePrimitiveDescriptorBuffer = nullptr;
+			HasRectanglesToDraw = false;
 			return;
+		}
 
-		// TODO: only recreate the buffer if it has to be resized
-		RectangleMeshBuffer = Renderer::GetDevice().CreateBuffer(RectangleVertices.size() * sizeof(RectangleVertices[0]), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-		GPUInteractionUtilities::UploadDataToGPUBuffer(RectangleVertices.data(), RectangleMeshBuffer->GetSize(), 0, *RectangleMeshBuffer);
+		auto& FrameAllocator = Renderer::GetFrameAllocator();
+		Frame.RectangleVertices = FrameAllocator.Upload<Vertex2D>(RectangleVertices);
+		Frame.RectangleVertexCount = static_cast<uint32>(VertexCount);
 
-		RectanglePrimitiveBuffer = Renderer::GetDevice().CreateBuffer(RectanglePrimitives.size() * sizeof(RectanglePrimitives[0]), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
-		GPUInteractionUtilities::UploadDataToGPUBuffer(RectanglePrimitives.data(), RectanglePrimitiveBuffer->GetSize(), 0, *RectanglePrimitiveBuffer);
-		RectangleDescriptorSet->UpdateWithBuffer(RectanglePrimitivesDescriptorBinding, 0, *RectanglePrimitiveBuffer, 0, static_cast<uint32>(RectanglePrimitiveBuffer->GetSize()));
+		// NOTE: the range of a dynamic storage buffer descriptor is fixed, so the allocation always has room for the maximal number of rectangles
+		static constexpr auto RectanglePrimitivesRange = GMaxRectangleTextureCount * sizeof(RectanglePrimitive);
+		Frame.RectanglePrimitives = FrameAllocator.Allocate(RectanglePrimitivesRange, alignof(RectanglePrimitive));
+		memcpy(Frame.RectanglePrimitives.Data, RectanglePrimitives.data(), RectanglePrimitives.size() * sizeof(RectanglePrimitive));
+		Frame.RectanglePrimitives.Flush();
+		if (Frame.RectanglePrimitives.Buffer != Frame.RectanglePrimitiveDescriptorBuffer)
+		{
+			Frame.RectangleDescriptorSet->UpdateWithBuffer(RectanglePrimitivesDescriptorBinding, 0, *Frame.RectanglePrimitives.Buffer, 0, static_cast<uint32>(RectanglePrimitivesRange));
+			Frame.RectanglePrimitiveDescriptorBuffer = Frame.RectanglePrimitives.Buffer;
+		}
 
 		HasRectanglesToDraw = true;
 	}
@@ -510,6 +530,7 @@ namespace Hermes
 		}
 		FontPack.Repack();
 
+		auto& Frame = PerFrameData[Renderer::GetCurrentFrameIndex()];
 		std::vector<FontVertex2D> TextVertices;
 		for (const auto& Text : DrawingContext.GetDrawableTexts())
 		{
@@ -522,7 +543,7 @@ namespace Hermes
 			});
 			
 			FontPack.Repack();
-			TextDescriptorSet->UpdateWithImageAndSampler(0, 0, FontPack.GetImage(), *TextFontSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+			Frame.TextDescriptorSet->UpdateWithImageAndSampler(0, 0, FontPack.GetImage(), *TextFontSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 			auto TextLocation = Vec2(Text.Rect.Min);
 			for (auto [GlyphIndex, GlyphPosition] : GlyphPositions)
@@ -555,8 +576,8 @@ namespace Hermes
 			}
 		}
 
-		TextMeshBuffer = Renderer::GetDevice().CreateBuffer(TextVertices.size() * sizeof(FontVertex2D), VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-		GPUInteractionUtilities::UploadDataToGPUBuffer(TextVertices.data(), TextVertices.size() * sizeof(FontVertex2D), 0, *TextMeshBuffer);
+		Frame.TextVertices = Renderer::GetFrameAllocator().Upload<FontVertex2D>(TextVertices);
+		Frame.TextVertexCount = static_cast<uint32>(TextVertices.size());
 
 		HasTextToDraw = true;
 	}
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "Core/Core.h"
 #include "RenderingEngine/FontPack.h"
+#include "RenderingEngine/FrameAllocator.h"
 #include "UIEngine/Widgets/Widget.h"
 #include "Vulkan/Buffer.h"
+#include "Vulkan/CommandBuffer.h"
 #include "Vulkan/Descriptor.h"
 #include "Vulkan/Image.h"
 #include "Vulkan/Pipeline.h"
@@ -31,18 +36,12 @@ namespace Hermes
 
 		bool HasRectanglesToDraw = false;
 		std::unique_ptr<Vulkan::Pipeline> RectanglePipeline;
-		std::unique_ptr<Vulkan::DescriptorSet> RectangleDescriptorSet;
 		std::unique_ptr<Vulkan::Sampler> RectangleTextureSampler;
-		std::unique_ptr<Vulkan::Buffer> RectangleMeshBuffer;
-		std::unique_ptr<Vulkan::Buffer> RectanglePrimitiveBuffer;
-		std::vector<AssetHandle<Texture2D>> RectangleTextures; // NOTE: this is to ensure that the textures won't be destroyed during rendering
 		AssetHandle<Texture2D> EmptyTexture; // NOTE: this is to bind to unused slots in the texture array descriptor to be fully compatible with the spec
 
 		static constexpr VkFormat TextFontImageFormat = VK_FORMAT_R8_UNORM;
 		bool HasTextToDraw = false;
 		std::unique_ptr<Vulkan::Pipeline> TextPipeline;
-		std::unique_ptr<Vulkan::DescriptorSet> TextDescriptorSet;
-		std::unique_ptr<Vulkan::Buffer> TextMeshBuffer;
 		FontPack FontPack;
 		std::unique_ptr<Vulkan::Sampler> TextFontSampler;
 
@@ -50,6 +49,27 @@ namespace Hermes
 		std::unique_ptr<Vulkan::Image> DestinationImage;
 		std::unique_ptr<Vulkan::ImageView> DestinationImageView;
 
+		/*
+		 * Resources that are rewritten every frame; each frame in flight has its own copy so that the CPU can prepare
+		 * the next frame while the GPU is still drawing the previous ones. The geometry and the rectangle primitives
+		 * live in the renderer's frame allocator
+		 */
+		struct FrameData
+		{
+			std::unique_ptr<Vulkan::DescriptorSet> RectangleDescriptorSet;
+			FrameAllocation RectangleVertices;
+			uint32 RectangleVertexCount = 0;
+			FrameAllocation RectanglePrimitives;
+			// The rectangle primitives are bound with a dynamic offset, the descriptor only changes with the buffer
+			const Vulkan::Buffer* RectanglePrimitiveDescriptorBuffer = nullptr;
+			std::vector<AssetHandle<Texture2D>> RectangleTextures; // NOTE: this is to ensure that the textures won't be destroyed during rendering
+
+			std::unique_ptr<Vulkan::DescriptorSet> TextDescriptorSet;
+			FrameAllocation TextVertices;
+			uint32 TextVertexCount = 0;
+		};
+		std::vector<FrameData> PerFrameData;
+
 		Vec2ui CurrentDimensions = {};
 		Rect2Dui SceneViewport = {};
 
@@ -0,0 +1,83 @@
+#include "GPUStatsOverlay.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "RenderingEngine/Renderer.h"
+#include "UIEngine/TextLayout.h"
+
+namespace Hermes::UI
+{
+	std::shared_ptr<GPUStatsOverlay> GPUStatsOverlay::Create(uint32 InFontSize, AssetHandle<UI::Font> InFont)
+	{
+		return std::shared_ptr<GPUStatsOverlay>(new GPUStatsOverlay(InFontSize, std::move(InFont)));
+	}
+
+	GPUStatsOverlay::GPUStatsOverlay(uint32 InFontSize, AssetHandle<class Font> InFont)
+		: FontSize(InFontSize)
+		, Font(std::move(InFont))
+	{
+		Lines.emplace_back("GPU: waiting for the first frames");
+	}
+
+	void GPUStatsOverlay::OnUpdate(float DeltaTime)
+	{
+		for (const auto& Timing : Renderer::GetGPUProfiler().GetLastFrameTimings())
+		{
+			auto Accumulated = std::ranges::find(AccumulatedMilliseconds, Timing.Name, &std::pair<String, float>::first);
+			if (Accumulated == AccumulatedMilliseconds.end())
+				AccumulatedMilliseconds.emplace_back(Timing.Name, Timing.Milliseconds);
+			else
+				Accumulated->second += Timing.Milliseconds;
+		}
+		AccumulatedFrameCount++;
+
+		TimeSinceRefresh += DeltaTime;
+		if (TimeSinceRefresh < RefreshInterval || AccumulatedMilliseconds.empty())
+			return;
+
+		float TotalMilliseconds = 0.0f;
+		for (const auto& [Name, Milliseconds] : AccumulatedMilliseconds)
+			TotalMilliseconds += Milliseconds / static_cast<float>(AccumulatedFrameCount);
+
+		char Buffer[256];
+		Lines.clear();
+		std::snprintf(Buffer, sizeof(Buffer), "GPU frame: %.2f ms", TotalMilliseconds);
+		Lines.emplace_back(Buffer);
+		for (const auto& [Name, Milliseconds] : AccumulatedMilliseconds)
+		{
+			std::snprintf(Buffer, sizeof(Buffer), "%s: %.2f ms", Name.c_str(), Milliseconds / static_cast<float>(AccumulatedFrameCount));
+			Lines.emplace_back(Buffer);
+		}
+
+		AccumulatedMilliseconds.clear();
+		AccumulatedFrameCount = 0;
+		TimeSinceRefresh = 0.0f;
+	}
+
+	Vec2 GPUStatsOverlay::ComputePreferredSize() const
+	{
+		Vec2 Result = {};
+		for (const auto& Line : Lines)
+		{
+			auto LineSize = TextLayout::Measure(Line, FontSize, *Font);
+			Result.X = std::max(Result.X, LineSize.X);
+			Result.Y += LineSize.Y;
+		}
+		return Result;
+	}
+
+	void GPUStatsOverlay::Draw(DrawingContext& Context) const
+	{
+		Context.DrawRectangle(BoundingBox, Vec4(0.0f, 0.0f, 0.0f, 0.5f));
+
+		float LineTop = BoundingBox.Min.Y;
+		for (const auto& Line : Lines)
+		{
+			auto LineSize = TextLayout::Measure(Line, FontSize, *Font);
+			Rect2D LineRect = { { BoundingBox.Min.X, LineTop }, { BoundingBox.Min.X + LineSize.X, LineTop + LineSize.Y } };
+			Context.DrawText(LineRect, Line, FontSize, Font);
+			LineTop += LineSize.Y;
+		}
+	}
+}
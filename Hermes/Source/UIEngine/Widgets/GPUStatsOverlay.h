@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include "Core/Core.h"
+#include "UIEngine/Font.h"
+#include "UIEngine/Widgets/Widget.h"
+
+namespace Hermes::UI
+{
+	/*
+	 * Shows the GPU time of every frame graph pass and of the whole frame, averaged over the last refresh interval
+	 * so that the numbers stay readable
+	 */
+	class HERMES_API GPUStatsOverlay : public Widget
+	{
+	public:
+		static std::shared_ptr<GPUStatsOverlay> Create(uint32 InFontSize, AssetHandle<Font> InFont);
+
+	private:
+		static constexpr float RefreshInterval = 0.5f;
+
+		uint32 FontSize;
+		AssetHandle<Font> Font;
+
+		std::vector<std::pair<String, float>> AccumulatedMilliseconds;
+		uint32 AccumulatedFrameCount = 0;
+		float TimeSinceRefresh = 0.0f;
+
+		std::vector<String> Lines;
+
+		GPUStatsOverlay(uint32 InFontSize, AssetHandle<class Font> InFont);
+
+		virtual void OnUpdate(float DeltaTime) override;
+
+		virtual Vec2 ComputePreferredSize() const override;
+
+		virtual void Draw(DrawingContext& Context) const override;
+	};
+}
@@ -1,6 +1,7 @@
 #include "Buffer.h"
 
 #include "Vulkan/Device.h"
+#include "Vulkan/MemoryBlock.h"
 
 namespace Hermes::Vulkan
 {
@@ -10,43 +11,66 @@ namespace Hermes::Vulkan
 		, Size(BufferSize)
 	{
 		VmaAllocator Allocator = Device->Allocator;
-		VkBufferCreateInfo CreateInfo = {};
-		CreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-		CreateInfo.size = BufferSize;
-		CreateInfo.usage = Usage;
-		CreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		auto CreateInfo = MakeCreateInfo(BufferSize, Usage);
 
 		VmaAllocationCreateInfo AllocationInfo = {};
 		AllocationInfo.usage = VMA_MEMORY_USAGE_AUTO;
 		if (IsMappable)
-			AllocationInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+			AllocationInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
 		else
 			AllocationInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
-		VK_CHECK_RESULT(vmaCreateBuffer(Allocator, &CreateInfo, &AllocationInfo, &Handle, &Allocation, nullptr));
+		VmaAllocationInfo ResultInfo = {};
+		VK_CHECK_RESULT(vmaCreateBuffer(Allocator, &CreateInfo, &AllocationInfo, &Handle, &Allocation, &ResultInfo));
+
+		if (IsMappable)
+		{
+			MappedData = ResultInfo.pMappedData;
+			HERMES_ASSERT(MappedData);
+
+			VkMemoryPropertyFlags MemoryProperties;
+			vmaGetAllocationMemoryProperties(Allocator, Allocation, &MemoryProperties);
+			IsHostCoherent = (MemoryProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+		}
+	}
+
+	Buffer::Buffer(std::shared_ptr<Device::VkDeviceHolder> InDevice, const MemoryBlock& Memory, size_t BufferSize,
+	               VkBufferUsageFlags Usage)
+		: Device(std::move(InDevice))
+		, Size(BufferSize)
+	{
+		auto CreateInfo = MakeCreateInfo(BufferSize, Usage);
+		VK_CHECK_RESULT(vmaCreateAliasingBuffer(Device->Allocator, Memory.GetAllocation(), &CreateInfo, &Handle));
 	}
 
 	Buffer::~Buffer()
 	{
+		// NOTE: VMA unmaps persistently mapped allocations itself
 		VmaAllocator Allocator = Device->Allocator;
-		if (IsMapped)
-			Unmap();
 		vmaDestroyBuffer(Allocator, Handle, Allocation);
 	}
 
-	void* Buffer::Map() const
+	void* Buffer::GetMappedData() const
 	{
-		void* Result;
-		VmaAllocator Allocator = Device->Allocator;
-		VK_CHECK_RESULT(vmaMapMemory(Allocator, Allocation, &Result));
-		IsMapped = true;
-		return Result;
+		HERMES_ASSERT_LOG(MappedData, "Trying to access the memory of a buffer that is not mappable");
+		return MappedData;
 	}
 
-	void Buffer::Unmap() const
+	void Buffer::Flush(size_t Offset, size_t FlushSize) const
 	{
-		VmaAllocator Allocator = Device->Allocator;
-		vmaUnmapMemory(Allocator, Allocation);
-		IsMapped = false;
+		HERMES_ASSERT(MappedData);
+		if (IsHostCoherent)
+			return;
+
+		VK_CHECK_RESULT(vmaFlushAllocation(Device->Allocator, Allocation, Offset, FlushSize));
+	}
+
+	void Buffer::Invalidate(size_t Offset, size_t InvalidateSize) const
+	{
+		HERMES_ASSERT(MappedData);
+		if (IsHostCoherent)
+			return;
+
+		VK_CHECK_RESULT(vmaInvalidateAllocation(Device->Allocator, Allocation, Offset, InvalidateSize));
 	}
 
 	size_t Buffer::GetSize() const
@@ -58,4 +82,15 @@ namespace Hermes::Vulkan
 	{
 		return Handle;
 	}
+
+	VkBufferCreateInfo Buffer::MakeCreateInfo(size_t Size, VkBufferUsageFlags Usage)
+	{
+		VkBufferCreateInfo CreateInfo = {};
+		CreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		CreateInfo.size = Size;
+		CreateInfo.usage = Usage;
+		CreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		return CreateInfo;
+	}
 }
@@ -21,11 +21,29 @@ namespace Hermes::Vulkan
 		Buffer(std::shared_ptr<Device::VkDeviceHolder> InDevice, size_t BufferSize, VkBufferUsageFlags Usage,
 		       bool IsMappable);
 
+		/*
+		 * Aliasing constructor, the buffer is placed into a memory block that it does not own and cannot be mapped
+		 */
+		Buffer(std::shared_ptr<Device::VkDeviceHolder> InDevice, const MemoryBlock& Memory, size_t BufferSize,
+		       VkBufferUsageFlags Usage);
+
 		~Buffer();
 
-		void* Map() const;
+		/*
+		 * Returns the host pointer to the beginning of the buffer. Mappable buffers are mapped once when they are
+		 * created and stay mapped for their whole lifetime, so this never calls into the driver
+		 */
+		void* GetMappedData() const;
+
+		/*
+		 * Makes host writes to the range visible to the device, does nothing if the memory is host-coherent
+		 */
+		void Flush(size_t Offset = 0, size_t FlushSize = VK_WHOLE_SIZE) const;
 
-		void Unmap() const;
+		/*
+		 * Makes device writes to the range visible to host reads, does nothing if the memory is host-coherent
+		 */
+		void Invalidate(size_t Offset = 0, size_t InvalidateSize = VK_WHOLE_SIZE) const;
 
 		size_t GetSize() const;
 
@@ -35,9 +53,16 @@ namespace Hermes::Vulkan
 		std::shared_ptr<Device::VkDeviceHolder> Device;
 
 		VkBuffer Handle = VK_NULL_HANDLE;
+		// NOTE: null for buffers that are placed into a MemoryBlock
 		VmaAllocation Allocation = VK_NULL_HANDLE;
 
-		mutable bool IsMapped = false;
+		// NOTE: null for buffers that are not mappable
+		void* MappedData = nullptr;
+		bool IsHostCoherent = false;
 		size_t Size = 0;
+
+		static VkBufferCreateInfo MakeCreateInfo(size_t Size, VkBufferUsageFlags Usage);
+
+		friend class Device;
 	};
 }
@@ -1,33 +1,35 @@
 ﻿#include "CommandBuffer.h"
 
+#include <vector>
+
 #include "Vulkan/Buffer.h"
 #include "Vulkan/ComputePipeline.h"
 #include "Vulkan/Descriptor.h"
 #include "Vulkan/Image.h"
 #include "Vulkan/Pipeline.h"
+#include "Vulkan/QueryPool.h"
 #include "Vulkan/RenderPass.h"
 #include "Vulkan/Framebuffer.h"
-#include "Vulkan/Queue.h"
 
 namespace Hermes::Vulkan
 {
-	CommandBuffer::CommandBuffer(std::shared_ptr<Queue::VkQueueHolder> InQueue, bool IsPrimaryBuffer)
-		: Queue(std::move(InQueue))
+	CommandBuffer::CommandBuffer(std::shared_ptr<CommandPool::VkCommandPoolHolder> InPool, bool IsPrimaryBuffer)
+		: Pool(std::move(InPool))
 	{
 		VkCommandBufferAllocateInfo AllocateInfo = {};
 		AllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		AllocateInfo.commandPool = Queue->CommandPool;
+		AllocateInfo.commandPool = Pool->Pool;
 		AllocateInfo.commandBufferCount = 1; // TODO : add a way to allocate multiple buffers at one time
 		if (IsPrimaryBuffer)
 			AllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 		else
 			AllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
-		VK_CHECK_RESULT(vkAllocateCommandBuffers(Queue->Device->Device, &AllocateInfo, &Handle));
+		VK_CHECK_RESULT(vkAllocateCommandBuffers(Pool->Device->Device, &AllocateInfo, &Handle));
 	}
 
 	CommandBuffer::~CommandBuffer()
 	{
-		vkFreeCommandBuffers(Queue->Device->Device, Queue->CommandPool, 1, &Handle);
+		vkFreeCommandBuffers(Pool->Device->Device, Pool->Pool, 1, &Handle);
 	}
 
 	void CommandBuffer::BeginRecording()
@@ -37,6 +39,28 @@ namespace Hermes::Vulkan
 		VK_CHECK_RESULT(vkBeginCommandBuffer(Handle, &BeginInfo));
 	}
 
+	void CommandBuffer::BeginRecording(std::span<const VkFormat> ColorAttachmentFormats, VkFormat DepthAttachmentFormat,
+	                                   VkFormat StencilAttachmentFormat)
+	{
+		VkCommandBufferInheritanceRenderingInfo InheritanceRenderingInfo = {};
+		InheritanceRenderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+		InheritanceRenderingInfo.colorAttachmentCount = static_cast<uint32>(ColorAttachmentFormats.size());
+		InheritanceRenderingInfo.pColorAttachmentFormats = ColorAttachmentFormats.data();
+		InheritanceRenderingInfo.depthAttachmentFormat = DepthAttachmentFormat;
+		InheritanceRenderingInfo.stencilAttachmentFormat = StencilAttachmentFormat;
+		InheritanceRenderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+		VkCommandBufferInheritanceInfo InheritanceInfo = {};
+		InheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		InheritanceInfo.pNext = &InheritanceRenderingInfo;
+
+		VkCommandBufferBeginInfo BeginInfo = {};
+		BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		BeginInfo.pInheritanceInfo = &InheritanceInfo;
+		VK_CHECK_RESULT(vkBeginCommandBuffer(Handle, &BeginInfo));
+	}
+
 	void CommandBuffer::EndRecording()
 	{
 		VK_CHECK_RESULT(vkEndCommandBuffer(Handle));
@@ -57,12 +81,12 @@ namespace Hermes::Vulkan
 		vkCmdBeginRenderPass(Handle, &BeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 	}
 
-	void CommandBuffer::BeginRendering(VkRect2D RenderingArea, std::span<const VkRenderingAttachmentInfo> ColorAttachments, std::optional<VkRenderingAttachmentInfo> DepthAttachment, std::optional<VkRenderingAttachmentInfo> StencilAttachment)
+	void CommandBuffer::BeginRendering(VkRect2D RenderingArea, std::span<const VkRenderingAttachmentInfo> ColorAttachments, std::optional<VkRenderingAttachmentInfo> DepthAttachment, std::optional<VkRenderingAttachmentInfo> StencilAttachment, bool IsRecordedInSecondaryBuffers)
 	{
 		VkRenderingInfo RenderingInfo = {
 			.sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
 			.pNext = nullptr,
-			.flags = 0,
+			.flags = IsRecordedInSecondaryBuffers ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0u,
 			.renderArea = RenderingArea,
 			.layerCount = 1,
 			.viewMask = 0,
@@ -119,17 +143,30 @@ namespace Hermes::Vulkan
 		vkCmdDrawIndexed(Handle, IndexCount, InstanceCount, IndexOffset, VertexOffset, InstanceOffset);
 	}
 
+	void CommandBuffer::DrawIndexedIndirectCount(const Buffer& DrawBuffer, VkDeviceSize DrawBufferOffset, const Buffer& CountBuffer,
+	                                             VkDeviceSize CountBufferOffset, uint32 MaxDrawCount, uint32 Stride)
+	{
+		GProfilingMetrics.DrawCallCount++;
+		vkCmdDrawIndexedIndirectCount(Handle, DrawBuffer.GetBuffer(), DrawBufferOffset, CountBuffer.GetBuffer(), CountBufferOffset,
+		                              MaxDrawCount, Stride);
+	}
+
 	void CommandBuffer::Dispatch(uint32 GroupCountX, uint32 GroupCountY, uint32 GroupCountZ)
 	{
 		GProfilingMetrics.ComputeDispatchCount++;
 		vkCmdDispatch(Handle, GroupCountX, GroupCountY, GroupCountZ);
 	}
 
-	void CommandBuffer::BindVertexBuffer(const Buffer& Buffer)
+	void CommandBuffer::DispatchIndirect(const Buffer& Buffer, VkDeviceSize Offset)
+	{
+		GProfilingMetrics.ComputeDispatchCount++;
+		vkCmdDispatchIndirect(Handle, Buffer.GetBuffer(), Offset);
+	}
+
+	void CommandBuffer::BindVertexBuffer(const Buffer& Buffer, VkDeviceSize Offset)
 	{
 		GProfilingMetrics.BufferBindCount++;
 		VkBuffer TmpBuffer = Buffer.GetBuffer();
-		VkDeviceSize Offset = 0;
 		vkCmdBindVertexBuffers(Handle, 0, 1, &TmpBuffer, &Offset);
 	}
 
@@ -140,20 +177,22 @@ namespace Hermes::Vulkan
 		vkCmdBindIndexBuffer(Handle, Buffer.GetBuffer(), Offset, IndexType);
 	}
 
-	void CommandBuffer::BindDescriptorSet(const DescriptorSet& Set, const Pipeline& Pipeline, uint32 BindingIndex)
+	void CommandBuffer::BindDescriptorSet(const DescriptorSet& Set, const Pipeline& Pipeline, uint32 BindingIndex,
+	                                      std::span<const uint32> DynamicOffsets)
 	{
 		GProfilingMetrics.DescriptorSetBindCount++;
 		auto DescriptorSet = Set.GetDescriptorSet();
 		vkCmdBindDescriptorSets(Handle, VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline.GetPipelineLayout(), BindingIndex, 1,
-		                        &DescriptorSet, 0, nullptr);
+		                        &DescriptorSet, static_cast<uint32>(DynamicOffsets.size()), DynamicOffsets.data());
 	}
 
-	void CommandBuffer::BindDescriptorSet(const DescriptorSet& Set, const ComputePipeline& Pipeline, uint32 BindingIndex)
+	void CommandBuffer::BindDescriptorSet(const DescriptorSet& Set, const ComputePipeline& Pipeline, uint32 BindingIndex,
+	                                      std::span<const uint32> DynamicOffsets)
 	{
 		GProfilingMetrics.DescriptorSetBindCount++;
 		auto DescriptorSet = Set.GetDescriptorSet();
 		vkCmdBindDescriptorSets(Handle, VK_PIPELINE_BIND_POINT_COMPUTE, Pipeline.GetPipelineLayout(), BindingIndex, 1,
-		                        &DescriptorSet, 0, nullptr);
+		                        &DescriptorSet, static_cast<uint32>(DynamicOffsets.size()), DynamicOffsets.data());
 	}
 
 	void CommandBuffer::UploadPushConstants(const Pipeline& Pipeline, VkShaderStageFlags ShadersThatUse,
@@ -162,6 +201,18 @@ namespace Hermes::Vulkan
 		vkCmdPushConstants(Handle, Pipeline.GetPipelineLayout(), ShadersThatUse, Offset, Size, Data);
 	}
 
+	void CommandBuffer::UploadPushConstants(const ComputePipeline& Pipeline, const void* Data, uint32 Size, uint32 Offset)
+	{
+		vkCmdPushConstants(Handle, Pipeline.GetPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, Offset, Size, Data);
+	}
+
+	void CommandBuffer::InsertMemoryBarrier(const VkMemoryBarrier& Barrier,
+	                                        VkPipelineStageFlags SourceStage,
+	                                        VkPipelineStageFlags DestinationStage)
+	{
+		vkCmdPipelineBarrier(Handle, SourceStage, DestinationStage, 0, 1, &Barrier, 0, nullptr, 0, nullptr);
+	}
+
 	void CommandBuffer::InsertBufferMemoryBarrier(const VkBufferMemoryBarrier& Barrier,
 	                                              VkPipelineStageFlags SourceStage,
 	                                              VkPipelineStageFlags DestinationStage)
@@ -192,6 +243,24 @@ namespace Hermes::Vulkan
 		                     static_cast<uint32>(Barriers.size()), Barriers.data());
 	}
 
+	void CommandBuffer::InsertDependency(std::span<const VkMemoryBarrier2> MemoryBarriers,
+	                                     std::span<const VkBufferMemoryBarrier2> BufferBarriers,
+	                                     std::span<const VkImageMemoryBarrier2> ImageBarriers)
+	{
+		VkDependencyInfo DependencyInfo = {
+			.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+			.pNext = nullptr,
+			.dependencyFlags = 0,
+			.memoryBarrierCount = static_cast<uint32>(MemoryBarriers.size()),
+			.pMemoryBarriers = MemoryBarriers.data(),
+			.bufferMemoryBarrierCount = static_cast<uint32>(BufferBarriers.size()),
+			.pBufferMemoryBarriers = BufferBarriers.data(),
+			.imageMemoryBarrierCount = static_cast<uint32>(ImageBarriers.size()),
+			.pImageMemoryBarriers = ImageBarriers.data()
+		};
+		vkCmdPipelineBarrier2(Handle, &DependencyInfo);
+	}
+
 	void CommandBuffer::CopyBuffer(const Buffer& Source, const Buffer& Destination, std::span<VkBufferCopy> CopyRegions)
 	{
 		vkCmdCopyBuffer(Handle, Source.GetBuffer(), Destination.GetBuffer(), static_cast<uint32>(CopyRegions.size()),
@@ -220,6 +289,26 @@ namespace Hermes::Vulkan
 		               static_cast<uint32>(Regions.size()), Regions.data(), Filter);
 	}
 
+	void CommandBuffer::FillBuffer(const Buffer& Buffer, VkDeviceSize Offset, VkDeviceSize Size, uint32 Data)
+	{
+		vkCmdFillBuffer(Handle, Buffer.GetBuffer(), Offset, Size, Data);
+	}
+
+	void CommandBuffer::ExecuteCommands(std::span<const CommandBuffer* const> SecondaryBuffers)
+	{
+		std::vector<VkCommandBuffer> Handles;
+		Handles.reserve(SecondaryBuffers.size());
+		for (const auto* SecondaryBuffer : SecondaryBuffers)
+			Handles.push_back(SecondaryBuffer->GetBuffer());
+
+		vkCmdExecuteCommands(Handle, static_cast<uint32>(Handles.size()), Handles.data());
+	}
+
+	void CommandBuffer::WriteTimestamp(const QueryPool& Pool, uint32 QueryIndex, VkPipelineStageFlags2 Stage)
+	{
+		vkCmdWriteTimestamp2(Handle, Stage, Pool.GetQueryPool(), QueryIndex);
+	}
+
 	void CommandBuffer::ClearColorImage(const Image& Image, VkImageLayout CurrentLayout, VkClearColorValue Color, std::span<const VkImageSubresourceRange> Ranges)
 	{
 		vkCmdClearColorImage(Handle, Image.GetImage(), CurrentLayout, &Color, static_cast<uint32>(Ranges.size()), Ranges.data());
@@ -6,7 +6,7 @@
 #include "Core/Core.h"
 #include "Core/Misc/NonCopyableMovable.h"
 #include "Vulkan/Forward.h"
-#include "Vulkan/Queue.h"
+#include "Vulkan/CommandPool.h"
 #include "Vulkan/VulkanCore.h"
 
 namespace Hermes::Vulkan
@@ -20,18 +20,29 @@ namespace Hermes::Vulkan
 		MAKE_NON_MOVABLE(CommandBuffer)
 
 	public:
-		CommandBuffer(std::shared_ptr<Queue::VkQueueHolder> InQueue, bool IsPrimaryBuffer);
+		CommandBuffer(std::shared_ptr<CommandPool::VkCommandPoolHolder> InPool, bool IsPrimaryBuffer);
 
 		~CommandBuffer();
 
 		void BeginRecording();
 
+		/*
+		 * Begins recording of a secondary command buffer that will be executed inside a dynamic rendering instance
+		 * with the given attachment formats (pass VK_FORMAT_UNDEFINED for attachments that are not used)
+		 */
+		void BeginRecording(std::span<const VkFormat> ColorAttachmentFormats, VkFormat DepthAttachmentFormat,
+		                    VkFormat StencilAttachmentFormat);
+
 		void EndRecording();
 
 		void BeginRenderPass(const RenderPass& RenderPass, const Framebuffer& Framebuffer,
 		                     std::span<VkClearValue> ClearColors);
 
-		void BeginRendering(VkRect2D RenderingArea, std::span<const VkRenderingAttachmentInfo> ColorAttachments, std::optional<VkRenderingAttachmentInfo> DepthAttachment, std::optional<VkRenderingAttachmentInfo> StencilAttachment);
+		/*
+		 * If IsRecordedInSecondaryBuffers is true, the contents of the rendering instance must be provided by
+		 * calling ExecuteCommands() instead of recording draw commands directly into this buffer
+		 */
+		void BeginRendering(VkRect2D RenderingArea, std::span<const VkRenderingAttachmentInfo> ColorAttachments, std::optional<VkRenderingAttachmentInfo> DepthAttachment, std::optional<VkRenderingAttachmentInfo> StencilAttachment, bool IsRecordedInSecondaryBuffers = false);
 
 		void EndRenderPass();
 
@@ -50,19 +61,41 @@ namespace Hermes::Vulkan
 		void DrawIndexed(uint32 IndexCount, uint32 InstanceCount, uint32 IndexOffset, int32 VertexOffset,
 		                 uint32 InstanceOffset);
 
+		/*
+		 * Draws up to MaxDrawCount indexed draws whose parameters (VkDrawIndexedIndirectCommand) are stored in DrawBuffer
+		 * at DrawBufferOffset; the actual number of draws is read from CountBuffer at CountBufferOffset
+		 */
+		void DrawIndexedIndirectCount(const Buffer& DrawBuffer, VkDeviceSize DrawBufferOffset, const Buffer& CountBuffer,
+		                              VkDeviceSize CountBufferOffset, uint32 MaxDrawCount, uint32 Stride);
+
 		void Dispatch(uint32 GroupCountX, uint32 GroupCountY, uint32 GroupCountZ);
 
-		void BindVertexBuffer(const Buffer& Buffer);
+		/*
+		 * Reads the group counts from a VkDispatchIndirectCommand stored in Buffer at Offset
+		 */
+		void DispatchIndirect(const Buffer& Buffer, VkDeviceSize Offset);
+
+		void BindVertexBuffer(const Buffer& Buffer, VkDeviceSize Offset = 0);
 
 		void BindIndexBuffer(const Buffer& Buffer, VkIndexType IndexType);
 
-		void BindDescriptorSet(const DescriptorSet& Set, const Pipeline& Pipeline, uint32 BindingIndex);
+		/*
+		 * DynamicOffsets must contain one offset for every dynamic uniform or storage buffer in the set, in binding order
+		 */
+		void BindDescriptorSet(const DescriptorSet& Set, const Pipeline& Pipeline, uint32 BindingIndex,
+		                       std::span<const uint32> DynamicOffsets = {});
 
-		void BindDescriptorSet(const DescriptorSet& Set, const ComputePipeline& Pipeline, uint32 BindingIndex);
+		void BindDescriptorSet(const DescriptorSet& Set, const ComputePipeline& Pipeline, uint32 BindingIndex,
+		                       std::span<const uint32> DynamicOffsets = {});
 
 		void UploadPushConstants(const Pipeline& Pipeline, VkShaderStageFlags ShadersThatUse, const void* Data,
 		                         uint32 Size, uint32 Offset);
+
+		void UploadPushConstants(const ComputePipeline& Pipeline, const void* Data, uint32 Size, uint32 Offset);
 		
+		void InsertMemoryBarrier(const VkMemoryBarrier& Barrier, VkPipelineStageFlags SourceStage,
+		                         VkPipelineStageFlags DestinationStage);
+
 		void InsertBufferMemoryBarrier(const VkBufferMemoryBarrier& Barrier, VkPipelineStageFlags SourceStage,
 		                               VkPipelineStageFlags DestinationStage);
 
@@ -75,6 +108,13 @@ namespace Hermes::Vulkan
 		void InsertImageMemoryBarriers(std::span<const VkImageMemoryBarrier> Barriers, VkPipelineStageFlags SourceStage,
 		                              VkPipelineStageFlags DestinationStage);
 
+		/*
+		 * Records all barriers with a single vkCmdPipelineBarrier2 call, every barrier carries its own stage masks
+		 */
+		void InsertDependency(std::span<const VkMemoryBarrier2> MemoryBarriers,
+		                      std::span<const VkBufferMemoryBarrier2> BufferBarriers,
+		                      std::span<const VkImageMemoryBarrier2> ImageBarriers);
+
 		void CopyBuffer(const Buffer& Source, const Buffer& Destination, std::span<VkBufferCopy> CopyRegions);
 
 		void CopyBufferToImage(const Buffer& Source, const Image& Destination, VkImageLayout DestinationImageLayout,
@@ -86,12 +126,24 @@ namespace Hermes::Vulkan
 		void BlitImage(const Image& Source, VkImageLayout SourceLayout, const Image& Destination,
 		               VkImageLayout DestinationLayout, std::span<VkImageBlit> Regions, VkFilter Filter);
 
+		/*
+		 * Fills Size bytes of the buffer starting at Offset with the repeated 4-byte value Data
+		 */
+		void FillBuffer(const Buffer& Buffer, VkDeviceSize Offset, VkDeviceSize Size, uint32 Data);
+
+		void ExecuteCommands(std::span<const CommandBuffer* const> SecondaryBuffers);
+
+		/*
+		 * Writes the GPU time into the query once all previous commands have reached the given stage
+		 */
+		void WriteTimestamp(const QueryPool& Pool, uint32 QueryIndex, VkPipelineStageFlags2 Stage);
+
 		void ClearColorImage(const Image& Image, VkImageLayout CurrentLayout, VkClearColorValue Color, std::span<const VkImageSubresourceRange> Ranges);
 
 		VkCommandBuffer GetBuffer() const;
 
 	private:
-		std::shared_ptr<Queue::VkQueueHolder> Queue;
+		std::shared_ptr<CommandPool::VkCommandPoolHolder> Pool;
 
 		VkCommandBuffer Handle = VK_NULL_HANDLE;
 	};
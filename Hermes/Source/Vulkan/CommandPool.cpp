@@ -0,0 +1,39 @@
+#include "CommandPool.h"
+
+#include "Vulkan/CommandBuffer.h"
+
+namespace Hermes::Vulkan
+{
+	CommandPool::CommandPool(std::shared_ptr<Device::VkDeviceHolder> InDevice, uint32 InQueueFamilyIndex, VkCommandPoolCreateFlags Flags)
+		: Holder(std::make_shared<VkCommandPoolHolder>())
+		, QueueFamilyIndex(InQueueFamilyIndex)
+	{
+		Holder->Device = std::move(InDevice);
+
+		VkCommandPoolCreateInfo CreateInfo = {};
+		CreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		CreateInfo.queueFamilyIndex = QueueFamilyIndex;
+		CreateInfo.flags = Flags;
+		VK_CHECK_RESULT(vkCreateCommandPool(Holder->Device->Device, &CreateInfo, GVulkanAllocator, &Holder->Pool));
+	}
+
+	std::unique_ptr<CommandBuffer> CommandPool::CreateCommandBuffer(bool IsPrimaryBuffer/* = true*/) const
+	{
+		return std::make_unique<CommandBuffer>(Holder, IsPrimaryBuffer);
+	}
+
+	void CommandPool::Reset()
+	{
+		VK_CHECK_RESULT(vkResetCommandPool(Holder->Device->Device, Holder->Pool, 0));
+	}
+
+	uint32 CommandPool::GetQueueFamilyIndex() const
+	{
+		return QueueFamilyIndex;
+	}
+
+	CommandPool::VkCommandPoolHolder::~VkCommandPoolHolder()
+	{
+		vkDestroyCommandPool(Device->Device, Pool, GVulkanAllocator);
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+
+#include "Core/Core.h"
+#include "Core/Misc/DefaultConstructors.h"
+#include "Core/Misc/NonCopyableMovable.h"
+#include "Vulkan/Device.h"
+#include "Vulkan/Forward.h"
+#include "Vulkan/VulkanCore.h"
+
+namespace Hermes::Vulkan
+{
+	/*
+	 * A wrapper around VkCommandPool that allocates command buffers for a single queue family
+	 *
+	 * NOTE: Vulkan requires external synchronization of the pool and of every command buffer allocated from it,
+	 * so each thread that records commands concurrently must use its own pool
+	 */
+	class HERMES_API CommandPool
+	{
+		MAKE_NON_COPYABLE(CommandPool)
+		MAKE_NON_MOVABLE(CommandPool)
+
+	public:
+		CommandPool(std::shared_ptr<Device::VkDeviceHolder> InDevice, uint32 InQueueFamilyIndex, VkCommandPoolCreateFlags Flags);
+
+		std::unique_ptr<CommandBuffer> CreateCommandBuffer(bool IsPrimaryBuffer = true) const;
+
+		/*
+		 * Returns all command buffers allocated from this pool to the initial state at once, none of them may be
+		 * pending execution on the GPU
+		 */
+		void Reset();
+
+		uint32 GetQueueFamilyIndex() const;
+
+	private:
+		struct VkCommandPoolHolder
+		{
+			MAKE_NON_COPYABLE(VkCommandPoolHolder)
+			MAKE_NON_MOVABLE(VkCommandPoolHolder)
+			ADD_DEFAULT_CONSTRUCTOR(VkCommandPoolHolder)
+
+			~VkCommandPoolHolder();
+
+			std::shared_ptr<Device::VkDeviceHolder> Device;
+			VkCommandPool Pool = VK_NULL_HANDLE;
+		};
+
+		std::shared_ptr<VkCommandPoolHolder> Holder;
+		uint32 QueueFamilyIndex = 0;
+
+		friend class CommandBuffer;
+	};
+}
@@ -7,7 +7,8 @@ namespace Hermes::Vulkan
 {
 	ComputePipeline::ComputePipeline(std::shared_ptr<Device::VkDeviceHolder> InDevice,
 	                                 const std::vector<const DescriptorSetLayout*>& DescriptorSetLayouts,
-	                                 const Shader& Shader)
+	                                 const Shader& Shader,
+	                                 const std::vector<VkPushConstantRange>& PushConstants)
 		: Device(std::move(InDevice))
 	{
 		std::vector<VkDescriptorSetLayout> VkDescriptorSetLayouts(DescriptorSetLayouts.size());
@@ -20,6 +21,8 @@ namespace Hermes::Vulkan
 		PipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		PipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32>(VkDescriptorSetLayouts.size());
 		PipelineLayoutCreateInfo.pSetLayouts = VkDescriptorSetLayouts.data();
+		PipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<uint32>(PushConstants.size());
+		PipelineLayoutCreateInfo.pPushConstantRanges = PushConstants.data();
 		VK_CHECK_RESULT(vkCreatePipelineLayout(Device->Device, &PipelineLayoutCreateInfo, GVulkanAllocator, &PipelineLayout));
 
 		VkComputePipelineCreateInfo PipelineCreateInfo = {};
@@ -32,7 +35,7 @@ namespace Hermes::Vulkan
 
 		PipelineCreateInfo.layout = PipelineLayout;
 
-		VK_CHECK_RESULT(vkCreateComputePipelines(Device->Device, VK_NULL_HANDLE, 1, &PipelineCreateInfo, GVulkanAllocator, &Pipeline));
+		VK_CHECK_RESULT(vkCreateComputePipelines(Device->Device, Device->PipelineCache, 1, &PipelineCreateInfo, GVulkanAllocator, &Pipeline));
 	}
 
 	VkPipeline ComputePipeline::GetPipeline() const
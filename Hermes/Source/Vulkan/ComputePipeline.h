@@ -14,7 +14,8 @@ namespace Hermes::Vulkan
 	public:
 		ComputePipeline(std::shared_ptr<Device::VkDeviceHolder> InDevice,
 		                const std::vector<const DescriptorSetLayout*>& DescriptorSetLayouts,
-		                const Shader& Shader);
+		                const Shader& Shader,
+		                const std::vector<VkPushConstantRange>& PushConstants = {});
 
 		VkPipeline GetPipeline() const;
 
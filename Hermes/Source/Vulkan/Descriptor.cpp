@@ -7,10 +7,15 @@
 namespace Hermes::Vulkan
 {
 	DescriptorSetLayout::DescriptorSetLayout(std::shared_ptr<Device::VkDeviceHolder> InDevice,
-	                                         const std::vector<VkDescriptorSetLayoutBinding>& Bindings)
+	                                         const std::vector<VkDescriptorSetLayoutBinding>& Bindings,
+	                                         const std::vector<VkDescriptorBindingFlags>& BindingFlags)
 	{
+		HERMES_ASSERT(BindingFlags.empty() || BindingFlags.size() == Bindings.size());
+
 		Holder = std::make_shared<VkDescriptorSetLayoutHolder>();
 		Holder->Device = std::move(InDevice);
+		Holder->Bindings = Bindings;
+		Holder->BindingFlags = BindingFlags;
 
 		for (const auto& Binding : Bindings)
 		{
@@ -23,6 +28,21 @@ namespace Hermes::Vulkan
 		CreateInfo.bindingCount = static_cast<uint32>(Bindings.size());
 		CreateInfo.pBindings = Bindings.data();
 
+		VkDescriptorSetLayoutBindingFlagsCreateInfo BindingFlagsCreateInfo = {};
+		if (!BindingFlags.empty())
+		{
+			BindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+			BindingFlagsCreateInfo.bindingCount = static_cast<uint32>(BindingFlags.size());
+			BindingFlagsCreateInfo.pBindingFlags = BindingFlags.data();
+			CreateInfo.pNext = &BindingFlagsCreateInfo;
+
+			for (auto Flags : BindingFlags)
+			{
+				if (Flags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT)
+					CreateInfo.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+			}
+		}
+
 		VK_CHECK_RESULT(vkCreateDescriptorSetLayout(Holder->Device->Device, &CreateInfo, GVulkanAllocator, &Holder->
 			                Layout));
 	}
@@ -37,6 +57,16 @@ namespace Hermes::Vulkan
 		return Holder->DescriptorTypes.at(BindingIndex);
 	}
 
+	const std::vector<VkDescriptorSetLayoutBinding>& DescriptorSetLayout::GetBindings() const
+	{
+		return Holder->Bindings;
+	}
+
+	const std::vector<VkDescriptorBindingFlags>& DescriptorSetLayout::GetBindingFlags() const
+	{
+		return Holder->BindingFlags;
+	}
+
 	DescriptorSetLayout::VkDescriptorSetLayoutHolder::~VkDescriptorSetLayoutHolder()
 	{
 		vkDestroyDescriptorSetLayout(Device->Device, Layout, GVulkanAllocator);
@@ -44,7 +74,7 @@ namespace Hermes::Vulkan
 
 	DescriptorSetPool::DescriptorSetPool(std::shared_ptr<Device::VkDeviceHolder> InDevice, uint32 InNumberOfSets,
 	                                     const std::vector<VkDescriptorPoolSize>& InPoolSizes,
-	                                     bool InSupportIndividualDeallocations)
+	                                     bool InSupportIndividualDeallocations, bool InSupportUpdateAfterBind)
 		: Holder(std::make_shared<VkDescriptorPoolHolder>())
 		, NumSets(InNumberOfSets)
 		, SupportIndividualDeallocations(InSupportIndividualDeallocations)
@@ -57,6 +87,8 @@ namespace Hermes::Vulkan
 		CreateInfo.pPoolSizes = InPoolSizes.data();
 		CreateInfo.poolSizeCount = static_cast<uint32>(InPoolSizes.size());
 		CreateInfo.flags = SupportIndividualDeallocations ? VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT : 0;
+		if (InSupportUpdateAfterBind)
+			CreateInfo.flags |= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
 
 		VK_CHECK_RESULT(vkCreateDescriptorPool(Holder->Device->Device, &CreateInfo, GVulkanAllocator, &Holder->Pool ));
 	}
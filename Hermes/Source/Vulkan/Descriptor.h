@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "Core/Core.h"
 #include "Core/Misc/DefaultConstructors.h"
@@ -14,6 +15,9 @@ namespace Hermes::Vulkan
 {
 	/*
 	 * A wrapper around VkDescriptorSetLayout that also stores a map of binding types
+	 *
+	 * Binding flags are optional, if given there must be one per binding. A layout with any
+	 * VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT binding can only be allocated from a pool that supports update after bind
 	 */
 	class HERMES_API DescriptorSetLayout
 	{
@@ -23,12 +27,23 @@ namespace Hermes::Vulkan
 
 	public:
 		DescriptorSetLayout(std::shared_ptr<Device::VkDeviceHolder> InDevice,
-		                    const std::vector<VkDescriptorSetLayoutBinding>& Bindings);
+		                    const std::vector<VkDescriptorSetLayoutBinding>& Bindings,
+		                    const std::vector<VkDescriptorBindingFlags>& BindingFlags = {});
 
 		VkDescriptorSetLayout GetDescriptorSetLayout() const;
 
 		VkDescriptorType GetDescriptorType(uint32 BindingIndex) const;
 
+		/*
+		 * Bindings the layout was created with, two layouts with identical bindings are compatible with each other
+		 */
+		const std::vector<VkDescriptorSetLayoutBinding>& GetBindings() const;
+
+		/*
+		 * Empty if the layout was created without binding flags
+		 */
+		const std::vector<VkDescriptorBindingFlags>& GetBindingFlags() const;
+
 	private:
 		struct VkDescriptorSetLayoutHolder
 		{
@@ -42,6 +57,8 @@ namespace Hermes::Vulkan
 
 			VkDescriptorSetLayout Layout = VK_NULL_HANDLE;
 			std::unordered_map<uint32, VkDescriptorType> DescriptorTypes;
+			std::vector<VkDescriptorSetLayoutBinding> Bindings;
+			std::vector<VkDescriptorBindingFlags> BindingFlags;
 		};
 
 		std::shared_ptr<VkDescriptorSetLayoutHolder> Holder;
@@ -61,7 +78,8 @@ namespace Hermes::Vulkan
 
 	public:
 		DescriptorSetPool(std::shared_ptr<Device::VkDeviceHolder> InDevice, uint32 InNumberOfSets,
-		                  const std::vector<VkDescriptorPoolSize>& InPoolSizes, bool InSupportIndividualDeallocations);
+		                  const std::vector<VkDescriptorPoolSize>& InPoolSizes, bool InSupportIndividualDeallocations,
+		                  bool InSupportUpdateAfterBind = false);
 
 		/*
 		 * Tries to allocate a new descriptor set with given layout from this pool
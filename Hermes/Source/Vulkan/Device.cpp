@@ -1,16 +1,24 @@
 ﻿#include "Device.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include "Platform/GenericPlatform/PlatformFile.h"
 #include "Platform/GenericPlatform/PlatformMisc.h"
+#include "VirtualFilesystem/VirtualFilesystem.h"
 #include "Vulkan/Buffer.h"
 #include "Vulkan/ComputePipeline.h"
 #include "Vulkan/Descriptor.h"
 #include "Vulkan/Fence.h"
 #include "Vulkan/Framebuffer.h"
 #include "Vulkan/Image.h"
+#include "Vulkan/MemoryBlock.h"
 #include "Vulkan/Pipeline.h"
+#include "Vulkan/QueryPool.h"
 #include "Vulkan/Queue.h"
 #include "Vulkan/RenderPass.h"
 #include "Vulkan/Sampler.h"
+#include "Vulkan/Semaphore.h"
 #include "Vulkan/Shader.h"
 #include "Vulkan/Swapchain.h"
 
@@ -37,9 +45,30 @@ namespace Hermes::Vulkan
 		return nullptr;
 	}
 
+	static constexpr const char* PipelineCachePath = "/PipelineCache.bin";
+
+	/*
+	 * Written in front of the data returned by vkGetPipelineCacheData. The data is only valid for the same GPU and
+	 * driver, some drivers do not validate it themselves and crash on a cache from a different driver version
+	 */
+	struct PipelineCacheFileHeader
+	{
+		static constexpr uint32 ExpectedMagic = 0x43504848; // "HHPC"
+		static constexpr uint32 ExpectedVersion = 1;
+
+		uint32 Magic;
+		uint32 Version;
+		uint32 VendorID;
+		uint32 DeviceID;
+		uint32 DriverVersion;
+		uint8 PipelineCacheUUID[VK_UUID_SIZE];
+		uint64 DataSize;
+	};
+
 	Device::VkDeviceHolder::~VkDeviceHolder()
 	{
 		vkDeviceWaitIdle(Device);
+		vkDestroyPipelineCache(Device, PipelineCache, GVulkanAllocator);
 		vmaDestroyAllocator(Allocator);
 		vkDestroyDevice(Device, GVulkanAllocator);
 	}
@@ -72,7 +101,7 @@ namespace Hermes::Vulkan
 				GraphicsQueueFamilyIndex = static_cast<int32>(Index);
 				QueueUsed = true;
 			}
-			if (TransferQueueFamilyIndex == -1 && (QueueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) ==
+			if (ComputeQueueFamilyIndex == -1 && (QueueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) ==
 				VK_QUEUE_COMPUTE_BIT && !QueueUsed)
 			{
 				ComputeQueueFamilyIndex = static_cast<int32>(Index);
@@ -140,30 +169,60 @@ namespace Hermes::Vulkan
 		VkPhysicalDeviceFeatures AvailableFeatures;
 		vkGetPhysicalDeviceFeatures(Holder->PhysicalDevice, &AvailableFeatures);
 		IsAnisotropyAvailable = AvailableFeatures.samplerAnisotropy;
+
+		vkGetPhysicalDeviceProperties(Holder->PhysicalDevice, &Properties);
 		
 		VkPhysicalDeviceVulkan13Features Available13Features = {};
 		Available13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
 
+		VkPhysicalDeviceVulkan12Features Available12Features = {};
+		Available12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		Available12Features.pNext = &Available13Features;
+
 		VkPhysicalDeviceFeatures2 AvailableFeatures2 = {};
 		AvailableFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
-		AvailableFeatures2.pNext = &Available13Features;
+		AvailableFeatures2.pNext = &Available12Features;
 
 		vkGetPhysicalDeviceFeatures2(Holder->PhysicalDevice, &AvailableFeatures2);
 
 		HERMES_ASSERT_LOG(Available13Features.dynamicRendering, "Dynamic rendering is not supported on the selected Vulkan device");
-
-		VkPhysicalDeviceDynamicRenderingFeatures DynamicRenderingFeature = {
-			.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES,
-			.pNext = nullptr,
-			.dynamicRendering = VK_TRUE
-		};
-		CreateInfo.pNext = &DynamicRenderingFeature;
+		HERMES_ASSERT_LOG(Available13Features.synchronization2, "Synchronization2 is not supported on the selected Vulkan device");
+		HERMES_ASSERT_LOG(Available12Features.drawIndirectCount, "Indirect draw count is not supported on the selected Vulkan device");
+		HERMES_ASSERT_LOG(Available12Features.timelineSemaphore, "Timeline semaphores are not supported on the selected Vulkan device");
+		HERMES_ASSERT_LOG(Available12Features.hostQueryReset, "Host query reset is not supported on the selected Vulkan device");
+		HERMES_ASSERT_LOG(Available12Features.runtimeDescriptorArray && Available12Features.descriptorBindingPartiallyBound &&
+		                  Available12Features.descriptorBindingSampledImageUpdateAfterBind && Available12Features.shaderSampledImageArrayNonUniformIndexing,
+		                  "Descriptor indexing is not supported on the selected Vulkan device");
+
+		// NOTE: required by the GPU-driven meshlet rendering (vkCmdDrawIndexedIndirectCount)
+		VkPhysicalDeviceVulkan12Features Vulkan12Features = {};
+		Vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		Vulkan12Features.drawIndirectCount = VK_TRUE;
+		// NOTE: the renderer tracks the frames that the GPU has finished with a timeline semaphore
+		Vulkan12Features.timelineSemaphore = VK_TRUE;
+		// NOTE: the GPU profiler resets its timestamp queries from the CPU when it reads their results
+		Vulkan12Features.hostQueryReset = VK_TRUE;
+		// NOTE: materials sample their textures from one bindless array that grows while it is bound
+		Vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+		Vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+		Vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		Vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+
+		// NOTE: synchronization2 is required by the barriers that the frame graph derives from the declared pass accesses
+		VkPhysicalDeviceVulkan13Features Vulkan13Features = {};
+		Vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+		Vulkan13Features.pNext = &Vulkan12Features;
+		Vulkan13Features.synchronization2 = VK_TRUE;
+		Vulkan13Features.dynamicRendering = VK_TRUE;
+		CreateInfo.pNext = &Vulkan13Features;
 
 		VkPhysicalDeviceFeatures RequiredFeatures = {};
 		RequiredFeatures.samplerAnisotropy = IsAnisotropyAvailable;
 		CreateInfo.pEnabledFeatures = &RequiredFeatures;
 		VK_CHECK_RESULT(vkCreateDevice(Holder->PhysicalDevice, &CreateInfo, GVulkanAllocator, &Holder->Device));
 
+		CreatePipelineCache();
+
 		if (TransferQueueFamilyIndex == -1)
 		{
 			// We have to use render queue to perform transfer operations then
@@ -252,6 +311,21 @@ namespace Hermes::Vulkan
 		return std::make_unique<Fence>(Holder, InitialState);
 	}
 
+	std::unique_ptr<Semaphore> Device::CreateBinarySemaphore() const
+	{
+		return std::make_unique<Semaphore>(Holder);
+	}
+
+	std::unique_ptr<TimelineSemaphore> Device::CreateTimelineSemaphore(uint64 InitialValue/* = 0*/) const
+	{
+		return std::make_unique<TimelineSemaphore>(Holder, InitialValue);
+	}
+
+	std::unique_ptr<QueryPool> Device::CreateQueryPool(VkQueryType Type, uint32 QueryCount) const
+	{
+		return std::make_unique<QueryPool>(Holder, Type, QueryCount);
+	}
+
 	std::unique_ptr<Shader> Device::CreateShader(const String& Path, VkShaderStageFlagBits Type) const
 	{
 		return std::make_unique<Shader>(Holder, Path, Type);
@@ -282,18 +356,20 @@ namespace Hermes::Vulkan
 	}
 
 	std::unique_ptr<DescriptorSetLayout> Device::CreateDescriptorSetLayout(
-		const std::vector<VkDescriptorSetLayoutBinding>& Bindings) const
+		const std::vector<VkDescriptorSetLayoutBinding>& Bindings,
+		const std::vector<VkDescriptorBindingFlags>& BindingFlags /*= {}*/) const
 	{
-		return std::make_unique<DescriptorSetLayout>(Holder, Bindings);
+		return std::make_unique<DescriptorSetLayout>(Holder, Bindings, BindingFlags);
 	}
 
 	std::unique_ptr<DescriptorSetPool> Device::CreateDescriptorSetPool(uint32 NumberOfSets,
 	                                                                   const std::vector<VkDescriptorPoolSize>&
 	                                                                   Subpools,
-	                                                                   bool SupportIndividualDeallocations /*= false*/)
+	                                                                   bool SupportIndividualDeallocations /*= false*/,
+	                                                                   bool SupportUpdateAfterBind /*= false*/)
 	const
 	{
-		return std::make_unique<DescriptorSetPool>(Holder, NumberOfSets, Subpools, SupportIndividualDeallocations);
+		return std::make_unique<DescriptorSetPool>(Holder, NumberOfSets, Subpools, SupportIndividualDeallocations, SupportUpdateAfterBind);
 	}
 
 	std::unique_ptr<Sampler> Device::CreateSampler(const SamplerDescription& Description) const
@@ -301,9 +377,10 @@ namespace Hermes::Vulkan
 		return std::make_unique<Sampler>(Holder, Description);
 	}
 
-	std::unique_ptr<ComputePipeline> Device::CreateComputePipeline(const std::vector<const DescriptorSetLayout*>& DescriptorSetLayouts, const Shader& Shader) const
+	std::unique_ptr<ComputePipeline> Device::CreateComputePipeline(const std::vector<const DescriptorSetLayout*>& DescriptorSetLayouts, const Shader& Shader,
+	                                                               const std::vector<VkPushConstantRange>& PushConstants) const
 	{
-		return std::make_unique<ComputePipeline>(Holder, DescriptorSetLayouts, Shader);
+		return std::make_unique<ComputePipeline>(Holder, DescriptorSetLayouts, Shader, PushConstants);
 	}
 
 	std::unique_ptr<Image> Device::CreateImage(Vec2ui Dimensions, VkImageUsageFlags Usage, VkFormat Format,
@@ -318,8 +395,127 @@ namespace Hermes::Vulkan
 		return std::make_unique<Image>(Holder, Dimensions, Usage, Format, MipLevels, true);
 	}
 
+	VkMemoryRequirements Device::GetBufferMemoryRequirements(size_t Size, VkBufferUsageFlags Usage) const
+	{
+		auto CreateInfo = Buffer::MakeCreateInfo(Size, Usage);
+
+		VkDeviceBufferMemoryRequirements RequirementsInfo = {};
+		RequirementsInfo.sType = VK_STRUCTURE_TYPE_DEVICE_BUFFER_MEMORY_REQUIREMENTS;
+		RequirementsInfo.pCreateInfo = &CreateInfo;
+
+		VkMemoryRequirements2 Result = {};
+		Result.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		vkGetDeviceBufferMemoryRequirements(Holder->Device, &RequirementsInfo, &Result);
+		return Result.memoryRequirements;
+	}
+
+	VkMemoryRequirements Device::GetImageMemoryRequirements(Vec2ui Dimensions, VkImageUsageFlags Usage, VkFormat Format,
+	                                                        uint32 MipLevels) const
+	{
+		auto CreateInfo = Image::MakeCreateInfo(Dimensions, Usage, Format, MipLevels, false);
+
+		VkDeviceImageMemoryRequirements RequirementsInfo = {};
+		RequirementsInfo.sType = VK_STRUCTURE_TYPE_DEVICE_IMAGE_MEMORY_REQUIREMENTS;
+		RequirementsInfo.pCreateInfo = &CreateInfo;
+
+		VkMemoryRequirements2 Result = {};
+		Result.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		vkGetDeviceImageMemoryRequirements(Holder->Device, &RequirementsInfo, &Result);
+		return Result.memoryRequirements;
+	}
+
+	std::unique_ptr<MemoryBlock> Device::AllocateMemory(const VkMemoryRequirements& Requirements) const
+	{
+		return std::make_unique<MemoryBlock>(Holder, Requirements);
+	}
+
+	std::unique_ptr<Buffer> Device::CreateAliasingBuffer(const MemoryBlock& Memory, size_t Size, VkBufferUsageFlags Usage) const
+	{
+		return std::make_unique<Buffer>(Holder, Memory, Size, Usage);
+	}
+
+	std::unique_ptr<Image> Device::CreateAliasingImage(const MemoryBlock& Memory, Vec2ui Dimensions, VkImageUsageFlags Usage,
+	                                                   VkFormat Format, uint32 MipLevels) const
+	{
+		return std::make_unique<Image>(Holder, Memory, Dimensions, Usage, Format, MipLevels);
+	}
+
 	void Device::WaitForIdle() const
 	{
 		vkDeviceWaitIdle(Holder->Device);
 	}
+
+	float Device::GetTimestampPeriod() const
+	{
+		return Properties.limits.timestampPeriod;
+	}
+
+	size_t Device::GetMinBufferOffsetAlignment() const
+	{
+		return std::max(Properties.limits.minUniformBufferOffsetAlignment, Properties.limits.minStorageBufferOffsetAlignment);
+	}
+
+	void Device::SavePipelineCache() const
+	{
+		size_t DataSize = 0;
+		VK_CHECK_RESULT(vkGetPipelineCacheData(Holder->Device, Holder->PipelineCache, &DataSize, nullptr));
+
+		std::vector<uint8> FileContents(sizeof(PipelineCacheFileHeader) + DataSize);
+		VK_CHECK_RESULT(vkGetPipelineCacheData(Holder->Device, Holder->PipelineCache, &DataSize, FileContents.data() + sizeof(PipelineCacheFileHeader)));
+
+		PipelineCacheFileHeader Header = {
+			.Magic = PipelineCacheFileHeader::ExpectedMagic,
+			.Version = PipelineCacheFileHeader::ExpectedVersion,
+			.VendorID = Properties.vendorID,
+			.DeviceID = Properties.deviceID,
+			.DriverVersion = Properties.driverVersion,
+			.PipelineCacheUUID = {},
+			.DataSize = DataSize
+		};
+		std::memcpy(Header.PipelineCacheUUID, Properties.pipelineCacheUUID, VK_UUID_SIZE);
+		std::memcpy(FileContents.data(), &Header, sizeof(Header));
+
+		auto File = VirtualFilesystem::Open(PipelineCachePath, FileOpenMode::CreateNew, FileAccessMode::ReadWrite);
+		if (!File || !File->Write(FileContents.data(), sizeof(PipelineCacheFileHeader) + DataSize))
+		{
+			HERMES_LOG_WARNING("Could not write the pipeline cache to %s", PipelineCachePath);
+			return;
+		}
+		HERMES_LOG_INFO("Saved %zu bytes of the pipeline cache to %s", DataSize, PipelineCachePath);
+	}
+
+	void Device::CreatePipelineCache()
+	{
+		VkPipelineCacheCreateInfo CreateInfo = {};
+		CreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+		// NOTE: a cache that cannot be used is not an error, the pipelines are just compiled from scratch
+		auto FileContents = VirtualFilesystem::ReadFileAsBytes(PipelineCachePath);
+		if (FileContents.has_value())
+		{
+			PipelineCacheFileHeader Header = {};
+			if (FileContents->size() >= sizeof(Header))
+				std::memcpy(&Header, FileContents->data(), sizeof(Header));
+
+			if (Header.Magic != PipelineCacheFileHeader::ExpectedMagic || Header.Version != PipelineCacheFileHeader::ExpectedVersion ||
+			    Header.DataSize != FileContents->size() - sizeof(Header))
+			{
+				HERMES_LOG_WARNING("Ignoring the pipeline cache in %s because it is corrupted", PipelineCachePath);
+			}
+			else if (Header.VendorID != Properties.vendorID || Header.DeviceID != Properties.deviceID ||
+			         Header.DriverVersion != Properties.driverVersion ||
+			         std::memcmp(Header.PipelineCacheUUID, Properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+			{
+				HERMES_LOG_INFO("Ignoring the pipeline cache in %s because it was created for a different GPU or driver", PipelineCachePath);
+			}
+			else
+			{
+				CreateInfo.initialDataSize = static_cast<size_t>(Header.DataSize);
+				CreateInfo.pInitialData = FileContents->data() + sizeof(Header);
+				HERMES_LOG_INFO("Loaded %zu bytes of the pipeline cache from %s", CreateInfo.initialDataSize, PipelineCachePath);
+			}
+		}
+
+		VK_CHECK_RESULT(vkCreatePipelineCache(Holder->Device, &CreateInfo, GVulkanAllocator, &Holder->PipelineCache));
+	}
 }
@@ -40,8 +40,35 @@ namespace Hermes::Vulkan
 		std::unique_ptr<Image> CreateCubemap(Vec2ui Dimensions, VkImageUsageFlags Usage, VkFormat Format,
 		                                     uint32 MipLevels) const;
 
+		/*
+		 * Returns the memory requirements of a buffer or an image that would be created with the same parameters
+		 * without creating it
+		 */
+		VkMemoryRequirements GetBufferMemoryRequirements(size_t Size, VkBufferUsageFlags Usage) const;
+		VkMemoryRequirements GetImageMemoryRequirements(Vec2ui Dimensions, VkImageUsageFlags Usage, VkFormat Format,
+		                                                uint32 MipLevels) const;
+
+		std::unique_ptr<MemoryBlock> AllocateMemory(const VkMemoryRequirements& Requirements) const;
+
+		/*
+		 * Creates a buffer or an image at the beginning of a memory block that the caller owns, the block must satisfy
+		 * the memory requirements of the resource
+		 */
+		std::unique_ptr<Buffer> CreateAliasingBuffer(const MemoryBlock& Memory, size_t Size, VkBufferUsageFlags Usage) const;
+		std::unique_ptr<Image> CreateAliasingImage(const MemoryBlock& Memory, Vec2ui Dimensions, VkImageUsageFlags Usage,
+		                                           VkFormat Format, uint32 MipLevels) const;
+
 		std::unique_ptr<Fence> CreateFence(bool InitialState = false) const;
 
+		/*
+		 * NOTE: not named CreateSemaphore because windows.h defines a macro with this name
+		 */
+		std::unique_ptr<Semaphore> CreateBinarySemaphore() const;
+
+		std::unique_ptr<TimelineSemaphore> CreateTimelineSemaphore(uint64 InitialValue = 0) const;
+
+		std::unique_ptr<QueryPool> CreateQueryPool(VkQueryType Type, uint32 QueryCount) const;
+
 		std::unique_ptr<Shader> CreateShader(const String& Path, VkShaderStageFlagBits Type) const;
 
 		std::unique_ptr<RenderPass> CreateRenderPass(
@@ -56,20 +83,40 @@ namespace Hermes::Vulkan
 		                                               Vec2ui Dimensions) const;
 
 		std::unique_ptr<DescriptorSetLayout> CreateDescriptorSetLayout(
-			const std::vector<VkDescriptorSetLayoutBinding>& Bindings) const;
+			const std::vector<VkDescriptorSetLayoutBinding>& Bindings,
+			const std::vector<VkDescriptorBindingFlags>& BindingFlags = {}) const;
 
 		std::unique_ptr<DescriptorSetPool> CreateDescriptorSetPool(uint32 NumberOfSets,
 		                                                           const std::vector<VkDescriptorPoolSize>& Subpools,
-		                                                           bool SupportIndividualDeallocations = false) const;
+		                                                           bool SupportIndividualDeallocations = false,
+		                                                           bool SupportUpdateAfterBind = false) const;
 
 		std::unique_ptr<Sampler> CreateSampler(const SamplerDescription& Description) const;
 
-		std::unique_ptr<ComputePipeline> CreateComputePipeline(const std::vector<const DescriptorSetLayout*>& DescriptorSetLayouts, const Shader& Shader) const;
+		std::unique_ptr<ComputePipeline> CreateComputePipeline(const std::vector<const DescriptorSetLayout*>& DescriptorSetLayouts, const Shader& Shader,
+		                                                       const std::vector<VkPushConstantRange>& PushConstants = {}) const;
 
 		void WaitForIdle() const;
 
+		/*
+		 * Writes the pipeline cache to the virtual filesystem, the next device that is created for the same GPU and
+		 * driver loads it, so that the pipelines compiled in this run do not have to be compiled again
+		 */
+		void SavePipelineCache() const;
+
+		/*
+		 * Number of nanoseconds it takes for a timestamp query to be incremented by 1
+		 */
+		float GetTimestampPeriod() const;
+
+		/*
+		 * Smallest alignment that is valid for the offset of any uniform or storage buffer descriptor (including dynamic offsets)
+		 */
+		size_t GetMinBufferOffsetAlignment() const;
+
 		VmaAllocator GetAllocator() const { return Holder->Allocator; }
 		VkDevice GetDevice() const { return Holder->Device; }
+		VkPhysicalDevice GetPhysicalDevice() const { return Holder->PhysicalDevice; }
 
 	private:
 		struct VkDeviceHolder
@@ -85,6 +132,8 @@ namespace Hermes::Vulkan
 			VkDevice Device = VK_NULL_HANDLE;
 			VkPhysicalDevice PhysicalDevice = VK_NULL_HANDLE;
 			VmaAllocator Allocator = VK_NULL_HANDLE;
+			// Used by every pipeline creation
+			VkPipelineCache PipelineCache = VK_NULL_HANDLE;
 
 			VkQueue PresentationQueue = VK_NULL_HANDLE;
 		};
@@ -92,12 +141,17 @@ namespace Hermes::Vulkan
 		std::shared_ptr<VkDeviceHolder> Holder;
 		const IPlatformWindow& Window;
 
+		VkPhysicalDeviceProperties Properties = {};
+
 		std::unique_ptr<Queue> GraphicsQueue;
 		std::unique_ptr<Queue> TransferQueue;
 		std::unique_ptr<Queue> ComputeQueue;
 
+		void CreatePipelineCache();
+
 		friend class Buffer;
 		friend class CommandBuffer;
+		friend class CommandPool;
 		friend class ComputePipeline;
 		friend class DescriptorSet;
 		friend class DescriptorSetLayout;
@@ -106,11 +160,15 @@ namespace Hermes::Vulkan
 		friend class Framebuffer;
 		friend class Image;
 		friend class ImageView;
+		friend class MemoryBlock;
 		friend class Pipeline;
+		friend class QueryPool;
 		friend class Queue;
 		friend class RenderPass;
 		friend class Sampler;
+		friend class Semaphore;
 		friend class Shader;
 		friend class Swapchain;
+		friend class TimelineSemaphore;
 	};
 }
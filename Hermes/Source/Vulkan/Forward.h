@@ -4,6 +4,7 @@ namespace Hermes::Vulkan
 {
 	class Buffer;
 	class CommandBuffer;
+	class CommandPool;
 	class ComputePipeline;
 	class DescriptorSet;
 	class DescriptorSetLayout;
@@ -14,13 +15,17 @@ namespace Hermes::Vulkan
 	class Image;
 	class ImageView;
 	class Instance;
+	class MemoryBlock;
 	class Queue;
 	class Pipeline;
+	class QueryPool;
 	class Queue;
 	class RenderPass;
 	class Sampler;
+	class Semaphore;
 	class Shader;
 	class Swapchain;
+	class TimelineSemaphore;
 
 	struct DeviceProperties;
 	struct PipelineDescription;
@@ -2,6 +2,8 @@
 
 #include <algorithm>
 
+#include "Vulkan/MemoryBlock.h"
+
 namespace Hermes::Vulkan
 {
 	uint32 CubemapSideToArrayLayer(CubemapSide Side)
@@ -77,25 +79,7 @@ namespace Hermes::Vulkan
 		Holder->Format = InFormat;
 		Holder->Dimensions = InDimensions;
 
-		VkImageCreateInfo CreateInfo = {};
-		CreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-		CreateInfo.extent.width = Holder->Dimensions.X;
-		CreateInfo.extent.height = Holder->Dimensions.Y;
-		CreateInfo.extent.depth = 1;
-		CreateInfo.arrayLayers = IsCubemapCompatible ? 6 : 1;
-		CreateInfo.format = Holder->Format;
-		CreateInfo.usage = InUsage;
-		CreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		CreateInfo.imageType = VK_IMAGE_TYPE_2D;
-		CreateInfo.mipLevels = InMipLevels;
-		CreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-		CreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL; // TODO
-		CreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // TODO: perhaps we should allow the user to change this?
-		// FIXME: this might have some impact on performance, we should only set this if it's reasonable to assume
-		//        that the image might be used with different formats (e.g. SRGB/UNORM)
-		CreateInfo.flags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
-		if (IsCubemapCompatible)
-			CreateInfo.flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+		auto CreateInfo = MakeCreateInfo(Holder->Dimensions, InUsage, Holder->Format, InMipLevels, IsCubemapCompatible);
 
 		VmaAllocationCreateInfo AllocationInfo = {};
 		AllocationInfo.usage = VMA_MEMORY_USAGE_AUTO;
@@ -106,6 +90,22 @@ namespace Hermes::Vulkan
 		Holder->IsOwned = true;
 	}
 
+	Image::Image(std::shared_ptr<Device::VkDeviceHolder> InDevice, const MemoryBlock& Memory, Vec2ui InDimensions,
+	             VkImageUsageFlags InUsage, VkFormat InFormat, uint32 InMipLevels)
+		: Holder(std::make_shared<VkImageHolder>())
+		, MipLevelCount(InMipLevels)
+		, IsCubemapCompatible(false)
+	{
+		Holder->Device = std::move(InDevice);
+		Holder->Format = InFormat;
+		Holder->Dimensions = InDimensions;
+
+		auto CreateInfo = MakeCreateInfo(Holder->Dimensions, InUsage, Holder->Format, InMipLevels, IsCubemapCompatible);
+		VK_CHECK_RESULT(vmaCreateAliasingImage(Holder->Device->Allocator, Memory.GetAllocation(), &CreateInfo, &Holder->Image))
+
+		Holder->IsOwned = true;
+	}
+
 	std::unique_ptr<ImageView> Image::CreateImageView(const VkImageSubresourceRange& Range) const
 	{
 		return std::make_unique<ImageView>(Holder, Range, Holder->Format, false);
@@ -182,6 +182,32 @@ namespace Hermes::Vulkan
 		return Holder->Image;
 	}
 
+	VkImageCreateInfo Image::MakeCreateInfo(Vec2ui Dimensions, VkImageUsageFlags Usage, VkFormat Format,
+	                                        uint32 MipLevels, bool IsCubemapCompatible)
+	{
+		VkImageCreateInfo CreateInfo = {};
+		CreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		CreateInfo.extent.width = Dimensions.X;
+		CreateInfo.extent.height = Dimensions.Y;
+		CreateInfo.extent.depth = 1;
+		CreateInfo.arrayLayers = IsCubemapCompatible ? 6 : 1;
+		CreateInfo.format = Format;
+		CreateInfo.usage = Usage;
+		CreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		CreateInfo.imageType = VK_IMAGE_TYPE_2D;
+		CreateInfo.mipLevels = MipLevels;
+		CreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		CreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL; // TODO
+		CreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // TODO: perhaps we should allow the user to change this?
+		// FIXME: this might have some impact on performance, we should only set this if it's reasonable to assume
+		//        that the image might be used with different formats (e.g. SRGB/UNORM)
+		CreateInfo.flags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
+		if (IsCubemapCompatible)
+			CreateInfo.flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+
+		return CreateInfo;
+	}
+
 	Image::VkImageHolder::~VkImageHolder()
 	{
 		if (IsOwned)
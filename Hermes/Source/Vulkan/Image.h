@@ -55,6 +55,12 @@ namespace Hermes::Vulkan
 		Image(std::shared_ptr<Device::VkDeviceHolder> InDevice, Vec2ui InDimensions, VkImageUsageFlags InUsage,
 		      VkFormat InFormat, uint32 InMipLevels, bool InIsCubemapCompatible);
 
+		/*
+		 * Aliasing constructor, the image is placed into a memory block that it does not own
+		 */
+		Image(std::shared_ptr<Device::VkDeviceHolder> InDevice, const MemoryBlock& Memory, Vec2ui InDimensions,
+		      VkImageUsageFlags InUsage, VkFormat InFormat, uint32 InMipLevels);
+
 		/*
 		 * Creates image view for given subresource range
 		 */
@@ -114,6 +120,7 @@ namespace Hermes::Vulkan
 			std::shared_ptr<Device::VkDeviceHolder> Device;
 
 			VkImage Image = VK_NULL_HANDLE;
+			// NOTE: null for images that are placed into a MemoryBlock
 			VmaAllocation Allocation = VK_NULL_HANDLE;
 			VkFormat Format = VK_FORMAT_UNDEFINED;
 			Vec2ui Dimensions;
@@ -125,6 +132,10 @@ namespace Hermes::Vulkan
 		uint32 MipLevelCount = 0;
 		bool IsCubemapCompatible = false;
 
+		static VkImageCreateInfo MakeCreateInfo(Vec2ui Dimensions, VkImageUsageFlags Usage, VkFormat Format,
+		                                        uint32 MipLevels, bool IsCubemapCompatible);
+
+		friend class Device;
 		friend class ImageView;
 	};
 
@@ -0,0 +1,29 @@
+#include "MemoryBlock.h"
+
+namespace Hermes::Vulkan
+{
+	MemoryBlock::MemoryBlock(std::shared_ptr<Device::VkDeviceHolder> InDevice, const VkMemoryRequirements& Requirements)
+		: Device(std::move(InDevice))
+		, Size(Requirements.size)
+	{
+		VmaAllocationCreateInfo AllocationInfo = {};
+		AllocationInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		AllocationInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+		VK_CHECK_RESULT(vmaAllocateMemory(Device->Allocator, &Requirements, &AllocationInfo, &Allocation, nullptr));
+	}
+
+	MemoryBlock::~MemoryBlock()
+	{
+		vmaFreeMemory(Device->Allocator, Allocation);
+	}
+
+	VkDeviceSize MemoryBlock::GetSize() const
+	{
+		return Size;
+	}
+
+	VmaAllocation MemoryBlock::GetAllocation() const
+	{
+		return Allocation;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+
+#include "Core/Core.h"
+#include "Core/Misc/NonCopyableMovable.h"
+#include "Vulkan/Device.h"
+#include "Vulkan/VulkanCore.h"
+
+namespace Hermes::Vulkan
+{
+	/*
+	 * A block of device local memory that is not bound to any resource on its own
+	 *
+	 * Images and buffers are placed into it with Device::CreateAliasingImage() and Device::CreateAliasingBuffer(), several
+	 * of them can share the same block as long as they are not used at the same time.
+	 * NOTE: the block must outlive all resources that were placed into it
+	 */
+	class HERMES_API MemoryBlock
+	{
+		MAKE_NON_COPYABLE(MemoryBlock)
+		MAKE_NON_MOVABLE(MemoryBlock)
+
+	public:
+		MemoryBlock(std::shared_ptr<Device::VkDeviceHolder> InDevice, const VkMemoryRequirements& Requirements);
+
+		~MemoryBlock();
+
+		VkDeviceSize GetSize() const;
+
+		VmaAllocation GetAllocation() const;
+
+	private:
+		std::shared_ptr<Device::VkDeviceHolder> Device;
+
+		VmaAllocation Allocation = VK_NULL_HANDLE;
+		VkDeviceSize Size = 0;
+	};
+}
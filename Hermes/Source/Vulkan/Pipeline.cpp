@@ -169,6 +169,6 @@ namespace Hermes::Vulkan
 			CreateInfo.pNext = &PipelineRenderingCreateInfo;
 		}
 
-		vkCreateGraphicsPipelines(Device->Device, VK_NULL_HANDLE, 1, &CreateInfo, GVulkanAllocator, &Handle);
+		vkCreateGraphicsPipelines(Device->Device, Device->PipelineCache, 1, &CreateInfo, GVulkanAllocator, &Handle);
 	}
 }
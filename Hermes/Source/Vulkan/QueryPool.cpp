@@ -0,0 +1,53 @@
+#include "QueryPool.h"
+
+namespace Hermes::Vulkan
+{
+	QueryPool::QueryPool(std::shared_ptr<Device::VkDeviceHolder> InDevice, VkQueryType InType, uint32 InQueryCount)
+		: Device(std::move(InDevice))
+		, QueryCount(InQueryCount)
+	{
+		VkQueryPoolCreateInfo CreateInfo = {};
+		CreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		CreateInfo.queryType = InType;
+		CreateInfo.queryCount = QueryCount;
+		VK_CHECK_RESULT(vkCreateQueryPool(Device->Device, &CreateInfo, GVulkanAllocator, &Handle));
+
+		// NOTE: queries start in an undefined state and cannot be written before they are reset
+		Reset(0, QueryCount);
+	}
+
+	QueryPool::~QueryPool()
+	{
+		vkDestroyQueryPool(Device->Device, Handle, GVulkanAllocator);
+	}
+
+	void QueryPool::Reset(uint32 FirstQuery, uint32 Count)
+	{
+		HERMES_ASSERT(FirstQuery + Count <= QueryCount);
+		vkResetQueryPool(Device->Device, Handle, FirstQuery, Count);
+	}
+
+	bool QueryPool::GetResults(uint32 FirstQuery, std::span<uint64> Results) const
+	{
+		HERMES_ASSERT(FirstQuery + Results.size() <= QueryCount);
+		if (Results.empty())
+			return true;
+
+		VkResult Result = vkGetQueryPoolResults(Device->Device, Handle, FirstQuery, static_cast<uint32>(Results.size()),
+		                                        Results.size_bytes(), Results.data(), sizeof(uint64), VK_QUERY_RESULT_64_BIT);
+		if (Result == VK_NOT_READY)
+			return false;
+		VK_CHECK_RESULT(Result);
+		return true;
+	}
+
+	uint32 QueryPool::GetQueryCount() const
+	{
+		return QueryCount;
+	}
+
+	VkQueryPool QueryPool::GetQueryPool() const
+	{
+		return Handle;
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <span>
+
+#include "Core/Core.h"
+#include "Core/Misc/NonCopyableMovable.h"
+#include "Vulkan/Device.h"
+#include "Vulkan/VulkanCore.h"
+
+namespace Hermes::Vulkan
+{
+	/*
+	 * A wrapper around VkQueryPool, a fixed number of queries of one type (e.g. timestamps) whose results the GPU writes
+	 * and the CPU reads back once the commands that wrote them have finished
+	 */
+	class HERMES_API QueryPool
+	{
+		MAKE_NON_COPYABLE(QueryPool)
+		MAKE_NON_MOVABLE(QueryPool)
+
+	public:
+		QueryPool(std::shared_ptr<Device::VkDeviceHolder> InDevice, VkQueryType InType, uint32 InQueryCount);
+
+		~QueryPool();
+
+		/*
+		 * Resets the queries from the CPU, they must not be used by any pending command buffer
+		 */
+		void Reset(uint32 FirstQuery, uint32 Count);
+
+		/*
+		 * Reads the 64-bit results of the queries without waiting, returns false if some of them are not available yet
+		 */
+		bool GetResults(uint32 FirstQuery, std::span<uint64> Results) const;
+
+		uint32 GetQueryCount() const;
+
+		VkQueryPool GetQueryPool() const;
+
+	private:
+		std::shared_ptr<Device::VkDeviceHolder> Device;
+
+		VkQueryPool Handle = VK_NULL_HANDLE;
+		uint32 QueryCount = 0;
+	};
+}
@@ -1,7 +1,11 @@
 #include "Queue.h"
 
-#include "Vulkan/Fence.h"
+#include <vector>
+
 #include "Vulkan/CommandBuffer.h"
+#include "Vulkan/CommandPool.h"
+#include "Vulkan/Fence.h"
+#include "Vulkan/Semaphore.h"
 
 namespace Hermes::Vulkan
 {
@@ -13,11 +17,13 @@ namespace Hermes::Vulkan
 
 		vkGetDeviceQueue(Holder->Device->Device, QueueFamilyIndex, 0, &Holder->Queue);
 
-		VkCommandPoolCreateInfo CreateInfo = {};
-		CreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		CreateInfo.queueFamilyIndex = QueueFamilyIndex;
-		CreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-		VK_CHECK_RESULT(vkCreateCommandPool(Holder->Device->Device, &CreateInfo, GVulkanAllocator, &Holder->CommandPool));
+		uint32 QueueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(Holder->Device->PhysicalDevice, &QueueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> QueueFamilies(QueueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(Holder->Device->PhysicalDevice, &QueueFamilyCount, QueueFamilies.data());
+		TimestampValidBits = QueueFamilies[QueueFamilyIndex].timestampValidBits;
+
+		DefaultCommandPool = CreateCommandPool();
 	}
 		
 	// Because VkQueue is automatically destroyed (released) when VkDevice is
@@ -28,16 +34,84 @@ namespace Hermes::Vulkan
 
 	std::unique_ptr<CommandBuffer> Queue::CreateCommandBuffer(bool IsPrimaryBuffer/* = true*/) const
 	{
-		return std::make_unique<CommandBuffer>(Holder, IsPrimaryBuffer);
+		return DefaultCommandPool->CreateCommandBuffer(IsPrimaryBuffer);
+	}
+
+	std::unique_ptr<CommandPool> Queue::CreateCommandPool(VkCommandPoolCreateFlags Flags/* = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT*/) const
+	{
+		return std::make_unique<CommandPool>(Holder->Device, QueueFamilyIndex, Flags);
 	}
 
 	void Queue::SubmitCommandBuffer(const CommandBuffer& Buffer, std::optional<Fence*> Fence) const
-	{;
+	{
+		SubmitCommandBuffer(Buffer, {}, {}, Fence);
+	}
+
+	void Queue::SubmitCommandBuffer(const CommandBuffer& Buffer, std::span<const SemaphoreWait> WaitSemaphores,
+	                                std::span<const Semaphore* const> SignalSemaphores, std::optional<Fence*> Fence) const
+	{
+		SubmitCommandBuffer(Buffer, WaitSemaphores, SignalSemaphores, {}, Fence);
+	}
+
+	void Queue::SubmitCommandBuffer(const CommandBuffer& Buffer, std::span<const SemaphoreWait> WaitSemaphores,
+	                                std::span<const Semaphore* const> SignalSemaphores,
+	                                std::span<const TimelineSemaphoreSignal> TimelineSignals, std::optional<Fence*> Fence) const
+	{
+		SubmitCommandBuffer(Buffer, WaitSemaphores, {}, SignalSemaphores, TimelineSignals, Fence);
+	}
+
+	void Queue::SubmitCommandBuffer(const CommandBuffer& Buffer, std::span<const SemaphoreWait> WaitSemaphores,
+	                                std::span<const TimelineSemaphoreWait> TimelineWaits, std::span<const Semaphore* const> SignalSemaphores,
+	                                std::span<const TimelineSemaphoreSignal> TimelineSignals, std::optional<Fence*> Fence) const
+	{
+		std::vector<VkSemaphore> WaitSemaphoreHandles, SignalSemaphoreHandles;
+		std::vector<VkPipelineStageFlags> WaitStages;
+		WaitSemaphoreHandles.reserve(WaitSemaphores.size() + TimelineWaits.size());
+		WaitStages.reserve(WaitSemaphores.size() + TimelineWaits.size());
+		for (const auto& Wait : WaitSemaphores)
+		{
+			WaitSemaphoreHandles.push_back(Wait.Semaphore->GetSemaphore());
+			WaitStages.push_back(Wait.Stages);
+		}
+
+		std::vector<uint64> WaitValues(WaitSemaphores.size(), 0);
+		for (const auto& Wait : TimelineWaits)
+		{
+			WaitSemaphoreHandles.push_back(Wait.Semaphore->GetSemaphore());
+			WaitStages.push_back(Wait.Stages);
+			WaitValues.push_back(Wait.Value);
+		}
+		SignalSemaphoreHandles.reserve(SignalSemaphores.size() + TimelineSignals.size());
+		for (const auto* Semaphore : SignalSemaphores)
+			SignalSemaphoreHandles.push_back(Semaphore->GetSemaphore());
+
+		// NOTE: there has to be a value for every signaled semaphore, the values of binary semaphores are ignored
+		std::vector<uint64> SignalValues(SignalSemaphores.size(), 0);
+		for (const auto& Signal : TimelineSignals)
+		{
+			SignalSemaphoreHandles.push_back(Signal.Semaphore->GetSemaphore());
+			SignalValues.push_back(Signal.Value);
+		}
+
+		VkTimelineSemaphoreSubmitInfo TimelineSubmitInfo = {};
+		TimelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		TimelineSubmitInfo.waitSemaphoreValueCount = static_cast<uint32>(WaitValues.size());
+		TimelineSubmitInfo.pWaitSemaphoreValues = WaitValues.data();
+		TimelineSubmitInfo.signalSemaphoreValueCount = static_cast<uint32>(SignalValues.size());
+		TimelineSubmitInfo.pSignalSemaphoreValues = SignalValues.data();
+
 		VkSubmitInfo SubmitInfo = {};
 		SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		if (!TimelineWaits.empty() || !TimelineSignals.empty())
+			SubmitInfo.pNext = &TimelineSubmitInfo;
 		SubmitInfo.commandBufferCount = 1;
 		VkCommandBuffer TmpBufferCopy = Buffer.GetBuffer();
 		SubmitInfo.pCommandBuffers = &TmpBufferCopy;
+		SubmitInfo.waitSemaphoreCount = static_cast<uint32>(WaitSemaphoreHandles.size());
+		SubmitInfo.pWaitSemaphores = WaitSemaphoreHandles.data();
+		SubmitInfo.pWaitDstStageMask = WaitStages.data();
+		SubmitInfo.signalSemaphoreCount = static_cast<uint32>(SignalSemaphoreHandles.size());
+		SubmitInfo.pSignalSemaphores = SignalSemaphoreHandles.data();
 		VkFence VkFenceHandle = VK_NULL_HANDLE;
 		if (Fence.has_value())
 			VkFenceHandle = Fence.value()->GetFence();
@@ -59,8 +133,8 @@ namespace Hermes::Vulkan
 		return QueueFamilyIndex;
 	}
 
-	Queue::VkQueueHolder::~VkQueueHolder()
+	uint32 Queue::GetTimestampValidBits() const
 	{
-		vkDestroyCommandPool(Device->Device, CommandPool, GVulkanAllocator);
+		return TimestampValidBits;
 	}
 }
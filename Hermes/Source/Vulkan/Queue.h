@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <optional>
+#include <span>
 
 #include "Core/Core.h"
 #include "Core/Misc/DefaultConstructors.h"
@@ -13,7 +14,35 @@
 namespace Hermes::Vulkan
 {
 	/*
-	 * A wrapper around VkQueue object and a VkCommandPool that was created for this particular queue
+	 * A semaphore that a queue submission waits on before executing the given pipeline stages
+	 */
+	struct SemaphoreWait
+	{
+		const Semaphore* Semaphore;
+		VkPipelineStageFlags Stages;
+	};
+
+	/*
+	 * A timeline semaphore that a queue submission waits to reach Value before executing the given pipeline stages
+	 */
+	struct TimelineSemaphoreWait
+	{
+		const TimelineSemaphore* Semaphore;
+		uint64 Value;
+		VkPipelineStageFlags Stages;
+	};
+
+	/*
+	 * A timeline semaphore that a queue submission sets to Value once all its work has finished
+	 */
+	struct TimelineSemaphoreSignal
+	{
+		const TimelineSemaphore* Semaphore;
+		uint64 Value;
+	};
+
+	/*
+	 * A wrapper around VkQueue object and a default CommandPool that was created for this particular queue
 	 */
 	class HERMES_API Queue
 	{
@@ -25,16 +54,40 @@ namespace Hermes::Vulkan
 
 		~Queue();
 
+		/*
+		 * Allocates the command buffer from the default pool of the queue, that pool must only be used from one thread
+		 */
 		std::unique_ptr<CommandBuffer> CreateCommandBuffer(bool IsPrimaryBuffer = true) const;
 
+		/*
+		 * Creates a new command pool for the family of this queue, e.g. for recording on a worker thread
+		 */
+		std::unique_ptr<CommandPool> CreateCommandPool(VkCommandPoolCreateFlags Flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT) const;
+
 		void SubmitCommandBuffer(const CommandBuffer& Buffer, std::optional<Fence*> Fence) const;
 
+		void SubmitCommandBuffer(const CommandBuffer& Buffer, std::span<const SemaphoreWait> WaitSemaphores,
+		                         std::span<const Semaphore* const> SignalSemaphores, std::optional<Fence*> Fence) const;
+
+		void SubmitCommandBuffer(const CommandBuffer& Buffer, std::span<const SemaphoreWait> WaitSemaphores,
+		                         std::span<const Semaphore* const> SignalSemaphores,
+		                         std::span<const TimelineSemaphoreSignal> TimelineSignals, std::optional<Fence*> Fence) const;
+
+		void SubmitCommandBuffer(const CommandBuffer& Buffer, std::span<const SemaphoreWait> WaitSemaphores,
+		                         std::span<const TimelineSemaphoreWait> TimelineWaits, std::span<const Semaphore* const> SignalSemaphores,
+		                         std::span<const TimelineSemaphoreSignal> TimelineSignals, std::optional<Fence*> Fence) const;
+
 		void WaitForIdle() const;
 
 		VkQueue GetQueue() const;
 
 		uint32 GetQueueFamilyIndex() const;
 
+		/*
+		 * Number of meaningful bits in the timestamps written by this queue, 0 if it does not support timestamps
+		 */
+		uint32 GetTimestampValidBits() const;
+
 	private:
 		struct VkQueueHolder
 		{
@@ -42,16 +95,14 @@ namespace Hermes::Vulkan
 			MAKE_NON_MOVABLE(VkQueueHolder)
 			ADD_DEFAULT_CONSTRUCTOR(VkQueueHolder)
 
-			~VkQueueHolder();
-
 			std::shared_ptr<Device::VkDeviceHolder> Device;
 			VkQueue Queue = VK_NULL_HANDLE;
-			VkCommandPool CommandPool = VK_NULL_HANDLE;
 		};
 
 		std::shared_ptr<VkQueueHolder> Holder;
 		uint32 QueueFamilyIndex = 0;
+		uint32 TimestampValidBits = 0;
 
-		friend class CommandBuffer;
+		std::unique_ptr<CommandPool> DefaultCommandPool;
 	};
 }
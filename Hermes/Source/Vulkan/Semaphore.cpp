@@ -0,0 +1,63 @@
+﻿#include "Semaphore.h"
+
+namespace Hermes::Vulkan
+{
+	Semaphore::Semaphore(std::shared_ptr<Device::VkDeviceHolder> InDevice)
+		: Device(std::move(InDevice))
+	{
+		VkSemaphoreCreateInfo CreateInfo = {};
+		CreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		VK_CHECK_RESULT(vkCreateSemaphore(Device->Device, &CreateInfo, GVulkanAllocator, &Handle));
+	}
+
+	Semaphore::~Semaphore()
+	{
+		vkDestroySemaphore(Device->Device, Handle, GVulkanAllocator);
+	}
+
+	VkSemaphore Semaphore::GetSemaphore() const
+	{
+		return Handle;
+	}
+
+	TimelineSemaphore::TimelineSemaphore(std::shared_ptr<Device::VkDeviceHolder> InDevice, uint64 InitialValue)
+		: Device(std::move(InDevice))
+	{
+		VkSemaphoreTypeCreateInfo TypeCreateInfo = {};
+		TypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		TypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		TypeCreateInfo.initialValue = InitialValue;
+
+		VkSemaphoreCreateInfo CreateInfo = {};
+		CreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		CreateInfo.pNext = &TypeCreateInfo;
+		VK_CHECK_RESULT(vkCreateSemaphore(Device->Device, &CreateInfo, GVulkanAllocator, &Handle));
+	}
+
+	TimelineSemaphore::~TimelineSemaphore()
+	{
+		vkDestroySemaphore(Device->Device, Handle, GVulkanAllocator);
+	}
+
+	uint64 TimelineSemaphore::GetValue() const
+	{
+		uint64 Value = 0;
+		VK_CHECK_RESULT(vkGetSemaphoreCounterValue(Device->Device, Handle, &Value));
+		return Value;
+	}
+
+	bool TimelineSemaphore::Wait(uint64 Value, uint64 Timeout) const
+	{
+		VkSemaphoreWaitInfo WaitInfo = {};
+		WaitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		WaitInfo.semaphoreCount = 1;
+		WaitInfo.pSemaphores = &Handle;
+		WaitInfo.pValues = &Value;
+		return vkWaitSemaphores(Device->Device, &WaitInfo, Timeout) == VK_SUCCESS;
+	}
+
+	VkSemaphore TimelineSemaphore::GetSemaphore() const
+	{
+		return Handle;
+	}
+}
@@ -0,0 +1,68 @@
+﻿#pragma once
+
+#include <memory>
+
+#include "Core/Core.h"
+#include "Core/Misc/NonCopyableMovable.h"
+#include "Vulkan/Device.h"
+#include "Vulkan/VulkanCore.h"
+
+namespace Hermes::Vulkan
+{
+	/*
+	 * A wrapper around binary VkSemaphore, a GPU-to-GPU synchronization primitive that orders queue submissions
+	 * and presentation without blocking the CPU
+	 */
+	class HERMES_API Semaphore
+	{
+		MAKE_NON_COPYABLE(Semaphore)
+		MAKE_NON_MOVABLE(Semaphore)
+
+	public:
+		explicit Semaphore(std::shared_ptr<Device::VkDeviceHolder> InDevice);
+
+		~Semaphore();
+
+		VkSemaphore GetSemaphore() const;
+
+	private:
+		std::shared_ptr<Device::VkDeviceHolder> Device;
+
+		VkSemaphore Handle = VK_NULL_HANDLE;
+	};
+
+	/*
+	 * A wrapper around timeline VkSemaphore, which holds a monotonically increasing 64-bit value instead of a binary
+	 * state. Queue submissions signal it with a new value and the CPU can query or wait for a value without any
+	 * resetting, so a single timeline semaphore can track any number of submissions
+	 */
+	class HERMES_API TimelineSemaphore
+	{
+		MAKE_NON_COPYABLE(TimelineSemaphore)
+		MAKE_NON_MOVABLE(TimelineSemaphore)
+
+	public:
+		TimelineSemaphore(std::shared_ptr<Device::VkDeviceHolder> InDevice, uint64 InitialValue);
+
+		~TimelineSemaphore();
+
+		/*
+		 * Returns the value of the last signal operation that has completed
+		 */
+		uint64 GetValue() const;
+
+		/*
+		 * Blocks current thread for at most Timeout nanoseconds waiting until the value is at least Value
+		 *
+		 * Returns true if the value was reached
+		 */
+		bool Wait(uint64 Value, uint64 Timeout) const;
+
+		VkSemaphore GetSemaphore() const;
+
+	private:
+		std::shared_ptr<Device::VkDeviceHolder> Device;
+
+		VkSemaphore Handle = VK_NULL_HANDLE;
+	};
+}
@@ -7,8 +7,8 @@
 #include "Core/Profiling.h"
 #include "Math/Math.h"
 #include "Platform/GenericPlatform/PlatformWindow.h"
-#include "Vulkan/Fence.h"
 #include "Vulkan/Image.h"
+#include "Vulkan/Semaphore.h"
 
 namespace Hermes::Vulkan
 {
@@ -73,15 +73,17 @@ namespace Hermes::Vulkan
 		return *Images[Index];
 	}
 
-	std::optional<uint32> Swapchain::AcquireImage(uint64 Timeout, const Fence& Fence, bool& SwapchainWasRecreated)
+	std::optional<uint32> Swapchain::AcquireImage(uint64 Timeout, const Semaphore& Semaphore, bool& SwapchainWasRecreated)
 	{
 		HERMES_PROFILE_FUNC();
 		uint32 Result;
-		VkResult Error = vkAcquireNextImageKHR(Device->Device, Handle, Timeout, VK_NULL_HANDLE, Fence.GetFence(),
+		VkResult Error = vkAcquireNextImageKHR(Device->Device, Handle, Timeout, Semaphore.GetSemaphore(), VK_NULL_HANDLE,
 		                                       &Result);
-		if (Error == VK_SUCCESS)
+		// NOTE: a suboptimal image was still acquired and the semaphore will be signaled, so it has to be used and presented;
+		//       the swapchain is then recreated by Present()
+		if (Error == VK_SUCCESS || Error == VK_SUBOPTIMAL_KHR)
 			return Result;
-		if (Error == VK_SUBOPTIMAL_KHR || Error == VK_ERROR_OUT_OF_DATE_KHR)
+		if (Error == VK_ERROR_OUT_OF_DATE_KHR)
 		{
 			RecreateSwapchain(static_cast<uint32>(Images.size()));
 			SwapchainWasRecreated = true;
@@ -93,17 +95,19 @@ namespace Hermes::Vulkan
 		return {};
 	}
 
-	void Swapchain::Present(uint32 ImageIndex, bool& SwapchainWasRecreated)
+	void Swapchain::Present(uint32 ImageIndex, const Semaphore& WaitSemaphore, bool& SwapchainWasRecreated)
 	{
 		HERMES_PROFILE_FUNC();
 		VkPresentInfoKHR Info = {};
 		VkResult Result;
+		VkSemaphore WaitSemaphoreHandle = WaitSemaphore.GetSemaphore();
 		Info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 		Info.pResults = &Result;
 		Info.pImageIndices = &ImageIndex;
 		Info.pSwapchains = &Handle;
 		Info.swapchainCount = 1;
-		Info.waitSemaphoreCount = 0;
+		Info.waitSemaphoreCount = 1;
+		Info.pWaitSemaphores = &WaitSemaphoreHandle;
 		{
 			vkQueuePresentKHR(Device->PresentationQueue, &Info);
 			HERMES_PROFILE_FRAME();
@@ -124,6 +128,8 @@ namespace Hermes::Vulkan
 
 	void Swapchain::RecreateSwapchain(uint32 NumFrames)
 	{
+		// The images might still be in use by frames that are in flight
+		VK_CHECK_RESULT(vkDeviceWaitIdle(Device->Device));
 		Images.clear();
 
 		auto NewDimensions = Window.GetSize();
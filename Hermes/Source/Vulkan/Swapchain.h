@@ -29,21 +29,23 @@ namespace Hermes::Vulkan
 
 		/*
 		 * Tries to acquire the index of the next swapchain image that the application can draw to. Blocks current thread
+		 * only until the index is known, the image itself might still be in use by the presentation engine
 		 *
 		 * @param Timeout Number of nanoseconds to block the current thread for while waiting for the image to become available
-		 * @param Fence Fence object that will be signaled when the presentation engine no
-		 *              longer needs the image, so the application can start using it
+		 * @param Semaphore Semaphore object that will be signaled when the presentation engine no
+		 *                  longer needs the image, so the GPU can start using it
 		 * @param SwapchainWasRecreated Is set to true if the swapchain images were changed (e.g. swapchain was resized)
 		 */
-		std::optional<uint32> AcquireImage(uint64 Timeout, const Fence& Fence, bool& SwapchainWasRecreated);
+		std::optional<uint32> AcquireImage(uint64 Timeout, const Semaphore& Semaphore, bool& SwapchainWasRecreated);
 
 		/*
-		 * Presents an image with the given index (that must have been previously acquired via AcquireImage()). Blocking
+		 * Presents an image with the given index (that must have been previously acquired via AcquireImage())
 		 *
 		 * @param ImageIndex Index of the swapchain image to present
+		 * @param WaitSemaphore Semaphore that is signaled when rendering to the image is finished
 		 * @param SwapchainWasRecreated Is set to true if the swapchain images were changed (e.g. swapchain was resized)
 		 */
-		void Present(uint32 ImageIndex, bool& SwapchainWasRecreated);
+		void Present(uint32 ImageIndex, const Semaphore& WaitSemaphore, bool& SwapchainWasRecreated);
 
 		VkFormat GetImageFormat() const;
 
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include "Core/Misc/RangeAllocator.h"
+
+using namespace Hermes;
+
+TEST(TestRangeAllocator, AllocateSequentially)
+{
+	RangeAllocator Allocator(100);
+
+	EXPECT_EQ(Allocator.Allocate(10), 0);
+	EXPECT_EQ(Allocator.Allocate(20), 10);
+	EXPECT_EQ(Allocator.Allocate(70), 30);
+	EXPECT_EQ(Allocator.GetAllocatedSize(), 100);
+	EXPECT_FALSE(Allocator.Allocate(1).has_value());
+}
+
+TEST(TestRangeAllocator, Alignment)
+{
+	RangeAllocator Allocator(100);
+
+	EXPECT_EQ(Allocator.Allocate(5), 0);
+	// Alignment that is not a power of two, like the stride of a vertex
+	EXPECT_EQ(Allocator.Allocate(12, 12), 12);
+	// The padding before the aligned allocation stays free
+	EXPECT_EQ(Allocator.Allocate(7), 5);
+	EXPECT_EQ(Allocator.Allocate(4, 4), 24);
+}
+
+TEST(TestRangeAllocator, FreeMergesNeighbours)
+{
+	RangeAllocator Allocator(30);
+
+	auto First = Allocator.Allocate(10);
+	auto Second = Allocator.Allocate(10);
+	auto Third = Allocator.Allocate(10);
+	ASSERT_TRUE(First.has_value() && Second.has_value() && Third.has_value());
+	EXPECT_EQ(Allocator.GetLargestFreeRangeSize(), 0);
+
+	Allocator.Free(First.value());
+	Allocator.Free(Third.value());
+	EXPECT_EQ(Allocator.GetLargestFreeRangeSize(), 10);
+	EXPECT_FALSE(Allocator.Allocate(20).has_value());
+
+	Allocator.Free(Second.value());
+	EXPECT_EQ(Allocator.GetLargestFreeRangeSize(), 30);
+	EXPECT_EQ(Allocator.GetAllocatedSize(), 0);
+	EXPECT_EQ(Allocator.Allocate(30), 0);
+}
+
+TEST(TestRangeAllocator, ReuseFreedRange)
+{
+	RangeAllocator Allocator(100);
+
+	auto First = Allocator.Allocate(40);
+	Allocator.Allocate(40);
+	ASSERT_TRUE(First.has_value());
+
+	Allocator.Free(First.value());
+	EXPECT_EQ(Allocator.Allocate(30), 0);
+	EXPECT_EQ(Allocator.Allocate(20), 80);
+	EXPECT_EQ(Allocator.Allocate(10), 30);
+}
+
+TEST(TestRangeAllocator, Defragment)
+{
+	RangeAllocator Allocator(64);
+
+	auto First = Allocator.Allocate(10);
+	auto Second = Allocator.Allocate(10);
+	auto Third = Allocator.Allocate(8, 8);
+	auto Fourth = Allocator.Allocate(10);
+	ASSERT_EQ(First, 0);
+	ASSERT_EQ(Second, 10);
+	ASSERT_EQ(Third, 24);
+	ASSERT_EQ(Fourth, 32);
+
+	Allocator.Free(First.value());
+	Allocator.Free(Third.value());
+	EXPECT_EQ(Allocator.GetLargestFreeRangeSize(), 22);
+
+	auto Relocations = Allocator.Defragment();
+	ASSERT_EQ(Relocations.size(), 2);
+	EXPECT_EQ(Relocations[0].OldOffset, 10);
+	EXPECT_EQ(Relocations[0].NewOffset, 0);
+	EXPECT_EQ(Relocations[0].Size, 10);
+	EXPECT_EQ(Relocations[1].OldOffset, 32);
+	EXPECT_EQ(Relocations[1].NewOffset, 10);
+	EXPECT_EQ(Relocations[1].Size, 10);
+
+	EXPECT_EQ(Allocator.GetAllocationSize(0), 10);
+	EXPECT_EQ(Allocator.GetAllocationSize(10), 10);
+	EXPECT_EQ(Allocator.GetLargestFreeRangeSize(), 44);
+	EXPECT_EQ(Allocator.Allocate(44), 20);
+}
+
+TEST(TestRangeAllocator, DefragmentKeepsAlignment)
+{
+	RangeAllocator Allocator(64);
+
+	auto First = Allocator.Allocate(3);
+	Allocator.Allocate(12, 12);
+	ASSERT_TRUE(First.has_value());
+
+	Allocator.Free(First.value());
+	auto Relocations = Allocator.Defragment();
+	ASSERT_EQ(Relocations.size(), 1);
+	EXPECT_EQ(Relocations[0].NewOffset, 0);
+
+	EXPECT_EQ(Allocator.Allocate(12, 12), 12);
+}
+
+TEST(TestRangeAllocator, Grow)
+{
+	RangeAllocator Allocator(16);
+
+	Allocator.Allocate(10);
+	EXPECT_FALSE(Allocator.Allocate(10).has_value());
+
+	Allocator.Grow(32);
+	EXPECT_EQ(Allocator.GetCapacity(), 32);
+	// The tail of the old capacity is merged with the new range
+	EXPECT_EQ(Allocator.GetLargestFreeRangeSize(), 22);
+	EXPECT_EQ(Allocator.Allocate(20), 10);
+}
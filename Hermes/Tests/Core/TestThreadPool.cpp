@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "Core/Misc/ThreadPool.h"
+
+using namespace Hermes;
+
+TEST(TestThreadPool, EveryIndexRunsOnce)
+{
+	ThreadPool Pool(3);
+
+	// Several loops in a row to make sure the workers pick up every new loop
+	for (int Loop = 0; Loop < 100; Loop++)
+	{
+		std::vector<std::atomic<int>> CallCounts(1000);
+		Pool.ParallelFor(CallCounts.size(), [&](size_t Index, uint32) { CallCounts[Index]++; });
+
+		for (const auto& Count : CallCounts)
+			ASSERT_EQ(Count, 1);
+	}
+}
+
+TEST(TestThreadPool, ThreadIndexIsInRange)
+{
+	ThreadPool Pool(2);
+	EXPECT_EQ(Pool.GetThreadCount(), 3);
+
+	std::vector<std::atomic<int>> CallsPerThread(Pool.GetThreadCount());
+	Pool.ParallelFor(500, [&](size_t, uint32 ThreadIndex)
+	{
+		ASSERT_LT(ThreadIndex, CallsPerThread.size());
+		CallsPerThread[ThreadIndex]++;
+	});
+
+	int TotalCalls = 0;
+	for (const auto& Calls : CallsPerThread)
+		TotalCalls += Calls;
+	EXPECT_EQ(TotalCalls, 500);
+}
+
+TEST(TestThreadPool, NoWorkers)
+{
+	ThreadPool Pool(0);
+	EXPECT_EQ(Pool.GetThreadCount(), 1);
+
+	// Everything runs on the calling thread
+	std::vector<size_t> Indices;
+	Pool.ParallelFor(4, [&](size_t Index, uint32 ThreadIndex)
+	{
+		EXPECT_EQ(ThreadIndex, 0);
+		Indices.push_back(Index);
+	});
+	EXPECT_EQ(Indices, (std::vector<size_t>{ 0, 1, 2, 3 }));
+}
+
+TEST(TestThreadPool, EmptyLoop)
+{
+	ThreadPool Pool(2);
+
+	bool WasCalled = false;
+	Pool.ParallelFor(0, [&](size_t, uint32) { WasCalled = true; });
+	EXPECT_FALSE(WasCalled);
+}
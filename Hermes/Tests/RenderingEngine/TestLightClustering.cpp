@@ -0,0 +1,378 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Math/Math.h"
+#include "RenderingEngine/LightClustering.h"
+
+using namespace Hermes;
+
+static constexpr Vec2ui ViewportDimensions = { 200, 120 };
+static constexpr Vec2ui ClusterSize = { 32, 32 };
+static constexpr uint32 ZClusterCount = 32;
+static constexpr float NearZ = 0.1f;
+static constexpr float FarZ = 1000.0f;
+
+static SceneData CreateSceneData(const Mat4& ViewMatrix, uint32 PointLightCount, Vec2ui Dimensions = ViewportDimensions)
+{
+	auto AspectRatio = static_cast<float>(Dimensions.X) / static_cast<float>(Dimensions.Y);
+	auto ProjectionMatrix = Mat4::Perspective(Math::Radians(70.0f), AspectRatio, NearZ, FarZ);
+
+	SceneData Result = {};
+	Result.ViewProjection = ProjectionMatrix * ViewMatrix;
+	Result.View = ViewMatrix;
+	Result.InverseProjection = ProjectionMatrix.Inverse();
+	Result.ScreenDimensions = Vec2(Dimensions);
+	Result.MaxPixelsPerLightCluster = Vec2(ClusterSize);
+	Result.CameraZBounds = { NearZ, FarZ };
+	Result.NumberOfXYClusters = (Dimensions + ClusterSize - 1) / ClusterSize;
+	Result.NumberOfZClusters = ZClusterCount;
+	Result.LightMaskWordsPerCluster = (PointLightCount + 31) / 32;
+	Result.ClusterZScaleAndBias = LightClustering::ComputeClusterZScaleAndBias(NearZ, FarZ, ZClusterCount);
+	Result.PointLightCount = PointLightCount;
+
+	return Result;
+}
+
+static size_t GetClusterCount(const SceneData& SceneData)
+{
+	return static_cast<size_t>(SceneData.NumberOfXYClusters.X) * SceneData.NumberOfXYClusters.Y * SceneData.NumberOfZClusters;
+}
+
+// Straightforward version of AssignLights() that the optimized one has to match bit by bit
+static void AssignLightsReference(std::span<const PointLight> Lights, std::span<const uint32> Clusters, const SceneData& SceneData,
+                                  std::span<uint32> Masks)
+{
+	for (auto ClusterIndex : Clusters)
+	{
+		auto Bounds = LightClustering::ComputeClusterBounds(ClusterIndex, SceneData);
+		auto* ClusterMasks = &Masks[static_cast<size_t>(ClusterIndex) * SceneData.LightMaskWordsPerCluster];
+
+		std::fill_n(ClusterMasks, SceneData.LightMaskWordsPerCluster, 0u);
+		for (size_t LightIndex = 0; LightIndex < Lights.size(); LightIndex++)
+		{
+			if (LightClustering::DoesLightIntersectCluster(Lights[LightIndex], Bounds, SceneData.View))
+				ClusterMasks[LightIndex / 32] |= 1u << (LightIndex % 32);
+		}
+	}
+}
+
+// Reconstructs the view space position of the center of a pixel the same way the forward pass sees it
+static Vec3 ComputeViewSpacePosition(Vec2ui Pixel, float DeviceDepth, const SceneData& SceneData)
+{
+	Vec2 NormalizedCoordinates = (Vec2(Pixel) + 0.5f) / SceneData.ScreenDimensions * 2.0f - 1.0f;
+	auto ViewSpacePosition = SceneData.InverseProjection * Vec4(NormalizedCoordinates.X, NormalizedCoordinates.Y, DeviceDepth, 1.0f);
+
+	return Vec3(ViewSpacePosition.X, ViewSpacePosition.Y, ViewSpacePosition.Z) / ViewSpacePosition.W;
+}
+
+// Deterministic pseudo-random depth buffer with some pixels left cleared
+static std::vector<float> CreateDepthBuffer(Vec2ui Dimensions = ViewportDimensions)
+{
+	std::vector<float> Result(static_cast<size_t>(Dimensions.X) * Dimensions.Y);
+
+	uint32 State = 12345;
+	for (auto& Depth : Result)
+	{
+		State = State * 1664525u + 1013904223u;
+		if ((State >> 28) == 0)
+			Depth = 0.0f;
+		else
+			Depth = static_cast<float>(State >> 8) / static_cast<float>(1u << 24) * 0.01f;
+	}
+
+	return Result;
+}
+
+static std::vector<PointLight> CreatePointLights(uint32 Count, const Mat4& InverseViewMatrix)
+{
+	std::vector<PointLight> Result(Count);
+
+	uint32 State = 54321;
+	auto NextFloat = [&State]()
+	{
+		State = State * 1664525u + 1013904223u;
+		return static_cast<float>(State >> 8) / static_cast<float>(1u << 24);
+	};
+
+	for (auto& Light : Result)
+	{
+		Vec4 ViewSpacePosition = { (NextFloat() - 0.5f) * 60.0f, (NextFloat() - 0.5f) * 40.0f, -NextFloat() * 80.0f, 1.0f };
+		auto WorldSpacePosition = InverseViewMatrix * ViewSpacePosition;
+
+		Vec3 Color = { 1.0f, NextFloat(), NextFloat() };
+		float Intensity = 0.05f + NextFloat() * 0.5f;
+
+		Light.Position = Vec4(Vec3(WorldSpacePosition.X, WorldSpacePosition.Y, WorldSpacePosition.Z),
+		                      LightClustering::ComputeLightRadius(Color, Intensity));
+		Light.Color = Vec4(Color, Intensity);
+	}
+
+	return Result;
+}
+
+TEST(TestLightClustering, LinearizeDepth)
+{
+	Vec2 CameraZBounds = { NearZ, FarZ };
+
+	EXPECT_NEAR(LightClustering::LinearizeDepth(1.0f, CameraZBounds), NearZ, 0.0001f);
+	EXPECT_NEAR(LightClustering::LinearizeDepth(0.0f, CameraZBounds), FarZ, 0.01f);
+}
+
+TEST(TestLightClustering, ZSliceCoversDepthRange)
+{
+	auto SceneData = CreateSceneData(Mat4::Identity(), 0);
+
+	EXPECT_EQ(LightClustering::ComputeClusterZSlice(NearZ, SceneData), 0u);
+	EXPECT_EQ(LightClustering::ComputeClusterZSlice(FarZ * 0.999f, SceneData), ZClusterCount - 1);
+	EXPECT_EQ(LightClustering::ComputeClusterZSlice(FarZ * 2.0f, SceneData), ZClusterCount - 1);
+
+	uint32 PreviousSlice = 0;
+	for (float Depth = NearZ; Depth < FarZ; Depth *= 1.05f)
+	{
+		auto Slice = LightClustering::ComputeClusterZSlice(Depth, SceneData);
+		EXPECT_GE(Slice, PreviousSlice);
+		PreviousSlice = Slice;
+	}
+}
+
+TEST(TestLightClustering, PixelIsInsideItsClusterBounds)
+{
+	auto SceneData = CreateSceneData(Mat4::Identity(), 0);
+	auto DepthBuffer = CreateDepthBuffer();
+
+	for (uint32 Y = 0; Y < ViewportDimensions.Y; Y++)
+	{
+		for (uint32 X = 0; X < ViewportDimensions.X; X++)
+		{
+			float Depth = DepthBuffer[static_cast<size_t>(Y) * ViewportDimensions.X + X];
+			if (Depth == 0.0f)
+				continue;
+
+			auto Position = ComputeViewSpacePosition({ X, Y }, Depth, SceneData);
+			auto Bounds = LightClustering::ComputeClusterBounds(LightClustering::ComputeClusterIndex({ X, Y }, Depth, SceneData), SceneData);
+
+			// NOTE: the tolerance accounts for the float precision of the logarithmic Z slices
+			float Tolerance = 0.001f * -Position.Z;
+			ASSERT_GE(Position.X, Bounds.MinCorner.X - Tolerance);
+			ASSERT_GE(Position.Y, Bounds.MinCorner.Y - Tolerance);
+			ASSERT_GE(Position.Z, Bounds.MinCorner.Z - Tolerance);
+			ASSERT_LE(Position.X, Bounds.MaxCorner.X + Tolerance);
+			ASSERT_LE(Position.Y, Bounds.MaxCorner.Y + Tolerance);
+			ASSERT_LE(Position.Z, Bounds.MaxCorner.Z + Tolerance);
+		}
+	}
+}
+
+TEST(TestLightClustering, FindActiveClustersWithConstantDepth)
+{
+	auto SceneData = CreateSceneData(Mat4::Identity(), 0);
+	std::vector<float> DepthBuffer(static_cast<size_t>(ViewportDimensions.X) * ViewportDimensions.Y, 0.001f);
+
+	auto ActiveClusters = LightClustering::FindActiveClusters(DepthBuffer, SceneData);
+
+	uint32 XYClusterCount = SceneData.NumberOfXYClusters.X * SceneData.NumberOfXYClusters.Y;
+	ASSERT_EQ(ActiveClusters.size(), XYClusterCount);
+
+	uint32 ExpectedSlice = LightClustering::ComputeClusterZSlice(LightClustering::LinearizeDepth(0.001f, SceneData.CameraZBounds), SceneData);
+	for (uint32 Index = 0; Index < XYClusterCount; Index++)
+		EXPECT_EQ(ActiveClusters[Index], ExpectedSlice * XYClusterCount + Index);
+}
+
+TEST(TestLightClustering, FindActiveClustersMatchesPerPixelIndices)
+{
+	auto SceneData = CreateSceneData(Mat4::Identity(), 0);
+	auto DepthBuffer = CreateDepthBuffer();
+
+	std::vector<uint32> ExpectedClusters;
+	for (uint32 Y = 0; Y < ViewportDimensions.Y; Y++)
+	{
+		for (uint32 X = 0; X < ViewportDimensions.X; X++)
+		{
+			float Depth = DepthBuffer[static_cast<size_t>(Y) * ViewportDimensions.X + X];
+			if (Depth != 0.0f)
+				ExpectedClusters.push_back(LightClustering::ComputeClusterIndex({ X, Y }, Depth, SceneData));
+		}
+	}
+	std::ranges::sort(ExpectedClusters);
+	ExpectedClusters.erase(std::unique(ExpectedClusters.begin(), ExpectedClusters.end()), ExpectedClusters.end());
+
+	EXPECT_EQ(LightClustering::FindActiveClusters(DepthBuffer, SceneData), ExpectedClusters);
+
+	ThreadPool Pool(3);
+	EXPECT_EQ(LightClustering::FindActiveClusters(DepthBuffer, SceneData, Pool), ExpectedClusters);
+}
+
+TEST(TestLightClustering, FindActiveClustersSkipsEmptyPixels)
+{
+	auto SceneData = CreateSceneData(Mat4::Identity(), 0);
+	std::vector<float> DepthBuffer(static_cast<size_t>(ViewportDimensions.X) * ViewportDimensions.Y, 0.0f);
+
+	EXPECT_TRUE(LightClustering::FindActiveClusters(DepthBuffer, SceneData).empty());
+}
+
+TEST(TestLightClustering, AssignLightsIsConservative)
+{
+	static constexpr uint32 LightCount = 70;
+
+	auto ViewMatrix = Mat4::LookAt(Vec3(3.0f, 2.0f, -5.0f), Vec3(0.2f, -0.1f, 1.0f), Vec3(0.0f, 1.0f, 0.0f));
+	auto SceneData = CreateSceneData(ViewMatrix, LightCount);
+	auto Lights = CreatePointLights(LightCount, ViewMatrix.Inverse());
+	auto DepthBuffer = CreateDepthBuffer();
+
+	auto ActiveClusters = LightClustering::FindActiveClusters(DepthBuffer, SceneData);
+	std::vector<uint32> Masks(GetClusterCount(SceneData) * SceneData.LightMaskWordsPerCluster, 0);
+	LightClustering::AssignLights(Lights, ActiveClusters, SceneData, Masks);
+
+	for (uint32 Y = 0; Y < ViewportDimensions.Y; Y++)
+	{
+		for (uint32 X = 0; X < ViewportDimensions.X; X++)
+		{
+			float Depth = DepthBuffer[static_cast<size_t>(Y) * ViewportDimensions.X + X];
+			if (Depth == 0.0f)
+				continue;
+
+			auto Position = ComputeViewSpacePosition({ X, Y }, Depth, SceneData);
+			auto ClusterIndex = LightClustering::ComputeClusterIndex({ X, Y }, Depth, SceneData);
+			const auto* ClusterMasks = &Masks[static_cast<size_t>(ClusterIndex) * SceneData.LightMaskWordsPerCluster];
+
+			for (uint32 LightIndex = 0; LightIndex < LightCount; LightIndex++)
+			{
+				auto LightPosition = ViewMatrix * Vec4(Lights[LightIndex].Position.X, Lights[LightIndex].Position.Y, Lights[LightIndex].Position.Z, 1.0f);
+				auto Distance = (Vec3(LightPosition.X, LightPosition.Y, LightPosition.Z) - Position).Length();
+				if (Distance > Lights[LightIndex].Position.W * 0.999f)
+					continue;
+
+				ASSERT_TRUE(ClusterMasks[LightIndex / 32] & (1u << (LightIndex % 32)))
+					<< "Light " << LightIndex << " is missing from the cluster of pixel (" << X << ", " << Y << ")";
+			}
+		}
+	}
+}
+
+TEST(TestLightClustering, AssignLightsOnlyWritesGivenClusters)
+{
+	static constexpr uint32 LightCount = 33;
+
+	auto SceneData = CreateSceneData(Mat4::Identity(), LightCount);
+	auto Lights = CreatePointLights(LightCount, Mat4::Identity());
+
+	std::vector<uint32> Masks(GetClusterCount(SceneData) * SceneData.LightMaskWordsPerCluster, 0xDEADBEEF);
+	uint32 Clusters[] = { 0, 5 };
+	LightClustering::AssignLights(Lights, Clusters, SceneData, Masks);
+
+	for (size_t ClusterIndex = 0; ClusterIndex < GetClusterCount(SceneData); ClusterIndex++)
+	{
+		for (uint32 WordIndex = 0; WordIndex < SceneData.LightMaskWordsPerCluster; WordIndex++)
+		{
+			auto Word = Masks[ClusterIndex * SceneData.LightMaskWordsPerCluster + WordIndex];
+			if (ClusterIndex == 0 || ClusterIndex == 5)
+				EXPECT_NE(Word, 0xDEADBEEF);
+			else
+				EXPECT_EQ(Word, 0xDEADBEEF);
+		}
+	}
+	// Only the first light fits into the second word
+	EXPECT_EQ(Masks[1] & ~1u, 0u);
+}
+
+TEST(TestLightClustering, LightBehindCameraIsNotAssigned)
+{
+	auto SceneData = CreateSceneData(Mat4::Identity(), 1);
+	auto DepthBuffer = CreateDepthBuffer();
+
+	PointLight Light = {};
+	Light.Position = { 0.0f, 0.0f, 10.0f, 5.0f };
+	Light.Color = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	auto ActiveClusters = LightClustering::FindActiveClusters(DepthBuffer, SceneData);
+	std::vector<uint32> Masks(GetClusterCount(SceneData), 0);
+	LightClustering::AssignLights({ &Light, 1 }, ActiveClusters, SceneData, Masks);
+
+	for (auto Mask : Masks)
+		EXPECT_EQ(Mask, 0u);
+}
+
+TEST(TestLightClustering, AssignLightsMatchesReference)
+{
+	// NOTE: not a multiple of 4 or 32 to cover the padding of the last batch and the last word
+	static constexpr uint32 LightCount = 101;
+
+	auto ViewMatrix = Mat4::LookAt(Vec3(-4.0f, 1.0f, 2.0f), Vec3(0.3f, 0.0f, -1.0f), Vec3(0.0f, 1.0f, 0.0f));
+	auto SceneData = CreateSceneData(ViewMatrix, LightCount);
+	auto Lights = CreatePointLights(LightCount, ViewMatrix.Inverse());
+	auto ActiveClusters = LightClustering::FindActiveClusters(CreateDepthBuffer(), SceneData);
+
+	size_t MaskWordCount = GetClusterCount(SceneData) * SceneData.LightMaskWordsPerCluster;
+	std::vector<uint32> ExpectedMasks(MaskWordCount, 0);
+	AssignLightsReference(Lights, ActiveClusters, SceneData, ExpectedMasks);
+
+	std::vector<uint32> Masks(MaskWordCount, 0);
+	LightClustering::AssignLights(Lights, ActiveClusters, SceneData, Masks);
+	EXPECT_EQ(Masks, ExpectedMasks);
+
+	ThreadPool Pool(3);
+	std::vector<uint32> ParallelMasks(MaskWordCount, 0);
+	LightClustering::AssignLights(Lights, ActiveClusters, SceneData, ParallelMasks, Pool);
+	EXPECT_EQ(ParallelMasks, ExpectedMasks);
+}
+
+TEST(TestLightClustering, AssignLightsWithoutLights)
+{
+	auto SceneData = CreateSceneData(Mat4::Identity(), 0);
+	auto ActiveClusters = LightClustering::FindActiveClusters(CreateDepthBuffer(), SceneData);
+
+	std::vector<uint32> Masks;
+	ThreadPool Pool(2);
+	LightClustering::AssignLights({}, ActiveClusters, SceneData, Masks, Pool);
+	EXPECT_TRUE(Masks.empty());
+}
+
+/*
+ * Measures the CPU light assignment at 1080p. Disabled by default, run with --gtest_also_run_disabled_tests
+ * and --gtest_output=xml to collect the timings, which are reported as test properties.
+ * NOTE: only the CPU implementations are measured, the GPU light culling pass is not timed here
+ */
+TEST(TestLightClustering, DISABLED_Benchmark)
+{
+	static constexpr Vec2ui BenchmarkDimensions = { 1920, 1080 };
+	static constexpr uint32 LightCount = 1024;
+	static constexpr int IterationCount = 10;
+
+	auto ViewMatrix = Mat4::LookAt(Vec3(0.0f, 2.0f, 0.0f), Vec3(0.0f, 0.0f, -1.0f), Vec3(0.0f, 1.0f, 0.0f));
+	auto SceneData = CreateSceneData(ViewMatrix, LightCount, BenchmarkDimensions);
+	auto Lights = CreatePointLights(LightCount, ViewMatrix.Inverse());
+	auto DepthBuffer = CreateDepthBuffer(BenchmarkDimensions);
+	std::vector<uint32> Masks(GetClusterCount(SceneData) * SceneData.LightMaskWordsPerCluster, 0);
+
+	auto Measure = [](const char* PropertyName, const auto& Function)
+	{
+		auto Start = std::chrono::steady_clock::now();
+		for (int Iteration = 0; Iteration < IterationCount; Iteration++)
+			Function();
+		auto Duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start) / IterationCount;
+
+		::testing::Test::RecordProperty(PropertyName, std::to_string(Duration.count()));
+	};
+
+	std::vector<uint32> ActiveClusters;
+	ThreadPool Pool(Math::Max(std::thread::hardware_concurrency(), 2u) - 1);
+
+	Measure("FindActiveClustersMs", [&]() { ActiveClusters = LightClustering::FindActiveClusters(DepthBuffer, SceneData); });
+	Measure("FindActiveClustersThreadPoolMs", [&]() { ActiveClusters = LightClustering::FindActiveClusters(DepthBuffer, SceneData, Pool); });
+	Measure("AssignLightsReferenceMs", [&]() { AssignLightsReference(Lights, ActiveClusters, SceneData, Masks); });
+	Measure("AssignLightsMs", [&]() { LightClustering::AssignLights(Lights, ActiveClusters, SceneData, Masks); });
+	Measure("AssignLightsThreadPoolMs", [&]() { LightClustering::AssignLights(Lights, ActiveClusters, SceneData, Masks, Pool); });
+
+	size_t AssignedLightCount = 0;
+	for (auto Word : Masks)
+		AssignedLightCount += std::popcount(Word);
+	RecordProperty("ActiveClusterCount", std::to_string(ActiveClusters.size()));
+	RecordProperty("ClusterCount", std::to_string(GetClusterCount(SceneData)));
+	RecordProperty("LightAssignmentCount", std::to_string(AssignedLightCount));
+}
@@ -13,6 +13,7 @@
 #include "RenderingEngine/Scene/Camera.h"
 #include "UIEngine/Font.h"
 #include "UIEngine/Widgets/Button.h"
+#include "UIEngine/Widgets/GPUStatsOverlay.h"
 #include "UIEngine/Widgets/Image.h"
 #include "UIEngine/Widgets/Label.h"
 #include "UIEngine/Widgets/Containers/VerticalContainer.h"
@@ -240,6 +241,8 @@ public:
 		PlayButton->Margins.Right = { Hermes::UI::MarginValueType::PercentOfParent, 0.5f };
 		VerticalContainer->AddChild(PlayButton);
 
+		VerticalContainer->AddChild(Hermes::UI::GPUStatsOverlay::Create(14, Font));
+
 		Hermes::GGameLoop->SetRootWidget(RootWidget);
 
 		return true;
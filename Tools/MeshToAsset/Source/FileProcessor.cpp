@@ -6,15 +6,18 @@
 
 #include "GLTFReader.h"
 #include "Mesh.h"
+#include "MeshOptimizer.h"
 #include "MeshWriter.h"
 #include "Node.h"
 #include "OBJReader.h"
 
 namespace Hermes::Tools
 {
-	FileProcessor::FileProcessor(StringView InFileName, bool InFlipVertexOrder)
+	FileProcessor::FileProcessor(StringView InFileName, bool InFlipVertexOrder, bool InOptimizeMesh, bool InCompressVertices)
 		: InputFileName(InFileName)
 		, ShouldFlipVertexOrder(InFlipVertexOrder)
+		, ShouldOptimizeMesh(InOptimizeMesh)
+		, ShouldCompressVertices(InCompressVertices)
 	{
 		auto Extension = StringView(InFileName.begin() + static_cast<ptrdiff_t>(InFileName.find_last_of('.')) + 1, InFileName.end());
 		if (Extension == "obj")
@@ -87,8 +90,18 @@ namespace Hermes::Tools
 		if (!TraverseTree(InputFileReader->GetRootNode()))
 			return false;
 
+		if (ShouldOptimizeMesh)
+		{
+			auto StatisticsBefore = MeshOptimizer::ComputeVertexCacheStatistics(MergedMesh);
+			MergedMesh = MeshOptimizer::Optimize(MergedMesh);
+			auto StatisticsAfter = MeshOptimizer::ComputeVertexCacheStatistics(MergedMesh);
+
+			std::cout << std::format("Vertex cache (FIFO, {} entries): ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", MeshOptimizer::VertexCacheSize,
+			                         StatisticsBefore.ACMR, StatisticsAfter.ACMR, StatisticsBefore.ATVR, StatisticsAfter.ATVR) << std::endl;
+		}
+
 		String OutputFileName = std::format("{}.hac", MergedMesh.GetName());
-		if (!MeshWriter::Write(OutputFileName, MergedMesh))
+		if (!MeshWriter::Write(OutputFileName, MergedMesh, ShouldCompressVertices))
 			return false;
 
 		return true;
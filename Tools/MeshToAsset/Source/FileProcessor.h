@@ -11,7 +11,7 @@ namespace Hermes::Tools
 	class FileProcessor
 	{
 	public:
-		FileProcessor(StringView InFileName, bool InFlipVertexOrder);
+		FileProcessor(StringView InFileName, bool InFlipVertexOrder, bool InOptimizeMesh, bool InCompressVertices);
 
 		bool Run() const;
 
@@ -21,6 +21,8 @@ namespace Hermes::Tools
 		String InputFileName;
 
 		bool ShouldFlipVertexOrder = false;
+		bool ShouldOptimizeMesh = true;
+		bool ShouldCompressVertices = false;
 
 		static Vertex ApplyVertexTransformation(Vertex Input, Mat4 TransformationMatrix);
 		static Mesh ApplyVertexTransformation(const Mesh& Input, Mat4 TransformationMatrix);
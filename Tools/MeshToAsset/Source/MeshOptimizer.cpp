@@ -0,0 +1,320 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "Mesh.h"
+
+namespace Hermes::Tools
+{
+	static constexpr uint32 FaceSeparator = static_cast<uint32>(-1);
+
+	/*
+	 * Converts a range of the mesh index buffer in which each triangle is followed by index -1 into a plain triangle list
+	 */
+	static std::vector<uint32> ExtractTriangleList(std::span<const uint32> Indices)
+	{
+		std::vector<uint32> Result;
+		Result.reserve(Indices.size() / 4 * 3);
+		for (auto Index : Indices)
+		{
+			if (Index != FaceSeparator)
+				Result.push_back(Index);
+		}
+		return Result;
+	}
+
+	Mesh MeshOptimizer::Optimize(const Mesh& Input)
+	{
+		HERMES_ASSERT(Input.IsTriangulated());
+
+		const auto& InputVertices = Input.GetVertices();
+		auto Indices = Input.GetIndices();
+
+		for (const auto& Primitive : Input.GetPrimitives())
+		{
+			auto PrimitiveIndices = std::span(Indices).subspan(Primitive.IndexBufferOffset, Primitive.IndexCount);
+			auto TriangleList = ExtractTriangleList(PrimitiveIndices);
+
+			// NOTE: vertices of the primitive are renumbered so that the cost of the reordering depends only on the size of the primitive
+			std::unordered_map<uint32, uint32> GlobalToLocalIndex;
+			std::vector<uint32> LocalToGlobalIndex;
+			for (auto& Index : TriangleList)
+			{
+				auto [Iterator, WasInserted] = GlobalToLocalIndex.try_emplace(Index, static_cast<uint32>(LocalToGlobalIndex.size()));
+				if (WasInserted)
+					LocalToGlobalIndex.push_back(Index);
+				Index = Iterator->second;
+			}
+
+			std::vector<uint32> ClusterOffsets;
+			auto CacheOptimizedTriangles = ReorderForVertexCache(TriangleList, LocalToGlobalIndex.size(), ClusterOffsets);
+			for (auto& Index : CacheOptimizedTriangles)
+				Index = LocalToGlobalIndex[Index];
+
+			auto OptimizedTriangles = ReorderForOverdraw(CacheOptimizedTriangles, ClusterOffsets, InputVertices);
+			for (size_t TriangleIndex = 0; TriangleIndex < OptimizedTriangles.size() / 3; TriangleIndex++)
+			{
+				PrimitiveIndices[TriangleIndex * 4 + 0] = OptimizedTriangles[TriangleIndex * 3 + 0];
+				PrimitiveIndices[TriangleIndex * 4 + 1] = OptimizedTriangles[TriangleIndex * 3 + 1];
+				PrimitiveIndices[TriangleIndex * 4 + 2] = OptimizedTriangles[TriangleIndex * 3 + 2];
+				PrimitiveIndices[TriangleIndex * 4 + 3] = FaceSeparator;
+			}
+		}
+
+		// Vertex fetch optimization: vertices are stored in the order in which the index buffer references them for the first time
+		std::vector<uint32> VertexRemapTable(InputVertices.size(), FaceSeparator);
+		std::vector<Vertex> Vertices;
+		Vertices.reserve(InputVertices.size());
+		for (auto& Index : Indices)
+		{
+			if (Index == FaceSeparator)
+				continue;
+
+			if (VertexRemapTable[Index] == FaceSeparator)
+			{
+				VertexRemapTable[Index] = static_cast<uint32>(Vertices.size());
+				Vertices.push_back(InputVertices[Index]);
+			}
+			Index = VertexRemapTable[Index];
+		}
+
+		// NOTE: vertices that are not referenced by any primitive are kept at the end of the vertex buffer so that the content of the mesh stays the same
+		for (size_t VertexIndex = 0; VertexIndex < InputVertices.size(); VertexIndex++)
+		{
+			if (VertexRemapTable[VertexIndex] == FaceSeparator)
+				Vertices.push_back(InputVertices[VertexIndex]);
+		}
+
+		return { String(Input.GetName()), std::move(Vertices), std::move(Indices), Input.GetPrimitives(), Input.HasTangents() };
+	}
+
+	VertexCacheStatistics MeshOptimizer::ComputeVertexCacheStatistics(const Mesh& Input)
+	{
+		std::vector<uint32> CacheTimestamps(Input.GetVertices().size(), 0);
+		std::vector<bool> IsVertexReferenced(Input.GetVertices().size(), false);
+
+		// NOTE: vertex is in the cache if less than VertexCacheSize other vertices were inserted after it; the clock starts
+		//       at VertexCacheSize + 1 so that the zero-initialized timestamps are treated as evicted
+		uint32 Clock = VertexCacheSize + 1;
+		size_t TransformedVertexCount = 0;
+		size_t ReferencedVertexCount = 0;
+		size_t TriangleCount = 0;
+
+		for (auto Index : Input.GetIndices())
+		{
+			if (Index == FaceSeparator)
+			{
+				TriangleCount++;
+				continue;
+			}
+
+			if (Clock - CacheTimestamps[Index] > VertexCacheSize)
+			{
+				CacheTimestamps[Index] = Clock++;
+				TransformedVertexCount++;
+			}
+
+			if (!IsVertexReferenced[Index])
+			{
+				IsVertexReferenced[Index] = true;
+				ReferencedVertexCount++;
+			}
+		}
+
+		VertexCacheStatistics Result = {};
+		if (TriangleCount > 0)
+			Result.ACMR = static_cast<float>(TransformedVertexCount) / static_cast<float>(TriangleCount);
+		if (ReferencedVertexCount > 0)
+			Result.ATVR = static_cast<float>(TransformedVertexCount) / static_cast<float>(ReferencedVertexCount);
+		return Result;
+	}
+
+	/*
+	 * Implementation of the Tipsify algorithm from 'Fast Triangle Reordering for Vertex Locality and Reduced Overdraw' by Sander et al.
+	 * Triangles are emitted as fans around the current vertex; the next fanning vertex is the one that is going to stay in the cache
+	 * the longest. A new cluster starts every time the next fanning vertex is not in the cache anymore, which means that the cluster
+	 * order can be changed without affecting the cache hit rate
+	 */
+	std::vector<uint32> MeshOptimizer::ReorderForVertexCache(std::span<const uint32> Indices, size_t VertexCount, std::vector<uint32>& ClusterOffsets)
+	{
+		ClusterOffsets.clear();
+
+		std::vector<uint32> Result;
+		if (Indices.empty() || VertexCount == 0)
+			return Result;
+		Result.reserve(Indices.size());
+
+		size_t TriangleCount = Indices.size() / 3;
+
+		// Vertex-triangle adjacency, triangles adjacent to vertex V are stored in AdjacentTriangles[AdjacencyOffsets[V]..AdjacencyOffsets[V + 1]]
+		std::vector<uint32> LiveTriangleCount(VertexCount, 0);
+		for (auto Index : Indices)
+			LiveTriangleCount[Index]++;
+
+		std::vector<uint32> AdjacencyOffsets(VertexCount + 1, 0);
+		for (size_t VertexIndex = 0; VertexIndex < VertexCount; VertexIndex++)
+			AdjacencyOffsets[VertexIndex + 1] = AdjacencyOffsets[VertexIndex] + LiveTriangleCount[VertexIndex];
+
+		std::vector<uint32> AdjacentTriangles(Indices.size());
+		std::vector<uint32> InsertionPoints(AdjacencyOffsets.begin(), AdjacencyOffsets.end() - 1);
+		for (size_t Index = 0; Index < Indices.size(); Index++)
+			AdjacentTriangles[InsertionPoints[Indices[Index]]++] = static_cast<uint32>(Index / 3);
+
+		std::vector<uint32> CacheTimestamps(VertexCount, 0);
+		std::vector<bool> IsTriangleEmitted(TriangleCount, false);
+		std::vector<uint32> DeadEndStack;
+		std::vector<uint32> Candidates;
+
+		uint32 Clock = VertexCacheSize + 1;
+		size_t ScanCursor = 0;
+		int64 FanningVertex = 0;
+		bool StartsNewCluster = true;
+
+		while (FanningVertex >= 0)
+		{
+			if (StartsNewCluster)
+				ClusterOffsets.push_back(static_cast<uint32>(Result.size() / 3));
+
+			Candidates.clear();
+			for (auto AdjacencyIndex = AdjacencyOffsets[FanningVertex]; AdjacencyIndex < AdjacencyOffsets[FanningVertex + 1]; AdjacencyIndex++)
+			{
+				auto Triangle = AdjacentTriangles[AdjacencyIndex];
+				if (IsTriangleEmitted[Triangle])
+					continue;
+
+				for (size_t Corner = 0; Corner < 3; Corner++)
+				{
+					auto Vertex = Indices[Triangle * 3 + Corner];
+					Result.push_back(Vertex);
+					DeadEndStack.push_back(Vertex);
+					Candidates.push_back(Vertex);
+					LiveTriangleCount[Vertex]--;
+
+					if (Clock - CacheTimestamps[Vertex] > VertexCacheSize)
+						CacheTimestamps[Vertex] = Clock++;
+				}
+				IsTriangleEmitted[Triangle] = true;
+			}
+
+			// Pick the candidate that will still be in the cache after all of its remaining triangles are emitted and that was
+			// inserted into the cache the earliest
+			int64 NextVertex = -1;
+			int64 BestPriority = -1;
+			for (auto Candidate : Candidates)
+			{
+				if (LiveTriangleCount[Candidate] == 0)
+					continue;
+
+				int64 Priority = 0;
+				int64 CacheAge = Clock - CacheTimestamps[Candidate];
+				if (CacheAge + 2 * static_cast<int64>(LiveTriangleCount[Candidate]) <= VertexCacheSize)
+					Priority = CacheAge;
+
+				if (Priority > BestPriority)
+				{
+					BestPriority = Priority;
+					NextVertex = Candidate;
+				}
+			}
+
+			if (NextVertex < 0)
+			{
+				// Dead end: try the recently emitted vertices first and only then fall back to scanning through the whole vertex list
+				while (!DeadEndStack.empty() && NextVertex < 0)
+				{
+					auto Vertex = DeadEndStack.back();
+					DeadEndStack.pop_back();
+					if (LiveTriangleCount[Vertex] > 0)
+						NextVertex = Vertex;
+				}
+
+				while (NextVertex < 0 && ScanCursor < VertexCount)
+				{
+					if (LiveTriangleCount[ScanCursor] > 0)
+						NextVertex = static_cast<int64>(ScanCursor);
+					else
+						ScanCursor++;
+				}
+			}
+
+			StartsNewCluster = NextVertex >= 0 && Clock - CacheTimestamps[NextVertex] > VertexCacheSize;
+			FanningVertex = NextVertex;
+		}
+
+		return Result;
+	}
+
+	/*
+	 * Sorts clusters so that the ones that face away from the center of the primitive are drawn first; such clusters are more likely
+	 * to occlude the rest of the primitive, so more fragments get rejected by the early depth test
+	 */
+	std::vector<uint32> MeshOptimizer::ReorderForOverdraw(std::span<const uint32> Indices, std::span<const uint32> ClusterOffsets, std::span<const Vertex> Vertices)
+	{
+		size_t TriangleCount = Indices.size() / 3;
+		size_t ClusterCount = ClusterOffsets.size();
+		if (ClusterCount <= 1)
+			return { Indices.begin(), Indices.end() };
+
+		struct ClusterInfo
+		{
+			Vec3 Centroid;
+			Vec3 Normal;
+			float Area = 0.0f;
+		};
+		std::vector<ClusterInfo> Clusters(ClusterCount);
+
+		Vec3 PrimitiveCentroid = {};
+		float PrimitiveArea = 0.0f;
+		for (size_t ClusterIndex = 0; ClusterIndex < ClusterCount; ClusterIndex++)
+		{
+			size_t FirstTriangle = ClusterOffsets[ClusterIndex];
+			size_t LastTriangle = ClusterIndex + 1 < ClusterCount ? ClusterOffsets[ClusterIndex + 1] : TriangleCount;
+
+			auto& Cluster = Clusters[ClusterIndex];
+			for (size_t Triangle = FirstTriangle; Triangle < LastTriangle; Triangle++)
+			{
+				auto P1 = Vertices[Indices[Triangle * 3 + 0]].Position;
+				auto P2 = Vertices[Indices[Triangle * 3 + 1]].Position;
+				auto P3 = Vertices[Indices[Triangle * 3 + 2]].Position;
+
+				auto ScaledNormal = (P2 - P1).Cross(P3 - P1);
+				float Area = ScaledNormal.Length() * 0.5f;
+
+				Cluster.Centroid += (P1 + P2 + P3) * (Area / 3.0f);
+				Cluster.Normal += ScaledNormal;
+				Cluster.Area += Area;
+			}
+
+			PrimitiveCentroid += Cluster.Centroid;
+			PrimitiveArea += Cluster.Area;
+			if (Cluster.Area > 0.0f)
+				Cluster.Centroid /= Cluster.Area;
+		}
+		if (PrimitiveArea > 0.0f)
+			PrimitiveCentroid /= PrimitiveArea;
+
+		std::vector<float> SortKeys(ClusterCount);
+		for (size_t ClusterIndex = 0; ClusterIndex < ClusterCount; ClusterIndex++)
+		{
+			const auto& Cluster = Clusters[ClusterIndex];
+			SortKeys[ClusterIndex] = (Cluster.Centroid - PrimitiveCentroid).Dot(Cluster.Normal.SafeNormalized());
+		}
+
+		std::vector<size_t> ClusterOrder(ClusterCount);
+		for (size_t ClusterIndex = 0; ClusterIndex < ClusterCount; ClusterIndex++)
+			ClusterOrder[ClusterIndex] = ClusterIndex;
+		std::ranges::stable_sort(ClusterOrder, [&](size_t A, size_t B) { return SortKeys[A] > SortKeys[B]; });
+
+		std::vector<uint32> Result;
+		Result.reserve(Indices.size());
+		for (auto ClusterIndex : ClusterOrder)
+		{
+			size_t FirstIndex = static_cast<size_t>(ClusterOffsets[ClusterIndex]) * 3;
+			size_t LastIndex = ClusterIndex + 1 < ClusterCount ? static_cast<size_t>(ClusterOffsets[ClusterIndex + 1]) * 3 : Indices.size();
+			Result.insert(Result.end(), Indices.begin() + static_cast<ptrdiff_t>(FirstIndex), Indices.begin() + static_cast<ptrdiff_t>(LastIndex));
+		}
+
+		return Result;
+	}
+}
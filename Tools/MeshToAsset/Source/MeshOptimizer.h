@@ -0,0 +1,52 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "AssetSystem/AssetHeaders.h"
+#include "Core/Core.h"
+
+namespace Hermes::Tools
+{
+	class Mesh;
+
+	/*
+	 * Post-transform vertex cache statistics of an index buffer
+	 * ACMR - average number of vertex shader invocations per triangle (lower is better, 0.5 is the theoretical minimum)
+	 * ATVR - average number of vertex shader invocations per referenced vertex (lower is better, 1.0 is the minimum)
+	 */
+	struct VertexCacheStatistics
+	{
+		float ACMR = 0.0f;
+		float ATVR = 0.0f;
+	};
+
+	/*
+	 * Reorders triangles and vertices of a mesh to make it cheaper to render on the GPU without changing its content:
+	 *  - triangles of each primitive are reordered for post-transform vertex cache locality (Tipsify)
+	 *  - clusters of triangles produced by the previous step are sorted so that the outermost ones are drawn first to reduce overdraw
+	 *  - vertices are reordered in the order in which they are first referenced by the index buffer to improve vertex fetch locality
+	 */
+	class HERMES_API MeshOptimizer
+	{
+	public:
+		/*
+		 * Size of the FIFO cache that is used by the optimizer and the statistics computation
+		 */
+		static constexpr uint32 VertexCacheSize = 16;
+
+		/*
+		 * Returns an optimized copy of the mesh. Expects the mesh to be triangulated
+		 */
+		static Mesh Optimize(const Mesh& Input);
+
+		/*
+		 * Simulates a FIFO post-transform vertex cache of VertexCacheSize entries over the whole index buffer of the mesh
+		 */
+		static VertexCacheStatistics ComputeVertexCacheStatistics(const Mesh& Input);
+
+	private:
+		static std::vector<uint32> ReorderForVertexCache(std::span<const uint32> Indices, size_t VertexCount, std::vector<uint32>& ClusterOffsets);
+		static std::vector<uint32> ReorderForOverdraw(std::span<const uint32> Indices, std::span<const uint32> ClusterOffsets, std::span<const Vertex> Vertices);
+	};
+}
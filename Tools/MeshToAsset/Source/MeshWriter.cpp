@@ -1,15 +1,119 @@
 #include "MeshWriter.h"
 
 #include <algorithm>
+#include <bit>
+#include <cmath>
 #include <iostream>
 
 #include "AssetSystem/AssetLoader.h"
 #include "Mesh.h"
+#include "MeshletBuilder.h"
 #include "Platform/GenericPlatform/PlatformFile.h"
 
 namespace Hermes::Tools
 {
-	bool MeshWriter::Write(StringView FileName, const Mesh& Mesh)
+	/*
+	 * Converts a 32-bit float into IEEE 754 half precision float with round-to-nearest-even
+	 */
+	static uint16 FloatToHalf(float Value)
+	{
+		auto Bits = std::bit_cast<uint32>(Value);
+		auto Sign = static_cast<uint16>((Bits >> 16) & 0x8000);
+		auto Exponent = static_cast<int32>((Bits >> 23) & 0xFF);
+		auto Mantissa = Bits & 0x007FFFFF;
+
+		// Infinity or NaN
+		if (Exponent == 0xFF)
+			return static_cast<uint16>(Sign | 0x7C00 | (Mantissa ? 0x0200 : 0));
+
+		int32 HalfExponent = Exponent - 127 + 15;
+		// Overflow, clamp to infinity
+		if (HalfExponent >= 0x1F)
+			return static_cast<uint16>(Sign | 0x7C00);
+
+		// Denormalized half or zero
+		if (HalfExponent <= 0)
+		{
+			if (HalfExponent < -10)
+				return Sign;
+
+			Mantissa |= 0x00800000;
+			auto Shift = static_cast<uint32>(14 - HalfExponent);
+			auto HalfMantissa = Mantissa >> Shift;
+			auto Remainder = Mantissa & ((1u << Shift) - 1);
+			auto Halfway = 1u << (Shift - 1);
+			if (Remainder > Halfway || (Remainder == Halfway && (HalfMantissa & 1)))
+				HalfMantissa++;
+			return static_cast<uint16>(Sign | HalfMantissa);
+		}
+
+		auto Result = static_cast<uint32>(Sign) | (static_cast<uint32>(HalfExponent) << 10) | (Mantissa >> 13);
+		auto Remainder = Mantissa & 0x1FFF;
+		// NOTE: carry from the mantissa into the exponent produces the correct result (including rounding up to infinity)
+		if (Remainder > 0x1000 || (Remainder == 0x1000 && (Result & 1)))
+			Result++;
+		return static_cast<uint16>(Result);
+	}
+
+	static int16 FloatToSNorm16(float Value)
+	{
+		return static_cast<int16>(std::round(Math::Clamp(-1.0f, 1.0f, Value) * 32767.0f));
+	}
+
+	/*
+	 * Encodes a unit vector into two components using octahedral mapping (see 'A Survey of Efficient Representations
+	 * for Independent Unit Vectors' by Cigolle et al.)
+	 */
+	static void EncodeOctahedral(Vec3 Vector, int16 (&Result)[2])
+	{
+		float L1Norm = Math::Abs(Vector.X) + Math::Abs(Vector.Y) + Math::Abs(Vector.Z);
+		if (L1Norm <= 0.0f)
+		{
+			Result[0] = 0;
+			Result[1] = 0;
+			return;
+		}
+
+		Vector /= L1Norm;
+		Vec2 Encoded = { Vector.X, Vector.Y };
+		if (Vector.Z < 0.0f)
+		{
+			Encoded.X = (1.0f - Math::Abs(Vector.Y)) * (Vector.X >= 0.0f ? 1.0f : -1.0f);
+			Encoded.Y = (1.0f - Math::Abs(Vector.X)) * (Vector.Y >= 0.0f ? 1.0f : -1.0f);
+		}
+
+		Result[0] = FloatToSNorm16(Encoded.X);
+		Result[1] = FloatToSNorm16(Encoded.Y);
+	}
+
+	static std::vector<CompressedVertex> CompressVertices(const std::vector<Vertex>& Vertices, Vec3 BoundingBoxMin, Vec3 BoundingBoxMax)
+	{
+		auto Extent = BoundingBoxMax - BoundingBoxMin;
+
+		std::vector<CompressedVertex> Result(Vertices.size());
+		for (size_t VertexIndex = 0; VertexIndex < Vertices.size(); VertexIndex++)
+		{
+			const auto& Input = Vertices[VertexIndex];
+			auto& Output = Result[VertexIndex];
+
+			for (size_t Component = 0; Component < 3; Component++)
+			{
+				float Normalized = Extent[Component] > 0.0f ? (Input.Position[Component] - BoundingBoxMin[Component]) / Extent[Component] : 0.0f;
+				Output.Position[Component] = static_cast<uint16>(std::round(Math::Clamp(0.0f, 1.0f, Normalized) * 65535.0f));
+			}
+			Output.Position[3] = 0;
+
+			Output.TextureCoordinates[0] = FloatToHalf(Input.TextureCoordinates.X);
+			Output.TextureCoordinates[1] = FloatToHalf(Input.TextureCoordinates.Y);
+
+			EncodeOctahedral(Input.Normal, Output.Normal);
+			EncodeOctahedral(Input.Tangent, Output.Tangent);
+		}
+
+		return Result;
+	}
+
+	bool MeshWriter::Write(StringView FileName, const Mesh& Mesh, bool CompressVertices)
 	{
 		auto File = PlatformFilesystem::OpenFile(FileName, IPlatformFile::FileAccessMode::Write, IPlatformFile::FileOpenMode::Create);
 		if (!File)
@@ -31,19 +135,65 @@ namespace Hermes::Tools
 			Primitive.IndexBufferOffset = Primitive.IndexBufferOffset / 4 * 3;
 		}
 
+		auto Meshlets = MeshletBuilder::Build(FilteredIndices, Primitives, Mesh.GetVertices());
+
 		AssetHeader AssetHeader = { .Type = AssetType::Mesh };
 		memcpy(AssetHeader.Signature, AssetHeader::ExpectedSignature, sizeof(AssetHeader.Signature));
 		MeshAssetHeader MeshHeader = {};
+		MeshHeader.Version = MeshAssetHeader::CurrentVersion;
 		MeshHeader.VertexBufferSize = static_cast<uint32>(Mesh.GetVertices().size());
 		MeshHeader.IndexBufferSize = static_cast<uint32>(FilteredIndices.size());
 		MeshHeader.PrimitiveCount = static_cast<uint32>(Primitives.size());
+		MeshHeader.MeshletCount = static_cast<uint32>(Meshlets.size());
+		MeshHeader.VertexFormat = CompressVertices ? MeshVertexFormat::Compressed : MeshVertexFormat::Full;
+		// NOTE: primitive restart is never enabled, so index 0xFFFF is an ordinary index and 65536 vertices can be addressed with 16-bit indices
+		bool UseShortIndices = Mesh.GetVertices().size() <= static_cast<size_t>(UINT16_MAX) + 1;
+		MeshHeader.IndexType = UseShortIndices ? MeshIndexType::UInt16 : MeshIndexType::UInt32;
+
+		Vec3 BoundingBoxMin = {}, BoundingBoxMax = {};
+		if (!Mesh.GetVertices().empty())
+		{
+			BoundingBoxMin = BoundingBoxMax = Mesh.GetVertices()[0].Position;
+			for (const auto& Vertex : Mesh.GetVertices())
+			{
+				for (size_t Component = 0; Component < 3; Component++)
+				{
+					BoundingBoxMin[Component] = Math::Min(BoundingBoxMin[Component], Vertex.Position[Component]);
+					BoundingBoxMax[Component] = Math::Max(BoundingBoxMax[Component], Vertex.Position[Component]);
+				}
+			}
+		}
+		MeshHeader.BoundingBoxMin = BoundingBoxMin;
+		MeshHeader.BoundingBoxMax = BoundingBoxMax;
+
+		std::vector<CompressedVertex> CompressedVertices;
+		const void* VertexData = Mesh.GetVertices().data();
+		size_t VertexDataSize = Mesh.GetVertices().size() * sizeof(Vertex);
+		if (CompressVertices)
+		{
+			CompressedVertices = Tools::CompressVertices(Mesh.GetVertices(), BoundingBoxMin, BoundingBoxMax);
+			VertexData = CompressedVertices.data();
+			VertexDataSize = CompressedVertices.size() * sizeof(CompressedVertex);
+		}
+
+		std::vector<uint16> ShortIndices;
+		const void* IndexData = FilteredIndices.data();
+		size_t IndexDataSize = FilteredIndices.size() * sizeof(uint32);
+		if (UseShortIndices)
+		{
+			ShortIndices.resize(FilteredIndices.size());
+			std::ranges::transform(FilteredIndices, ShortIndices.begin(), [](uint32 Index) { return static_cast<uint16>(Index); });
+			IndexData = ShortIndices.data();
+			IndexDataSize = ShortIndices.size() * sizeof(uint16);
+		}
 
 		bool Result =
 			File->Write(&AssetHeader, sizeof(AssetHeader)) &&
 			File->Write(&MeshHeader, sizeof(MeshHeader)) &&
 			File->Write(Primitives.data(), Primitives.size() * sizeof(MeshPrimitiveHeader)) &&
-			File->Write(Mesh.GetVertices().data(), Mesh.GetVertices().size() * sizeof(Mesh.GetVertices()[0])) &&
-			File->Write(FilteredIndices.data(), FilteredIndices.size() * sizeof(FilteredIndices[0]));
+			File->Write(VertexData, VertexDataSize) &&
+			File->Write(IndexData, IndexDataSize) &&
+			File->Write(Meshlets.data(), Meshlets.size() * sizeof(MeshletHeader));
 
 		if (!Result)
 		{
@@ -11,6 +11,10 @@ namespace Hermes::Tools
 	class HERMES_API MeshWriter
 	{
 	public:
-		static bool Write(StringView FileName, const Mesh& Mesh);
+		/*
+		 * Writes the mesh into a .hac file; if CompressVertices is true then the vertices are stored in the packed format
+		 * (see CompressedVertex in AssetHeaders.h)
+		 */
+		static bool Write(StringView FileName, const Mesh& Mesh, bool CompressVertices);
 	};
 }
@@ -0,0 +1,143 @@
+#include "MeshletBuilder.h"
+
+namespace Hermes::Tools
+{
+	std::vector<MeshletHeader> MeshletBuilder::Build(std::span<const uint32> Indices, std::span<const MeshPrimitiveHeader> Primitives, std::span<const Vertex> Vertices)
+	{
+		std::vector<MeshletHeader> Result;
+
+		// NOTE: stores the index of the last meshlet that referenced the vertex so that the set of vertices of the current
+		//       meshlet does not have to be cleared every time a new meshlet is started
+		std::vector<uint32> LastMeshletOfVertex(Vertices.size(), static_cast<uint32>(-1));
+
+		for (uint32 PrimitiveIndex = 0; PrimitiveIndex < static_cast<uint32>(Primitives.size()); PrimitiveIndex++)
+		{
+			const auto& Primitive = Primitives[PrimitiveIndex];
+			HERMES_ASSERT(Primitive.IndexCount % 3 == 0);
+
+			uint32 MeshletStart = Primitive.IndexBufferOffset;
+			uint32 MeshletVertexCount = 0;
+			auto CurrentMeshletIndex = static_cast<uint32>(Result.size());
+
+			auto FinishMeshlet = [&](uint32 MeshletEnd)
+			{
+				if (MeshletEnd == MeshletStart)
+					return;
+
+				auto Meshlet = ComputeBounds(Indices, MeshletStart, MeshletEnd - MeshletStart, Vertices);
+				Meshlet.PrimitiveIndex = PrimitiveIndex;
+				Result.push_back(Meshlet);
+
+				MeshletStart = MeshletEnd;
+				MeshletVertexCount = 0;
+				CurrentMeshletIndex = static_cast<uint32>(Result.size());
+			};
+
+			uint32 PrimitiveEnd = Primitive.IndexBufferOffset + Primitive.IndexCount;
+			for (uint32 TriangleStart = Primitive.IndexBufferOffset; TriangleStart < PrimitiveEnd; TriangleStart += 3)
+			{
+				uint32 NewVertexCount = 0;
+				for (uint32 Corner = 0; Corner < 3; Corner++)
+				{
+					auto Index = Indices[TriangleStart + Corner];
+					// NOTE: a triangle can reference the same vertex twice, it must not be counted twice in that case
+					bool IsDuplicate = (Corner > 0 && Indices[TriangleStart] == Index) || (Corner > 1 && Indices[TriangleStart + 1] == Index);
+					if (LastMeshletOfVertex[Index] != CurrentMeshletIndex && !IsDuplicate)
+						NewVertexCount++;
+				}
+
+				uint32 TriangleCount = (TriangleStart - MeshletStart) / 3;
+				if (MeshletVertexCount + NewVertexCount > MaxVertices || TriangleCount == MaxTriangles)
+					FinishMeshlet(TriangleStart);
+
+				for (uint32 Corner = 0; Corner < 3; Corner++)
+				{
+					auto Index = Indices[TriangleStart + Corner];
+					if (LastMeshletOfVertex[Index] != CurrentMeshletIndex)
+					{
+						LastMeshletOfVertex[Index] = CurrentMeshletIndex;
+						MeshletVertexCount++;
+					}
+				}
+			}
+
+			FinishMeshlet(PrimitiveEnd);
+		}
+
+		return Result;
+	}
+
+	MeshletHeader MeshletBuilder::ComputeBounds(std::span<const uint32> Indices, uint32 IndexOffset, uint32 IndexCount, std::span<const Vertex> Vertices)
+	{
+		MeshletHeader Result = {};
+		Result.IndexOffset = IndexOffset;
+		Result.IndexCount = IndexCount;
+
+		auto MeshletIndices = Indices.subspan(IndexOffset, IndexCount);
+
+		// Bounding sphere is centered at the center of the bounding box
+		Vec3 BoundingBoxMin = Vertices[MeshletIndices[0]].Position;
+		Vec3 BoundingBoxMax = BoundingBoxMin;
+		for (auto Index : MeshletIndices)
+		{
+			for (size_t Component = 0; Component < 3; Component++)
+			{
+				BoundingBoxMin[Component] = Math::Min(BoundingBoxMin[Component], Vertices[Index].Position[Component]);
+				BoundingBoxMax[Component] = Math::Max(BoundingBoxMax[Component], Vertices[Index].Position[Component]);
+			}
+		}
+		Result.Center = (BoundingBoxMin + BoundingBoxMax) * 0.5f;
+
+		float MaxDistanceSquared = 0.0f;
+		for (auto Index : MeshletIndices)
+			MaxDistanceSquared = Math::Max(MaxDistanceSquared, (Vertices[Index].Position - Result.Center).LengthSq());
+		Result.Radius = Math::Sqrt(MaxDistanceSquared);
+
+		// Normal cone is computed from the geometric normals of the triangles because they (and not the vertex normals) determine
+		// whether a triangle gets culled by the rasterizer
+		std::vector<Vec3> TriangleNormals;
+		TriangleNormals.reserve(IndexCount / 3);
+		Vec3 NormalSum = {};
+		for (uint32 TriangleStart = 0; TriangleStart < IndexCount; TriangleStart += 3)
+		{
+			const auto& A = Vertices[MeshletIndices[TriangleStart + 0]];
+			const auto& B = Vertices[MeshletIndices[TriangleStart + 1]];
+			const auto& C = Vertices[MeshletIndices[TriangleStart + 2]];
+
+			auto Normal = (B.Position - A.Position).Cross(C.Position - A.Position);
+			if (Normal.LengthSq() <= 0.0f)
+				continue;
+			Normal = Normal.Normalized();
+
+			// NOTE: vertex normals are only used to determine which side of the triangle is the front one, so the result
+			//       does not depend on the winding order convention of the source file
+			if (Normal.Dot(A.Normal + B.Normal + C.Normal) < 0.0f)
+				Normal = -Normal;
+
+			TriangleNormals.push_back(Normal);
+			NormalSum += Normal;
+		}
+
+		// Degenerate cone that never passes the back-facing test
+		Result.ConeAxis = Vec3(0.0f, 0.0f, 1.0f);
+		Result.ConeCutoff = 1.0f;
+
+		if (TriangleNormals.empty() || NormalSum.LengthSq() <= 0.0f)
+			return Result;
+
+		auto Axis = NormalSum.Normalized();
+		float MinDotProduct = 1.0f;
+		for (const auto& Normal : TriangleNormals)
+			MinDotProduct = Math::Min(MinDotProduct, Normal.Dot(Axis));
+
+		// NOTE: if the normals are spread over more than ~170 degrees then the meshlet is visible from almost any direction
+		//       and the cone test would only waste time
+		if (MinDotProduct <= 0.1f)
+			return Result;
+
+		Result.ConeAxis = Axis;
+		Result.ConeCutoff = Math::Sqrt(1.0f - MinDotProduct * MinDotProduct);
+
+		return Result;
+	}
+}
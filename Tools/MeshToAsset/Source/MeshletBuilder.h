@@ -0,0 +1,30 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "AssetSystem/AssetHeaders.h"
+#include "Core/Core.h"
+
+namespace Hermes::Tools
+{
+	/*
+	 * Splits the triangles of a mesh into meshlets that can be culled on the GPU individually (see MeshletHeader in AssetHeaders.h)
+	 */
+	class HERMES_API MeshletBuilder
+	{
+	public:
+		static constexpr uint32 MaxVertices = 64;
+		static constexpr uint32 MaxTriangles = 124;
+
+		/*
+		 * Greedily groups consecutive triangles of each primitive into meshlets. Expects a plain triangle list (without
+		 * the -1 face separators) and primitives whose offsets and counts are expressed in the same units.
+		 * The triangle order is preserved, so meshlets built after vertex cache optimization stay cache-friendly
+		 */
+		static std::vector<MeshletHeader> Build(std::span<const uint32> Indices, std::span<const MeshPrimitiveHeader> Primitives, std::span<const Vertex> Vertices);
+
+	private:
+		static MeshletHeader ComputeBounds(std::span<const uint32> Indices, uint32 IndexOffset, uint32 IndexCount, std::span<const Vertex> Vertices);
+	};
+}
@@ -15,6 +15,8 @@ namespace Hermes::Tools
 			meshtoasset [OPTIONS] file
 		Options:
 			--flip, -f: flip order of vertices in triangles
+			--compress, -c: store vertices in the compressed format (quantized positions, octahedral normals and tangents, half float UVs)
+			--no-optimize: do not reorder triangles and vertices for vertex cache locality and reduced overdraw
 			--help, -h: display this help message
 		)";
 		std::cout << HelpMessage << std::endl;
@@ -29,11 +31,15 @@ namespace Hermes::Tools
 		}
 
 		bool FlipVertexOrder = false;
+		bool DisableOptimization = false;
+		bool CompressVertices = false;
 		bool ShowHelpOption = false;
 		String FileName;
 
 		ArgsParser Parser;
 		Parser.AddOption("flip", 'f', &FlipVertexOrder);
+		Parser.AddOption("no-optimize", {}, &DisableOptimization);
+		Parser.AddOption("compress", 'c', &CompressVertices);
 		Parser.AddOption("help", 'h', &ShowHelpOption);
 		Parser.AddPositional(true, &FileName);
 
@@ -49,7 +55,7 @@ namespace Hermes::Tools
 			return 0;
 		}
 
-		FileProcessor Processor(FileName, FlipVertexOrder);
+		FileProcessor Processor(FileName, FlipVertexOrder, !DisableOptimization, CompressVertices);
 
 		return Processor.Run();
 	}